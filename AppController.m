@@ -104,6 +104,7 @@
         [SCUIUtilities presentError: err];
 		return;
 	}
+	[domainListWindowController_ saveBlocklistNow];
 	if (([[defaults_ arrayForKey: @"Blocklist"] count] == 0) && ![defaults_ boolForKey: @"BlockAsWhitelist"]) {
 		// Since the Start button should be disabled when the blocklist has no entries (and it's not an allowlist)
 		// this should definitely not be happening.  Exit.
@@ -352,6 +353,7 @@
     
     // clean out empty strings from the defaults blocklist (they can end up there occasionally due to UI glitches etc)
     // note we don't screw with the actively running blocklist - that should've been cleaned before it started anyway
+    [domainListWindowController_ saveBlocklistNow];
     NSArray<NSString*>* cleanedBlocklist = [SCMiscUtilities cleanBlocklist: [defaults_ arrayForKey: @"Blocklist"]];
     [defaults_ setObject: cleanedBlocklist forKey: @"Blocklist"];
 
@@ -475,7 +477,7 @@
     }];
 
     // start up our daemon XPC
-    self.xpc = [SCXPCClient new];
+    self.xpc = [SCXPCClient sharedClient];
     [self.xpc connectToHelperTool];
     
     // if we don't have a connection within 0.5 seconds,
@@ -716,6 +718,7 @@
 }
 
 - (void)closeDomainList {
+	[domainListWindowController_ saveBlocklistNow];
 	[domainListWindowController_ close];
 	domainListWindowController_ = nil;
 }
@@ -743,6 +746,8 @@
 
 - (void)addToBlockList:(NSString*)host lock:(NSLock*)lock {
     NSLog(@"addToBlocklist: %@", host);
+    // we're about to replace the Blocklist default, so don't let a pending domain list save clobber it later
+    [domainListWindowController_ saveBlocklistNow];
     // Note we RETRIEVE the latest list from settings (ActiveBlocklist), but we SET the new list in defaults
     // since the helper daemon should be the only one changing ActiveBlocklist
     NSMutableArray* list = [[settings_ valueForKey: @"ActiveBlocklist"] mutableCopy];
@@ -992,6 +997,9 @@
 
 	/* if successful, save file under designated name */
 	if (runResult == NSModalResponseOK) {
+        // make sure the last few edits in the domain list are in the file
+        [domainListWindowController_ saveBlocklistNow];
+
         NSError* err;
         [SCBlockFileReaderWriter writeBlocklistToFileURL: sp.URL
                                    blockInfo: @{
@@ -1017,6 +1025,9 @@
     NSDictionary* settingsFromFile = [SCBlockFileReaderWriter readBlocklistFromFile: fileURL];
     
     if (settingsFromFile != nil) {
+        // otherwise a pending domain list save would overwrite the list we're opening
+        [domainListWindowController_ saveBlocklistNow];
+
         [defaults_ setObject: settingsFromFile[@"Blocklist"] forKey: @"Blocklist"];
         [defaults_ setObject: settingsFromFile[@"BlockAsWhitelist"] forKey: @"BlockAsWhitelist"];
         [SCSentry addBreadcrumb: @"Opened blocklist from file" category:@"app"];
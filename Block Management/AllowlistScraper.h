@@ -10,8 +10,31 @@
 
 @class SCBlockEntry;
 
+// Finds the hosts an allowlisted site links to from its front page, so they can be allowed too.
+// One scraper covers a whole block's worth of domains: fetches share a URL session (so
+// connections are kept alive between them), at most maxConcurrentFetches run at once, and
+// everything still outstanding timeLimit seconds after the first fetch started is given up on.
 @interface AllowlistScraper : NSObject
 
+- (instancetype)initWithMaxConcurrentFetches:(NSUInteger)maxConcurrentFetches timeLimit:(NSTimeInterval)timeLimit;
+
+// Queues a fetch of the domain's front page. The handler is called exactly once, on a
+// background queue, with the hosts it links to - empty if the fetch failed, ran past the
+// time limit or was cancelled.
+- (void)scrapeDomain:(NSString*)domain completionHandler:(void (^)(NSSet<SCBlockEntry*>* relatedEntries))completionHandler;
+
+// Blocks until every queued scrape's handler has run. Thanks to the time limit, that's never
+// much longer than timeLimit after the first fetch.
+- (void)waitUntilFinished;
+
+// Stops every fetch; queued and running scrapes complete with no entries, as do any queued later
+- (void)cancel;
+
+// Hosts the page's href and src attributes point to, other than its own host and sites that
+// are never added
++ (NSSet<SCBlockEntry*>*)relatedBlockEntriesInHTML:(NSString*)html rootHost:(NSString*)rootHost;
+
+// Scrapes a single domain synchronously
 + (NSSet<SCBlockEntry*>*)relatedBlockEntries:(NSString*)domain;
 
 @end
@@ -8,66 +8,256 @@
 
 #import "AllowlistScraper.h"
 #import "SCBlockEntry.h"
+#import "SCLinkHostExtractor.h"
 
-@implementation AllowlistScraper
-
-+ (NSSet<SCBlockEntry*>*)relatedBlockEntries:(NSString*)domain; {
-	NSURL* rootURL = [NSURL URLWithString: [NSString stringWithFormat: @"http://%@", domain]];
-	if (!rootURL) {
-		return nil;
-	}
-
-	// stale data is OK
-	NSURLRequest* request = [NSURLRequest requestWithURL: rootURL cachePolicy: NSURLRequestReturnCacheDataElseLoad timeoutInterval: 5];
-	NSURLResponse* response = nil;
-	NSError* error = nil;
-	NSData* data = [NSURLConnection sendSynchronousRequest: request returningResponse: &response error: &error];
-	if (!response) {
-		return nil;
-	}
-	NSString* html = [[NSString alloc] initWithData: data encoding: NSUTF8StringEncoding];
-	if (!html) {
-		return nil;
-	}
+// per page; the scraper's time limit caps the whole run
+static const NSTimeInterval kScraperFetchTimeout = 5.0;
 
+// One front page being fetched, and the hosts found in what's arrived of it so far
+@interface SCAllowlistFetch : NSObject
+
+@property (nonatomic, strong) NSURLSessionDataTask* task;
+@property (nonatomic, strong) SCLinkHostExtractor* extractor;
+@property (nonatomic, copy) void (^completionHandler)(NSSet<SCBlockEntry*>*);
+
+@end
+
+@implementation SCAllowlistFetch
+@end
+
+// The session keeps its delegate until it's invalidated, which the scraper only does in dealloc,
+// so the delegate can't be the scraper itself
+@interface SCAllowlistScraperSessionDelegate : NSObject <NSURLSessionDataDelegate>
+
+@property (nonatomic, weak) AllowlistScraper* scraper;
+
+@end
+
+@interface AllowlistScraper ()
+
+- (void)fetchTask:(NSURLSessionTask*)task didReceiveData:(NSData*)data;
+- (void)fetchTask:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error;
+
+@end
+
+@implementation SCAllowlistScraperSessionDelegate
+
+- (void)URLSession:(NSURLSession*)session dataTask:(NSURLSessionDataTask*)dataTask didReceiveData:(NSData*)data {
+    [self.scraper fetchTask: dataTask didReceiveData: data];
+}
+
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error {
+    [self.scraper fetchTask: task didCompleteWithError: error];
+}
+
+@end
+
+@implementation AllowlistScraper {
+    NSURLSession* _session;
+    NSUInteger _maxConcurrentFetches;
+    NSTimeInterval _timeLimit;
+
+    // everything below is only touched on _queue
+    dispatch_queue_t _queue;
+    NSDate* _deadline;
+    BOOL _cancelled;
+    NSMutableArray<NSArray*>* _pendingScrapes; // [root URL, completion handler]
+    NSMutableDictionary<NSNumber*, SCAllowlistFetch*>* _runningFetches; // by task identifier
+
+    // entered per scrape, left once its handler has run
+    dispatch_group_t _outstandingScrapes;
+}
+
+- (instancetype)initWithMaxConcurrentFetches:(NSUInteger)maxConcurrentFetches timeLimit:(NSTimeInterval)timeLimit {
+    if (self = [super init]) {
+        _maxConcurrentFetches = MAX(maxConcurrentFetches, 1);
+        _timeLimit = timeLimit;
+        _queue = dispatch_queue_create("org.eyebeam.SelfControl.AllowlistScraper", DISPATCH_QUEUE_SERIAL);
+        _pendingScrapes = [NSMutableArray array];
+        _runningFetches = [NSMutableDictionary dictionary];
+        _outstandingScrapes = dispatch_group_create();
+
+        NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+        // stale data is OK
+        configuration.requestCachePolicy = NSURLRequestReturnCacheDataElseLoad;
+        configuration.HTTPMaximumConnectionsPerHost = _maxConcurrentFetches;
+        // delegate callbacks come in on _queue, so each page is parsed chunk by chunk as it
+        // arrives rather than once it's all been buffered
+        NSOperationQueue* delegateQueue = [[NSOperationQueue alloc] init];
+        delegateQueue.maxConcurrentOperationCount = 1;
+        delegateQueue.underlyingQueue = _queue;
+        SCAllowlistScraperSessionDelegate* delegate = [[SCAllowlistScraperSessionDelegate alloc] init];
+        delegate.scraper = self;
+        _session = [NSURLSession sessionWithConfiguration: configuration delegate: delegate delegateQueue: delegateQueue];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_session invalidateAndCancel];
+}
+
+- (void)scrapeDomain:(NSString*)domain completionHandler:(void (^)(NSSet<SCBlockEntry*>* relatedEntries))completionHandler {
+    dispatch_group_enter(_outstandingScrapes);
+
+    NSURL* rootURL = [NSURL URLWithString: [NSString stringWithFormat: @"http://%@", domain]];
+    if (rootURL == nil) {
+        [self finishScrapeWithEntries: [NSSet set] completionHandler: completionHandler];
+        return;
+    }
+
+    dispatch_async(_queue, ^{
+        if (self->_cancelled) {
+            [self finishScrapeWithEntries: [NSSet set] completionHandler: completionHandler];
+            return;
+        }
+
+        // the clock starts with the first fetch, not when the scraper was made
+        if (self->_deadline == nil) {
+            self->_deadline = [NSDate dateWithTimeIntervalSinceNow: self->_timeLimit];
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self->_timeLimit * NSEC_PER_SEC)), self->_queue, ^{
+                if (!self->_cancelled && (self->_pendingScrapes.count > 0 || self->_runningFetches.count > 0)) {
+                    NSLog(@"AllowlistScraper: Hit the %.0f second time limit, giving up on %lu remaining domains",
+                          self->_timeLimit, (unsigned long)(self->_pendingScrapes.count + self->_runningFetches.count));
+                }
+                [self cancelOnQueue];
+            });
+        }
+
+        [self->_pendingScrapes addObject: @[rootURL, completionHandler]];
+        [self startPendingFetches];
+    });
+}
+
+// on _queue
+- (void)startPendingFetches {
+    while (!_cancelled && _runningFetches.count < _maxConcurrentFetches && _pendingScrapes.count > 0) {
+        NSArray* scrape = _pendingScrapes.firstObject;
+        [_pendingScrapes removeObjectAtIndex: 0];
+        [self startFetchOfURL: scrape[0] completionHandler: scrape[1]];
+    }
+}
+
+// on _queue
+- (void)startFetchOfURL:(NSURL*)rootURL completionHandler:(void (^)(NSSet<SCBlockEntry*>*))completionHandler {
+    NSTimeInterval remaining = [_deadline timeIntervalSinceNow];
+    if (remaining <= 0) {
+        [self finishScrapeWithEntries: [NSSet set] completionHandler: completionHandler];
+        return;
+    }
+
+    NSURLRequest* request = [NSURLRequest requestWithURL: rootURL
+                                             cachePolicy: NSURLRequestReturnCacheDataElseLoad
+                                         timeoutInterval: MIN(kScraperFetchTimeout, remaining)];
+    SCAllowlistFetch* fetch = [[SCAllowlistFetch alloc] init];
+    fetch.task = [_session dataTaskWithRequest: request];
+    fetch.extractor = [[SCLinkHostExtractor alloc] initWithExcludedHosts: [AllowlistScraper excludedHostsForRootHost: rootURL.host]];
+    fetch.completionHandler = completionHandler;
+    _runningFetches[@(fetch.task.taskIdentifier)] = fetch;
+    [fetch.task resume];
+}
+
+// on _queue
+- (void)fetchTask:(NSURLSessionTask*)task didReceiveData:(NSData*)data {
+    [_runningFetches[@(task.taskIdentifier)].extractor appendData: data];
+}
+
+// on _queue
+- (void)fetchTask:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error {
+    SCAllowlistFetch* fetch = _runningFetches[@(task.taskIdentifier)];
+    if (fetch == nil) return;
+    [_runningFetches removeObjectForKey: @(task.taskIdentifier)];
+
+    // a page cut short (timed out, cancelled) gives no entries, as it did when pages were buffered
+    NSSet<SCBlockEntry*>* relatedEntries = error == nil ? [AllowlistScraper blockEntriesForHosts: fetch.extractor.hosts] : [NSSet set];
+    [self finishScrapeWithEntries: relatedEntries completionHandler: fetch.completionHandler];
+    [self startPendingFetches];
+}
+
+- (void)finishScrapeWithEntries:(NSSet<SCBlockEntry*>*)relatedEntries completionHandler:(void (^)(NSSet<SCBlockEntry*>*))completionHandler {
+    // off _queue and the session's delegate queue, so a slow handler holds up nobody else
+    dispatch_group_async(_outstandingScrapes, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        completionHandler(relatedEntries);
+    });
+    dispatch_group_leave(_outstandingScrapes);
+}
+
+- (void)waitUntilFinished {
+    dispatch_group_wait(_outstandingScrapes, DISPATCH_TIME_FOREVER);
+}
+
+- (void)cancel {
+    dispatch_async(_queue, ^{
+        [self cancelOnQueue];
+    });
+}
+
+// on _queue
+- (void)cancelOnQueue {
+    _cancelled = YES;
+    for (NSArray* scrape in _pendingScrapes) {
+        [self finishScrapeWithEntries: [NSSet set] completionHandler: scrape[1]];
+    }
+    [_pendingScrapes removeAllObjects];
+    // they still complete, with an NSURLErrorCancelled error
+    for (SCAllowlistFetch* fetch in _runningFetches.allValues) {
+        [fetch.task cancel];
+    }
+}
+
++ (NSSet<NSString*>*)excludedHostsForRootHost:(NSString*)rootHost {
     // these sites are often featured in "share links" on a wide variety of websites
     // we really don't want to add them to the allowlist, since they're also
     // super distracting. So explicitly flag them to skip in this process
-    NSArray* neverAddSites = @[
-        @"instagram.com",
-        @"www.instagram.com",
-        @"twitter.com",
-        @"www.twitter.com",
-        @"facebook.com",
-        @"www.facebook.com",
-        @"reddit.com",
-        @"www.reddit.com",
-        @"youtube.com",
-        @"www.youtube.com",
-        @"pinterest.com",
-        @"plus.google.com",
-        @"www.pinterest.com",
-        @"linkedin.com",
-        @"www.linkedin.com",
-        @"tumblr.com",
-        @"www.tumblr.com"
-    ];
-
-	NSDataDetector* dataDetector = [[NSDataDetector alloc] initWithTypes: NSTextCheckingTypeLink error: nil];
-	NSCountedSet<SCBlockEntry*>* relatedEntries = [NSCountedSet set];
-	[dataDetector enumerateMatchesInString: html
-								   options: kNilOptions
-									 range: NSMakeRange(0, [html length])
-								usingBlock:^(NSTextCheckingResult* result, NSMatchingFlags flags, BOOL* stop) {
-									if (([result.URL.scheme isEqualToString: @"http"] || [result.URL.scheme isEqualToString: @"https"])
-										&& [result.URL.host length]
-										&& ![result.URL.host isEqualToString: rootURL.host]
-                                        && ![neverAddSites containsObject: result.URL.host]) {
-                                        [relatedEntries addObject: [SCBlockEntry entryWithHostname: result.URL.host]];
-                                    }
-								}];
-
-	return relatedEntries;
+    static NSSet<NSString*>* neverAddSites;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        neverAddSites = [NSSet setWithArray: @[
+            @"instagram.com",
+            @"www.instagram.com",
+            @"twitter.com",
+            @"www.twitter.com",
+            @"facebook.com",
+            @"www.facebook.com",
+            @"reddit.com",
+            @"www.reddit.com",
+            @"youtube.com",
+            @"www.youtube.com",
+            @"pinterest.com",
+            @"plus.google.com",
+            @"www.pinterest.com",
+            @"linkedin.com",
+            @"www.linkedin.com",
+            @"tumblr.com",
+            @"www.tumblr.com"
+        ]];
+    });
+
+    return rootHost.length ? [neverAddSites setByAddingObject: rootHost] : neverAddSites;
+}
+
++ (NSSet<SCBlockEntry*>*)relatedBlockEntriesInHTML:(NSString*)html rootHost:(NSString*)rootHost {
+    NSData* data = [html dataUsingEncoding: NSUTF8StringEncoding];
+    NSSet<NSString*>* hosts = [SCLinkHostExtractor hostsInData: data excludingHosts: [AllowlistScraper excludedHostsForRootHost: rootHost]];
+    return [AllowlistScraper blockEntriesForHosts: hosts];
+}
+
++ (NSSet<SCBlockEntry*>*)blockEntriesForHosts:(NSSet<NSString*>*)hosts {
+    NSMutableSet<SCBlockEntry*>* entries = [NSMutableSet setWithCapacity: hosts.count];
+    for (NSString* host in hosts) {
+        [entries addObject: [SCBlockEntry entryWithHostname: host]];
+    }
+    return entries;
+}
+
++ (NSSet<SCBlockEntry*>*)relatedBlockEntries:(NSString*)domain {
+    AllowlistScraper* scraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: 1 timeLimit: kScraperFetchTimeout];
+    __block NSSet<SCBlockEntry*>* relatedEntries = nil;
+    [scraper scrapeDomain: domain completionHandler:^(NSSet<SCBlockEntry*>* entries) {
+        relatedEntries = entries;
+    }];
+    [scraper waitUntilFinished];
+    return relatedEntries;
 }
 
 @end
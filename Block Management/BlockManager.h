@@ -27,6 +27,8 @@
 @class SCBlockEntry;
 @class HostFileBlockerSet;
 @class AppBlocker;
+@class SCBlocklistDelta;
+@class AllowlistScraper;
 
 @interface BlockManager : NSObject {
 	NSOperationQueue* opQueue;
@@ -38,6 +40,8 @@
 	BOOL includeCommonSubdomains;
 	BOOL includeLinkedDomains;
     NSMutableSet* addedBlockEntries;
+    AllowlistScraper* allowlistScraper;
+    SCBlocklistDelta* resolvedDelta;
 }
 
 /// App blocker instance for killing blocked applications
@@ -55,6 +59,9 @@
 - (void)addBlockEntryFromString:(NSString*)entry;
 - (void)addBlockEntry:(SCBlockEntry*)entry;
 - (void)addBlockEntriesFromStrings:(NSArray<NSString*>*)blockList;
+- (BOOL)applyBlocklistDelta:(SCBlocklistDelta*)delta toBlocklist:(NSArray<NSString*>*)newBlockList;
+- (BOOL)resolveBlocklistDelta:(SCBlocklistDelta*)delta toBlocklist:(NSArray<NSString*>*)newBlockList;
+- (BOOL)commitResolvedBlocklistDelta;
 - (BOOL)clearBlock;
 - (BOOL)forceClearBlock;
 - (BOOL)blockIsActive;
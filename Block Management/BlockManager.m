@@ -29,6 +29,11 @@
 #import "AppBlocker.h"
 #import "SCSettings.h"
 #import "SCBlockUtilities.h"
+#import "SCBlocklistDelta.h"
+
+// linked domains are scraped a few at a time, and the whole allowlist gets this long
+static const NSUInteger kAllowlistScraperMaxConcurrentFetches = 8;
+static const NSTimeInterval kAllowlistScraperTimeLimit = 30.0;
 
 @interface BlockManager ()
 @property (nonatomic, strong, readwrite) AppBlocker* appBlocker;
@@ -109,7 +114,7 @@ BOOL appendMode = NO;
 - (void)finishAppending {
     NSLog(@"BlockManager: About to run operation queue for appending...");
     NSDate* startedRunning  = [NSDate date];
-    [opQueue waitUntilAllOperationsAreFinished];
+    [self waitForQueuedEntries];
     NSDate* finishedRunning  = [NSDate date];
     NSTimeInterval runTime = [finishedRunning timeIntervalSinceDate: startedRunning];
     NSLog(@"BlockManager: Operation queue ran in %f seconds!", runTime);
@@ -127,7 +132,7 @@ BOOL appendMode = NO;
 - (void)finalizeBlock {
     NSLog(@"BlockManager: About to run operation queue...");
     NSDate* startedRunning  = [NSDate date];
-	[opQueue waitUntilAllOperationsAreFinished];
+	[self waitForQueuedEntries];
     NSDate* finishedRunning  = [NSDate date];
     NSTimeInterval runTime = [finishedRunning timeIntervalSinceDate: startedRunning];
     NSLog(@"BlockManager: Operation queue ran in %f seconds!", runTime);
@@ -150,6 +155,44 @@ BOOL appendMode = NO;
     }
 }
 
+// Scrapes are started by queued operations, and queue more operations as they come back,
+// so the queue has to be drained again once they're all in
+- (void)waitForQueuedEntries {
+    [opQueue waitUntilAllOperationsAreFinished];
+
+    AllowlistScraper* scraper;
+    @synchronized (self) {
+        scraper = allowlistScraper;
+    }
+    if (scraper != nil) {
+        [scraper waitUntilFinished];
+        [opQueue waitUntilAllOperationsAreFinished];
+    }
+}
+
+// The linked domains are added whenever the scrape comes back, without holding up this entry
+- (void)scrapeLinkedDomainsForEntry:(SCBlockEntry*)entry {
+    AllowlistScraper* scraper;
+    @synchronized (self) {
+        if (allowlistScraper == nil) {
+            allowlistScraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: kAllowlistScraperMaxConcurrentFetches
+                                                                            timeLimit: kAllowlistScraperTimeLimit];
+        }
+        scraper = allowlistScraper;
+    }
+
+    NSDate* startedScraping  = [NSDate date];
+    [scraper scrapeDomain: entry.hostname completionHandler:^(NSSet<SCBlockEntry*>* scrapedEntries) {
+        NSTimeInterval scrapeTime = [[NSDate date] timeIntervalSinceDate: startedScraping];
+        if (scrapeTime > 5.0) {
+            NSLog(@"BlockManager: Warning: allowlist scraper took %f seconds on %@", scrapeTime, entry.hostname);
+        }
+        for (SCBlockEntry* scrapedEntry in scrapedEntries) {
+            [self enqueueBlockEntry: scrapedEntry];
+        }
+    }];
+}
+
 - (void)enqueueBlockEntry:(SCBlockEntry*)entry {
 	NSBlockOperation* op = [NSBlockOperation blockOperationWithBlock:^{
         [self addBlockEntry: entry];
@@ -233,6 +276,9 @@ BOOL appendMode = NO;
     for (SCBlockEntry* relatedEntry in relatedEntries) {
         [self enqueueBlockEntry: relatedEntry];
     }
+    if (isAllowlist && includeLinkedDomains && ![entry.hostname isValidIPAddress]) {
+        [self scrapeLinkedDomainsForEntry: entry];
+    }
 
     [self addBlockEntry: entry];
 }
@@ -246,6 +292,135 @@ BOOL appendMode = NO;
 	}
 }
 
+// Moves a running blocklist block onto newBlockList without clearing it first.
+// Entries common to both lists stay enforced the whole time.
+- (BOOL)applyBlocklistDelta:(SCBlocklistDelta*)delta toBlocklist:(NSArray<NSString*>*)newBlockList {
+    if (![self resolveBlocklistDelta: delta toBlocklist: newBlockList]) return NO;
+    return [self commitResolvedBlocklistDelta];
+}
+
+// First half of applyBlocklistDelta:toBlocklist: - does all the DNS lookups, into
+// in-memory pf rules only. Nothing on disk or in the app blocker changes until
+// commitResolvedBlocklistDelta, so callers can run this without holding up the daemon.
+// Add-only deltas only resolve the added entries; deltas with removals resolve the
+// whole new list, since the pf rules get swapped out wholesale.
+- (BOOL)resolveBlocklistDelta:(SCBlocklistDelta*)delta toBlocklist:(NSArray<NSString*>*)newBlockList {
+    resolvedDelta = nil;
+    if (isAllowlist) {
+        NSLog(@"ERROR: can't apply blocklist delta to allowlist block");
+        return NO;
+    }
+    if (delta.isEmpty) {
+        resolvedDelta = delta;
+        return YES;
+    }
+
+    NSLog(@"BlockManager: Resolving blocklist delta %@", delta);
+
+    // apps don't need resolving, and the app blocker is shared, so they wait for the commit
+    NSArray<NSString*>* entriesToResolve = delta.hasRemovals ? newBlockList : delta.addedEntries;
+    NSMutableArray<NSString*>* networkEntries = [NSMutableArray arrayWithCapacity: entriesToResolve.count];
+    for (NSString* entryString in entriesToResolve) {
+        SCBlockEntry* entry = [SCBlockEntry entryFromString: entryString];
+        if (entry == nil || [entry isAppEntry]) continue;
+        [networkEntries addObject: entryString];
+    }
+
+    // hosts rules are patched at commit time, so keep addBlockEntry: from touching the hosts file
+    hostsBlockingEnabled = NO;
+    appendMode = NO;
+    [self addBlockEntriesFromStrings: networkEntries];
+    NSDate* startedRunning  = [NSDate date];
+    [self waitForQueuedEntries];
+    NSLog(@"BlockManager: Operation queue ran in %f seconds!", [[NSDate date] timeIntervalSinceDate: startedRunning]);
+
+    resolvedDelta = delta;
+    return YES;
+}
+
+// Second half of applyBlocklistDelta:toBlocklist: - patches the hosts file by set
+// difference, loads the resolved pf rules (appended, or swapped in atomically when
+// the delta has removals), and updates the app blocker.
+- (BOOL)commitResolvedBlocklistDelta {
+    SCBlocklistDelta* delta = resolvedDelta;
+    resolvedDelta = nil;
+    if (delta == nil) {
+        NSLog(@"ERROR: can't commit a blocklist delta that hasn't been resolved");
+        return NO;
+    }
+    if (delta.isEmpty) {
+        NSLog(@"BlockManager: Blocklist delta is empty, nothing to apply");
+        return YES;
+    }
+
+    // the hosts file may have been rewritten while the delta was resolving
+    [hostBlockerSet revertFileContentsToDisk];
+    if(![hostBlockerSet.defaultBlocker containsSelfControlBlock]) {
+        NSLog(@"ERROR: can't apply blocklist delta to hosts block that doesn't yet exist");
+        return NO;
+    }
+
+    NSLog(@"BlockManager: Applying blocklist delta %@", delta);
+
+    for (NSString* entryString in delta.removedEntries) {
+        SCBlockEntry* entry = [SCBlockEntry entryFromString: entryString];
+        if ([entry isAppEntry]) {
+            [self.appBlocker removeBlockedApp: entry.appBundleID];
+        }
+    }
+    for (NSString* entryString in delta.addedEntries) {
+        SCBlockEntry* entry = [SCBlockEntry entryFromString: entryString];
+        if ([entry isAppEntry]) {
+            [self addBlockEntry: entry];
+        }
+    }
+
+    NSMutableSet<NSString*>* wantedDomains = [NSMutableSet set];
+    @synchronized (addedBlockEntries) {
+        for (SCBlockEntry* entry in addedBlockEntries) {
+            if ([entry isAppEntry] || entry.hostname == nil) continue;
+            if ([entry.hostname isEqualToString: @"*"] || entry.port || [entry.hostname isValidIPAddress]) continue;
+            [wantedDomains addObject: entry.hostname];
+        }
+    }
+
+    NSSet<NSString*>* currentDomains = [hostBlockerSet blockedDomainsInExistingBlock];
+    NSMutableSet<NSString*>* missingDomains = [wantedDomains mutableCopy];
+    [missingDomains minusSet: currentDomains];
+    NSMutableSet<NSString*>* staleDomains = [NSMutableSet set];
+    if (delta.hasRemovals) {
+        [staleDomains unionSet: currentDomains];
+        [staleDomains minusSet: wantedDomains];
+    }
+
+    for (NSString* domain in missingDomains) {
+        [hostBlockerSet appendExistingBlockWithRuleForDomain: domain];
+    }
+    [hostBlockerSet removeRulesFromExistingBlockForDomains: staleDomains];
+    [hostBlockerSet writeNewFileContents];
+    hostsBlockingEnabled = YES;
+
+    if (delta.hasRemovals) {
+        [pf replaceRunningBlockRules];
+    } else {
+        [pf appendRulesToRunningBlock];
+    }
+
+    if (self.appBlocker.blockedBundleIDs.count > 0) {
+        [self.appBlocker startMonitoring];
+        [self.appBlocker findAndKillBlockedApps];
+    } else {
+        [self.appBlocker stopMonitoring];
+    }
+
+    NSLog(@"BlockManager: Applied blocklist delta (hosts +%lu -%lu, apps now %lu)",
+          (unsigned long)missingDomains.count,
+          (unsigned long)staleDomains.count,
+          (unsigned long)self.appBlocker.blockedBundleIDs.count);
+
+    return YES;
+}
+
 - (BOOL)clearBlock {
     // Stop app blocker monitoring
     [self.appBlocker stopMonitoring];
@@ -474,17 +649,7 @@ BOOL appendMode = NO;
     
     NSMutableArray<SCBlockEntry*>* relatedEntries = [NSMutableArray array];
 
-    if (isAllowlist && includeLinkedDomains && ![entry.hostname isValidIPAddress]) {
-        NSDate* startedScraping  = [NSDate date];
-        NSArray<SCBlockEntry*>* scrapedEntries = [[AllowlistScraper relatedBlockEntries: entry.hostname] allObjects];
-        NSDate* finishedScraping  = [NSDate date];
-        NSTimeInterval resolutionTime = [finishedScraping timeIntervalSinceDate: startedScraping];
-        if (resolutionTime > 5.0) {
-            NSLog(@"BlockManager: Warning: allowlist scraper took %f seconds on %@", resolutionTime, entry.hostname);
-        }
-        [relatedEntries addObjectsFromArray: scrapedEntries];
-    }
-
+    // linked domains of allowlist entries are scraped asynchronously (see scrapeLinkedDomainsForEntry:)
     if(![entry.hostname isValidIPAddress] && includeCommonSubdomains) {
         NSArray<NSString*>* commonSubdomains = [self commonSubdomainsForHostName: entry.hostname];
 
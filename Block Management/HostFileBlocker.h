@@ -41,6 +41,12 @@
 - (void)addRuleBlockingDomain:(NSString*)domainName;
 - (void)appendExistingBlockWithRuleForDomain:(NSString*)domainName;
 
+// Returns the set of domains currently blocked inside the SelfControl block section
+- (NSSet<NSString*>*)blockedDomainsInExistingBlock;
+// Removes the rules for the given domains from the existing SelfControl block section,
+// leaving the rest of the block (and the rest of the file) untouched
+- (void)removeRulesFromExistingBlockForDomains:(NSSet<NSString*>*)domainNames;
+
 - (BOOL)containsSelfControlBlock;
 
 - (void)removeSelfControlBlock;
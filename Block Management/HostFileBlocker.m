@@ -182,6 +182,73 @@ NSString* const kDefaultHostsFileContents = @"##\n"
     [strLock unlock];
 }
 
+// returns the range between the end of the header line and the start of the footer,
+// or NSNotFound if there's no complete block in the file. Caller must hold strLock.
+- (NSRange)blockBodyRange {
+    NSRange headerRange = [newFileContents rangeOfString: kHostFileBlockerSelfControlHeader];
+    NSRange footerRange = [newFileContents rangeOfString: kHostFileBlockerSelfControlFooter];
+    if (headerRange.location == NSNotFound || footerRange.location == NSNotFound || footerRange.location < NSMaxRange(headerRange)) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+
+    return NSMakeRange(NSMaxRange(headerRange), footerRange.location - NSMaxRange(headerRange));
+}
+
+// rule lines look like "0.0.0.0\tdomain" or "::\tdomain"
+- (NSString*)domainForRuleLine:(NSString*)line {
+    NSRange tabRange = [line rangeOfString: @"\t"];
+    if (tabRange.location == NSNotFound) return nil;
+
+    NSString* domain = [line substringFromIndex: NSMaxRange(tabRange)];
+    return domain.length > 0 ? domain : nil;
+}
+
+- (NSSet<NSString*>*)blockedDomainsInExistingBlock {
+    NSMutableSet<NSString*>* domains = [NSMutableSet set];
+
+    [strLock lock];
+    NSRange bodyRange = [self blockBodyRange];
+    if (bodyRange.location != NSNotFound) {
+        NSString* body = [newFileContents substringWithRange: bodyRange];
+        [body enumerateLinesUsingBlock:^(NSString * _Nonnull line, BOOL * _Nonnull stop) {
+            NSString* domain = [self domainForRuleLine: line];
+            if (domain != nil) [domains addObject: domain];
+        }];
+    }
+    [strLock unlock];
+
+    return domains;
+}
+
+- (void)removeRulesFromExistingBlockForDomains:(NSSet<NSString*>*)domainNames {
+    if (domainNames.count < 1) return;
+
+    [strLock lock];
+    NSRange bodyRange = [self blockBodyRange];
+    if (bodyRange.location == NSNotFound) {
+        NSLog(@"WARNING: can't remove rules from host block because header or footer can't be found");
+    } else {
+        // rebuild only the block body, keeping every line we aren't removing in its original order
+        NSString* body = [newFileContents substringWithRange: bodyRange];
+        NSMutableString* newBody = [NSMutableString stringWithCapacity: body.length];
+        [body enumerateLinesUsingBlock:^(NSString * _Nonnull line, BOOL * _Nonnull stop) {
+            NSString* domain = [self domainForRuleLine: line];
+            if (domain != nil && [domainNames containsObject: domain]) return;
+
+            [newBody appendString: line];
+            [newBody appendString: @"\n"];
+        }];
+
+        // the header is always followed by a newline, which enumerateLinesUsingBlock: doesn't report
+        if (![newBody hasPrefix: @"\n"]) {
+            [newBody insertString: @"\n" atIndex: 0];
+        }
+
+        [newFileContents replaceCharactersInRange: bodyRange withString: newBody];
+    }
+    [strLock unlock];
+}
+
 - (BOOL)containsSelfControlBlock {
 	[strLock lock];
 
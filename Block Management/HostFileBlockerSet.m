@@ -104,6 +104,16 @@
     }
 }
 
+- (NSSet<NSString*>*)blockedDomainsInExistingBlock {
+    // the default blocker is the source of truth; VPN host files mirror it
+    return [self.defaultBlocker blockedDomainsInExistingBlock];
+}
+- (void)removeRulesFromExistingBlockForDomains:(NSSet<NSString*>*)domainNames {
+    for (HostFileBlocker* blocker in self.blockers) {
+        [blocker removeRulesFromExistingBlockForDomains: domainNames];
+    }
+}
+
 - (BOOL)containsSelfControlBlock {
     BOOL ret = NO;
     for (HostFileBlocker* blocker in self.blockers) {
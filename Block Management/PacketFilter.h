@@ -29,5 +29,7 @@
 - (void)enterAppendMode;
 - (void)finishAppending;
 - (int)refreshPFRules;
+- (int)replaceRunningBlockRules;
+- (int)appendRulesToRunningBlock;
 
 @end
@@ -244,6 +244,50 @@ NSFileHandle* appendFileHandle;
     return [task terminationStatus];
 }
 
+// Swaps the running block's anchor rules for the ones collected in `rules`, without
+// tearing down the block first. pfctl loads the new ruleset atomically, so there's
+// no window where neither the old nor the new rules are enforced.
+- (int)replaceRunningBlockRules {
+    NSMutableString* newConfiguration = [NSMutableString stringWithCapacity: 1000];
+    [self addBlockHeader: newConfiguration];
+    [newConfiguration appendString: rules];
+    if (isAllowlist) {
+        [self addAllowlistFooter: newConfiguration];
+    }
+
+    NSString* currentConfiguration = [NSString stringWithContentsOfFile: @"/etc/pf.anchors/org.eyebeam" encoding: NSUTF8StringEncoding error: nil];
+    NSSet<NSString*>* currentLines = [NSSet setWithArray: [currentConfiguration componentsSeparatedByString: @"\n"] ?: @[]];
+    NSSet<NSString*>* newLines = [NSSet setWithArray: [newConfiguration componentsSeparatedByString: @"\n"]];
+    if ([currentLines isEqualToSet: newLines]) {
+        NSLog(@"INFO: pf rules unchanged, skipping reload");
+        return 0;
+    }
+
+    [newConfiguration writeToFile: @"/etc/pf.anchors/org.eyebeam" atomically: true encoding: NSUTF8StringEncoding error: nil];
+    return [self refreshPFRules];
+}
+
+// Appends the rules collected in `rules` to the running block's anchor and reloads it.
+// Used for add-only changes, where the existing rules all stay.
+- (int)appendRulesToRunningBlock {
+    if (isAllowlist) {
+        NSLog(@"WARNING: Can't append rules to allowlist blocks - ignoring");
+        return 0;
+    }
+    if (rules.length < 1) return 0;
+
+    NSFileHandle* fileHandle = [NSFileHandle fileHandleForWritingAtPath: @"/etc/pf.anchors/org.eyebeam"];
+    if (!fileHandle) {
+        NSLog(@"ERROR: Failed to get handle for pf.anchors file while attempting to append rules");
+        return 1;
+    }
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData: [rules dataUsingEncoding: NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+
+    return [self refreshPFRules];
+}
+
 - (void)writePFToken:(NSString*)token error:(NSError**)error {
 	[token writeToFile: @"/etc/SelfControlPFToken" atomically: YES encoding: NSUTF8StringEncoding error: error];
 }
@@ -0,0 +1,45 @@
+//
+//  SCBlocklistDelta.h
+//  SelfControl
+//
+//  Hash-based diff between two blocklists (arrays of entry strings).
+//  Used to apply blocklist changes to a running block in place, instead of
+//  tearing the block down and rebuilding it from scratch.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCBlocklistDelta : NSObject
+
+/// Entries present in the new blocklist but not the old one (in new-list order, deduplicated)
+@property (nonatomic, readonly) NSArray<NSString*>* addedEntries;
+
+/// Entries present in the old blocklist but not the new one (in old-list order, deduplicated)
+@property (nonatomic, readonly) NSArray<NSString*>* removedEntries;
+
+/// Number of distinct entries present in both lists
+@property (nonatomic, readonly) NSUInteger unchangedCount;
+
+/// YES if both lists contain the same set of entries
+@property (nonatomic, readonly) BOOL isEmpty;
+
+/// YES if applying this delta would remove anything from the running block
+@property (nonatomic, readonly) BOOL hasRemovals;
+
+/// Computes the delta between two blocklists in O(n + m).
+/// Non-string items (e.g. legacy dictionary entries) are ignored.
++ (instancetype)deltaFromBlocklist:(nullable NSArray<NSString*>*)oldBlocklist
+                       toBlocklist:(nullable NSArray<NSString*>*)newBlocklist;
+
+/// Returns a copy of this delta with the same additions and no removals
+- (SCBlocklistDelta*)deltaByDroppingRemovals;
+
+/// Returns oldBlocklist with only the added entries appended (removals are not applied).
+/// This is the blocklist actually enforced after an add-only update.
+- (NSArray<NSString*>*)blocklistByApplyingAdditionsToBlocklist:(nullable NSArray<NSString*>*)oldBlocklist;
+
+@end
+
+NS_ASSUME_NONNULL_END
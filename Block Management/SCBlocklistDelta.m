@@ -0,0 +1,86 @@
+//
+//  SCBlocklistDelta.m
+//  SelfControl
+//
+
+#import "SCBlocklistDelta.h"
+
+@interface SCBlocklistDelta ()
+@property (nonatomic, readwrite) NSArray<NSString*>* addedEntries;
+@property (nonatomic, readwrite) NSArray<NSString*>* removedEntries;
+@property (nonatomic, readwrite) NSUInteger unchangedCount;
+@end
+
+@implementation SCBlocklistDelta
+
++ (instancetype)deltaFromBlocklist:(NSArray<NSString*>*)oldBlocklist toBlocklist:(NSArray<NSString*>*)newBlocklist {
+    SCBlocklistDelta* delta = [SCBlocklistDelta new];
+
+    // NSOrderedSet gives us hash lookups while keeping the original list order for logging/UI
+    NSOrderedSet<NSString*>* oldSet = [SCBlocklistDelta orderedEntrySetFromBlocklist: oldBlocklist];
+    NSOrderedSet<NSString*>* newSet = [SCBlocklistDelta orderedEntrySetFromBlocklist: newBlocklist];
+
+    NSMutableArray<NSString*>* added = [NSMutableArray array];
+    NSUInteger unchanged = 0;
+    for (NSString* entry in newSet) {
+        if ([oldSet containsObject: entry]) {
+            unchanged++;
+        } else {
+            [added addObject: entry];
+        }
+    }
+
+    NSMutableArray<NSString*>* removed = [NSMutableArray array];
+    for (NSString* entry in oldSet) {
+        if (![newSet containsObject: entry]) {
+            [removed addObject: entry];
+        }
+    }
+
+    delta.addedEntries = added;
+    delta.removedEntries = removed;
+    delta.unchangedCount = unchanged;
+
+    return delta;
+}
+
++ (NSOrderedSet<NSString*>*)orderedEntrySetFromBlocklist:(NSArray<NSString*>*)blocklist {
+    NSMutableOrderedSet<NSString*>* set = [NSMutableOrderedSet orderedSetWithCapacity: blocklist.count];
+    for (id entry in blocklist) {
+        if (![entry isKindOfClass: [NSString class]] || [entry length] == 0) continue;
+
+        [set addObject: entry];
+    }
+    return set;
+}
+
+- (BOOL)isEmpty {
+    return self.addedEntries.count == 0 && self.removedEntries.count == 0;
+}
+
+- (BOOL)hasRemovals {
+    return self.removedEntries.count > 0;
+}
+
+- (SCBlocklistDelta*)deltaByDroppingRemovals {
+    SCBlocklistDelta* delta = [SCBlocklistDelta new];
+    delta.addedEntries = self.addedEntries;
+    delta.removedEntries = @[];
+    delta.unchangedCount = self.unchangedCount;
+    return delta;
+}
+
+- (NSArray<NSString*>*)blocklistByApplyingAdditionsToBlocklist:(NSArray<NSString*>*)oldBlocklist {
+    NSMutableArray<NSString*>* result = [NSMutableArray arrayWithArray: oldBlocklist ?: @[]];
+    [result addObjectsFromArray: self.addedEntries];
+    return result;
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat: @"<SCBlocklistDelta: +%lu -%lu =%lu>",
+            (unsigned long)self.addedEntries.count,
+            (unsigned long)self.removedEntries.count,
+            (unsigned long)self.unchangedCount];
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  SCIntervalSet.h
+//  SelfControl
+//
+//  Immutable set of minutes stored as sorted, disjoint, half-open [start, end) intervals.
+//  Touching or overlapping intervals are coalesced on construction, so two sets with the
+//  same minutes always have the same intervals. Set operations are a single linear merge.
+//
+
+#import <Foundation/Foundation.h>
+
+@class SCTimeRange;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCIntervalSet : NSObject <NSCopying>
+
++ (instancetype)emptySet;
+
+/// Set holding the minutes [interval.location, NSMaxRange(interval))
++ (instancetype)setWithInterval:(NSRange)interval;
+
+/// Normalizes the given intervals (any order, overlapping or touching); empty intervals are dropped
++ (instancetype)setWithIntervals:(const NSRange *)intervals count:(NSUInteger)count;
+
+/// Minutes of the day covered by ranges, treating each as [start, end). Overnight ranges
+/// (end before start) cover both the end of the day and its start, like durationMinutes.
+/// Everything is clipped to 00:00-24:00.
++ (instancetype)setWithTimeRanges:(NSArray<SCTimeRange *> *)ranges;
+
+/// Number of disjoint intervals
+@property (nonatomic, readonly) NSUInteger intervalCount;
+
+/// Number of minutes in the set
+@property (nonatomic, readonly) NSUInteger totalLength;
+
+@property (nonatomic, readonly, getter=isEmpty) BOOL empty;
+
+- (NSRange)intervalAtIndex:(NSUInteger)index;
+
+- (BOOL)containsMinute:(NSUInteger)minute;
+
+/// YES if any minute of interval is in the set (always NO for an empty interval)
+- (BOOL)intersectsInterval:(NSRange)interval;
+
+- (BOOL)intersectsSet:(SCIntervalSet *)other;
+- (BOOL)isSubsetOfSet:(SCIntervalSet *)other;
+
+- (SCIntervalSet *)setByUnioningWithSet:(SCIntervalSet *)other;
+- (SCIntervalSet *)setByIntersectingWithSet:(SCIntervalSet *)other;
+- (SCIntervalSet *)setBySubtractingSet:(SCIntervalSet *)other;
+- (SCIntervalSet *)setByAddingInterval:(NSRange)interval;
+
+/// Minutes of bounds that are not in the set
+- (SCIntervalSet *)setByComplementingInInterval:(NSRange)bounds;
+
+- (void)enumerateIntervalsUsingBlock:(void (NS_NOESCAPE ^)(NSRange interval, BOOL *stop))block;
+
+/// One SCTimeRange per interval ("HH:mm", with 24:00 for an interval running to midnight)
+- (NSArray<SCTimeRange *> *)timeRanges;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,291 @@
+//
+//  SCIntervalSet.m
+//  SelfControl
+//
+
+#import "SCIntervalSet.h"
+#import "SCTimeRange.h"
+
+static const NSUInteger kMinutesPerDay = 24 * 60;
+
+typedef NS_ENUM(NSInteger, SCIntervalSetOperation) {
+    SCIntervalSetOperationUnion,
+    SCIntervalSetOperationIntersection,
+    SCIntervalSetOperationDifference
+};
+
+@interface SCIntervalSet () {
+    // boundaries_[2i] and boundaries_[2i + 1] are the start and end of interval i,
+    // strictly increasing across the whole array (intervals never touch)
+    NSUInteger *boundaries_;
+    NSUInteger count_;
+    NSUInteger totalLength_;
+}
+@end
+
+static int SCCompareIntervalStarts(const void *a, const void *b) {
+    NSUInteger x = ((const NSUInteger *)a)[0];
+    NSUInteger y = ((const NSUInteger *)b)[0];
+    return (x > y) - (x < y);
+}
+
+@implementation SCIntervalSet
+
+// takes ownership of boundaries, which must already be normalized
+- (instancetype)initWithBoundaries:(NSUInteger *)boundaries count:(NSUInteger)count {
+    if (self = [super init]) {
+        boundaries_ = boundaries;
+        count_ = count;
+        for (NSUInteger i = 0; i < count; i++) {
+            totalLength_ += boundaries[2 * i + 1] - boundaries[2 * i];
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(boundaries_);
+}
+
++ (instancetype)emptySet {
+    return [[SCIntervalSet alloc] initWithBoundaries:NULL count:0];
+}
+
++ (instancetype)setWithInterval:(NSRange)interval {
+    return [self setWithIntervals:&interval count:1];
+}
+
++ (instancetype)setWithIntervals:(const NSRange *)intervals count:(NSUInteger)count {
+    NSUInteger *boundaries = malloc(sizeof(NSUInteger) * 2 * MAX(count, 1));
+    NSUInteger pairs = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (intervals[i].length == 0) continue;
+        boundaries[2 * pairs] = intervals[i].location;
+        boundaries[2 * pairs + 1] = (intervals[i].length > NSUIntegerMax - intervals[i].location) ? NSUIntegerMax : NSMaxRange(intervals[i]);
+        pairs++;
+    }
+    qsort(boundaries, pairs, sizeof(NSUInteger) * 2, SCCompareIntervalStarts);
+
+    // coalesce anything that overlaps or touches the interval before it
+    NSUInteger merged = 0;
+    for (NSUInteger i = 0; i < pairs; i++) {
+        NSUInteger start = boundaries[2 * i];
+        NSUInteger end = boundaries[2 * i + 1];
+        if (merged > 0 && start <= boundaries[2 * merged - 1]) {
+            boundaries[2 * merged - 1] = MAX(boundaries[2 * merged - 1], end);
+        } else {
+            boundaries[2 * merged] = start;
+            boundaries[2 * merged + 1] = end;
+            merged++;
+        }
+    }
+
+    return [[SCIntervalSet alloc] initWithBoundaries:boundaries count:merged];
+}
+
++ (instancetype)setWithTimeRanges:(NSArray<SCTimeRange *> *)ranges {
+    NSRange *intervals = malloc(sizeof(NSRange) * 2 * MAX(ranges.count, 1));
+    NSUInteger count = 0;
+    for (SCTimeRange *range in ranges) {
+        NSUInteger start = (NSUInteger)MAX(0, MIN([range startMinutes], (NSInteger)kMinutesPerDay));
+        NSUInteger end = (NSUInteger)MAX(0, MIN([range endMinutes], (NSInteger)kMinutesPerDay));
+        if (start <= end) {
+            intervals[count++] = NSMakeRange(start, end - start);
+        } else {
+            // overnight: runs to midnight, then from midnight
+            intervals[count++] = NSMakeRange(start, kMinutesPerDay - start);
+            intervals[count++] = NSMakeRange(0, end);
+        }
+    }
+
+    SCIntervalSet *set = [self setWithIntervals:intervals count:count];
+    free(intervals);
+    return set;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    // immutable
+    return self;
+}
+
+#pragma mark - Queries
+
+- (NSUInteger)intervalCount {
+    return count_;
+}
+
+- (NSUInteger)totalLength {
+    return totalLength_;
+}
+
+- (BOOL)isEmpty {
+    return count_ == 0;
+}
+
+- (NSRange)intervalAtIndex:(NSUInteger)index {
+    if (index >= count_) {
+        [NSException raise:NSRangeException format:@"Interval index %lu beyond count %lu", (unsigned long)index, (unsigned long)count_];
+    }
+    return NSMakeRange(boundaries_[2 * index], boundaries_[2 * index + 1] - boundaries_[2 * index]);
+}
+
+// index of the first interval whose end is after minute, or count_ if there isn't one
+- (NSUInteger)indexOfFirstIntervalEndingAfter:(NSUInteger)minute {
+    NSUInteger lo = 0, hi = count_;
+    while (lo < hi) {
+        NSUInteger mid = lo + (hi - lo) / 2;
+        if (boundaries_[2 * mid + 1] <= minute) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+- (BOOL)containsMinute:(NSUInteger)minute {
+    NSUInteger i = [self indexOfFirstIntervalEndingAfter:minute];
+    return i < count_ && boundaries_[2 * i] <= minute;
+}
+
+- (BOOL)intersectsInterval:(NSRange)interval {
+    if (interval.length == 0) return NO;
+    NSUInteger i = [self indexOfFirstIntervalEndingAfter:interval.location];
+    return i < count_ && boundaries_[2 * i] < NSMaxRange(interval);
+}
+
+- (BOOL)intersectsSet:(SCIntervalSet *)other {
+    NSUInteger i = 0, j = 0;
+    while (i < count_ && j < other->count_) {
+        if (boundaries_[2 * i] < other->boundaries_[2 * j + 1] && other->boundaries_[2 * j] < boundaries_[2 * i + 1]) {
+            return YES;
+        }
+        // drop whichever interval ends first; it can't meet anything later in the other set
+        if (boundaries_[2 * i + 1] <= other->boundaries_[2 * j + 1]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+    return NO;
+}
+
+- (BOOL)isSubsetOfSet:(SCIntervalSet *)other {
+    if (totalLength_ > other->totalLength_) return NO;
+
+    // other's intervals never touch, so each of ours has to sit inside a single one of them
+    NSUInteger j = 0;
+    for (NSUInteger i = 0; i < count_; i++) {
+        NSUInteger start = boundaries_[2 * i];
+        NSUInteger end = boundaries_[2 * i + 1];
+        while (j < other->count_ && other->boundaries_[2 * j + 1] <= start) j++;
+        if (j == other->count_ || other->boundaries_[2 * j] > start || other->boundaries_[2 * j + 1] < end) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+#pragma mark - Set Operations
+
+// one pass over both boundary lists, tracking whether we're inside each set;
+// a boundary goes into the result wherever the operation's answer flips
+- (SCIntervalSet *)setByCombiningWithSet:(SCIntervalSet *)other operation:(SCIntervalSetOperation)operation {
+    NSUInteger aCount = 2 * count_, bCount = 2 * other->count_;
+    const NSUInteger *a = boundaries_, *b = other->boundaries_;
+    NSUInteger *result = malloc(sizeof(NSUInteger) * MAX(aCount + bCount, 2));
+    NSUInteger resultCount = 0;
+    NSUInteger ai = 0, bi = 0;
+    BOOL inside = NO;
+
+    while (ai < aCount || bi < bCount) {
+        NSUInteger x = MIN(ai < aCount ? a[ai] : NSUIntegerMax, bi < bCount ? b[bi] : NSUIntegerMax);
+        if (ai < aCount && a[ai] == x) ai++;
+        if (bi < bCount && b[bi] == x) bi++;
+
+        // having passed an odd number of boundaries means we're inside an interval
+        BOOL inA = (ai & 1), inB = (bi & 1);
+        BOOL nowInside = NO;
+        switch (operation) {
+            case SCIntervalSetOperationUnion: nowInside = inA || inB; break;
+            case SCIntervalSetOperationIntersection: nowInside = inA && inB; break;
+            case SCIntervalSetOperationDifference: nowInside = inA && !inB; break;
+        }
+
+        if (nowInside != inside) {
+            result[resultCount++] = x;
+            inside = nowInside;
+        }
+    }
+
+    return [[SCIntervalSet alloc] initWithBoundaries:result count:resultCount / 2];
+}
+
+- (SCIntervalSet *)setByUnioningWithSet:(SCIntervalSet *)other {
+    if (other->count_ == 0) return self;
+    if (count_ == 0) return other;
+    return [self setByCombiningWithSet:other operation:SCIntervalSetOperationUnion];
+}
+
+- (SCIntervalSet *)setByIntersectingWithSet:(SCIntervalSet *)other {
+    return [self setByCombiningWithSet:other operation:SCIntervalSetOperationIntersection];
+}
+
+- (SCIntervalSet *)setBySubtractingSet:(SCIntervalSet *)other {
+    if (other->count_ == 0) return self;
+    return [self setByCombiningWithSet:other operation:SCIntervalSetOperationDifference];
+}
+
+- (SCIntervalSet *)setByAddingInterval:(NSRange)interval {
+    return [self setByUnioningWithSet:[SCIntervalSet setWithInterval:interval]];
+}
+
+- (SCIntervalSet *)setByComplementingInInterval:(NSRange)bounds {
+    return [[SCIntervalSet setWithInterval:bounds] setBySubtractingSet:self];
+}
+
+#pragma mark - Enumeration
+
+- (void)enumerateIntervalsUsingBlock:(void (NS_NOESCAPE ^)(NSRange interval, BOOL *stop))block {
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < count_ && !stop; i++) {
+        block(NSMakeRange(boundaries_[2 * i], boundaries_[2 * i + 1] - boundaries_[2 * i]), &stop);
+    }
+}
+
+- (NSArray<SCTimeRange *> *)timeRanges {
+    NSMutableArray<SCTimeRange *> *ranges = [NSMutableArray arrayWithCapacity:count_];
+    for (NSUInteger i = 0; i < count_; i++) {
+        NSUInteger start = boundaries_[2 * i];
+        NSUInteger end = boundaries_[2 * i + 1];
+        [ranges addObject:[SCTimeRange rangeWithStart:[NSString stringWithFormat:@"%02lu:%02lu", (unsigned long)(start / 60), (unsigned long)(start % 60)]
+                                                  end:[NSString stringWithFormat:@"%02lu:%02lu", (unsigned long)(end / 60), (unsigned long)(end % 60)]]];
+    }
+    return ranges;
+}
+
+#pragma mark - Equality
+
+- (BOOL)isEqual:(id)object {
+    if (self == object) return YES;
+    if (![object isKindOfClass:[SCIntervalSet class]]) return NO;
+
+    SCIntervalSet *other = (SCIntervalSet *)object;
+    return count_ == other->count_ && (count_ == 0 || memcmp(boundaries_, other->boundaries_, sizeof(NSUInteger) * 2 * count_) == 0);
+}
+
+- (NSUInteger)hash {
+    NSUInteger hash = count_;
+    for (NSUInteger i = 0; i < 2 * count_; i++) hash = hash * 31 + boundaries_[i];
+    return hash;
+}
+
+- (NSString *)description {
+    NSMutableArray<NSString *> *parts = [NSMutableArray arrayWithCapacity:count_];
+    for (NSUInteger i = 0; i < count_; i++) {
+        [parts addObject:[NSString stringWithFormat:@"[%lu, %lu)", (unsigned long)boundaries_[2 * i], (unsigned long)boundaries_[2 * i + 1]]];
+    }
+    return [NSString stringWithFormat:@"<SCIntervalSet: %@>", [parts componentsJoinedByString:@" "]];
+}
+
+@end
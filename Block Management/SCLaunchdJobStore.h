@@ -0,0 +1,56 @@
+//
+//  SCLaunchdJobStore.h
+//  SelfControl
+//
+//  Batched install and removal of launchd schedule jobs. Plists are written in parallel,
+//  loaded and unloaded with as few launchctl runs as possible, and the installed labels are
+//  kept in an index file so finding jobs never needs a scan of ~/Library/LaunchAgents.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCLaunchdJobStore : NSObject
+
+/// Shared store for the user's LaunchAgents, indexed in the Schedules directory, using /bin/launchctl
++ (instancetype)defaultStore;
+
+/// launchctlPath only needs to understand `load <plist>...` and `unload <plist>...`,
+/// so tests can point it at a fake
+- (instancetype)initWithLaunchAgentsDirectory:(NSURL *)launchAgentsDirectory
+                                     indexURL:(NSURL *)indexURL
+                                 launchctlPath:(NSString *)launchctlPath;
+
+@property (nonatomic, readonly) NSURL *launchAgentsDirectory;
+@property (nonatomic, readonly) NSURL *indexURL;
+@property (nonatomic, readonly) NSString *launchctlPath;
+
+/// Most plists passed to a single launchctl run (keeps the argument list well under ARG_MAX)
+@property (nonatomic, assign) NSUInteger maxPlistsPerInvocation;
+
+/// Writes every plist (label -> launchd plist) and loads them all. expirationDates (label -> date
+/// the job is no longer needed) go into the index for -labelsExpiredBeforeDate:.
+/// Jobs are only indexed once loaded. On failure nothing new is indexed: the plists are unloaded
+/// (in case an earlier batch made it in) and deleted again.
+- (BOOL)installJobs:(NSDictionary<NSString *, NSDictionary *> *)plistsByLabel
+    expirationDates:(nullable NSDictionary<NSString *, NSDate *> *)expirationDates
+              error:(NSError **)error;
+
+/// Unloads the jobs and deletes their plists. Unload failures are ignored (the job
+/// may never have been loaded), but a plist that can't be deleted stays indexed.
+- (BOOL)removeJobsWithLabels:(NSArray<NSString *> *)labels error:(NSError **)error;
+
+/// All indexed labels, sorted
+- (NSArray<NSString *> *)installedLabels;
+
+- (NSArray<NSString *> *)installedLabelsWithPrefix:(NSString *)prefix;
+
+/// Indexed jobs whose expiration date is before date
+- (NSArray<NSString *> *)labelsExpiredBeforeDate:(NSDate *)date;
+
+- (nullable NSURL *)plistURLForLabel:(NSString *)label;
+
+@end
+
+NS_ASSUME_NONNULL_END
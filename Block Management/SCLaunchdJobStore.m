@@ -0,0 +1,294 @@
+//
+//  SCLaunchdJobStore.m
+//  SelfControl
+//
+
+#import "SCLaunchdJobStore.h"
+#import "SCScheduleLaunchdBridge.h"
+
+static const NSInteger kJobIndexFormatVersion = 1;
+
+@interface SCLaunchdJobStore ()
+// label -> index entry (ExpirationDate, if known); nil until first loaded
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *jobIndex;
+@end
+
+@implementation SCLaunchdJobStore
+
++ (instancetype)defaultStore {
+    // shared, so every bridge sees the same in-memory index
+    static SCLaunchdJobStore *defaultStore = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL *indexURL = [[SCScheduleLaunchdBridge schedulesDirectory] URLByAppendingPathComponent:@"InstalledJobs.plist"];
+        defaultStore = [[SCLaunchdJobStore alloc] initWithLaunchAgentsDirectory:[SCScheduleLaunchdBridge launchAgentsDirectory]
+                                                                       indexURL:indexURL
+                                                                  launchctlPath:@"/bin/launchctl"];
+    });
+    return defaultStore;
+}
+
+- (instancetype)initWithLaunchAgentsDirectory:(NSURL *)launchAgentsDirectory
+                                     indexURL:(NSURL *)indexURL
+                                 launchctlPath:(NSString *)launchctlPath {
+    if (self = [super init]) {
+        _launchAgentsDirectory = launchAgentsDirectory;
+        _indexURL = indexURL;
+        _launchctlPath = [launchctlPath copy];
+        _maxPlistsPerInvocation = 100;
+    }
+    return self;
+}
+
+- (nullable NSURL *)plistURLForLabel:(NSString *)label {
+    // labels become file names, so anything that could escape the directory is refused
+    if (label.length == 0 || [label containsString:@"/"] || [label hasPrefix:@"."]) {
+        return nil;
+    }
+    return [self.launchAgentsDirectory URLByAppendingPathComponent:[label stringByAppendingPathExtension:@"plist"]];
+}
+
+#pragma mark - Index
+
+// Must be called while synchronized on self
+- (NSMutableDictionary<NSString *, NSDictionary *> *)loadedIndex {
+    if (self.jobIndex) return self.jobIndex;
+
+    NSDictionary *stored = [NSDictionary dictionaryWithContentsOfURL:self.indexURL];
+    if ([stored[@"FormatVersion"] integerValue] == kJobIndexFormatVersion && [stored[@"Jobs"] isKindOfClass:[NSDictionary class]]) {
+        self.jobIndex = [stored[@"Jobs"] mutableCopy];
+    } else {
+        // first run with an index (or it was lost): one last scan to pick up existing jobs
+        self.jobIndex = [self indexFromLaunchAgentsDirectory];
+        [self saveIndex];
+    }
+    return self.jobIndex;
+}
+
+- (NSMutableDictionary<NSString *, NSDictionary *> *)indexFromLaunchAgentsDirectory {
+    NSMutableDictionary<NSString *, NSDictionary *> *index = [NSMutableDictionary dictionary];
+    NSString *prefix = [[SCScheduleLaunchdBridge jobLabelPrefix] stringByAppendingString:@"."];
+    NSArray<NSURL *> *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.launchAgentsDirectory
+                                                               includingPropertiesForKeys:nil
+                                                                                  options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                                    error:nil];
+    NSISO8601DateFormatter *isoFormatter = [[NSISO8601DateFormatter alloc] init];
+    for (NSURL *fileURL in contents) {
+        NSString *filename = fileURL.lastPathComponent;
+        if (![filename hasPrefix:prefix] || ![filename.pathExtension isEqualToString:@"plist"]) continue;
+
+        // end date is either --enddate=<date> (segment jobs) or --enddate <date> (bundle jobs)
+        NSDate *endDate = nil;
+        NSArray *args = [NSDictionary dictionaryWithContentsOfURL:fileURL][@"ProgramArguments"];
+        for (NSUInteger i = 0; i < args.count; i++) {
+            if (![args[i] isKindOfClass:[NSString class]]) continue;
+            if ([args[i] hasPrefix:@"--enddate="]) {
+                endDate = [isoFormatter dateFromString:[args[i] substringFromIndex:10]];
+            } else if ([args[i] isEqualToString:@"--enddate"] && i + 1 < args.count) {
+                endDate = [isoFormatter dateFromString:args[i + 1]];
+            }
+        }
+        index[filename.stringByDeletingPathExtension] = endDate ? @{@"ExpirationDate": endDate} : @{};
+    }
+    NSLog(@"SCLaunchdJobStore: Rebuilt job index from %@ (%lu jobs)", self.launchAgentsDirectory.path, (unsigned long)index.count);
+    return index;
+}
+
+// Must be called while synchronized on self
+- (void)saveIndex {
+    NSDictionary *stored = @{
+        @"FormatVersion": @(kJobIndexFormatVersion),
+        @"Jobs": self.jobIndex ?: @{}
+    };
+    NSError *error = nil;
+    [[NSFileManager defaultManager] createDirectoryAtURL:[self.indexURL URLByDeletingLastPathComponent]
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:nil];
+    if (![stored writeToURL:self.indexURL error:&error]) {
+        NSLog(@"WARNING: Failed to write launchd job index to %@: %@", self.indexURL.path, error);
+    }
+}
+
+- (NSArray<NSString *> *)installedLabels {
+    @synchronized (self) {
+        return [[self loadedIndex].allKeys sortedArrayUsingSelector:@selector(compare:)];
+    }
+}
+
+- (NSArray<NSString *> *)installedLabelsWithPrefix:(NSString *)prefix {
+    NSPredicate *hasPrefix = [NSPredicate predicateWithBlock:^BOOL(NSString *label, NSDictionary *bindings) {
+        return [label hasPrefix:prefix];
+    }];
+    return [[self installedLabels] filteredArrayUsingPredicate:hasPrefix];
+}
+
+- (NSArray<NSString *> *)labelsExpiredBeforeDate:(NSDate *)date {
+    NSMutableArray<NSString *> *labels = [NSMutableArray array];
+    @synchronized (self) {
+        NSDictionary<NSString *, NSDictionary *> *index = [self loadedIndex];
+        for (NSString *label in index) {
+            NSDate *expirationDate = index[label][@"ExpirationDate"];
+            if ([expirationDate isKindOfClass:[NSDate class]] && [expirationDate compare:date] == NSOrderedAscending) {
+                [labels addObject:label];
+            }
+        }
+    }
+    return [labels sortedArrayUsingSelector:@selector(compare:)];
+}
+
+#pragma mark - launchctl
+
+// Runs launchctl <subcommand> over the plists, maxPlistsPerInvocation at a time
+- (BOOL)runLaunchctl:(NSString *)subcommand plistURLs:(NSArray<NSURL *> *)plistURLs error:(NSError **)error {
+    NSUInteger batchSize = MAX(self.maxPlistsPerInvocation, 1);
+    for (NSUInteger start = 0; start < plistURLs.count; start += batchSize) {
+        NSArray<NSURL *> *batch = [plistURLs subarrayWithRange:NSMakeRange(start, MIN(batchSize, plistURLs.count - start))];
+
+        NSTask *task = [[NSTask alloc] init];
+        task.executableURL = [NSURL fileURLWithPath:self.launchctlPath];
+        task.arguments = [@[subcommand] arrayByAddingObjectsFromArray:[batch valueForKey:@"path"]];
+
+        NSPipe *errorPipe = [NSPipe pipe];
+        task.standardError = errorPipe;
+
+        NSError *taskError = nil;
+        if (![task launchAndReturnError:&taskError]) {
+            NSLog(@"ERROR: Failed to launch launchctl %@: %@", subcommand, taskError);
+            if (error) *error = taskError;
+            return NO;
+        }
+
+        NSData *errorData = [[errorPipe fileHandleForReading] readDataToEndOfFile];
+        [task waitUntilExit];
+
+        if (task.terminationStatus != 0) {
+            NSString *errorStr = [[NSString alloc] initWithData:errorData encoding:NSUTF8StringEncoding];
+            NSLog(@"ERROR: launchctl %@ failed for %lu jobs: %@", subcommand, (unsigned long)batch.count, errorStr);
+            if (error) {
+                *error = [NSError errorWithDomain:@"SCLaunchdJobStore"
+                                             code:1
+                                         userInfo:@{NSLocalizedDescriptionKey: errorStr.length ? errorStr : [NSString stringWithFormat:@"launchctl %@ failed", subcommand]}];
+            }
+            return NO;
+        }
+    }
+    return YES;
+}
+
+#pragma mark - Install / Remove
+
+- (BOOL)installJobs:(NSDictionary<NSString *, NSDictionary *> *)plistsByLabel
+    expirationDates:(nullable NSDictionary<NSString *, NSDate *> *)expirationDates
+              error:(NSError **)error {
+    if (plistsByLabel.count == 0) return YES;
+
+    NSArray<NSString *> *labels = [plistsByLabel.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    NSMutableArray<NSURL *> *plistURLs = [NSMutableArray arrayWithCapacity:labels.count];
+    for (NSString *label in labels) {
+        NSURL *plistURL = [self plistURLForLabel:label];
+        if (!plistURL) {
+            if (error) {
+                *error = [NSError errorWithDomain:@"SCLaunchdJobStore"
+                                             code:2
+                                         userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Invalid job label %@", label]}];
+            }
+            return NO;
+        }
+        [plistURLs addObject:plistURL];
+    }
+
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.launchAgentsDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    // serializing and writing the plists is independent per job
+    __block NSError *writeError = nil;
+    NSObject *errorLock = [NSObject new];
+    dispatch_apply(labels.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        NSError *jobError = nil;
+        NSData *plistData = [NSPropertyListSerialization dataWithPropertyList:plistsByLabel[labels[i]]
+                                                                       format:NSPropertyListXMLFormat_v1_0
+                                                                      options:0
+                                                                        error:&jobError];
+        if (!plistData || ![plistData writeToURL:plistURLs[i] options:NSDataWritingAtomic error:&jobError]) {
+            @synchronized (errorLock) {
+                if (!writeError) writeError = jobError;
+            }
+        }
+    });
+    if (writeError) {
+        NSLog(@"ERROR: Failed to write launchd plists: %@", writeError);
+        if (error) *error = writeError;
+        [self discardUnindexedPlists:plistURLs];
+        return NO;
+    }
+
+    if (![self runLaunchctl:@"load" plistURLs:plistURLs error:error]) {
+        // an earlier batch may have loaded, and nothing but the index would ever find these again
+        [self runLaunchctl:@"unload" plistURLs:plistURLs error:nil];
+        [self discardUnindexedPlists:plistURLs];
+        return NO;
+    }
+
+    @synchronized (self) {
+        NSMutableDictionary<NSString *, NSDictionary *> *index = [self loadedIndex];
+        for (NSString *label in labels) {
+            NSDate *expirationDate = expirationDates[label];
+            index[label] = expirationDate ? @{@"ExpirationDate": expirationDate} : @{};
+        }
+        [self saveIndex];
+    }
+
+    NSLog(@"SCLaunchdJobStore: Installed %lu launchd jobs", (unsigned long)labels.count);
+    return YES;
+}
+
+// Deletes plists written by a failed install, which were never indexed
+- (void)discardUnindexedPlists:(NSArray<NSURL *> *)plistURLs {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    for (NSURL *plistURL in plistURLs) {
+        NSError *removeError = nil;
+        if (![fm removeItemAtURL:plistURL error:&removeError] && [fm fileExistsAtPath:plistURL.path]) {
+            NSLog(@"WARNING: Failed to remove plist file %@ after a failed install: %@", plistURL.path, removeError);
+        }
+    }
+}
+
+- (BOOL)removeJobsWithLabels:(NSArray<NSString *> *)labels error:(NSError **)error {
+    if (labels.count == 0) return YES;
+
+    NSFileManager *fm = [NSFileManager defaultManager];
+    NSMutableArray<NSString *> *presentLabels = [NSMutableArray arrayWithCapacity:labels.count];
+    NSMutableArray<NSURL *> *plistURLs = [NSMutableArray arrayWithCapacity:labels.count];
+    for (NSString *label in labels) {
+        NSURL *plistURL = [self plistURLForLabel:label];
+        if (plistURL && [fm fileExistsAtPath:plistURL.path]) {
+            [presentLabels addObject:label];
+            [plistURLs addObject:plistURL];
+        }
+    }
+
+    // ignore unload errors - jobs might not be loaded
+    [self runLaunchctl:@"unload" plistURLs:plistURLs error:nil];
+
+    BOOL success = YES;
+    NSMutableSet<NSString *> *removedLabels = [NSMutableSet setWithArray:labels];
+    for (NSUInteger i = 0; i < presentLabels.count; i++) {
+        NSError *removeError = nil;
+        if (![fm removeItemAtURL:plistURLs[i] error:&removeError]) {
+            NSLog(@"ERROR: Failed to remove plist file %@: %@", plistURLs[i].path, removeError);
+            if (error && success) *error = removeError;
+            [removedLabels removeObject:presentLabels[i]];
+            success = NO;
+        }
+    }
+
+    @synchronized (self) {
+        [[self loadedIndex] removeObjectsForKeys:removedLabels.allObjects];
+        [self saveIndex];
+    }
+
+    NSLog(@"SCLaunchdJobStore: Removed %lu launchd jobs", (unsigned long)removedLabels.count);
+    return success;
+}
+
+@end
@@ -0,0 +1,31 @@
+//
+//  SCLinkHostExtractor.h
+//  SelfControl
+//
+//  Pulls the hosts out of a page's href and src attributes as its bytes arrive, without
+//  decoding the page into a string. Only absolute http(s) and protocol-relative URLs
+//  name a host; relative ones are skipped.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCLinkHostExtractor : NSObject
+
+/// excludedHosts are never reported (compared lowercased)
+- (instancetype)initWithExcludedHosts:(nullable NSSet<NSString*>*)excludedHosts;
+
+/// Feeds the next chunk of the page. Attributes split across chunks are picked up once
+/// the rest arrives.
+- (void)appendBytes:(const void*)bytes length:(NSUInteger)length;
+- (void)appendData:(NSData*)data;
+
+/// Lowercased hosts found so far
+@property (nonatomic, readonly) NSSet<NSString*>* hosts;
+
++ (NSSet<NSString*>*)hostsInData:(NSData*)data excludingHosts:(nullable NSSet<NSString*>*)excludedHosts;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,212 @@
+//
+//  SCLinkHostExtractor.m
+//  SelfControl
+//
+
+#import "SCLinkHostExtractor.h"
+
+// bytes kept before an '=' so "href" / "src" (and the whitespace around them) can be checked
+// when a chunk boundary falls just after the name
+static const NSUInteger kAttributeNameContext = 16;
+// an attribute value whose host hasn't ended this far past its '=' isn't waited on any longer
+static const NSUInteger kMaxPendingValueLength = 512;
+static const NSUInteger kMaxHostLength = 253;
+
+typedef NS_ENUM(NSInteger, SCAttributeScanResult) {
+    SCAttributeScanResultDone,
+    // the buffer ended before the host did
+    SCAttributeScanResultIncomplete
+};
+
+static inline BOOL SCIsHTMLSpace(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static inline BOOL SCIsASCIILetter(uint8_t c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline uint8_t SCLowercaseASCII(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+static BOOL SCHasPrefixCaseInsensitive(const uint8_t* bytes, NSUInteger length, const char* prefix) {
+    for (NSUInteger i = 0; prefix[i] != '\0'; i++) {
+        if (i >= length || SCLowercaseASCII(bytes[i]) != (uint8_t)prefix[i]) return NO;
+    }
+    return YES;
+}
+
+// whether all of bytes (maybe none) could be the start of prefix
+static BOOL SCIsCaseInsensitivePrefixOf(const uint8_t* bytes, NSUInteger length, const char* prefix) {
+    if (length > strlen(prefix)) return NO;
+    for (NSUInteger i = 0; i < length; i++) {
+        if (SCLowercaseASCII(bytes[i]) != (uint8_t)prefix[i]) return NO;
+    }
+    return YES;
+}
+
+@implementation SCLinkHostExtractor {
+    NSSet<NSString*>* _excludedHosts;
+    NSMutableSet<NSString*>* _hosts;
+
+    // tail of the previous chunk still needed, and where in it to carry on looking for '='
+    NSMutableData* _carry;
+    NSUInteger _carryScanStart;
+}
+
+- (instancetype)initWithExcludedHosts:(nullable NSSet<NSString*>*)excludedHosts {
+    if (self = [super init]) {
+        NSMutableSet<NSString*>* lowercased = [NSMutableSet setWithCapacity: excludedHosts.count];
+        for (NSString* host in excludedHosts) {
+            [lowercased addObject: host.lowercaseString];
+        }
+        _excludedHosts = lowercased;
+        _hosts = [NSMutableSet set];
+        _carry = [NSMutableData data];
+    }
+    return self;
+}
+
+- (instancetype)init {
+    return [self initWithExcludedHosts: nil];
+}
+
+- (NSSet<NSString*>*)hosts {
+    return [_hosts copy];
+}
+
++ (NSSet<NSString*>*)hostsInData:(NSData*)data excludingHosts:(nullable NSSet<NSString*>*)excludedHosts {
+    SCLinkHostExtractor* extractor = [[SCLinkHostExtractor alloc] initWithExcludedHosts: excludedHosts];
+    [extractor appendData: data];
+    return extractor.hosts;
+}
+
+- (void)appendData:(NSData*)data {
+    [data enumerateByteRangesUsingBlock:^(const void* bytes, NSRange byteRange, BOOL* stop) {
+        [self appendBytes: bytes length: byteRange.length];
+    }];
+}
+
+- (void)appendBytes:(const void*)bytes length:(NSUInteger)length {
+    if (length == 0) return;
+
+    if (_carry.length == 0) {
+        [self scanBuffer: bytes length: length scanStart: 0];
+    } else {
+        NSMutableData* buffer = _carry;
+        [buffer appendBytes: bytes length: length];
+        _carry = [NSMutableData data];
+        [self scanBuffer: buffer.bytes length: buffer.length scanStart: _carryScanStart];
+    }
+}
+
+// Finds each '=' from scanStart on (memchr is vectorized), and reads an attribute at each one.
+// Whatever a later chunk could still need is kept in _carry.
+- (void)scanBuffer:(const uint8_t*)buffer length:(NSUInteger)length scanStart:(NSUInteger)scanStart {
+    NSUInteger position = scanStart;
+    while (position < length) {
+        const uint8_t* equals = memchr(buffer + position, '=', length - position);
+        if (equals == NULL) break;
+
+        NSUInteger equalsIndex = (NSUInteger)(equals - buffer);
+        if ([self scanAttributeAt: equalsIndex inBuffer: buffer length: length] == SCAttributeScanResultIncomplete) {
+            NSUInteger carryStart = equalsIndex > kAttributeNameContext ? equalsIndex - kAttributeNameContext : 0;
+            [_carry appendBytes: buffer + carryStart length: length - carryStart];
+            _carryScanStart = equalsIndex - carryStart;
+            return;
+        }
+        position = equalsIndex + 1;
+    }
+
+    // every '=' has been looked at; keep just enough for a name cut off at the end
+    NSUInteger carryStart = length > kAttributeNameContext ? length - kAttributeNameContext : 0;
+    [_carry appendBytes: buffer + carryStart length: length - carryStart];
+    _carryScanStart = length - carryStart;
+}
+
+- (SCAttributeScanResult)scanAttributeAt:(NSUInteger)equalsIndex inBuffer:(const uint8_t*)buffer length:(NSUInteger)length {
+    // the name before the '=' must be exactly href or src, preceded by whitespace
+    NSInteger nameEnd = (NSInteger)equalsIndex - 1;
+    while (nameEnd >= 0 && SCIsHTMLSpace(buffer[nameEnd])) nameEnd--;
+    NSInteger nameStart = nameEnd;
+    while (nameStart >= 0 && nameEnd - nameStart < 4 && SCIsASCIILetter(buffer[nameStart])) nameStart--;
+    // nameStart is now the byte before the name, which must be whitespace so data-src and the
+    // like don't count
+    if (nameStart < 0 || !SCIsHTMLSpace(buffer[nameStart])) return SCAttributeScanResultDone;
+
+    NSUInteger nameLength = (NSUInteger)(nameEnd - nameStart);
+    const uint8_t* name = buffer + nameStart + 1;
+    BOOL isLinkAttribute = (nameLength == 4 && SCHasPrefixCaseInsensitive(name, 4, "href"))
+        || (nameLength == 3 && SCHasPrefixCaseInsensitive(name, 3, "src"));
+    if (!isLinkAttribute) return SCAttributeScanResultDone;
+
+    NSUInteger valueStart = equalsIndex + 1;
+    while (valueStart < length && SCIsHTMLSpace(buffer[valueStart])) valueStart++;
+    uint8_t quote = 0;
+    if (valueStart < length && (buffer[valueStart] == '"' || buffer[valueStart] == '\'')) {
+        quote = buffer[valueStart++];
+    }
+
+    // "https://" is the longest prefix we need to see
+    NSUInteger available = length - MIN(valueStart, length);
+    NSUInteger hostStart;
+    if (SCHasPrefixCaseInsensitive(buffer + valueStart, available, "http://")) {
+        hostStart = valueStart + 7;
+    } else if (SCHasPrefixCaseInsensitive(buffer + valueStart, available, "https://")) {
+        hostStart = valueStart + 8;
+    } else if (SCHasPrefixCaseInsensitive(buffer + valueStart, available, "//")) {
+        hostStart = valueStart + 2;
+    } else {
+        // a value cut off by the end of the chunk might still turn out to be a link
+        BOOL couldStillMatch = SCIsCaseInsensitivePrefixOf(buffer + valueStart, available, "http://")
+            || SCIsCaseInsensitivePrefixOf(buffer + valueStart, available, "https://")
+            || SCIsCaseInsensitivePrefixOf(buffer + valueStart, available, "//");
+        return couldStillMatch ? [self incompleteUnlessTooLongSince: equalsIndex length: length] : SCAttributeScanResultDone;
+    }
+
+    // up to the end of the authority; userinfo before an '@' and a port after a ':' aren't
+    // part of the host
+    NSUInteger authorityEnd = hostStart;
+    while (authorityEnd < length) {
+        uint8_t c = buffer[authorityEnd];
+        if (c == '@') {
+            hostStart = authorityEnd + 1;
+        } else if (c == '/' || c == '?' || c == '#' || c == '\\' || c == '<' || c == '>'
+                   || c == '"' || c == '\'' || c == quote || SCIsHTMLSpace(c)) {
+            break;
+        }
+        authorityEnd++;
+    }
+    if (authorityEnd == length) return [self incompleteUnlessTooLongSince: equalsIndex length: length];
+
+    const uint8_t* port = memchr(buffer + hostStart, ':', authorityEnd - hostStart);
+    NSUInteger hostEnd = port != NULL ? (NSUInteger)(port - buffer) : authorityEnd;
+
+    [self addHostBytes: buffer + hostStart length: hostEnd - hostStart];
+    return SCAttributeScanResultDone;
+}
+
+- (SCAttributeScanResult)incompleteUnlessTooLongSince:(NSUInteger)equalsIndex length:(NSUInteger)length {
+    return (length - equalsIndex > kMaxPendingValueLength) ? SCAttributeScanResultDone : SCAttributeScanResultIncomplete;
+}
+
+- (void)addHostBytes:(const uint8_t*)bytes length:(NSUInteger)length {
+    if (length == 0 || length > kMaxHostLength) return;
+
+    char host[kMaxHostLength];
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = SCLowercaseASCII(bytes[i]);
+        // anything else (escapes, template syntax, IDNs left unencoded) isn't a host we can block
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '-')) return;
+        host[i] = (char)c;
+    }
+    if (host[0] == '.' || host[length - 1] == '.') return;
+
+    NSString* hostString = [[NSString alloc] initWithBytes: host length: length encoding: NSASCIIStringEncoding];
+    if (![_excludedHosts containsObject: hostString]) {
+        [_hosts addObject: hostString];
+    }
+}
+
+@end
@@ -10,6 +10,8 @@
 #import "SCBlockBundle.h"
 #import "SCWeeklySchedule.h"
 
+@class SCLaunchdJobStore;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /// Represents a calculated block window (inverted from allowed windows)
@@ -39,6 +41,9 @@ NS_ASSUME_NONNULL_BEGIN
 /// Bridge for connecting Weekly Schedule UX to CLI via launchd
 @interface SCScheduleLaunchdBridge : NSObject
 
+/// Installs, removes and indexes the launchd jobs (defaults to +[SCLaunchdJobStore defaultStore])
+@property (nonatomic, strong, null_resettable) SCLaunchdJobStore *jobStore;
+
 #pragma mark - Directory Paths
 
 /// Returns ~/Library/Application Support/SelfControl/Schedules/
@@ -71,16 +76,29 @@ NS_ASSUME_NONNULL_BEGIN
 /// Block windows are the inverse of allowed windows (when blocking should be active)
 /// @param schedule The weekly schedule containing allowed windows
 /// @param day The day to calculate windows for
-/// @param weekOffset 0 = current week, 1 = next week
+/// @param weekOffset 0 = current week, 1 = next week, and so on
 /// @return Array of SCBlockWindow representing when blocks should be active
 - (NSArray<SCBlockWindow *> *)blockWindowsForSchedule:(SCWeeklySchedule *)schedule
                                                   day:(SCDayOfWeek)day
                                            weekOffset:(NSInteger)weekOffset;
 
+/// Same as above, for the week starting on the given Monday. Window boundaries are local
+/// wall-clock times, so they stay put on days when the clocks change.
+- (NSArray<SCBlockWindow *> *)blockWindowsForSchedule:(SCWeeklySchedule *)schedule
+                                                  day:(SCDayOfWeek)day
+                                        weekStartDate:(NSDate *)weekStart;
+
 /// Calculates all block windows for an entire week
 - (NSArray<SCBlockWindow *> *)allBlockWindowsForSchedule:(SCWeeklySchedule *)schedule
                                               weekOffset:(NSInteger)weekOffset;
 
+/// Calculates all block windows for the week starting on the given Monday
+- (NSArray<SCBlockWindow *> *)allBlockWindowsForSchedule:(SCWeeklySchedule *)schedule
+                                           weekStartDate:(NSDate *)weekStart;
+
+/// Start of the week (Monday 00:00) weekOffset weeks from the current one
++ (NSDate *)weekStartDateForOffset:(NSInteger)weekOffset;
+
 #pragma mark - launchd Job Management
 
 /// Installs launchd jobs for a bundle's schedule
@@ -107,9 +125,24 @@ NS_ASSUME_NONNULL_BEGIN
 /// Uninstalls all SelfControl schedule-related launchd jobs
 - (BOOL)uninstallAllScheduleJobs:(NSError **)error;
 
+#pragma mark - Daemon Segment Scheduling
+
+/// What the daemon stores for an approved segment: the merged blocklist of bundles,
+/// isAllowlist, and blockSettings (including SegmentStartDate/SegmentEndDate)
+- (NSDictionary *)approvedScheduleForSegmentWithBundles:(NSArray<SCBlockBundle *> *)bundles
+                                              startDate:(NSDate *)startDate
+                                                endDate:(NSDate *)endDate;
+
+/// Registers segments (segment ID -> approved schedule) with the daemon in a single XPC call.
+/// Each distinct blocklist is sent once, with the segments referring to it by digest.
+/// The daemon starts each one itself when it comes due, including any already in progress.
+/// The daemon must already be installed by the caller.
+- (BOOL)registerSegmentsWithDaemon:(NSDictionary<NSString *, NSDictionary *> *)approvedSchedules error:(NSError **)error;
+
 #pragma mark - Segment-Based Merged Job Installation
 
-/// Writes a merged blocklist file for multiple bundles
+/// Writes a merged blocklist file for multiple bundles. Files are named by the blocklist's
+/// digest, so segments with the same bundle combination share one file, written once.
 /// @param bundles Array of bundles whose entries should be merged
 /// @param segmentID Unique identifier for this merged segment
 /// @param error Error output if write fails
@@ -118,6 +151,13 @@ NS_ASSUME_NONNULL_BEGIN
                                          segmentID:(NSString *)segmentID
                                              error:(NSError **)error;
 
+/// Schedules/{digest}.selfcontrol
++ (NSURL *)mergedBlocklistFileURLForDigest:(NSString *)digest;
+
+/// Deletes merged blocklist files whose digest isn't in digests (e.g. the content hashes
+/// of the committed timeline's segments); returns how many were deleted
+- (NSUInteger)removeMergedBlocklistFilesExceptDigests:(NSSet<NSString *> *)digests;
+
 /// Installs a launchd job for a merged segment
 /// @param bundles Array of bundles contributing to this segment
 /// @param segmentID Unique identifier for this segment
@@ -176,6 +216,10 @@ NS_ASSUME_NONNULL_BEGIN
 /// Unloads a launchd job using launchctl
 - (BOOL)unloadJobWithLabel:(NSString *)label error:(NSError **)error;
 
+/// Unloads and removes several launchd jobs with a single launchctl run,
+/// along with the merged blocklist files of any segment jobs among them
+- (BOOL)removeJobsWithLabels:(NSArray<NSString *> *)labels error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,6 +9,9 @@
 #import "SCBlockFileReaderWriter.h"
 #import "SCXPCClient.h"
 #import "SCMiscUtilities.h"
+#import "SCIntervalSet.h"
+#import "SCLaunchdJobStore.h"
+#import "SCBlocklistStore.h"
 
 #pragma mark - SCBlockWindow Implementation
 
@@ -112,15 +115,17 @@
 - (nullable NSURL *)writeBlocklistFileForBundle:(SCBlockBundle *)bundle error:(NSError **)error {
     NSURL *fileURL = [SCScheduleLaunchdBridge blocklistFileURLForBundleID:bundle.bundleID];
 
-    // Build block info dictionary in the format SCBlockFileReaderWriter expects
+    // Build block info dictionary in the format SCBlockFileReaderWriter expects.
+    // These files are only read back by selfcontrol-cli, so they use the compact format
+    // (smaller, and quicker to decode than a plist, though the CLI still reads every entry).
     NSDictionary *blockInfo = @{
         @"Blocklist": bundle.entries ?: @[],
         @"BlockAsWhitelist": @NO  // Schedules always use blocklist mode
     };
 
-    BOOL success = [SCBlockFileReaderWriter writeBlocklistToFileURL:fileURL
-                                                          blockInfo:blockInfo
-                                                              error:error];
+    BOOL success = [SCBlockFileReaderWriter writeCompactBlocklistToFileURL:fileURL
+                                                                 blockInfo:blockInfo
+                                                                     error:error];
     if (!success) {
         NSLog(@"ERROR: Failed to write blocklist file for bundle %@", bundle.bundleID);
         return nil;
@@ -142,30 +147,42 @@
 
 #pragma mark - Block Window Calculation
 
++ (NSDate *)weekStartDateForOffset:(NSInteger)weekOffset {
+    if (weekOffset == 0) return [SCWeeklySchedule startOfCurrentWeek];
+    return [[NSCalendar currentCalendar] dateByAddingUnit:NSCalendarUnitDay
+                                                    value:weekOffset * 7
+                                                   toDate:[SCWeeklySchedule startOfCurrentWeek]
+                                                  options:0];
+}
+
 - (NSArray<SCBlockWindow *> *)blockWindowsForSchedule:(SCWeeklySchedule *)schedule
                                                   day:(SCDayOfWeek)day
                                            weekOffset:(NSInteger)weekOffset {
+    return [self blockWindowsForSchedule:schedule
+                                     day:day
+                           weekStartDate:[SCScheduleLaunchdBridge weekStartDateForOffset:weekOffset]];
+}
+
+- (NSArray<SCBlockWindow *> *)blockWindowsForSchedule:(SCWeeklySchedule *)schedule
+                                                  day:(SCDayOfWeek)day
+                                        weekStartDate:(NSDate *)weekStart {
     NSMutableArray<SCBlockWindow *> *blockWindows = [NSMutableArray array];
 
-    // Get allowed windows for this day (sorted by start time)
+    // Get allowed windows for this day
     NSArray<SCTimeRange *> *allowedWindows = [schedule allowedWindowsForDay:day];
-    allowedWindows = [allowedWindows sortedArrayUsingComparator:^NSComparisonResult(SCTimeRange *a, SCTimeRange *b) {
-        return [@([a startMinutes]) compare:@([b startMinutes])];
-    }];
 
     // Calculate the absolute date for this day
-    NSDate *weekStart = (weekOffset == 0) ? [SCWeeklySchedule startOfCurrentWeek] : [SCWeeklySchedule startOfNextWeek];
     NSCalendar *calendar = [NSCalendar currentCalendar];
 
     // Week starts on Monday (day 1), so adjust: Sunday=6, Mon=0, Tue=1, etc.
     NSInteger daysFromMonday = (day == SCDayOfWeekSunday) ? 6 : (day - 1);
     NSDate *dayDate = [calendar dateByAddingUnit:NSCalendarUnitDay value:daysFromMonday toDate:weekStart options:0];
+    NSDate *startOfDay = [calendar startOfDayForDate:dayDate];
+    NSDate *startOfNextDay = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:startOfDay options:0];
 
     // If no allowed windows, entire day is blocked
     if (allowedWindows.count == 0) {
-        NSDate *startOfDay = [calendar startOfDayForDate:dayDate];
-        NSDate *endOfDay = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:startOfDay options:0];
-        endOfDay = [endOfDay dateByAddingTimeInterval:-1]; // 23:59:59
+        NSDate *endOfDay = [startOfNextDay dateByAddingTimeInterval:-1]; // 23:59:59
 
         SCBlockWindow *window = [SCBlockWindow windowWithStartDate:startOfDay
                                                            endDate:endOfDay
@@ -175,53 +192,44 @@
         return blockWindows;
     }
 
-    // Invert allowed windows to get blocked windows
-    // Walk through the day, creating block windows for gaps between allowed windows
-
-    NSInteger currentMinute = 0; // Start of day
-    NSDate *startOfDay = [calendar startOfDayForDate:dayDate];
-
-    for (SCTimeRange *allowedWindow in allowedWindows) {
-        NSInteger allowStart = [allowedWindow startMinutes];
-        NSInteger allowEnd = [allowedWindow endMinutes];
+    // Invert allowed windows to get blocked windows: each gap left in the day becomes one
+    // block window (overlapping or unsorted allowed windows don't matter here)
+    NSUInteger minutesPerDay = 24 * 60;
+    SCIntervalSet *blockedMinutes = [[SCIntervalSet setWithTimeRanges:allowedWindows] setByComplementingInInterval:NSMakeRange(0, minutesPerDay)];
 
-        // If there's a gap before this allowed window, it's a block window
-        if (currentMinute < allowStart) {
-            NSDate *blockStart = [startOfDay dateByAddingTimeInterval:currentMinute * 60];
-            NSDate *blockEnd = [startOfDay dateByAddingTimeInterval:allowStart * 60];
-
-            SCBlockWindow *window = [SCBlockWindow windowWithStartDate:blockStart
-                                                               endDate:blockEnd
-                                                                   day:day
-                                                          startMinutes:currentMinute];
-            [blockWindows addObject:window];
-        }
-
-        // Move past this allowed window
-        currentMinute = allowEnd;
-    }
+    // Wall-clock times go through the calendar rather than startOfDay + N minutes,
+    // so a 9:00 boundary is still 9:00 on the days clocks change
+    NSDate *(^dateForMinute)(NSInteger) = ^NSDate *(NSInteger minute) {
+        if (minute == 0) return startOfDay;
+        if (minute == (NSInteger)minutesPerDay) return startOfNextDay;
+        return [calendar dateBySettingHour:minute / 60 minute:minute % 60 second:0 ofDate:startOfDay options:NSCalendarMatchNextTime];
+    };
 
-    // If there's time remaining after the last allowed window, it's a block window
-    if (currentMinute < 24 * 60) {
-        NSDate *blockStart = [startOfDay dateByAddingTimeInterval:currentMinute * 60];
-        NSDate *endOfDay = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:startOfDay options:0];
+    [blockedMinutes enumerateIntervalsUsingBlock:^(NSRange gap, BOOL *stop) {
+        NSInteger blockStartMinute = gap.location;
 
-        SCBlockWindow *window = [SCBlockWindow windowWithStartDate:blockStart
-                                                           endDate:endOfDay
+        SCBlockWindow *window = [SCBlockWindow windowWithStartDate:dateForMinute(blockStartMinute)
+                                                           endDate:dateForMinute(NSMaxRange(gap))
                                                                day:day
-                                                      startMinutes:currentMinute];
+                                                      startMinutes:blockStartMinute];
         [blockWindows addObject:window];
-    }
+    }];
 
     return blockWindows;
 }
 
 - (NSArray<SCBlockWindow *> *)allBlockWindowsForSchedule:(SCWeeklySchedule *)schedule
                                               weekOffset:(NSInteger)weekOffset {
+    return [self allBlockWindowsForSchedule:schedule
+                              weekStartDate:[SCScheduleLaunchdBridge weekStartDateForOffset:weekOffset]];
+}
+
+- (NSArray<SCBlockWindow *> *)allBlockWindowsForSchedule:(SCWeeklySchedule *)schedule
+                                           weekStartDate:(NSDate *)weekStart {
     NSMutableArray<SCBlockWindow *> *allWindows = [NSMutableArray array];
 
     for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
-        NSArray<SCBlockWindow *> *dayWindows = [self blockWindowsForSchedule:schedule day:day weekOffset:weekOffset];
+        NSArray<SCBlockWindow *> *dayWindows = [self blockWindowsForSchedule:schedule day:day weekStartDate:weekStart];
         [allWindows addObjectsFromArray:dayWindows];
     }
 
@@ -318,87 +326,68 @@
 
 #pragma mark - launchctl Operations
 
-- (BOOL)loadJobWithLabel:(NSString *)label error:(NSError **)error {
-    NSString *filename = [NSString stringWithFormat:@"%@.plist", label];
-    NSURL *plistURL = [[SCScheduleLaunchdBridge launchAgentsDirectory] URLByAppendingPathComponent:filename];
-
-    NSTask *task = [[NSTask alloc] init];
-    task.executableURL = [NSURL fileURLWithPath:@"/bin/launchctl"];
-    task.arguments = @[@"load", plistURL.path];
-
-    NSPipe *errorPipe = [NSPipe pipe];
-    task.standardError = errorPipe;
-
-    NSError *taskError = nil;
-    [task launchAndReturnError:&taskError];
-    if (taskError) {
-        if (error) *error = taskError;
-        NSLog(@"ERROR: Failed to launch launchctl load: %@", taskError);
-        return NO;
+- (SCLaunchdJobStore *)jobStore {
+    if (!_jobStore) {
+        _jobStore = [SCLaunchdJobStore defaultStore];
     }
+    return _jobStore;
+}
 
-    [task waitUntilExit];
-
-    if (task.terminationStatus != 0) {
-        NSData *errorData = [[errorPipe fileHandleForReading] readDataToEndOfFile];
-        NSString *errorStr = [[NSString alloc] initWithData:errorData encoding:NSUTF8StringEncoding];
-        NSLog(@"ERROR: launchctl load failed for %@: %@", label, errorStr);
+- (BOOL)loadJobWithLabel:(NSString *)label error:(NSError **)error {
+    NSURL *plistURL = [self.jobStore plistURLForLabel:label];
+    NSDictionary *plist = plistURL ? [NSDictionary dictionaryWithContentsOfURL:plistURL] : nil;
+    if (!plist) {
+        NSLog(@"ERROR: No launchd plist to load for %@", label);
         if (error) {
             *error = [NSError errorWithDomain:@"SCScheduleLaunchdBridge"
                                          code:1
-                                     userInfo:@{NSLocalizedDescriptionKey: errorStr ?: @"launchctl load failed"}];
+                                     userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"No launchd plist for %@", label]}];
         }
         return NO;
     }
 
+    if (![self.jobStore installJobs:@{label: plist} expirationDates:nil error:error]) {
+        return NO;
+    }
+
     NSLog(@"SCScheduleLaunchdBridge: Loaded launchd job %@", label);
     return YES;
 }
 
 - (BOOL)unloadJobWithLabel:(NSString *)label error:(NSError **)error {
-    NSString *filename = [NSString stringWithFormat:@"%@.plist", label];
-    NSURL *plistURL = [[SCScheduleLaunchdBridge launchAgentsDirectory] URLByAppendingPathComponent:filename];
-
-    // First unload the job (ignore errors - job might not be loaded)
-    NSTask *unloadTask = [[NSTask alloc] init];
-    unloadTask.executableURL = [NSURL fileURLWithPath:@"/bin/launchctl"];
-    unloadTask.arguments = @[@"unload", plistURL.path];
+    return [self removeJobsWithLabels:@[label] error:error];
+}
 
-    [unloadTask launchAndReturnError:nil];
-    [unloadTask waitUntilExit];
-    // Ignore unload errors - job might not be loaded
+- (BOOL)removeJobsWithLabels:(NSArray<NSString *> *)labels error:(NSError **)error {
+    if (labels.count == 0) return YES;
 
     NSFileManager *fm = [NSFileManager defaultManager];
 
-    // Delete associated blocklist file for merged segment jobs
+    // Delete blocklist files written per segment before merged blocklists were named by digest
+    // (digest-named ones are shared, and removed by -removeMergedBlocklistFilesExceptDigests:)
     // Label format: org.eyebeam.selfcontrol.schedule.merged-{UUID}.{day}.{time}
-    if ([label containsString:@".merged-"]) {
+    for (NSString *label in labels) {
+        if (![label containsString:@".merged-"]) continue;
+
         NSArray *parts = [label componentsSeparatedByString:@".merged-"];
-        if (parts.count > 1) {
-            NSString *remainder = parts[1];  // {UUID}.{day}.{time}
-            NSString *segmentID = [remainder componentsSeparatedByString:@"."].firstObject;
-            if (segmentID.length > 0) {
-                NSURL *blocklistURL = [[SCScheduleLaunchdBridge schedulesDirectory]
-                                       URLByAppendingPathComponent:[NSString stringWithFormat:@"%@.selfcontrol", segmentID]];
-                if ([fm fileExistsAtPath:blocklistURL.path]) {
-                    [fm removeItemAtURL:blocklistURL error:nil];
-                    NSLog(@"SCScheduleLaunchdBridge: Removed merged blocklist file %@", blocklistURL.path);
-                }
+        NSString *remainder = parts[1];  // {UUID}.{day}.{time}
+        NSString *segmentID = [remainder componentsSeparatedByString:@"."].firstObject;
+        if (segmentID.length > 0) {
+            NSURL *blocklistURL = [[SCScheduleLaunchdBridge schedulesDirectory]
+                                   URLByAppendingPathComponent:[NSString stringWithFormat:@"%@.selfcontrol", segmentID]];
+            if ([fm fileExistsAtPath:blocklistURL.path]) {
+                [fm removeItemAtURL:blocklistURL error:nil];
+                NSLog(@"SCScheduleLaunchdBridge: Removed merged blocklist file %@", blocklistURL.path);
             }
         }
     }
 
-    // Then delete the plist file
-    if ([fm fileExistsAtPath:plistURL.path]) {
-        NSError *removeError = nil;
-        if (![fm removeItemAtURL:plistURL error:&removeError]) {
-            if (error) *error = removeError;
-            NSLog(@"ERROR: Failed to remove plist file %@: %@", plistURL.path, removeError);
-            return NO;
-        }
+    // One launchctl unload for the lot, then the plists go
+    if (![self.jobStore removeJobsWithLabels:labels error:error]) {
+        return NO;
     }
 
-    NSLog(@"SCScheduleLaunchdBridge: Unloaded and removed job %@", label);
+    NSLog(@"SCScheduleLaunchdBridge: Unloaded and removed %lu jobs", (unsigned long)labels.count);
     return YES;
 }
 
@@ -481,7 +470,9 @@
     NSLog(@"SCScheduleLaunchdBridge: Installing %lu jobs for bundle %@ (weekOffset=%ld)",
           (unsigned long)blockWindows.count, bundle.bundleID, (long)weekOffset);
 
-    // Create and install a job for each block window
+    // Create a job for each block window, then install them all in one batch
+    NSMutableDictionary<NSString *, NSDictionary *> *plistsByLabel = [NSMutableDictionary dictionary];
+    NSMutableDictionary<NSString *, NSDate *> *expirationDates = [NSMutableDictionary dictionary];
     for (SCBlockWindow *window in blockWindows) {
         // Skip windows that have already passed (for current week)
         if (weekOffset == 0 && [window.startDate timeIntervalSinceNow] < 0) {
@@ -508,29 +499,19 @@
         }
 
         NSString *label = plist[@"Label"];
-
-        // Write plist
-        if (![self writeLaunchdPlist:plist toLabel:label error:error]) {
-            return NO;
-        }
-
-        // Load job
-        if (![self loadJobWithLabel:label error:error]) {
-            return NO;
-        }
+        plistsByLabel[label] = plist;
+        expirationDates[label] = window.endDate;
     }
 
-    return YES;
+    return [self.jobStore installJobs:plistsByLabel expirationDates:expirationDates error:error];
 }
 
 - (BOOL)uninstallJobsForBundleID:(NSString *)bundleID error:(NSError **)error {
     NSArray<NSString *> *labels = [self installedJobLabelsForBundleID:bundleID];
 
-    for (NSString *label in labels) {
-        if (![self unloadJobWithLabel:label error:error]) {
-            // Log but continue trying to unload others
-            NSLog(@"WARNING: Failed to unload job %@", label);
-        }
+    if (![self removeJobsWithLabels:labels error:error]) {
+        // Log but don't fail - whatever couldn't be removed stays indexed for next time
+        NSLog(@"WARNING: Failed to remove some jobs for bundle %@", bundleID);
     }
 
     return YES;
@@ -539,10 +520,8 @@
 - (BOOL)uninstallAllScheduleJobs:(NSError **)error {
     NSArray<NSString *> *labels = [self allInstalledScheduleJobLabels];
 
-    for (NSString *label in labels) {
-        if (![self unloadJobWithLabel:label error:error]) {
-            NSLog(@"WARNING: Failed to unload job %@", label);
-        }
+    if (![self removeJobsWithLabels:labels error:error]) {
+        NSLog(@"WARNING: Failed to remove some schedule jobs");
     }
 
     return YES;
@@ -559,26 +538,7 @@
 }
 
 - (NSArray<NSString *> *)jobLabelsWithPrefix:(NSString *)prefix {
-    NSMutableArray<NSString *> *labels = [NSMutableArray array];
-
-    NSURL *launchAgentsDir = [SCScheduleLaunchdBridge launchAgentsDirectory];
-    NSFileManager *fm = [NSFileManager defaultManager];
-
-    NSArray<NSURL *> *contents = [fm contentsOfDirectoryAtURL:launchAgentsDir
-                                   includingPropertiesForKeys:nil
-                                                      options:NSDirectoryEnumerationSkipsHiddenFiles
-                                                        error:nil];
-
-    for (NSURL *fileURL in contents) {
-        NSString *filename = [fileURL lastPathComponent];
-        if ([filename hasPrefix:prefix] && [filename hasSuffix:@".plist"]) {
-            // Extract label from filename (remove .plist extension)
-            NSString *label = [filename stringByDeletingPathExtension];
-            [labels addObject:label];
-        }
-    }
-
-    return labels;
+    return [self.jobStore installedLabelsWithPrefix:prefix];
 }
 
 #pragma mark - Segment-Based Merged Job Installation
@@ -592,17 +552,23 @@
         [mergedEntries addObjectsFromArray:bundle.entries];
     }
 
-    NSURL *fileURL = [[SCScheduleLaunchdBridge schedulesDirectory]
-                      URLByAppendingPathComponent:[NSString stringWithFormat:@"%@.selfcontrol", segmentID]];
+    NSString *digest = [SCBlocklistStore digestForBlocklist:mergedEntries.array];
+    NSURL *fileURL = [SCScheduleLaunchdBridge mergedBlocklistFileURLForDigest:digest];
+
+    // Content-addressed: if the file exists, it already holds exactly these entries
+    if ([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path]) {
+        NSLog(@"SCScheduleLaunchdBridge: Segment %@ shares merged blocklist %@", segmentID, digest);
+        return fileURL;
+    }
 
     NSDictionary *blockInfo = @{
-        @"Blocklist": mergedEntries.array,
+        @"Blocklist": [SCBlocklistStore canonicalBlocklist:mergedEntries.array],
         @"BlockAsWhitelist": @NO
     };
 
-    BOOL success = [SCBlockFileReaderWriter writeBlocklistToFileURL:fileURL
-                                                          blockInfo:blockInfo
-                                                              error:error];
+    BOOL success = [SCBlockFileReaderWriter writeCompactBlocklistToFileURL:fileURL
+                                                                 blockInfo:blockInfo
+                                                                     error:error];
 
     if (!success) {
         NSLog(@"ERROR: Failed to write merged blocklist for segment %@", segmentID);
@@ -615,25 +581,42 @@
     return fileURL;
 }
 
-- (BOOL)installJobForSegmentWithBundles:(NSArray<SCBlockBundle *> *)bundles
-                              segmentID:(NSString *)segmentID
-                              startDate:(NSDate *)startDate
-                                endDate:(NSDate *)endDate
-                                    day:(SCDayOfWeek)day
-                           startMinutes:(NSInteger)startMinutes
-                             weekOffset:(NSInteger)weekOffset
-                                  error:(NSError **)error {
-    NSString *cliPath = [SCScheduleLaunchdBridge cliPath];
-    if (!cliPath) {
-        NSLog(@"ERROR: Cannot create plist without CLI path");
-        if (error) {
-            *error = [NSError errorWithDomain:@"SCScheduleLaunchdBridge"
-                                         code:1
-                                     userInfo:@{NSLocalizedDescriptionKey: @"CLI path not found"}];
++ (NSURL *)mergedBlocklistFileURLForDigest:(NSString *)digest {
+    return [[SCScheduleLaunchdBridge schedulesDirectory]
+            URLByAppendingPathComponent:[NSString stringWithFormat:@"%@.selfcontrol", digest]];
+}
+
+- (NSUInteger)removeMergedBlocklistFilesExceptDigests:(NSSet<NSString *> *)digests {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    NSCharacterSet *nonHexCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"] invertedSet];
+    NSArray<NSURL *> *contents = [fm contentsOfDirectoryAtURL:[SCScheduleLaunchdBridge schedulesDirectory]
+                                   includingPropertiesForKeys:nil
+                                                      options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                        error:nil];
+
+    NSUInteger removedCount = 0;
+    for (NSURL *fileURL in contents) {
+        if (![fileURL.pathExtension isEqualToString:@"selfcontrol"]) continue;
+
+        // only digest-named files; per-bundle files are named by bundle ID
+        NSString *name = fileURL.lastPathComponent.stringByDeletingPathExtension;
+        if (name.length != 32 || [name rangeOfCharacterFromSet:nonHexCharacters].location != NSNotFound) continue;
+        if ([digests containsObject:name]) continue;
+
+        if ([fm removeItemAtURL:fileURL error:nil]) {
+            removedCount++;
         }
-        return NO;
     }
 
+    if (removedCount > 0) {
+        NSLog(@"SCScheduleLaunchdBridge: Removed %lu unreferenced merged blocklist files", (unsigned long)removedCount);
+    }
+    return removedCount;
+}
+
+- (NSDictionary *)approvedScheduleForSegmentWithBundles:(NSArray<SCBlockBundle *> *)bundles
+                                              startDate:(NSDate *)startDate
+                                                endDate:(NSDate *)endDate {
     // Merge blocklists from all bundles
     NSMutableArray *mergedEntries = [NSMutableArray array];
     for (SCBlockBundle *bundle in bundles) {
@@ -649,19 +632,95 @@
         @"IncludeLinkedDomains": [defaults objectForKey:@"IncludeLinkedDomains"] ?: @YES,
         @"BlockSoundShouldPlay": [defaults objectForKey:@"BlockSoundShouldPlay"] ?: @NO,
         @"BlockSound": [defaults objectForKey:@"BlockSound"] ?: @5,
-        @"EnableErrorReporting": [defaults objectForKey:@"EnableErrorReporting"] ?: @YES
+        @"EnableErrorReporting": [defaults objectForKey:@"EnableErrorReporting"] ?: @YES,
+        // the daemon schedules the segment from these, and uses them to hand a running
+        // block straight over to this segment when the previous one ends
+        @"SegmentStartDate": startDate,
+        @"SegmentEndDate": endDate
+    };
+
+    return @{
+        @"blocklist": mergedEntries,
+        @"isAllowlist": @NO,
+        @"blockSettings": blockSettings
     };
+}
+
+- (BOOL)registerSegmentsWithDaemon:(NSDictionary<NSString *, NSDictionary *> *)approvedSchedules error:(NSError **)error {
+    // The same bundle combinations repeat all week, so each distinct blocklist is sent
+    // once and the segments refer to it by digest
+    SCBlocklistStore *blocklistStore = [[SCBlocklistStore alloc] init];
+    NSMutableDictionary<NSString *, NSDictionary *> *schedules = [NSMutableDictionary dictionaryWithCapacity:approvedSchedules.count];
+    for (NSString *segmentID in approvedSchedules) {
+        NSMutableDictionary *schedule = [approvedSchedules[segmentID] mutableCopy];
+        schedule[@"blocklistDigest"] = [blocklistStore addBlocklist:schedule[@"blocklist"] ?: @[]];
+        [schedule removeObjectForKey:@"blocklist"];
+        schedules[segmentID] = schedule;
+    }
+
+    SCXPCClient *xpc = [SCXPCClient sharedClient];
+    dispatch_semaphore_t registerSema = dispatch_semaphore_create(0);
+    __block NSError *registerError = nil;
+
+    [xpc registerSchedules:schedules
+                blocklists:blocklistStore.blocklists
+            controllingUID:getuid()
+                     reply:^(NSError *err) {
+        registerError = err;
+        dispatch_semaphore_signal(registerSema);
+    }];
+
+    // Use run loop-based wait to avoid deadlock when called from main thread
+    if (![NSThread isMainThread]) {
+        dispatch_semaphore_wait(registerSema, DISPATCH_TIME_FOREVER);
+    } else {
+        while (dispatch_semaphore_wait(registerSema, DISPATCH_TIME_NOW)) {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        }
+    }
+
+    if (registerError) {
+        NSLog(@"ERROR: Failed to register %lu segments with daemon: %@", (unsigned long)approvedSchedules.count, registerError);
+        if (error) *error = registerError;
+        return NO;
+    }
+
+    NSLog(@"SCScheduleLaunchdBridge: Registered %lu segments with daemon (%lu distinct blocklists)",
+          (unsigned long)approvedSchedules.count, (unsigned long)blocklistStore.count);
+    return YES;
+}
+
+- (BOOL)installJobForSegmentWithBundles:(NSArray<SCBlockBundle *> *)bundles
+                              segmentID:(NSString *)segmentID
+                              startDate:(NSDate *)startDate
+                                endDate:(NSDate *)endDate
+                                    day:(SCDayOfWeek)day
+                           startMinutes:(NSInteger)startMinutes
+                             weekOffset:(NSInteger)weekOffset
+                                  error:(NSError **)error {
+    NSString *cliPath = [SCScheduleLaunchdBridge cliPath];
+    if (!cliPath) {
+        NSLog(@"ERROR: Cannot create plist without CLI path");
+        if (error) {
+            *error = [NSError errorWithDomain:@"SCScheduleLaunchdBridge"
+                                         code:1
+                                     userInfo:@{NSLocalizedDescriptionKey: @"CLI path not found"}];
+        }
+        return NO;
+    }
+
+    NSDictionary *approvedSchedule = [self approvedScheduleForSegmentWithBundles:bundles startDate:startDate endDate:endDate];
 
     // Register the schedule with the daemon (daemon must already be installed by caller)
     // The schedule is stored in root-owned settings, so future triggers don't need password
-    SCXPCClient *xpc = [SCXPCClient new];
+    SCXPCClient *xpc = [SCXPCClient sharedClient];
     dispatch_semaphore_t registerSema = dispatch_semaphore_create(0);
     __block NSError *registerError = nil;
 
     [xpc registerScheduleWithID:segmentID
-                      blocklist:mergedEntries
+                      blocklist:approvedSchedule[@"blocklist"]
                     isAllowlist:NO
-                  blockSettings:blockSettings
+                  blockSettings:approvedSchedule[@"blockSettings"]
               controllingUID:getuid()
                           reply:^(NSError *err) {
         registerError = err;
@@ -726,13 +785,8 @@
         @"StandardErrorPath": @"/tmp/selfcontrol-schedule.log"
     };
 
-    // Write plist
-    if (![self writeLaunchdPlist:plist toLabel:label error:error]) {
-        return NO;
-    }
-
-    // Load job
-    if (![self loadJobWithLabel:label error:error]) {
+    // Write and load the job; the end date lets stale-job cleanup find it without reading plists
+    if (![self.jobStore installJobs:@{label: plist} expirationDates:@{label: endDate} error:error]) {
         return NO;
     }
 
@@ -782,7 +836,9 @@
         @"IncludeLinkedDomains": (userDefaults ? userDefaults[@"IncludeLinkedDomains"] : [[NSUserDefaults standardUserDefaults] objectForKey:@"IncludeLinkedDomains"]) ?: @YES,
         @"BlockSoundShouldPlay": (userDefaults ? userDefaults[@"BlockSoundShouldPlay"] : [[NSUserDefaults standardUserDefaults] objectForKey:@"BlockSoundShouldPlay"]) ?: @NO,
         @"BlockSound": (userDefaults ? userDefaults[@"BlockSound"] : [[NSUserDefaults standardUserDefaults] objectForKey:@"BlockSound"]) ?: @5,
-        @"EnableErrorReporting": (userDefaults ? userDefaults[@"EnableErrorReporting"] : [[NSUserDefaults standardUserDefaults] objectForKey:@"EnableErrorReporting"]) ?: @YES
+        @"EnableErrorReporting": (userDefaults ? userDefaults[@"EnableErrorReporting"] : [[NSUserDefaults standardUserDefaults] objectForKey:@"EnableErrorReporting"]) ?: @YES,
+        @"SegmentStartDate": [NSDate date],
+        @"SegmentEndDate": endDate
     };
 
     // If running as daemon (euid == 0), bypass XPC and call SCDaemonBlockMethods directly
@@ -872,31 +928,34 @@
     [debugLog appendFormat:@"Running as app - using XPC\n"];
     [debugLog writeToFile:@"/tmp/selfcontrol_xpc_debug.log" atomically:YES encoding:NSUTF8StringEncoding error:nil];
 
-    SCXPCClient *xpc = [SCXPCClient new];
+    SCXPCClient *xpc = [SCXPCClient sharedClient];
     dispatch_semaphore_t sema = dispatch_semaphore_create(0);
-    __block NSError *xpcError = nil;
+    dispatch_group_t group = dispatch_group_create();
+    __block NSError *registerError = nil;
+    __block NSError *startError = nil;
 
-    // First register the schedule
+    // Register the schedule and start it without waiting in between - the daemon handles
+    // the two in order, and if registering fails the start fails too
+    dispatch_group_enter(group);
     [xpc registerScheduleWithID:segmentID
                       blocklist:mergedEntries
                     isAllowlist:NO
                   blockSettings:blockSettings
               controllingUID:controllingUID
                           reply:^(NSError *err) {
-        if (err) {
-            xpcError = err;
-            dispatch_semaphore_signal(sema);
-            return;
-        }
-
-        // Then start it immediately
-        [xpc startScheduledBlockWithID:segmentID
-                               endDate:endDate
-                                 reply:^(NSError *startErr) {
-            xpcError = startErr;
-            dispatch_semaphore_signal(sema);
-        }];
+        registerError = err;
+        dispatch_group_leave(group);
+    }];
+    dispatch_group_enter(group);
+    [xpc startScheduledBlockWithID:segmentID
+                           endDate:endDate
+                             reply:^(NSError *startErr) {
+        startError = startErr;
+        dispatch_group_leave(group);
     }];
+    dispatch_group_notify(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        dispatch_semaphore_signal(sema);
+    });
 
     // Use run loop-based wait to avoid deadlock when called from main thread
     if (![NSThread isMainThread]) {
@@ -912,6 +971,7 @@
         }
     }
 
+    NSError *xpcError = registerError ?: startError;
     if (xpcError) {
         NSLog(@"ERROR: Failed to start immediate block for segment %@: %@", segmentID, xpcError);
         if (error) *error = xpcError;
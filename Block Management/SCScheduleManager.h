@@ -12,6 +12,8 @@
 #import "SCWeeklySchedule.h"
 #import "SCTimeRange.h"
 
+@class SCScheduleTimeline;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /// Posted when bundles or schedules change
@@ -82,11 +84,15 @@ extern NSNotificationName const SCScheduleManagerDidChangeNotification;
 /// Gets commitment end date for a specific week offset
 - (nullable NSDate *)commitmentEndDateForWeekOffset:(NSInteger)weekOffset;
 
-/// Commits to a specific week (0 = current, 1 = next)
-- (void)commitToWeekWithOffset:(NSInteger)weekOffset;
-
-/// Legacy method - commits to current week
-- (void)commitToWeek;
+/// Commits to a specific week (0 = current, 1 = next) in the background: stale jobs are
+/// cleaned up, segments calculated, the daemon installed (which may prompt for a password)
+/// and the segments registered with it. The returned progress has one unit per stage, with the current
+/// stage in localizedDescription. Cancelling it before registration starts abandons the
+/// commit with NSUserCancelledError; after that it can no longer be cancelled.
+/// Must be called on the main thread; completion is called on the main queue once the
+/// commitment is recorded (or the commit has been abandoned).
+- (NSProgress *)commitToWeekWithOffset:(NSInteger)weekOffset
+                            completion:(nullable void (^)(NSError * _Nullable error))completion;
 
 /// Checks if a change would make the schedule looser (not allowed when committed)
 - (BOOL)changeWouldLoosenSchedule:(SCWeeklySchedule *)oldSchedule
@@ -104,6 +110,15 @@ extern NSNotificationName const SCScheduleManagerDidChangeNotification;
 /// Preserves valid jobs from other weeks, enabling multi-week commits.
 - (void)cleanupStaleScheduleJobs;
 
+#pragma mark - Compiled Timeline
+
+/// Compiles every committed week's merged block segments into one absolute-time timeline
+- (SCScheduleTimeline *)compileCommittedTimeline;
+
+/// The timeline as last compiled (or read from disk). Recompiled and written to
+/// +[SCScheduleTimeline defaultTimelineURL] whenever commitments change.
+@property (nonatomic, readonly, nullable) SCScheduleTimeline *committedTimeline;
+
 #pragma mark - Status Display (UX Only)
 
 /// Returns status string for a specific bundle
@@ -10,6 +10,9 @@
 #import "SCMiscUtilities.h"
 #import "SCSettings.h"
 #import "SCVersionTracker.h"
+#import "SCIntervalSet.h"
+#import "SCScheduleTimeline.h"
+#import "SCLaunchdJobStore.h"
 
 NSNotificationName const SCScheduleManagerDidChangeNotification = @"SCScheduleManagerDidChangeNotification";
 
@@ -17,12 +20,16 @@ NSNotificationName const SCScheduleManagerDidChangeNotification = @"SCScheduleMa
 static NSString * const kBundlesKey = @"SCScheduleBundles";
 static NSString * const kWeekSchedulesPrefix = @"SCWeekSchedules_"; // + week key (e.g., "2024-12-23")
 static NSString * const kWeekCommitmentPrefix = @"SCWeekCommitment_"; // + week key
+static NSString * const kCommitmentWeekKeysKey = @"SCCommitmentWeekKeys"; // week keys with an SCWeekCommitment_ entry
 static NSString * const kCommitmentEndDateKey = @"SCCommitmentEndDate";
 static NSString * const kIsCommittedKey = @"SCIsCommitted";
 static NSString * const kEmergencyUnlockCreditsKey = @"SCEmergencyUnlockCredits";
 static NSString * const kEmergencyUnlockCreditsInitializedKey = @"SCEmergencyUnlockCreditsInitialized";
 static const NSInteger kDefaultEmergencyUnlockCredits = 5;
 
+// cleanup, segments, daemon install, registration
+static const int64_t kCommitStageCount = 4;
+
 @class SCBlockSegment;
 
 @interface SCScheduleManager ()
@@ -30,6 +37,9 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
 @property (nonatomic, strong) NSMutableArray<SCBlockBundle *> *mutableBundles;
 // Cache for week-specific schedules: weekKey -> array of schedules
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<SCWeeklySchedule *> *> *weekSchedulesCache;
+@property (nonatomic, strong, readwrite, nullable) SCScheduleTimeline *committedTimeline;
+// Background stages of a commit run here, one commit at a time
+@property (nonatomic, strong) dispatch_queue_t commitQueue;
 
 // Forward declaration for segment-based merging
 - (NSArray<SCBlockSegment *> *)calculateBlockSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
@@ -42,6 +52,12 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
                                                      weekOffset:(NSInteger)weekOffset
                                                          bridge:(SCScheduleLaunchdBridge *)bridge;
 
+// Variant for any week, given the Monday it starts on
+- (NSArray<SCBlockSegment *> *)calculateBlockSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
+                                                      schedules:(NSArray<SCWeeklySchedule *> *)schedules
+                                                  weekStartDate:(NSDate *)weekStart
+                                                         bridge:(SCScheduleLaunchdBridge *)bridge;
+
 @end
 
 #pragma mark - SCBlockSegment (Internal Helper Class)
@@ -78,6 +94,23 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
 }
 @end
 
+#pragma mark - Segment Sweep Events
+
+/// A window start (delta +1) or end (delta -1) for the segment sweep.
+/// delta is 0 for windows that don't cover any time but still mark a transition.
+typedef struct {
+    int64_t time;   // seconds since reference date
+    int32_t delta;
+    uint32_t bundleIndex;
+    __unsafe_unretained NSDate *date; // owned by the window, which outlives the sweep
+} SCSegmentEvent;
+
+static int SCCompareSegmentEvents(const void *a, const void *b) {
+    int64_t timeA = ((const SCSegmentEvent *)a)->time;
+    int64_t timeB = ((const SCSegmentEvent *)b)->time;
+    return (timeA > timeB) - (timeA < timeB);
+}
+
 #pragma mark - SCScheduleManager Implementation
 
 @implementation SCScheduleManager
@@ -98,6 +131,7 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
     if (self) {
         _mutableBundles = [NSMutableArray array];
         _weekSchedulesCache = [NSMutableDictionary dictionary];
+        _commitQueue = dispatch_queue_create("org.eyebeam.SelfControl.schedulecommit", DISPATCH_QUEUE_SERIAL);
         [self reload];
     }
     return self;
@@ -168,20 +202,12 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
             if ([SCBlockUtilities anyBlockIsRunning]) {
                 NSLog(@"SCScheduleManager: Block is running, updating active blocklist for bundle %@", bundle.name);
 
-                SCXPCClient *xpc = [[SCXPCClient alloc] init];
-                [xpc connectAndExecuteCommandBlock:^(NSError *connectError) {
-                    if (connectError) {
-                        NSLog(@"ERROR: Failed to connect to daemon for blocklist update: %@", connectError);
-                        return;
+                [[SCXPCClient sharedClient] updateBlocklist:bundle.entries reply:^(NSError *updateError) {
+                    if (updateError) {
+                        NSLog(@"ERROR: Failed to update active blocklist: %@", updateError);
+                    } else {
+                        NSLog(@"SCScheduleManager: Successfully updated active blocklist for bundle %@", bundle.name);
                     }
-
-                    [xpc updateBlocklist:bundle.entries reply:^(NSError *updateError) {
-                        if (updateError) {
-                            NSLog(@"ERROR: Failed to update active blocklist: %@", updateError);
-                        } else {
-                            NSLog(@"SCScheduleManager: Successfully updated active blocklist for bundle %@", bundle.name);
-                        }
-                    }];
                 }];
             }
         }
@@ -260,8 +286,10 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
 }
 
 - (NSArray<SCWeeklySchedule *> *)schedulesForWeekOffset:(NSInteger)weekOffset {
-    NSString *weekKey = [self weekKeyForOffset:weekOffset];
+    return [self schedulesForWeekKey:[self weekKeyForOffset:weekOffset]];
+}
 
+- (NSArray<SCWeeklySchedule *> *)schedulesForWeekKey:(NSString *)weekKey {
     // Check cache first
     if (self.weekSchedulesCache[weekKey]) {
         return [self.weekSchedulesCache[weekKey] copy];
@@ -422,52 +450,24 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
     return [[NSUserDefaults standardUserDefaults] objectForKey:storageKey];
 }
 
-- (void)commitToWeek {
-    [self commitToWeekWithOffset:0];
-}
-
-- (void)commitToWeekWithOffset:(NSInteger)weekOffset {
-    // Clean up old week data from NSUserDefaults before committing
-    [self cleanupExpiredCommitments];
-
-    NSCalendar *calendar = [NSCalendar currentCalendar];
-
-    // Get the Monday of the target week
-    NSDate *weekStart;
-    if (weekOffset == 0) {
-        weekStart = [SCWeeklySchedule startOfCurrentWeek];
-    } else {
-        weekStart = [calendar dateByAddingUnit:NSCalendarUnitDay
-                                         value:weekOffset * 7
-                                        toDate:[SCWeeklySchedule startOfCurrentWeek]
-                                       options:0];
-    }
-
-    // Week ends on Sunday (6 days after Monday) at 23:59:59
-    NSDate *endOfWeek = [calendar dateByAddingUnit:NSCalendarUnitDay value:6 toDate:weekStart options:0];
-    // Move to end of day
-    NSDateComponents *endOfDayComponents = [calendar components:(NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay)
-                                                       fromDate:endOfWeek];
-    endOfDayComponents.hour = 23;
-    endOfDayComponents.minute = 59;
-    endOfDayComponents.second = 59;
-    endOfWeek = [calendar dateFromComponents:endOfDayComponents];
+- (NSProgress *)commitToWeekWithOffset:(NSInteger)weekOffset completion:(nullable void (^)(NSError * _Nullable error))completion {
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:kCommitStageCount];
+    progress.localizedDescription = @"Preparing schedule…";
 
     // ═══════════════════════════════════════════════════════════════════════════
-    // Install launchd jobs using segment-based merging
+    // Main thread: snapshot everything the background stages need
     // ═══════════════════════════════════════════════════════════════════════════
 
-    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
-    NSError *error = nil;
+    // Clean up old week data from NSUserDefaults before committing
+    [self cleanupExpiredCommitments];
 
-    // Cleanup only stale (expired) schedule jobs, preserving valid ones from other weeks
-    [self cleanupStaleScheduleJobs];
+    NSDate *weekStart = [SCScheduleLaunchdBridge weekStartDateForOffset:weekOffset];
 
     // Collect all enabled bundles
     NSMutableArray<SCBlockBundle *> *enabledBundles = [NSMutableArray array];
     for (SCBlockBundle *bundle in self.mutableBundles) {
         if (bundle.enabled) {
-            [enabledBundles addObject:bundle];
+            [enabledBundles addObject:[bundle copy]];
         } else {
             NSLog(@"SCScheduleManager: Skipping disabled bundle %@", bundle.name);
         }
@@ -484,132 +484,147 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
         }
     }
 
-    if (enabledBundles.count == 0) {
-        NSLog(@"SCScheduleManager: No enabled bundles to schedule");
-    } else {
-        // Calculate merged segments
-        NSArray<SCBlockSegment *> *segments = [self calculateBlockSegmentsForBundles:enabledBundles
-                                                                          weekOffset:weekOffset
-                                                                              bridge:bridge];
+    NSMutableArray<SCWeeklySchedule *> *schedules = [NSMutableArray array];
+    for (SCWeeklySchedule *schedule in [self schedulesForWeekOffset:weekOffset]) {
+        [schedules addObject:[schedule copy]];
+    }
+
+    // ═══════════════════════════════════════════════════════════════════════════
+    // Commit queue: one stage at a time, checking for cancellation in between
+    // ═══════════════════════════════════════════════════════════════════════════
+
+    NSString *weekKey = [self weekKeyForOffset:weekOffset];
+    void (^finish)(NSError *, BOOL) = ^(NSError *error, BOOL committed) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (committed) {
+                [self recordCommitmentForWeekKey:weekKey weekStart:weekStart];
+            }
+            progress.completedUnitCount = progress.totalUnitCount;
+            if (completion) completion(error);
+        });
+    };
+
+    // Moves progress on to the next stage; NO if the commit was cancelled first
+    BOOL (^beginStage)(int64_t, NSString *) = ^BOOL(int64_t stage, NSString *description) {
+        if (progress.isCancelled) {
+            NSLog(@"SCScheduleManager: Commit cancelled before stage \"%@\"", description);
+            finish([NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil], NO);
+            return NO;
+        }
+        progress.completedUnitCount = stage;
+        progress.localizedDescription = description;
+        return YES;
+    };
+
+    dispatch_async(self.commitQueue, ^{
+        SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
 
-        NSLog(@"SCScheduleManager: Installing %lu segment-based jobs", (unsigned long)segments.count);
+        // Cleanup only stale (expired) schedule jobs, preserving valid ones from other weeks
+        if (!beginStage(0, @"Removing expired jobs…")) return;
+        [self cleanupStaleScheduleJobs];
+
+        if (!beginStage(1, @"Calculating block segments…")) return;
+        NSArray<SCBlockSegment *> *segments = @[];
+        if (enabledBundles.count == 0) {
+            NSLog(@"SCScheduleManager: No enabled bundles to schedule");
+        } else {
+            segments = [self calculateBlockSegmentsForBundles:enabledBundles
+                                                    schedules:schedules
+                                                weekStartDate:weekStart
+                                                       bridge:bridge];
+        }
+
+        // Hand every segment that hasn't ended to the daemon in one call. The daemon starts
+        // each one when it comes due (an in-progress segment right away), so there's no
+        // launchd job or CLI launch per segment.
+        NSMutableDictionary<NSString *, NSDictionary *> *approvedSchedules = [NSMutableDictionary dictionaryWithCapacity:segments.count];
+        for (SCBlockSegment *segment in segments) {
+            if ([segment.endDate timeIntervalSinceNow] <= 0) {
+                NSLog(@"SCScheduleManager: Skipping past segment %@", segment);
+                continue;
+            }
+            approvedSchedules[segment.segmentID] = [bridge approvedScheduleForSegmentWithBundles:segment.activeBundles
+                                                                                      startDate:segment.startDate
+                                                                                        endDate:segment.endDate];
+        }
+
+        if (approvedSchedules.count == 0) {
+            finish(nil, YES);
+            return;
+        }
 
         // Install daemon ONCE before registering any schedules (will prompt for password)
-        SCXPCClient *xpc = [SCXPCClient new];
+        if (!beginStage(2, @"Waiting for authorization…")) return;
+        // registration below goes over the same session, with the rights acquired here
+        SCXPCClient *xpc = [SCXPCClient sharedClient];
         dispatch_semaphore_t daemonSema = dispatch_semaphore_create(0);
         __block NSError *daemonError = nil;
-
         [xpc installDaemon:^(NSError *err) {
             daemonError = err;
             dispatch_semaphore_signal(daemonSema);
         }];
-
-        // Wait for daemon installation (use run loop to avoid main thread deadlock)
-        if (![NSThread isMainThread]) {
-            dispatch_semaphore_wait(daemonSema, DISPATCH_TIME_FOREVER);
-        } else {
-            while (dispatch_semaphore_wait(daemonSema, DISPATCH_TIME_NOW)) {
-                [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
-            }
-        }
+        dispatch_semaphore_wait(daemonSema, DISPATCH_TIME_FOREVER);
 
         if (daemonError) {
             NSLog(@"ERROR: Failed to install daemon for schedule commit: %@", daemonError);
+            finish([NSError errorWithDomain:@"SCScheduleManager"
+                                       code:1
+                                   userInfo:@{NSLocalizedDescriptionKey: @"Couldn't install the SelfControl helper",
+                                              NSUnderlyingErrorKey: daemonError}], NO);
             return; // Can't proceed without daemon
         }
 
-        NSLog(@"SCScheduleManager: Daemon installed, proceeding with schedule registration");
-
-        // Install a job for each segment
-        for (SCBlockSegment *segment in segments) {
-            // Skip segments that have already passed (for current week)
-            if (weekOffset == 0 && [segment.startDate timeIntervalSinceNow] < 0) {
-                // Check if we're currently within this segment
-                if ([segment.endDate timeIntervalSinceNow] > 0) {
-                    // We're in the middle of this segment - start it immediately!
-                    NSLog(@"SCScheduleManager: In-progress segment %@ - starting immediately", segment);
-                    NSError *startError = nil;
-                    if (![bridge startMergedBlockImmediatelyForBundles:segment.activeBundles
-                                                            segmentID:segment.segmentID
-                                                              endDate:segment.endDate
-                                                                error:&startError]) {
-                        NSLog(@"WARNING: Failed to start in-progress segment: %@", startError);
-                    }
-                } else {
-                    NSLog(@"SCScheduleManager: Skipping past segment %@", segment);
-                }
-                continue;
-            }
+        // Past this point the daemon holds the schedule, so the commit can't be taken back
+        if (!beginStage(3, [NSString stringWithFormat:@"Registering %lu segments…", (unsigned long)approvedSchedules.count])) return;
+        progress.cancellable = NO;
 
-            // Install launchd job for this segment
-            BOOL success = [bridge installJobForSegmentWithBundles:segment.activeBundles
-                                                         segmentID:segment.segmentID
-                                                         startDate:segment.startDate
-                                                           endDate:segment.endDate
-                                                               day:segment.day
-                                                      startMinutes:segment.startMinutes
-                                                        weekOffset:weekOffset
-                                                             error:&error];
-            if (!success) {
-                NSLog(@"ERROR: Failed to install segment job: %@", error);
-            }
+        NSLog(@"SCScheduleManager: Registering %lu merged segments", (unsigned long)approvedSchedules.count);
+        NSError *registerError = nil;
+        if (![bridge registerSegmentsWithDaemon:approvedSchedules error:&registerError]) {
+            NSLog(@"ERROR: Failed to register segments with daemon: %@", registerError);
         }
-    }
+        // a failed registration still commits, as it always has - the week is locked either way
+        finish(registerError, YES);
+    });
 
-    // ═══════════════════════════════════════════════════════════════════════════
+    return progress;
+}
+
+/// Stores the week's commitment once its segments are with the daemon. Main thread only.
+- (void)recordCommitmentForWeekKey:(NSString *)weekKey weekStart:(NSDate *)weekStart {
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+
+    // Week ends on Sunday (6 days after Monday) at 23:59:59
+    NSDate *endOfWeek = [calendar dateByAddingUnit:NSCalendarUnitDay value:6 toDate:weekStart options:0];
+    // Move to end of day
+    NSDateComponents *endOfDayComponents = [calendar components:(NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay)
+                                                       fromDate:endOfWeek];
+    endOfDayComponents.hour = 23;
+    endOfDayComponents.minute = 59;
+    endOfDayComponents.second = 59;
+    endOfWeek = [calendar dateFromComponents:endOfDayComponents];
 
     // Store commitment end date with week-specific key
-    NSString *weekKey = [self weekKeyForOffset:weekOffset];
-    NSString *storageKey = [kWeekCommitmentPrefix stringByAppendingString:weekKey];
-    [[NSUserDefaults standardUserDefaults] setObject:endOfWeek forKey:storageKey];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setCommitmentEndDate:endOfWeek forWeekKey:weekKey];
 
     // Mark that user has committed (persistent - skips test block prompt on future launches)
     [SCVersionTracker markHasEverCommitted];
 
+    // The newly committed week joins the compiled timeline
+    [self writeCommittedTimeline];
+
     [self postChangeNotification];
 }
 
 - (BOOL)changeWouldLoosenSchedule:(SCWeeklySchedule *)oldSchedule
                       toSchedule:(SCWeeklySchedule *)newSchedule
                           forDay:(SCDayOfWeek)day {
-    NSArray<SCTimeRange *> *oldWindows = [oldSchedule allowedWindowsForDay:day];
-    NSArray<SCTimeRange *> *newWindows = [newSchedule allowedWindowsForDay:day];
-
-    // Calculate total allowed minutes
-    NSInteger oldTotal = 0;
-    for (SCTimeRange *range in oldWindows) {
-        oldTotal += [range durationMinutes];
-    }
-
-    NSInteger newTotal = 0;
-    for (SCTimeRange *range in newWindows) {
-        newTotal += [range durationMinutes];
-    }
+    SCIntervalSet *oldAllowed = [SCIntervalSet setWithTimeRanges:[oldSchedule allowedWindowsForDay:day]];
+    SCIntervalSet *newAllowed = [SCIntervalSet setWithTimeRanges:[newSchedule allowedWindowsForDay:day]];
 
-    // If new has MORE allowed time, it's looser
-    if (newTotal > oldTotal) {
-        return YES;
-    }
-
-    // Check if any new window extends beyond old windows
-    // (More sophisticated check for partial overlap)
-    for (SCTimeRange *newRange in newWindows) {
-        BOOL coveredByOld = NO;
-        for (SCTimeRange *oldRange in oldWindows) {
-            // Check if new range is fully contained within old range
-            if ([newRange startMinutes] >= [oldRange startMinutes] &&
-                [newRange endMinutes] <= [oldRange endMinutes]) {
-                coveredByOld = YES;
-                break;
-            }
-        }
-        if (!coveredByOld && newRange.durationMinutes > 0) {
-            return YES; // New window not covered by any old window
-        }
-    }
-
-    return NO;
+    // Looser means some minute is allowed now that wasn't before - even if the total
+    // allowed time went down, or the new window straddles two adjacent old ones
+    return ![newAllowed isSubsetOfSet:oldAllowed];
 }
 
 #pragma mark - Segment-Based Block Merging
@@ -628,35 +643,60 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
                                                       schedules:(NSArray<SCWeeklySchedule *> *)schedules
                                                      weekOffset:(NSInteger)weekOffset
                                                          bridge:(SCScheduleLaunchdBridge *)bridge {
-    // Step 1: Collect all block windows for all bundles, tagged with their bundle
-    NSMutableArray<NSDictionary *> *allWindows = [NSMutableArray array];
+    return [self calculateBlockSegmentsForBundles:bundles
+                                        schedules:schedules ?: [self schedulesForWeekOffset:weekOffset]
+                                    weekStartDate:[SCScheduleLaunchdBridge weekStartDateForOffset:weekOffset]
+                                           bridge:bridge];
+}
 
+- (NSArray<SCBlockSegment *> *)calculateBlockSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
+                                                      schedules:(NSArray<SCWeeklySchedule *> *)schedules
+                                                  weekStartDate:(NSDate *)weekStart
+                                                         bridge:(SCScheduleLaunchdBridge *)bridge {
+    // Bundles compare equal by bundleID; the same bundle listed twice only counts once
+    // (and keeps its first position, which is the order active bundles are reported in)
+    NSMutableArray<SCBlockBundle *> *uniqueBundles = [NSMutableArray arrayWithCapacity:bundles.count];
+    NSMutableSet<NSString *> *seenBundleIDs = [NSMutableSet setWithCapacity:bundles.count];
     for (SCBlockBundle *bundle in bundles) {
-        SCWeeklySchedule *schedule = nil;
-
-        // If schedules were passed in, look up from there
-        if (schedules) {
-            for (SCWeeklySchedule *s in schedules) {
-                if ([s.bundleID isEqualToString:bundle.bundleID]) {
-                    schedule = s;
-                    break;
-                }
-            }
-        } else {
-            // Use self's schedule lookup
-            schedule = [self scheduleForBundleID:bundle.bundleID weekOffset:weekOffset];
+        if ([seenBundleIDs containsObject:bundle.bundleID]) continue;
+        [seenBundleIDs addObject:bundle.bundleID];
+        [uniqueBundles addObject:bundle];
+    }
+
+    // Index schedules by bundle ID (first match wins, like a linear search would)
+    NSMutableDictionary<NSString *, SCWeeklySchedule *> *schedulesByBundleID = [NSMutableDictionary dictionaryWithCapacity:schedules.count];
+    for (SCWeeklySchedule *s in schedules) {
+        if (s.bundleID && !schedulesByBundleID[s.bundleID]) {
+            schedulesByBundleID[s.bundleID] = s;
         }
+    }
+
+    // Step 1: Turn every block window into a start event and an end event.
+    // Times are whole seconds (windows are built from calendar days + minutes, and full-day
+    // windows end at 23:59:59), so integer offsets compare exactly like the NSDates they came from.
+    NSMutableArray<SCBlockWindow *> *allWindows = [NSMutableArray array];
+    NSMutableData *eventData = [NSMutableData data];
 
+    for (NSUInteger bundleIndex = 0; bundleIndex < uniqueBundles.count; bundleIndex++) {
+        SCBlockBundle *bundle = uniqueBundles[bundleIndex];
+        SCWeeklySchedule *schedule = schedulesByBundleID[bundle.bundleID];
         if (!schedule) {
             schedule = [SCWeeklySchedule emptyScheduleForBundleID:bundle.bundleID];
         }
 
-        NSArray<SCBlockWindow *> *windows = [bridge allBlockWindowsForSchedule:schedule weekOffset:weekOffset];
+        NSArray<SCBlockWindow *> *windows = [bridge allBlockWindowsForSchedule:schedule weekStartDate:weekStart];
         for (SCBlockWindow *window in windows) {
-            [allWindows addObject:@{
-                @"bundle": bundle,
-                @"window": window
-            }];
+            [allWindows addObject:window];
+
+            int64_t start = llround(window.startDate.timeIntervalSinceReferenceDate);
+            int64_t end = llround(window.endDate.timeIntervalSinceReferenceDate);
+            // Empty/backwards windows never cover anything, but their times still split segments
+            BOOL coversTime = (start < end);
+            SCSegmentEvent events[2] = {
+                { start, coversTime ? 1 : 0, (uint32_t)bundleIndex, window.startDate },
+                { end, coversTime ? -1 : 0, (uint32_t)bundleIndex, window.endDate }
+            };
+            [eventData appendBytes:events length:sizeof(events)];
         }
     }
 
@@ -664,52 +704,37 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
         return @[];
     }
 
-    // Step 2: Collect all unique transition times (start and end times)
-    NSMutableSet<NSDate *> *transitionTimes = [NSMutableSet set];
-    for (NSDictionary *entry in allWindows) {
-        SCBlockWindow *window = entry[@"window"];
-        [transitionTimes addObject:window.startDate];
-        [transitionTimes addObject:window.endDate];
-    }
-
-    // Sort transition times chronologically
-    NSArray<NSDate *> *sortedTimes = [[transitionTimes allObjects] sortedArrayUsingSelector:@selector(compare:)];
+    // Step 2: Sort events chronologically - O(W log W)
+    SCSegmentEvent *events = eventData.mutableBytes;
+    NSUInteger eventCount = eventData.length / sizeof(SCSegmentEvent);
+    qsort(events, eventCount, sizeof(SCSegmentEvent), SCCompareSegmentEvents);
 
-    if (sortedTimes.count < 2) {
-        return @[];
-    }
-
-    // Step 3: For each pair of consecutive times, determine active bundles
+    // Step 3: Sweep. After applying every event at time t, the active set is exactly the bundles
+    // whose windows cover [t, next t), so each segment is emitted without rescanning any windows.
     NSMutableArray<SCBlockSegment *> *segments = [NSMutableArray array];
     NSCalendar *calendar = [NSCalendar currentCalendar];
-
-    for (NSUInteger i = 0; i < sortedTimes.count - 1; i++) {
-        NSDate *segmentStart = sortedTimes[i];
-        NSDate *segmentEnd = sortedTimes[i + 1];
-
-        // Determine which bundles are active during this segment
-        // A bundle is active if its block window contains this segment
-        NSMutableArray<SCBlockBundle *> *activeBundles = [NSMutableArray array];
-
-        for (NSDictionary *entry in allWindows) {
-            SCBlockBundle *bundle = entry[@"bundle"];
-            SCBlockWindow *window = entry[@"window"];
-
-            // Check if this window covers the segment
-            // Window must start at or before segment start AND end at or after segment end
-            if ([window.startDate compare:segmentStart] != NSOrderedDescending &&
-                [window.endDate compare:segmentEnd] != NSOrderedAscending) {
-                // Avoid duplicates (same bundle may have multiple windows)
-                if (![activeBundles containsObject:bundle]) {
-                    [activeBundles addObject:bundle];
-                }
+    NSUInteger *activeWindowCounts = calloc(uniqueBundles.count, sizeof(NSUInteger));
+    NSMutableIndexSet *activeBundleIndexes = [NSMutableIndexSet indexSet];
+
+    NSUInteger i = 0;
+    while (i < eventCount) {
+        int64_t time = events[i].time;
+        NSDate *segmentStart = events[i].date;
+
+        for (; i < eventCount && events[i].time == time; i++) {
+            uint32_t bundleIndex = events[i].bundleIndex;
+            if (events[i].delta > 0) {
+                if (activeWindowCounts[bundleIndex]++ == 0) [activeBundleIndexes addIndex:bundleIndex];
+            } else if (events[i].delta < 0) {
+                if (--activeWindowCounts[bundleIndex] == 0) [activeBundleIndexes removeIndex:bundleIndex];
             }
         }
 
-        // Skip segments with no active bundles (these are allowed periods)
-        if (activeBundles.count == 0) {
+        // Nothing after the last transition; and segments with no active bundles are allowed periods
+        if (i >= eventCount || activeBundleIndexes.count == 0) {
             continue;
         }
+        NSDate *segmentEnd = events[i].date;
 
         // Apply 1-minute gap: end the segment 1 minute early
         NSDate *adjustedEnd = [calendar dateByAddingUnit:NSCalendarUnitMinute value:-1 toDate:segmentEnd options:0];
@@ -725,10 +750,16 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
                                                                end:adjustedEnd
                                                                day:day
                                                       startMinutes:startMinutes];
-        [segment.activeBundles addObjectsFromArray:activeBundles];
+        [segment.activeBundles addObjectsFromArray:[uniqueBundles objectsAtIndexes:activeBundleIndexes]];
+        // Same span + same bundles = same ID, so a recompiled timeline still names the segments the daemon approved
+        segment.segmentID = [SCScheduleTimeline segmentIDForStartDate:segmentStart
+                                                              endDate:adjustedEnd
+                                                            bundleIDs:[segment.activeBundles valueForKey:@"bundleID"]];
         [segments addObject:segment];
     }
 
+    free(activeWindowCounts);
+
     NSLog(@"SCScheduleManager: Calculated %lu segments from %lu bundles", (unsigned long)segments.count, (unsigned long)bundles.count);
     for (SCBlockSegment *seg in segments) {
         NSLog(@"  %@", seg);
@@ -737,6 +768,120 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
     return segments;
 }
 
+#pragma mark - Compiled Timeline
+
+/// Stores (or with nil, removes) a week's commitment end date, keeping the week key index in step
+- (void)setCommitmentEndDate:(nullable NSDate *)endDate forWeekKey:(NSString *)weekKey {
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSString *storageKey = [kWeekCommitmentPrefix stringByAppendingString:weekKey];
+    NSMutableArray<NSString *> *weekKeys = [[self commitmentWeekKeyIndex] mutableCopy];
+    [weekKeys removeObject:weekKey];
+
+    if (endDate) {
+        [defaults setObject:endDate forKey:storageKey];
+        [weekKeys addObject:weekKey];
+    } else {
+        [defaults removeObjectForKey:storageKey];
+    }
+    [defaults setObject:weekKeys forKey:kCommitmentWeekKeysKey];
+}
+
+/// Week keys that may have a commitment stored. Entries can outlive their commitment
+/// (emergency unlock removes the SCWeekCommitment_ keys directly), so check before use.
+- (NSArray<NSString *> *)commitmentWeekKeyIndex {
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSArray<NSString *> *weekKeys = [defaults stringArrayForKey:kCommitmentWeekKeysKey];
+    if (weekKeys) return weekKeys;
+
+    // Commitments stored before the index existed - find them once
+    NSMutableArray<NSString *> *foundKeys = [NSMutableArray array];
+    for (NSString *key in [defaults dictionaryRepresentation].allKeys) {
+        if ([key hasPrefix:kWeekCommitmentPrefix]) {
+            [foundKeys addObject:[key substringFromIndex:kWeekCommitmentPrefix.length]];
+        }
+    }
+    [defaults setObject:foundKeys forKey:kCommitmentWeekKeysKey];
+    return foundKeys;
+}
+
+/// Week keys of every commitment that hasn't ended yet, oldest first
+- (NSArray<NSString *> *)committedWeekKeys {
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSArray<NSString *> *indexedKeys = [self commitmentWeekKeyIndex];
+    NSMutableArray<NSString *> *storedKeys = [NSMutableArray arrayWithCapacity:indexedKeys.count];
+    NSMutableArray<NSString *> *weekKeys = [NSMutableArray array];
+    for (NSString *weekKey in indexedKeys) {
+        NSDate *endDate = [defaults objectForKey:[kWeekCommitmentPrefix stringByAppendingString:weekKey]];
+        if (!endDate) continue;
+
+        [storedKeys addObject:weekKey];
+        if ([endDate isKindOfClass:[NSDate class]] && [endDate timeIntervalSinceNow] > 0) {
+            [weekKeys addObject:weekKey];
+        }
+    }
+    // Drop entries whose commitment was removed behind our back
+    if (storedKeys.count != indexedKeys.count) {
+        [defaults setObject:storedKeys forKey:kCommitmentWeekKeysKey];
+    }
+
+    // ISO date strings sort chronologically
+    return [weekKeys sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (SCScheduleTimeline *)compileCommittedTimeline {
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+
+    NSMutableArray<SCBlockBundle *> *enabledBundles = [NSMutableArray array];
+    for (SCBlockBundle *bundle in self.mutableBundles) {
+        if (bundle.enabled) [enabledBundles addObject:bundle];
+    }
+
+    NSMutableArray<SCTimelineSegment *> *timelineSegments = [NSMutableArray array];
+    for (NSString *weekKey in [self committedWeekKeys]) {
+        NSDate *weekStart = [SCWeeklySchedule weekStartDateForWeekKey:weekKey];
+        if (!weekStart) continue;
+
+        NSArray<SCBlockSegment *> *segments = [self calculateBlockSegmentsForBundles:enabledBundles
+                                                                           schedules:[self schedulesForWeekKey:weekKey]
+                                                                       weekStartDate:weekStart
+                                                                              bridge:bridge];
+        for (SCBlockSegment *segment in segments) {
+            NSMutableArray<NSString *> *mergedEntries = [NSMutableArray array];
+            for (SCBlockBundle *bundle in segment.activeBundles) {
+                [mergedEntries addObjectsFromArray:bundle.entries ?: @[]];
+            }
+            [timelineSegments addObject:[SCTimelineSegment segmentWithID:segment.segmentID
+                                                               startDate:segment.startDate
+                                                                 endDate:segment.endDate
+                                                             contentHash:[SCScheduleTimeline contentHashForBlocklist:mergedEntries]
+                                                               bundleIDs:[segment.activeBundles valueForKey:@"bundleID"]]];
+        }
+    }
+
+    return [SCScheduleTimeline timelineWithSegments:timelineSegments];
+}
+
+- (void)writeCommittedTimeline {
+    SCScheduleTimeline *timeline = [self compileCommittedTimeline];
+    NSError *error = nil;
+    if (![timeline writeToURL:[SCScheduleTimeline defaultTimelineURL] error:&error]) {
+        NSLog(@"WARNING: Failed to write schedule timeline: %@", error);
+    }
+    self.committedTimeline = timeline;
+    NSLog(@"SCScheduleManager: Compiled timeline with %lu segments", (unsigned long)timeline.count);
+
+    // Merged blocklist files are shared by digest; keep the ones a committed segment still uses
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    [bridge removeMergedBlocklistFilesExceptDigests:[NSSet setWithArray:[timeline.segments valueForKey:@"contentHash"]]];
+}
+
+- (nullable SCScheduleTimeline *)committedTimeline {
+    if (!_committedTimeline) {
+        _committedTimeline = [SCScheduleTimeline timelineWithContentsOfURL:[SCScheduleTimeline defaultTimelineURL] error:nil];
+    }
+    return _committedTimeline;
+}
+
 - (void)clearCommitmentForDebug {
 #ifdef DEBUG
     // Uninstall all launchd jobs
@@ -750,8 +895,8 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
     // Clear week-specific commitment keys
     NSString *currentWeekKey = [self weekKeyForOffset:0];
     NSString *nextWeekKey = [self weekKeyForOffset:1];
-    [[NSUserDefaults standardUserDefaults] removeObjectForKey:[kWeekCommitmentPrefix stringByAppendingString:currentWeekKey]];
-    [[NSUserDefaults standardUserDefaults] removeObjectForKey:[kWeekCommitmentPrefix stringByAppendingString:nextWeekKey]];
+    [self setCommitmentEndDate:nil forWeekKey:currentWeekKey];
+    [self setCommitmentEndDate:nil forWeekKey:nextWeekKey];
 
     // Clear all week schedule data (SCWeekSchedules_*) - wipe schedule drawings
     NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
@@ -767,8 +912,11 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
 
     [defaults synchronize];
 
+    // Nothing is committed any more
+    [self writeCommittedTimeline];
+
     // Clear ApprovedSchedules and active block in daemon (requires XPC)
-    SCXPCClient *xpc = [[SCXPCClient alloc] init];
+    SCXPCClient *xpc = [SCXPCClient sharedClient];
 
     // Clear ApprovedSchedules
     [xpc clearAllApprovedSchedules:^(NSError *error) {
@@ -815,8 +963,7 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
             }
 
             // Clear the commitment metadata
-            NSString *storageKey = [kWeekCommitmentPrefix stringByAppendingString:weekKey];
-            [[NSUserDefaults standardUserDefaults] removeObjectForKey:storageKey];
+            [self setCommitmentEndDate:nil forWeekKey:weekKey];
         }
     }
 
@@ -837,86 +984,71 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
             // ISO date strings sort chronologically - delete only past weeks
             if ([weekKey compare:currentWeekKey] == NSOrderedAscending) {
                 NSLog(@"SCScheduleManager: Removing old week data: %@", key);
-                [defaults removeObjectForKey:key];
+                if ([key hasPrefix:kWeekCommitmentPrefix]) {
+                    [self setCommitmentEndDate:nil forWeekKey:weekKey];
+                } else {
+                    [defaults removeObjectForKey:key];
+                }
             }
         }
     }
 
     [[NSUserDefaults standardUserDefaults] synchronize];
+
+    // Drop expired weeks from the compiled timeline
+    [self writeCommittedTimeline];
 }
 
 /// Cleans up stale (expired) schedule jobs.
 /// Only removes jobs where endDate is in the past, preserving valid jobs from other weeks.
 /// This allows multi-week commits without destroying jobs from other committed weeks.
 - (void)cleanupStaleScheduleJobs {
-    NSDate *now = [NSDate date];
-    NSISO8601DateFormatter *isoFormatter = [[NSISO8601DateFormatter alloc] init];
-
-    // Scan all schedule job plists
-    NSString *launchAgentsDir = [@"~/Library/LaunchAgents" stringByExpandingTildeInPath];
-    NSFileManager *fm = [NSFileManager defaultManager];
-    NSString *prefix = @"org.eyebeam.selfcontrol.schedule.merged-";
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    NSString *prefix = [NSString stringWithFormat:@"%@.merged-", [SCScheduleLaunchdBridge jobLabelPrefix]];
 
-    NSArray *files = [fm contentsOfDirectoryAtPath:launchAgentsDir error:nil];
+    // The job index records each segment job's end date, so no plists need reading
+    NSMutableArray<NSString *> *staleLabels = [NSMutableArray array];
     NSMutableArray *staleSegmentIDs = [NSMutableArray array];
-
-    for (NSString *file in files) {
-        if (![file hasPrefix:prefix] || ![file hasSuffix:@".plist"]) continue;
-
-        NSString *path = [launchAgentsDir stringByAppendingPathComponent:file];
-        NSDictionary *plist = [NSDictionary dictionaryWithContentsOfFile:path];
-        if (!plist) continue;
-
-        // Parse endDate from ProgramArguments
-        NSDate *endDate = nil;
-        NSArray *args = plist[@"ProgramArguments"];
-        for (NSString *arg in args) {
-            if ([arg hasPrefix:@"--enddate="]) {
-                NSString *endDateStr = [arg substringFromIndex:10];
-                endDate = [isoFormatter dateFromString:endDateStr];
-                break;
-            }
-        }
-
-        // If expired (endDate in past), mark for cleanup
-        if (endDate && [now compare:endDate] == NSOrderedDescending) {
-            // Extract segmentID from label
-            NSString *label = plist[@"Label"];
-            NSArray *parts = [label componentsSeparatedByString:@".merged-"];
-            if (parts.count > 1) {
-                NSString *remainder = parts[1];
-                NSString *segmentID = [remainder componentsSeparatedByString:@"."].firstObject;
-                if (segmentID.length > 0) {
-                    [staleSegmentIDs addObject:segmentID];
-                    NSLog(@"SCScheduleManager: Found stale job %@ (endDate=%@)", segmentID, endDate);
-                }
-            }
+    for (NSString *label in [bridge.jobStore labelsExpiredBeforeDate:[NSDate date]]) {
+        if (![label hasPrefix:prefix]) continue;
+
+        // Extract segmentID from label: {prefix}{segmentID}.{day}.{time}
+        NSString *segmentID = [[label substringFromIndex:prefix.length] componentsSeparatedByString:@"."].firstObject;
+        if (segmentID.length > 0) {
+            [staleLabels addObject:label];
+            [staleSegmentIDs addObject:segmentID];
+            NSLog(@"SCScheduleManager: Found stale job %@", segmentID);
         }
     }
 
+    // Remove all the stale jobs with a single launchctl run
+    [bridge removeJobsWithLabels:staleLabels error:nil];
+
     // Cleanup stale jobs via daemon XPC
     if (staleSegmentIDs.count > 0) {
         NSLog(@"SCScheduleManager: Cleaning up %lu stale schedule jobs", (unsigned long)staleSegmentIDs.count);
-        SCXPCClient *xpc = [[SCXPCClient alloc] init];
+        SCXPCClient *xpc = [SCXPCClient sharedClient];
 
+        // Sent back to back; we only wait once, for the last reply
+        dispatch_group_t group = dispatch_group_create();
         for (NSString *segmentID in staleSegmentIDs) {
-            dispatch_semaphore_t sema = dispatch_semaphore_create(0);
+            dispatch_group_enter(group);
             [xpc cleanupStaleSchedule:segmentID reply:^(NSError *error) {
                 if (error) {
                     NSLog(@"SCScheduleManager: Cleanup failed for %@: %@", segmentID, error);
                 } else {
                     NSLog(@"SCScheduleManager: Cleaned up stale schedule %@", segmentID);
                 }
-                dispatch_semaphore_signal(sema);
+                dispatch_group_leave(group);
             }];
+        }
 
-            // Wait for cleanup (with run loop to avoid deadlock)
-            if (![NSThread isMainThread]) {
-                dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
-            } else {
-                while (dispatch_semaphore_wait(sema, DISPATCH_TIME_NOW)) {
-                    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
-                }
+        // Wait for cleanup (with run loop to avoid deadlock)
+        if (![NSThread isMainThread]) {
+            dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        } else {
+            while (dispatch_group_wait(group, DISPATCH_TIME_NOW)) {
+                [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
             }
         }
     } else {
@@ -939,6 +1071,11 @@ static const NSInteger kDefaultEmergencyUnlockCredits = 5;
     // This happens when bundle is blocked all week with no allowed windows
     if (baseStatus.length == 0) {
         NSDate *commitmentEnd = [self commitmentEndDateForWeekOffset:0];
+        // If later weeks are committed too, the block can run on past this week's end
+        NSDate *blockEnd = [self.committedTimeline blockEndDateForBundleID:bundleID atDate:[NSDate date]];
+        if (blockEnd && (!commitmentEnd || [blockEnd compare:commitmentEnd] == NSOrderedDescending)) {
+            return [self formatStatusStringForDate:blockEnd];
+        }
         if (commitmentEnd) {
             return [self formatStatusStringForDate:commitmentEnd];
         }
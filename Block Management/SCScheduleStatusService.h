@@ -0,0 +1,63 @@
+//
+//  SCScheduleStatusService.h
+//  SelfControl
+//
+//  Current allowed/blocked state of every bundle, computed once and shared by the
+//  menu bar and the schedule window. Refreshes itself at the next state change
+//  instead of being polled.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Posted on the main queue after the statuses are recomputed
+extern NSNotificationName const SCScheduleStatusServiceDidUpdateNotification;
+
+/// One bundle's status, as of the last refresh
+@interface SCBundleStatus : NSObject
+
+@property (nonatomic, copy, readonly) NSString *bundleID;
+
+/// Whether the bundle would be allowed right now (YES if it has no schedule this week)
+@property (nonatomic, readonly) BOOL isAllowed;
+
+/// "till X" part of the status, empty if the bundle has no schedule this week
+@property (nonatomic, copy, readonly) NSString *statusString;
+
+/// When the bundle next flips between allowed and blocked, nil if it doesn't this week
+@property (nonatomic, strong, readonly, nullable) NSDate *nextChangeDate;
+
+- (instancetype)initWithBundleID:(NSString *)bundleID
+                       isAllowed:(BOOL)isAllowed
+                    statusString:(NSString *)statusString
+                  nextChangeDate:(nullable NSDate *)nextChangeDate;
+
+@end
+
+@interface SCScheduleStatusService : NSObject
+
++ (instancetype)sharedService;
+
+/// Statuses keyed by bundle ID
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, SCBundleStatus *> *statuses;
+
+/// When the service will next refresh on its own
+@property (nonatomic, strong, readonly, nullable) NSDate *nextRefreshDate;
+
+/// Status for a bundle, nil if the bundle didn't exist at the last refresh
+- (nullable SCBundleStatus *)statusForBundleID:(NSString *)bundleID;
+
+/// Recomputes every status now. Schedule changes, wake from sleep and clock changes
+/// already trigger this; call it directly only after a change the service can't see.
+- (void)refresh;
+
+/// The earliest of the statuses' next changes, the commitment end and the next midnight
+/// (when "till X" strings switch between showing a day and not), all strictly after date
++ (NSDate *)refreshDateForStatuses:(NSArray<SCBundleStatus *> *)statuses
+                 commitmentEndDate:(nullable NSDate *)commitmentEndDate
+                         afterDate:(NSDate *)date;
+
+@end
+
+NS_ASSUME_NONNULL_END
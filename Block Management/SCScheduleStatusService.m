@@ -0,0 +1,156 @@
+//
+//  SCScheduleStatusService.m
+//  SelfControl
+//
+
+#import "SCScheduleStatusService.h"
+#import "SCScheduleManager.h"
+#import <AppKit/AppKit.h>
+
+NSNotificationName const SCScheduleStatusServiceDidUpdateNotification = @"SCScheduleStatusServiceDidUpdateNotification";
+
+@implementation SCBundleStatus
+
+- (instancetype)initWithBundleID:(NSString *)bundleID
+                       isAllowed:(BOOL)isAllowed
+                    statusString:(NSString *)statusString
+                  nextChangeDate:(nullable NSDate *)nextChangeDate {
+    self = [super init];
+    if (self) {
+        _bundleID = [bundleID copy];
+        _isAllowed = isAllowed;
+        _statusString = [statusString copy];
+        _nextChangeDate = nextChangeDate;
+    }
+    return self;
+}
+
+@end
+
+@interface SCScheduleStatusService ()
+
+@property (nonatomic, copy) NSDictionary<NSString *, SCBundleStatus *> *statuses;
+@property (nonatomic, strong, nullable) NSDate *nextRefreshDate;
+@property (nonatomic, strong, nullable) NSTimer *refreshTimer;
+
+@end
+
+@implementation SCScheduleStatusService
+
++ (instancetype)sharedService {
+    static SCScheduleStatusService *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[SCScheduleStatusService alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _statuses = @{};
+
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        [center addObserver:self selector:@selector(statusInputsDidChange:) name:SCScheduleManagerDidChangeNotification object:nil];
+        [center addObserver:self selector:@selector(statusInputsDidChange:) name:NSSystemClockDidChangeNotification object:nil];
+        [center addObserver:self selector:@selector(statusInputsDidChange:) name:NSSystemTimeZoneDidChangeNotification object:nil];
+
+        // The refresh timer doesn't count time asleep, so it's late after a wake
+        [[[NSWorkspace sharedWorkspace] notificationCenter] addObserver:self
+                                                               selector:@selector(statusInputsDidChange:)
+                                                                   name:NSWorkspaceDidWakeNotification
+                                                                 object:nil];
+
+        [self refresh];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [[[NSWorkspace sharedWorkspace] notificationCenter] removeObserver:self];
+    [self.refreshTimer invalidate];
+}
+
+#pragma mark - Statuses
+
+- (nullable SCBundleStatus *)statusForBundleID:(NSString *)bundleID {
+    return self.statuses[bundleID];
+}
+
+- (void)refresh {
+    if (![NSThread isMainThread]) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self refresh];
+        });
+        return;
+    }
+
+    SCScheduleManager *manager = [SCScheduleManager sharedManager];
+    NSMutableDictionary<NSString *, SCBundleStatus *> *statuses = [NSMutableDictionary dictionary];
+    for (SCBlockBundle *bundle in manager.bundles) {
+        SCWeeklySchedule *schedule = [manager scheduleForBundleID:bundle.bundleID weekOffset:0];
+        statuses[bundle.bundleID] = [[SCBundleStatus alloc] initWithBundleID:bundle.bundleID
+                                                                   isAllowed:[manager wouldBundleBeAllowed:bundle.bundleID]
+                                                                statusString:[manager statusStringForBundleID:bundle.bundleID]
+                                                              nextChangeDate:[schedule nextStateChangeDate]];
+    }
+    self.statuses = statuses;
+
+    [self scheduleRefreshAtDate:[SCScheduleStatusService refreshDateForStatuses:statuses.allValues
+                                                              commitmentEndDate:manager.commitmentEndDate
+                                                                      afterDate:[NSDate date]]];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:SCScheduleStatusServiceDidUpdateNotification object:self];
+}
+
++ (NSDate *)refreshDateForStatuses:(NSArray<SCBundleStatus *> *)statuses
+                 commitmentEndDate:(nullable NSDate *)commitmentEndDate
+                         afterDate:(NSDate *)date {
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    NSDate *refreshDate = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:[calendar startOfDayForDate:date] options:0];
+
+    NSMutableArray<NSDate *> *candidates = [NSMutableArray array];
+    for (SCBundleStatus *status in statuses) {
+        if (status.nextChangeDate) [candidates addObject:status.nextChangeDate];
+    }
+    if (commitmentEndDate) [candidates addObject:commitmentEndDate];
+
+    for (NSDate *candidate in candidates) {
+        if ([candidate compare:date] == NSOrderedDescending && [candidate compare:refreshDate] == NSOrderedAscending) {
+            refreshDate = candidate;
+        }
+    }
+    return refreshDate;
+}
+
+#pragma mark - Refresh Timer
+
+- (void)scheduleRefreshAtDate:(NSDate *)date {
+    [self.refreshTimer invalidate];
+
+    self.nextRefreshDate = date;
+    self.refreshTimer = [[NSTimer alloc] initWithFireDate:date
+                                                 interval:0
+                                                   target:self
+                                                 selector:@selector(refreshTimerFired:)
+                                                 userInfo:nil
+                                                  repeats:NO];
+    // Common modes, so an open status menu still sees the change
+    [[NSRunLoop mainRunLoop] addTimer:self.refreshTimer forMode:NSRunLoopCommonModes];
+}
+
+- (void)refreshTimerFired:(NSTimer *)timer {
+    [self refresh];
+}
+
+#pragma mark - Notifications
+
+- (void)statusInputsDidChange:(NSNotification *)note {
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self refresh];
+    });
+}
+
+@end
@@ -0,0 +1,87 @@
+//
+//  SCScheduleTimeline.h
+//  SelfControl
+//
+//  Every committed week's merged block segments, compiled into one list of absolute
+//  (UTC) instants. The app writes it when commitments change; the app and the daemon
+//  both read it, and finding the segment at a given moment is a binary search.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A segment ends a minute before the next one starts (the launchd gap), so anything
+/// starting within this long after a segment's end carries straight on from it
+extern const NSTimeInterval kScheduleTimelineMaxContinuationGapSecs;
+
+/// One merged block segment on the timeline
+@interface SCTimelineSegment : NSObject
+
+/// Stable for the same span and the same bundles (see +segmentIDForStartDate:endDate:bundleIDs:)
+@property (nonatomic, copy, readonly) NSString *segmentID;
+
+@property (nonatomic, strong, readonly) NSDate *startDate;
+
+/// When the segment's block ends (already includes the 1-minute launchd gap)
+@property (nonatomic, strong, readonly) NSDate *endDate;
+
+/// Hash of the merged blocklist entries blocked during this segment
+@property (nonatomic, copy, readonly) NSString *contentHash;
+
+@property (nonatomic, copy, readonly) NSArray<NSString *> *bundleIDs;
+
++ (instancetype)segmentWithID:(NSString *)segmentID
+                    startDate:(NSDate *)startDate
+                      endDate:(NSDate *)endDate
+                  contentHash:(NSString *)contentHash
+                    bundleIDs:(NSArray<NSString *> *)bundleIDs;
+
+@end
+
+
+@interface SCScheduleTimeline : NSObject
+
+/// Sorts segments by start date. Segments must not overlap (merged segments never do).
++ (instancetype)timelineWithSegments:(NSArray<SCTimelineSegment *> *)segments;
+
++ (nullable instancetype)timelineWithContentsOfURL:(NSURL *)url error:(NSError **)error;
+
+- (BOOL)writeToURL:(NSURL *)url error:(NSError **)error;
+
+/// ~/Library/Application Support/SelfControl/Schedules/ScheduleTimeline.plist for the current user
++ (NSURL *)defaultTimelineURL;
+
+/// The same file under another user's home directory (for the daemon, which runs as root)
++ (NSURL *)timelineURLForHomeDirectory:(NSString *)homeDirectory;
+
+#pragma mark - Identity
+
+/// Deterministic segment ID from the segment's instants and (order-independent) bundle IDs
++ (NSString *)segmentIDForStartDate:(NSDate *)startDate endDate:(NSDate *)endDate bundleIDs:(NSArray<NSString *> *)bundleIDs;
+
+/// Order-independent hash of a blocklist; duplicate entries don't change it.
+/// This is the blocklist's digest in SCBlocklistStore.
++ (NSString *)contentHashForBlocklist:(NSArray<NSString *> *)blocklist;
+
+#pragma mark - Lookup
+
+@property (nonatomic, readonly) NSArray<SCTimelineSegment *> *segments;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/// Segment whose [startDate, endDate) contains date, or nil if nothing is blocked then
+- (nullable SCTimelineSegment *)segmentAtDate:(NSDate *)date;
+
+/// First segment starting after date
+- (nullable SCTimelineSegment *)nextSegmentAfterDate:(NSDate *)date;
+
+- (nullable SCTimelineSegment *)segmentWithID:(NSString *)segmentID;
+
+/// If bundleID is blocked at date, when that block ends - following it across back-to-back
+/// segments (and week boundaries) for as long as the bundle stays in them. nil if it isn't blocked.
+- (nullable NSDate *)blockEndDateForBundleID:(NSString *)bundleID atDate:(NSDate *)date;
+
+@end
+
+NS_ASSUME_NONNULL_END
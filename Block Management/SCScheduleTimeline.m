@@ -0,0 +1,268 @@
+//
+//  SCScheduleTimeline.m
+//  SelfControl
+//
+
+#import "SCScheduleTimeline.h"
+#import "SCBlocklistStore.h"
+#import <CommonCrypto/CommonDigest.h>
+
+static const NSInteger kTimelineFormatVersion = 1;
+
+const NSTimeInterval kScheduleTimelineMaxContinuationGapSecs = 90.0;
+
+static NSString *SCHexDigest(NSData *data) {
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+
+    // 128 bits is plenty to tell segments and blocklists apart
+    NSMutableString *hex = [NSMutableString stringWithCapacity:32];
+    for (int i = 0; i < 16; i++) {
+        [hex appendFormat:@"%02x", digest[i]];
+    }
+    return hex;
+}
+
+static int64_t SCInstantForDate(NSDate *date) {
+    return (int64_t)floor(date.timeIntervalSince1970);
+}
+
+#pragma mark - SCTimelineSegment
+
+@interface SCTimelineSegment ()
+@property (nonatomic, copy, readwrite) NSString *segmentID;
+@property (nonatomic, strong, readwrite) NSDate *startDate;
+@property (nonatomic, strong, readwrite) NSDate *endDate;
+@property (nonatomic, copy, readwrite) NSString *contentHash;
+@property (nonatomic, copy, readwrite) NSArray<NSString *> *bundleIDs;
+@end
+
+@implementation SCTimelineSegment
+
++ (instancetype)segmentWithID:(NSString *)segmentID
+                    startDate:(NSDate *)startDate
+                      endDate:(NSDate *)endDate
+                  contentHash:(NSString *)contentHash
+                    bundleIDs:(NSArray<NSString *> *)bundleIDs {
+    SCTimelineSegment *segment = [[SCTimelineSegment alloc] init];
+    segment.segmentID = segmentID;
+    segment.startDate = startDate;
+    segment.endDate = endDate;
+    segment.contentHash = contentHash;
+    segment.bundleIDs = bundleIDs;
+    return segment;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<SCTimelineSegment %@ %@ - %@ bundles=%@>",
+            self.segmentID, self.startDate, self.endDate, self.bundleIDs];
+}
+
+@end
+
+#pragma mark - SCScheduleTimeline
+
+@interface SCScheduleTimeline () {
+    // parallel to segments: start and end instants, seconds since 1970 UTC
+    NSData *startInstants_;
+    NSData *endInstants_;
+}
+@property (nonatomic, copy, readwrite) NSArray<SCTimelineSegment *> *segments;
+@property (nonatomic, strong) NSDictionary<NSString *, NSNumber *> *indexesBySegmentID;
+@end
+
+@implementation SCScheduleTimeline
+
++ (instancetype)timelineWithSegments:(NSArray<SCTimelineSegment *> *)segments {
+    NSArray<SCTimelineSegment *> *sorted = [segments sortedArrayUsingComparator:^NSComparisonResult(SCTimelineSegment *a, SCTimelineSegment *b) {
+        return [a.startDate compare:b.startDate];
+    }];
+
+    NSMutableData *starts = [NSMutableData dataWithLength:sizeof(int64_t) * sorted.count];
+    NSMutableData *ends = [NSMutableData dataWithLength:sizeof(int64_t) * sorted.count];
+    int64_t *startValues = starts.mutableBytes;
+    int64_t *endValues = ends.mutableBytes;
+    NSMutableDictionary<NSString *, NSNumber *> *indexes = [NSMutableDictionary dictionaryWithCapacity:sorted.count];
+    for (NSUInteger i = 0; i < sorted.count; i++) {
+        startValues[i] = SCInstantForDate(sorted[i].startDate);
+        endValues[i] = SCInstantForDate(sorted[i].endDate);
+        indexes[sorted[i].segmentID] = @(i);
+    }
+
+    SCScheduleTimeline *timeline = [[SCScheduleTimeline alloc] init];
+    timeline.segments = sorted;
+    timeline.indexesBySegmentID = indexes;
+    timeline->startInstants_ = starts;
+    timeline->endInstants_ = ends;
+    return timeline;
+}
+
+#pragma mark - File Storage
+
++ (NSURL *)defaultTimelineURL {
+    return [self timelineURLForHomeDirectory:NSHomeDirectory()];
+}
+
++ (NSURL *)timelineURLForHomeDirectory:(NSString *)homeDirectory {
+    NSString *path = [homeDirectory stringByAppendingPathComponent:@"Library/Application Support/SelfControl/Schedules/ScheduleTimeline.plist"];
+    return [NSURL fileURLWithPath:path];
+}
+
+- (BOOL)writeToURL:(NSURL *)url error:(NSError **)error {
+    NSMutableArray<NSString *> *segmentIDs = [NSMutableArray arrayWithCapacity:self.count];
+    NSMutableArray<NSString *> *contentHashes = [NSMutableArray arrayWithCapacity:self.count];
+    NSMutableArray<NSArray<NSString *> *> *bundleIDs = [NSMutableArray arrayWithCapacity:self.count];
+    for (SCTimelineSegment *segment in self.segments) {
+        [segmentIDs addObject:segment.segmentID];
+        [contentHashes addObject:segment.contentHash];
+        [bundleIDs addObject:segment.bundleIDs];
+    }
+
+    NSDictionary *plist = @{
+        @"FormatVersion": @(kTimelineFormatVersion),
+        @"GeneratedDate": [NSDate date],
+        @"StartInstants": startInstants_,
+        @"EndInstants": endInstants_,
+        @"SegmentIDs": segmentIDs,
+        @"ContentHashes": contentHashes,
+        @"BundleIDs": bundleIDs
+    };
+
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:plist
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:error];
+    if (!data) {
+        NSLog(@"ERROR: Failed to serialize schedule timeline");
+        return NO;
+    }
+
+    [[NSFileManager defaultManager] createDirectoryAtURL:[url URLByDeletingLastPathComponent]
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:nil];
+    if (![data writeToURL:url options:NSDataWritingAtomic error:error]) {
+        NSLog(@"ERROR: Failed to write schedule timeline to %@", url.path);
+        return NO;
+    }
+    return YES;
+}
+
++ (nullable instancetype)timelineWithContentsOfURL:(NSURL *)url error:(NSError **)error {
+    NSData *data = [NSData dataWithContentsOfURL:url options:0 error:error];
+    if (!data) return nil;
+
+    NSDictionary *plist = [NSPropertyListSerialization propertyListWithData:data
+                                                                    options:NSPropertyListImmutable
+                                                                     format:NULL
+                                                                      error:error];
+    NSData *starts = plist[@"StartInstants"];
+    NSData *ends = plist[@"EndInstants"];
+    NSArray *segmentIDs = plist[@"SegmentIDs"];
+    NSArray *contentHashes = plist[@"ContentHashes"];
+    NSArray *bundleIDs = plist[@"BundleIDs"];
+
+    BOOL valid = [plist isKindOfClass:[NSDictionary class]] &&
+        [plist[@"FormatVersion"] integerValue] == kTimelineFormatVersion &&
+        [starts isKindOfClass:[NSData class]] && [ends isKindOfClass:[NSData class]] &&
+        [segmentIDs isKindOfClass:[NSArray class]] && [contentHashes isKindOfClass:[NSArray class]] && [bundleIDs isKindOfClass:[NSArray class]];
+    NSUInteger count = segmentIDs.count;
+    valid = valid && starts.length == count * sizeof(int64_t) && ends.length == count * sizeof(int64_t) &&
+        contentHashes.count == count && bundleIDs.count == count;
+    if (!valid) {
+        if (error) {
+            *error = [NSError errorWithDomain:@"SCScheduleTimeline"
+                                         code:1
+                                     userInfo:@{NSLocalizedDescriptionKey: @"Schedule timeline file is malformed or from another version"}];
+        }
+        return nil;
+    }
+
+    const int64_t *startValues = starts.bytes;
+    const int64_t *endValues = ends.bytes;
+    NSMutableArray<SCTimelineSegment *> *segments = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [segments addObject:[SCTimelineSegment segmentWithID:segmentIDs[i]
+                                                   startDate:[NSDate dateWithTimeIntervalSince1970:startValues[i]]
+                                                     endDate:[NSDate dateWithTimeIntervalSince1970:endValues[i]]
+                                                 contentHash:contentHashes[i]
+                                                   bundleIDs:bundleIDs[i]]];
+    }
+
+    return [self timelineWithSegments:segments];
+}
+
+#pragma mark - Identity
+
++ (NSString *)segmentIDForStartDate:(NSDate *)startDate endDate:(NSDate *)endDate bundleIDs:(NSArray<NSString *> *)bundleIDs {
+    NSArray<NSString *> *sortedBundleIDs = [[[NSSet setWithArray:bundleIDs] allObjects] sortedArrayUsingSelector:@selector(compare:)];
+    NSString *key = [NSString stringWithFormat:@"%lld|%lld|%@",
+                     SCInstantForDate(startDate), SCInstantForDate(endDate), [sortedBundleIDs componentsJoinedByString:@","]];
+    return SCHexDigest([key dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
++ (NSString *)contentHashForBlocklist:(NSArray<NSString *> *)blocklist {
+    // the blocklist's key in the daemon's blocklist store
+    return [SCBlocklistStore digestForBlocklist:blocklist];
+}
+
+#pragma mark - Lookup
+
+- (NSUInteger)count {
+    return self.segments.count;
+}
+
+// number of segments starting at or before instant
+- (NSUInteger)countOfSegmentsStartingAtOrBefore:(int64_t)instant {
+    const int64_t *starts = startInstants_.bytes;
+    NSUInteger lo = 0, hi = self.count;
+    while (lo < hi) {
+        NSUInteger mid = lo + (hi - lo) / 2;
+        if (starts[mid] <= instant) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+- (nullable SCTimelineSegment *)segmentAtDate:(NSDate *)date {
+    int64_t instant = SCInstantForDate(date);
+    NSUInteger n = [self countOfSegmentsStartingAtOrBefore:instant];
+    if (n == 0) return nil;
+
+    // segments don't overlap, so only the latest one to start can contain date
+    const int64_t *ends = endInstants_.bytes;
+    return (instant < ends[n - 1]) ? self.segments[n - 1] : nil;
+}
+
+- (nullable SCTimelineSegment *)nextSegmentAfterDate:(NSDate *)date {
+    NSUInteger n = [self countOfSegmentsStartingAtOrBefore:SCInstantForDate(date)];
+    return (n < self.count) ? self.segments[n] : nil;
+}
+
+- (nullable SCTimelineSegment *)segmentWithID:(NSString *)segmentID {
+    NSNumber *index = self.indexesBySegmentID[segmentID];
+    return index ? self.segments[index.unsignedIntegerValue] : nil;
+}
+
+- (nullable NSDate *)blockEndDateForBundleID:(NSString *)bundleID atDate:(NSDate *)date {
+    int64_t instant = SCInstantForDate(date);
+    NSUInteger n = [self countOfSegmentsStartingAtOrBefore:instant];
+    const int64_t *starts = startInstants_.bytes;
+    const int64_t *ends = endInstants_.bytes;
+    if (n == 0 || instant >= ends[n - 1] || ![self.segments[n - 1].bundleIDs containsObject:bundleID]) {
+        return nil;
+    }
+
+    NSUInteger last = n - 1;
+    while (last + 1 < self.count &&
+           starts[last + 1] - ends[last] <= kScheduleTimelineMaxContinuationGapSecs &&
+           [self.segments[last + 1].bundleIDs containsObject:bundleID]) {
+        last++;
+    }
+    return self.segments[last].endDate;
+}
+
+@end
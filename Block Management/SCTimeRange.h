@@ -21,6 +21,10 @@ NS_ASSUME_NONNULL_BEGIN
 /// Creates a time range from start to end times
 + (instancetype)rangeWithStart:(NSString *)start end:(NSString *)end;
 
+/// Bumped every time any range's start or end time changes. Lets caches built from
+/// ranges (e.g. SCWeeklySchedule's transition table) notice in-place edits cheaply.
++ (uint64_t)mutationGeneration;
+
 /// Creates a time range from a dictionary (for persistence)
 + (nullable instancetype)rangeFromDictionary:(NSDictionary *)dict;
 
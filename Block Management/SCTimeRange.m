@@ -4,6 +4,25 @@
 //
 
 #import "SCTimeRange.h"
+#include <stdatomic.h>
+
+static _Atomic uint64_t gTimeRangeMutationGeneration = 0;
+
+static NSInteger SCMinutesFromTimeString(NSString *timeString) {
+    NSArray *components = [timeString componentsSeparatedByString:@":"];
+    if (components.count != 2) return 0;
+
+    NSInteger hours = [components[0] integerValue];
+    NSInteger minutes = [components[1] integerValue];
+    return hours * 60 + minutes;
+}
+
+@interface SCTimeRange () {
+    // parsed once when the time string is set, rather than on every startMinutes/endMinutes call
+    NSInteger _startMinutes;
+    NSInteger _endMinutes;
+}
+@end
 
 @implementation SCTimeRange
 
@@ -16,10 +35,28 @@
     if (self) {
         _startTime = @"00:00";
         _endTime = @"23:59";
+        _startMinutes = 0;
+        _endMinutes = 23 * 60 + 59;
     }
     return self;
 }
 
++ (uint64_t)mutationGeneration {
+    return atomic_load(&gTimeRangeMutationGeneration);
+}
+
+- (void)setStartTime:(NSString *)startTime {
+    _startTime = [startTime copy];
+    _startMinutes = SCMinutesFromTimeString(_startTime);
+    atomic_fetch_add(&gTimeRangeMutationGeneration, 1);
+}
+
+- (void)setEndTime:(NSString *)endTime {
+    _endTime = [endTime copy];
+    _endMinutes = SCMinutesFromTimeString(_endTime);
+    atomic_fetch_add(&gTimeRangeMutationGeneration, 1);
+}
+
 + (instancetype)rangeWithStart:(NSString *)start end:(NSString *)end {
     SCTimeRange *range = [[SCTimeRange alloc] init];
     range.startTime = start;
@@ -44,20 +81,15 @@
 #pragma mark - Time Calculations
 
 - (NSInteger)startMinutes {
-    return [self minutesFromTimeString:self.startTime];
+    return _startMinutes;
 }
 
 - (NSInteger)endMinutes {
-    return [self minutesFromTimeString:self.endTime];
+    return _endMinutes;
 }
 
 - (NSInteger)minutesFromTimeString:(NSString *)timeString {
-    NSArray *components = [timeString componentsSeparatedByString:@":"];
-    if (components.count != 2) return 0;
-
-    NSInteger hours = [components[0] integerValue];
-    NSInteger minutes = [components[1] integerValue];
-    return hours * 60 + minutes;
+    return SCMinutesFromTimeString(timeString);
 }
 
 - (NSInteger)durationMinutes {
@@ -173,6 +205,8 @@
     if (self) {
         _startTime = [coder decodeObjectOfClass:[NSString class] forKey:@"startTime"];
         _endTime = [coder decodeObjectOfClass:[NSString class] forKey:@"endTime"];
+        _startMinutes = SCMinutesFromTimeString(_startTime);
+        _endMinutes = SCMinutesFromTimeString(_endTime);
     }
     return self;
 }
@@ -30,6 +30,7 @@ typedef NS_ENUM(NSInteger, SCDayOfWeek) {
 /// Schedule for each day: @{ @"sunday": @[SCTimeRange, ...], @"monday": @[...], ... }
 /// Arrays contain SCTimeRange objects representing ALLOWED windows
 /// Empty array = blocked all day
+/// Prefer the day access methods below for changes: they keep the compiled transition table current
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<SCTimeRange *> *> *daySchedules;
 
 /// Creates an empty schedule for a bundle (blocked all day every day)
@@ -86,6 +87,10 @@ typedef NS_ENUM(NSInteger, SCDayOfWeek) {
 /// Returns the next state change time (when allowed -> blocked or blocked -> allowed)
 - (nullable NSDate *)nextStateChangeDate;
 
+/// Same as nextStateChangeDate, but measured from the given date instead of now.
+/// Looks up the answer in a compiled table of weekly transitions (rebuilt after edits) by binary search.
+- (nullable NSDate *)nextStateChangeDateAfterDate:(NSDate *)date;
+
 /// Returns human-readable status for current state
 - (NSString *)currentStatusString;
 
@@ -132,6 +137,9 @@ typedef NS_ENUM(NSInteger, SCDayOfWeek) {
 /// Returns a string key for storing week data (e.g., "2024-12-23")
 + (NSString *)weekKeyForDate:(NSDate *)date;
 
+/// Returns the start of the week a key from weekKeyForDate: names, or nil if it isn't one
++ (nullable NSDate *)weekStartDateForWeekKey:(NSString *)weekKey;
+
 @end
 
 NS_ASSUME_NONNULL_END
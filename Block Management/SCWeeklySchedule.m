@@ -4,6 +4,32 @@
 //
 
 #import "SCWeeklySchedule.h"
+#import "SCIntervalSet.h"
+
+static const NSInteger kMinutesPerDay = 24 * 60;
+static const NSInteger kMinutesPerWeek = 7 * kMinutesPerDay;
+
+/// Everything derived from the day schedules, built together and swapped in as one object
+@interface SCCompiledWeek : NSObject
+// allowed minutes with end times exclusive - what durations and launchd block windows use
+@property (nonatomic, strong) SCIntervalSet *allowedMinutes;
+// allowed minutes with end times inclusive - what -[SCTimeRange containsTimeInMinutes:] answers
+@property (nonatomic, strong) SCIntervalSet *inclusiveAllowedMinutes;
+// sorted minute-of-week offsets where inclusiveAllowedMinutes flips (wrapping around the week)
+@property (nonatomic, strong) NSData *transitionTable;
+// SCTimeRange mutation generation this was built at; any in-place range edit makes it stale
+@property (nonatomic, assign) uint64_t generation;
+@end
+
+@implementation SCCompiledWeek
+@end
+
+@interface SCWeeklySchedule ()
+
+// nil until first needed, and again after each edit
+@property (atomic, strong, nullable) SCCompiledWeek *compiledWeek;
+
+@end
 
 @implementation SCWeeklySchedule
 
@@ -88,6 +114,7 @@
 - (void)setAllowedWindows:(NSArray<SCTimeRange *> *)windows forDay:(SCDayOfWeek)day {
     NSString *key = [SCWeeklySchedule stringForDay:day];
     self.daySchedules[key] = [windows mutableCopy] ?: [NSMutableArray array];
+    [self invalidateCompiledWeek];
 }
 
 - (void)addAllowedWindow:(SCTimeRange *)window toDay:(SCDayOfWeek)day {
@@ -101,16 +128,24 @@
     [self.daySchedules[key] sortUsingComparator:^NSComparisonResult(SCTimeRange *r1, SCTimeRange *r2) {
         return [@([r1 startMinutes]) compare:@([r2 startMinutes])];
     }];
+    [self invalidateCompiledWeek];
 }
 
 - (void)removeAllowedWindow:(SCTimeRange *)window fromDay:(SCDayOfWeek)day {
     NSString *key = [SCWeeklySchedule stringForDay:day];
     [self.daySchedules[key] removeObject:window];
+    [self invalidateCompiledWeek];
 }
 
 - (void)clearDay:(SCDayOfWeek)day {
     NSString *key = [SCWeeklySchedule stringForDay:day];
     [self.daySchedules[key] removeAllObjects];
+    [self invalidateCompiledWeek];
+}
+
+- (void)setDaySchedules:(NSMutableDictionary<NSString *, NSMutableArray<SCTimeRange *> *> *)daySchedules {
+    _daySchedules = daySchedules;
+    [self invalidateCompiledWeek];
 }
 
 #pragma mark - Day String Conversion
@@ -192,6 +227,12 @@
 }
 
 - (BOOL)isAllowedOnDay:(SCDayOfWeek)day atMinutes:(NSInteger)minutesFromMidnight {
+    // a single binary search for any real day and minute
+    if (day >= SCDayOfWeekSunday && day <= SCDayOfWeekSaturday && minutesFromMidnight >= 0 && minutesFromMidnight < kMinutesPerDay) {
+        return [[self compiledWeekIfNeeded].inclusiveAllowedMinutes containsMinute:day * kMinutesPerDay + minutesFromMidnight];
+    }
+
+    // out-of-range minutes (e.g. 1440 against a window ending at "24:00") get the original per-window check
     NSArray<SCTimeRange *> *windows = [self allowedWindowsForDay:day];
 
     // No windows = blocked all day
@@ -210,49 +251,125 @@
 }
 
 - (nullable NSDate *)nextStateChangeDate {
-    BOOL currentlyAllowed = [self isAllowedNow];
-    SCDayOfWeek today = [SCWeeklySchedule today];
+    return [self nextStateChangeDateAfterDate:[NSDate date]];
+}
+
+- (nullable NSDate *)nextStateChangeDateAfterDate:(NSDate *)date {
+    NSData *table = [self compiledWeekIfNeeded].transitionTable;
+    const int32_t *transitions = table.bytes;
+    NSUInteger count = table.length / sizeof(int32_t);
+
+    // Same state all week long - nothing to change to
+    if (count == 0) {
+        return nil;
+    }
 
     NSCalendar *calendar = [NSCalendar currentCalendar];
-    NSDateComponents *nowComponents = [calendar components:(NSCalendarUnitHour | NSCalendarUnitMinute)
-                                                  fromDate:[NSDate date]];
+    NSDateComponents *nowComponents = [calendar components:(NSCalendarUnitWeekday | NSCalendarUnitHour | NSCalendarUnitMinute)
+                                                  fromDate:date];
+    SCDayOfWeek today = (SCDayOfWeek)(nowComponents.weekday - 1);
     NSInteger currentMinutes = nowComponents.hour * 60 + nowComponents.minute;
+    NSInteger nowOffset = today * kMinutesPerDay + currentMinutes;
+
+    // First transition strictly after now, wrapping into next week if there's none left this week
+    NSUInteger low = 0, high = count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (transitions[mid] <= nowOffset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    NSInteger minutesAhead = (low < count) ? transitions[low] - nowOffset : transitions[0] + kMinutesPerWeek - nowOffset;
 
-    // Search for next state change within the next 7 days
-    for (NSInteger dayOffset = 0; dayOffset < 7; dayOffset++) {
-        SCDayOfWeek checkDay = (today + dayOffset) % 7;
-        NSArray<SCTimeRange *> *windows = [self allowedWindowsForDay:checkDay];
+    // We only look ahead through the end of the 7th day (counting today), same as we always have
+    NSInteger minutesFromStartOfToday = currentMinutes + minutesAhead;
+    NSInteger dayOffset = minutesFromStartOfToday / kMinutesPerDay;
+    if (dayOffset >= 7) {
+        return nil;
+    }
+    NSInteger minute = minutesFromStartOfToday % kMinutesPerDay;
 
-        NSInteger startMinute = (dayOffset == 0) ? currentMinutes + 1 : 0;
+    NSDate *targetDate = [calendar dateByAddingUnit:NSCalendarUnitDay
+                                              value:dayOffset
+                                             toDate:date
+                                            options:0];
 
-        for (NSInteger minute = startMinute; minute < 24 * 60; minute++) {
-            BOOL allowedAtMinute = NO;
-            for (SCTimeRange *window in windows) {
-                if ([window containsTimeInMinutes:minute]) {
-                    allowedAtMinute = YES;
-                    break;
-                }
-            }
+    NSDateComponents *targetComponents = [calendar components:(NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay)
+                                                     fromDate:targetDate];
+    targetComponents.hour = minute / 60;
+    targetComponents.minute = minute % 60;
+
+    return [calendar dateFromComponents:targetComponents];
+}
+
+#pragma mark - Compiled Week
+
+- (void)invalidateCompiledWeek {
+    self.compiledWeek = nil;
+}
 
-            if (allowedAtMinute != currentlyAllowed) {
-                // Found a state change
-                NSDate *todayDate = [NSDate date];
-                NSDate *targetDate = [calendar dateByAddingUnit:NSCalendarUnitDay
-                                                          value:dayOffset
-                                                         toDate:todayDate
-                                                        options:0];
+- (SCCompiledWeek *)compiledWeekIfNeeded {
+    SCCompiledWeek *compiled = self.compiledWeek;
+    uint64_t generation = [SCTimeRange mutationGeneration];
+    if (compiled != nil && compiled.generation == generation) {
+        return compiled;
+    }
+
+    compiled = [SCCompiledWeek new];
+    compiled.generation = generation;
 
-                NSDateComponents *targetComponents = [calendar components:(NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay)
-                                                                 fromDate:targetDate];
-                targetComponents.hour = minute / 60;
-                targetComponents.minute = minute % 60;
+    NSMutableData *allowed = [NSMutableData data];
+    NSMutableData *inclusiveAllowed = [NSMutableData data];
+    void (^addInterval)(NSMutableData *, NSInteger, NSInteger) = ^(NSMutableData *intervals, NSInteger start, NSInteger end) {
+        if (end <= start) return;
+        NSRange interval = NSMakeRange((NSUInteger)start, (NSUInteger)(end - start));
+        [intervals appendBytes:&interval length:sizeof(interval)];
+    };
 
-                return [calendar dateFromComponents:targetComponents];
+    for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
+        NSInteger dayStart = day * kMinutesPerDay;
+        for (SCTimeRange *window in self.daySchedules[[SCWeeklySchedule stringForDay:day]]) {
+            // clamp to the day, so nothing spills into its neighbours
+            NSInteger start = MIN(MAX([window startMinutes], 0), kMinutesPerDay);
+            NSInteger end = MIN(MAX([window endMinutes], 0), kMinutesPerDay);
+            NSInteger inclusiveEnd = MIN([window endMinutes] + 1, kMinutesPerDay);
+
+            if ([window startMinutes] <= [window endMinutes]) {
+                addInterval(allowed, dayStart + start, dayStart + end);
+                addInterval(inclusiveAllowed, dayStart + start, dayStart + inclusiveEnd);
+            } else {
+                // overnight range: from start to midnight, and from midnight to end
+                addInterval(allowed, dayStart + start, dayStart + kMinutesPerDay);
+                addInterval(allowed, dayStart, dayStart + end);
+                addInterval(inclusiveAllowed, dayStart + start, dayStart + kMinutesPerDay);
+                addInterval(inclusiveAllowed, dayStart, dayStart + inclusiveEnd);
             }
         }
     }
+    compiled.allowedMinutes = [SCIntervalSet setWithIntervals:allowed.bytes count:allowed.length / sizeof(NSRange)];
+    compiled.inclusiveAllowedMinutes = [SCIntervalSet setWithIntervals:inclusiveAllowed.bytes count:inclusiveAllowed.length / sizeof(NSRange)];
+
+    // Every interval boundary is a transition, except at the ends of the week: minute 0
+    // is compared with the week's last minute, so it only flips if exactly one is allowed
+    NSMutableData *transitions = [NSMutableData data];
+    SCIntervalSet *inclusiveAllowedMinutes = compiled.inclusiveAllowedMinutes;
+    if ([inclusiveAllowedMinutes containsMinute:0] != [inclusiveAllowedMinutes containsMinute:kMinutesPerWeek - 1]) {
+        int32_t minute = 0;
+        [transitions appendBytes:&minute length:sizeof(minute)];
+    }
+    [inclusiveAllowedMinutes enumerateIntervalsUsingBlock:^(NSRange interval, BOOL *stop) {
+        int32_t boundaries[2] = { (int32_t)interval.location, (int32_t)NSMaxRange(interval) };
+        for (int i = 0; i < 2; i++) {
+            if (boundaries[i] == 0 || boundaries[i] == kMinutesPerWeek) continue;
+            [transitions appendBytes:&boundaries[i] length:sizeof(int32_t)];
+        }
+    }];
+    compiled.transitionTable = transitions;
 
-    return nil;
+    self.compiledWeek = compiled;
+    return compiled;
 }
 
 - (NSString *)currentStatusString {
@@ -285,12 +402,11 @@
 }
 
 - (NSInteger)totalAllowedMinutesForDay:(SCDayOfWeek)day {
-    NSArray<SCTimeRange *> *windows = [self allowedWindowsForDay:day];
-    NSInteger total = 0;
-    for (SCTimeRange *window in windows) {
-        total += [window durationMinutes];
-    }
-    return total;
+    if (day < SCDayOfWeekSunday || day > SCDayOfWeekSaturday) return 0;
+
+    // overlapping windows were coalesced when the week was compiled, so they only count once
+    SCIntervalSet *dayMinutes = [SCIntervalSet setWithInterval:NSMakeRange(day * kMinutesPerDay, kMinutesPerDay)];
+    return [[[self compiledWeekIfNeeded].allowedMinutes setByIntersectingWithSet:dayMinutes] totalLength];
 }
 
 - (BOOL)hasAllowedWindowsForDay:(SCDayOfWeek)day {
@@ -414,11 +530,23 @@
     return [calendar startOfDayForDate:monday];
 }
 
-+ (NSString *)weekKeyForDate:(NSDate *)date {
-    NSDate *weekStart = [self startOfWeekContaining:date];
+/// Week keys are stored, so they're always Gregorian ISO dates whatever the user's locale and calendar
++ (NSDateFormatter *)weekKeyFormatter {
     NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.calendar = [NSCalendar calendarWithIdentifier:NSCalendarIdentifierGregorian];
     formatter.dateFormat = @"yyyy-MM-dd";
-    return [formatter stringFromDate:weekStart];
+    return formatter;
+}
+
++ (NSString *)weekKeyForDate:(NSDate *)date {
+    NSDate *weekStart = [self startOfWeekContaining:date];
+    return [[self weekKeyFormatter] stringFromDate:weekStart];
+}
+
++ (nullable NSDate *)weekStartDateForWeekKey:(NSString *)weekKey {
+    NSDate *date = [[self weekKeyFormatter] dateFromString:weekKey];
+    return date ? [self startOfWeekContaining:date] : nil;
 }
 
 #pragma mark - NSCopying
@@ -17,9 +17,19 @@ NS_ASSUME_NONNULL_BEGIN
 // in blockInfo.
 + (BOOL)writeBlocklistToFileURL:(NSURL*)targetFileURL blockInfo:(NSDictionary*)blockInfo error:(NSError*_Nullable*_Nullable)errRef;
 
+// Writes the same block info in the compact binary format (see SCCompactBlocklist).
+// The blocklist is stored sorted and deduplicated. Meant for files the app writes for
+// its own use (e.g. scheduled blocks); files saved for the user stay plists, which
+// older versions can still open.
++ (BOOL)writeCompactBlocklistToFileURL:(NSURL*)targetFileURL blockInfo:(NSDictionary*)blockInfo error:(NSError*_Nullable*_Nullable)errRef;
+
 // reads in a saved .selfcontrol blocklist file and returns
 // an NSDictionary with the block settings contained
-// (properties are Blocklist and BlockAsWhitelist)
+// (properties are Blocklist and BlockAsWhitelist).
+// Accepts both the plist and the compact format. Either way the
+// whole blocklist is read into the returned array; the compact
+// format only saves the plist parse, so callers that don't need
+// every entry should open an SCCompactBlocklist themselves.
 + (NSDictionary*)readBlocklistFromFile:(NSURL*)fileURL;
 
 @end
@@ -6,6 +6,7 @@
 //
 
 #import "SCBlockFileReaderWriter.h"
+#import "SCCompactBlocklist.h"
 
 @implementation SCBlockFileReaderWriter
 
@@ -31,8 +32,42 @@
     return YES;
 }
 
++ (BOOL)writeCompactBlocklistToFileURL:(NSURL*)targetFileURL blockInfo:(NSDictionary*)blockInfo error:(NSError**)errRef {
+    NSData* saveData = [SCCompactBlocklist dataWithBlocklist: blockInfo[@"Blocklist"]
+                                                 isAllowlist: [blockInfo[@"BlockAsWhitelist"] boolValue]];
+
+    if (![saveData writeToURL: targetFileURL atomically: YES]) {
+        NSLog(@"ERROR: Failed to write compact blocklist to URL %@", targetFileURL);
+        if (errRef != NULL) *errRef = [SCErr errorWithCode: 106];
+        return NO;
+    }
+
+    return YES;
+}
+
 + (NSDictionary*)readBlocklistFromFile:(NSURL*)fileURL {
-    NSDictionary* openedDict = [NSDictionary dictionaryWithContentsOfURL: fileURL];
+    NSData* fileData = [NSData dataWithContentsOfURL: fileURL options: NSDataReadingMappedIfSafe error: nil];
+
+    if (fileData != nil && [SCCompactBlocklist isCompactBlocklistData: fileData]) {
+        NSError* compactErr = nil;
+        SCCompactBlocklist* compactBlocklist = [SCCompactBlocklist blocklistWithData: fileData error: &compactErr];
+        if (compactBlocklist == nil) {
+            NSLog(@"ERROR: Could not read a valid block from file %@: %@", fileURL, compactErr);
+            return nil;
+        }
+
+        // the daemon takes the blocklist as an array, so every entry gets created here
+        return @{
+            @"Blocklist": [compactBlocklist allEntries],
+            @"BlockAsWhitelist": @(compactBlocklist.isAllowlist)
+        };
+    }
+
+    NSDictionary* openedDict = nil;
+    if (fileData != nil) {
+        openedDict = [NSPropertyListSerialization propertyListWithData: fileData options: NSPropertyListImmutable format: nil error: nil];
+    }
+    if (![openedDict isKindOfClass: [NSDictionary class]]) openedDict = nil;
     
     if (openedDict == nil || openedDict[@"HostBlacklist"] == nil || openedDict[@"BlockAsWhitelist"] == nil) {
         NSLog(@"ERROR: Could not read a valid block from file %@", fileURL);
@@ -0,0 +1,53 @@
+//
+//  SCBlocklistStore.h
+//  SelfControl
+//
+//  Content-addressed blocklists. Each distinct blocklist is kept once, keyed by the digest
+//  of its contents, and approved schedules refer to it by that digest instead of carrying
+//  their own copy. Blocklists no schedule refers to any more are garbage collected.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCBlocklistStore : NSObject
+
+/// The form a blocklist is stored in: entries deduplicated and sorted, since neither
+/// order nor repeats change what gets blocked
++ (NSArray<NSString*>*)canonicalBlocklist:(NSArray<NSString*>*)blocklist;
+
+/// Hex digest of the canonical blocklist (the same value SCScheduleTimeline uses as a segment's contentHash)
++ (NSString*)digestForBlocklist:(NSArray<NSString*>*)blocklist;
+
+/// Resolves an ApprovedSchedules entry's blocklist: by its blocklistDigest from blocklists,
+/// or the inline blocklist of entries registered before the store existed
++ (nullable NSArray<NSString*>*)blocklistForApprovedSchedule:(NSDictionary*)schedule
+                                                inBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists;
+
+/// How many ApprovedSchedules entries refer to each digest
++ (NSCountedSet<NSString*>*)referenceCountsForApprovedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules;
+
+/// blocklists is digest -> canonical blocklist, as stored in settings
+- (instancetype)initWithBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists;
+
+/// Everything stored, digest -> canonical blocklist
+@property (readonly) NSDictionary<NSString*, NSArray<NSString*>*>* blocklists;
+
+@property (readonly) NSUInteger count;
+
+/// Stores the blocklist unless it's already there; returns its digest
+- (NSString*)addBlocklist:(NSArray<NSString*>*)blocklist;
+
+/// Stores a blocklist that arrived with its digest, after checking the digest really is
+/// the digest of its contents. Returns NO (and stores nothing) if it isn't.
+- (BOOL)addBlocklist:(NSArray<NSString*>*)blocklist withDigest:(NSString*)digest;
+
+- (nullable NSArray<NSString*>*)blocklistForDigest:(NSString*)digest;
+
+/// Removes every blocklist that no entry of approvedSchedules refers to; returns how many went
+- (NSUInteger)removeBlocklistsUnreferencedByApprovedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,112 @@
+//
+//  SCBlocklistStore.m
+//  SelfControl
+//
+
+#import "SCBlocklistStore.h"
+#import <CommonCrypto/CommonDigest.h>
+
+@interface SCBlocklistStore () {
+    NSMutableDictionary<NSString*, NSArray<NSString*>*>* blocklists_;
+}
+@end
+
+@implementation SCBlocklistStore
+
++ (NSArray<NSString*>*)canonicalBlocklist:(NSArray<NSString*>*)blocklist {
+    return [[[NSSet setWithArray: blocklist] allObjects] sortedArrayUsingSelector: @selector(compare:)];
+}
+
++ (NSString*)digestForBlocklist:(NSArray<NSString*>*)blocklist {
+    NSData* data = [[[self canonicalBlocklist: blocklist] componentsJoinedByString: @"\n"] dataUsingEncoding: NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+
+    // 128 bits is plenty to tell blocklists apart
+    NSMutableString* hex = [NSMutableString stringWithCapacity: 32];
+    for (int i = 0; i < 16; i++) {
+        [hex appendFormat: @"%02x", digest[i]];
+    }
+    return hex;
+}
+
++ (nullable NSArray<NSString*>*)blocklistForApprovedSchedule:(NSDictionary*)schedule
+                                                inBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists {
+    NSString* digest = schedule[@"blocklistDigest"];
+    if ([digest isKindOfClass: [NSString class]]) {
+        return blocklists[digest];
+    }
+    NSArray* inlineBlocklist = schedule[@"blocklist"];
+    return [inlineBlocklist isKindOfClass: [NSArray class]] ? inlineBlocklist : nil;
+}
+
++ (NSCountedSet<NSString*>*)referenceCountsForApprovedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules {
+    NSCountedSet<NSString*>* counts = [NSCountedSet set];
+    for (NSString* scheduleId in approvedSchedules) {
+        NSString* digest = approvedSchedules[scheduleId][@"blocklistDigest"];
+        if ([digest isKindOfClass: [NSString class]]) {
+            [counts addObject: digest];
+        }
+    }
+    return counts;
+}
+
+- (instancetype)initWithBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists {
+    if (self = [super init]) {
+        blocklists_ = [blocklists mutableCopy] ?: [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (instancetype)init {
+    return [self initWithBlocklists: nil];
+}
+
+- (NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists {
+    return [blocklists_ copy];
+}
+
+- (NSUInteger)count {
+    return blocklists_.count;
+}
+
+- (NSString*)addBlocklist:(NSArray<NSString*>*)blocklist {
+    NSString* digest = [SCBlocklistStore digestForBlocklist: blocklist];
+    if (blocklists_[digest] == nil) {
+        blocklists_[digest] = [SCBlocklistStore canonicalBlocklist: blocklist];
+    }
+    return digest;
+}
+
+- (BOOL)addBlocklist:(NSArray<NSString*>*)blocklist withDigest:(NSString*)digest {
+    if (![blocklist isKindOfClass: [NSArray class]] || ![digest isKindOfClass: [NSString class]]) return NO;
+    for (id entry in blocklist) {
+        if (![entry isKindOfClass: [NSString class]]) return NO;
+    }
+
+    if (![[SCBlocklistStore digestForBlocklist: blocklist] isEqualToString: digest]) {
+        NSLog(@"WARNING: Rejecting blocklist whose contents don't match digest %@", digest);
+        return NO;
+    }
+    [self addBlocklist: blocklist];
+    return YES;
+}
+
+- (nullable NSArray<NSString*>*)blocklistForDigest:(NSString*)digest {
+    return blocklists_[digest];
+}
+
+- (NSUInteger)removeBlocklistsUnreferencedByApprovedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules {
+    NSCountedSet<NSString*>* referenceCounts = [SCBlocklistStore referenceCountsForApprovedSchedules: approvedSchedules];
+
+    NSMutableArray<NSString*>* unreferenced = [NSMutableArray array];
+    for (NSString* digest in blocklists_) {
+        if ([referenceCounts countForObject: digest] == 0) {
+            [unreferenced addObject: digest];
+        }
+    }
+    [blocklists_ removeObjectsForKeys: unreferenced];
+    return unreferenced.count;
+}
+
+@end
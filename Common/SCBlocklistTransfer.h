@@ -0,0 +1,38 @@
+//
+//  SCBlocklistTransfer.h
+//  SelfControl
+//
+//  Bulk path for sending a large blocklist to the daemon. Instead of an array that NSXPC
+//  archives and unarchives string by string, the sender writes the list in the compact
+//  format (see SCCompactBlocklist) to an unlinked file and sends a read-only descriptor for
+//  it along with the list's SCBlocklistStore digest. The daemon maps the file and checks
+//  the digest before it uses anything it read.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Blocklists with at least this many entries are sent as a file; below it the archived
+/// array is just as fast and there's no file to create
+extern const NSUInteger SCBlocklistTransferMinimumCount;
+
+@interface SCBlocklistTransfer : NSObject
+
+/// Whether the blocklist is big enough to be worth sending as a file
++ (BOOL)shouldTransferBlocklist:(NSArray<NSString*>*)blocklist;
+
+/// Encodes the blocklist into an unlinked temporary file and returns a read-only handle to it.
+/// Nobody holds a writable descriptor for the file once this returns.
++ (nullable NSFileHandle*)fileHandleForBlocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist error:(NSError**)error;
+
+/// Maps the file read-only and decodes its entries. Fails unless the entries' digest is digest,
+/// so a file that doesn't hold what the sender claimed (or changed since) is never used.
++ (nullable NSArray<NSString*>*)blocklistFromFileHandle:(NSFileHandle*)fileHandle
+                                                 digest:(NSString*)digest
+                                            isAllowlist:(nullable BOOL*)isAllowlist
+                                                  error:(NSError**)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
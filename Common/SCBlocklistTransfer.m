@@ -0,0 +1,128 @@
+//
+//  SCBlocklistTransfer.m
+//  SelfControl
+//
+
+#import "SCBlocklistTransfer.h"
+#import "SCCompactBlocklist.h"
+#import "SCBlocklistStore.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const NSUInteger SCBlocklistTransferMinimumCount = 1000;
+
+// far more than any real blocklist; anything bigger isn't mapped at all
+static const off_t kBlocklistTransferMaxLength = 64 * 1024 * 1024;
+
+@implementation SCBlocklistTransfer
+
++ (NSError*)posixErrorWithDescription:(NSString*)description {
+    int code = errno;
+    return [NSError errorWithDomain: NSPOSIXErrorDomain code: code userInfo: @{
+        NSLocalizedDescriptionKey: [NSString stringWithFormat: @"%@: %s", description, strerror(code)]
+    }];
+}
+
++ (BOOL)shouldTransferBlocklist:(NSArray<NSString*>*)blocklist {
+    return blocklist.count >= SCBlocklistTransferMinimumCount;
+}
+
++ (nullable NSFileHandle*)fileHandleForBlocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist error:(NSError**)error {
+    NSData* data = [SCCompactBlocklist dataWithBlocklist: blocklist isAllowlist: isAllowlist];
+
+    NSString* template = [NSTemporaryDirectory() stringByAppendingPathComponent: @"SCBlocklistTransfer.XXXXXX"];
+    char path[PATH_MAX];
+    if (strlcpy(path, template.fileSystemRepresentation, sizeof(path)) >= sizeof(path)) {
+        errno = ENAMETOOLONG;
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't create blocklist transfer file"];
+        return nil;
+    }
+
+    int writeFd = mkstemp(path);
+    if (writeFd < 0) {
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't create blocklist transfer file"];
+        return nil;
+    }
+
+    const uint8_t* bytes = data.bytes;
+    size_t remaining = data.length;
+    while (remaining > 0) {
+        ssize_t written = write(writeFd, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't write blocklist transfer file"];
+            unlink(path);
+            close(writeFd);
+            return nil;
+        }
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+
+    // Hand over a read-only descriptor and drop the writable one (and the name), so the
+    // contents can't change under the daemon's mapping once it's been sent
+    int readFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (readFd < 0 && error != NULL) {
+        *error = [self posixErrorWithDescription: @"Couldn't reopen blocklist transfer file"];
+    }
+    unlink(path);
+    close(writeFd);
+    if (readFd < 0) return nil;
+
+    return [[NSFileHandle alloc] initWithFileDescriptor: readFd closeOnDealloc: YES];
+}
+
++ (nullable NSArray<NSString*>*)blocklistFromFileHandle:(NSFileHandle*)fileHandle
+                                                 digest:(NSString*)digest
+                                            isAllowlist:(nullable BOOL*)isAllowlist
+                                                  error:(NSError**)error {
+    int fd = fileHandle.fileDescriptor;
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't read blocklist transfer file"];
+        return nil;
+    }
+    if (!S_ISREG(fileInfo.st_mode) || fileInfo.st_size <= 0 || fileInfo.st_size > kBlocklistTransferMaxLength) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain: @"SCBlocklistTransfer" code: 1 userInfo: @{
+                NSLocalizedDescriptionKey: @"The blocklist transfer file isn't a regular file of a sensible size."
+            }];
+        }
+        return nil;
+    }
+
+    size_t length = (size_t)fileInfo.st_size;
+    void* map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't map blocklist transfer file"];
+        return nil;
+    }
+
+    // the mapping goes away with the last reference to data, once the entries are copied out
+    NSData* data = [[NSData alloc] initWithBytesNoCopy: map length: length deallocator:^(void* bytes, NSUInteger mappedLength) {
+        munmap(bytes, mappedLength);
+    }];
+    SCCompactBlocklist* compactBlocklist = [SCCompactBlocklist blocklistWithData: data error: error];
+    if (compactBlocklist == nil) return nil;
+
+    // copied out once, so the digest below covers exactly what the caller gets back
+    NSArray<NSString*>* blocklist = [compactBlocklist allEntries];
+    BOOL fileIsAllowlist = compactBlocklist.isAllowlist;
+
+    if (![[SCBlocklistStore digestForBlocklist: blocklist] isEqualToString: digest]) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain: @"SCBlocklistTransfer" code: 2 userInfo: @{
+                NSLocalizedDescriptionKey: @"The transferred blocklist doesn't match its digest."
+            }];
+        }
+        return nil;
+    }
+
+    if (isAllowlist != NULL) *isAllowlist = fileIsAllowlist;
+    return blocklist;
+}
+
+@end
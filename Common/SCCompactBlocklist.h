@@ -0,0 +1,56 @@
+//
+//  SCCompactBlocklist.h
+//  SelfControl
+//
+//  Compact binary blocklist format for .selfcontrol files: a fixed header, one kind tag
+//  per entry, an offset table and a sorted, deduplicated UTF-8 string table. Files are
+//  mapped rather than read, and entries only become NSStrings when they're asked for.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(uint8_t, SCCompactBlocklistEntryKind) {
+    SCCompactBlocklistEntryKindHost = 0,
+    /// Has a mask length or port, so it needs SCBlockEntry's full parse
+    SCCompactBlocklistEntryKindNetwork = 1,
+    /// "app:<bundle ID>"
+    SCCompactBlocklistEntryKindApp = 2
+};
+
+@interface SCCompactBlocklist : NSObject
+
+/// Whether data starts with the compact format's magic number
++ (BOOL)isCompactBlocklistData:(NSData*)data;
+
+/// Encodes the blocklist, sorted by UTF-8 bytes and with duplicates removed
++ (NSData*)dataWithBlocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist;
+
+/// Maps the file (when it's safe to) and checks its header. Entries aren't touched until read.
++ (nullable instancetype)blocklistWithContentsOfURL:(NSURL*)fileURL error:(NSError**)error;
+
++ (nullable instancetype)blocklistWithData:(NSData*)data error:(NSError**)error;
+
++ (SCCompactBlocklistEntryKind)kindOfEntry:(NSString*)entry;
+
+@property (readonly) NSUInteger count;
+@property (readonly) BOOL isAllowlist;
+
+/// nil if the index is out of range or the entry is corrupt
+- (nullable NSString*)entryAtIndex:(NSUInteger)index;
+
+- (SCCompactBlocklistEntryKind)kindOfEntryAtIndex:(NSUInteger)index;
+
+/// Binary search over the string table; doesn't create a string per entry
+- (BOOL)containsEntry:(NSString*)entry;
+
+/// Creates each entry's string only as the enumeration reaches it. Corrupt entries are skipped.
+- (void)enumerateEntriesUsingBlock:(void (^)(NSString* entry, SCCompactBlocklistEntryKind kind, BOOL* stop))block;
+
+/// Every entry, for callers that need the blocklist as an array
+- (NSArray<NSString*>*)allEntries;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,290 @@
+//
+//  SCCompactBlocklist.m
+//  SelfControl
+//
+
+#import "SCCompactBlocklist.h"
+
+// Layout, all integers little-endian:
+//
+//   0  magic "SCBL"
+//   4  uint16 version
+//   6  uint16 flags (bit 0: allowlist)
+//   8  uint32 entry count (n)
+//  12  uint32 offset of the kind tags (n bytes)
+//  16  uint32 offset of the string offset table (n + 1 uint32s, relative to the string table)
+//  20  uint32 offset of the string table
+//  24  uint32 length of the string table
+//  28  uint32 reserved
+//
+// Entry i is the UTF-8 bytes [offsets[i], offsets[i + 1]) of the string table.
+// Entries are sorted by those bytes, which is what lets -containsEntry: binary search.
+
+static const char kCompactBlocklistMagic[4] = { 'S', 'C', 'B', 'L' };
+static const uint16_t kCompactBlocklistVersion = 1;
+static const uint16_t kCompactBlocklistFlagAllowlist = 1 << 0;
+static const NSUInteger kCompactBlocklistHeaderLength = 32;
+
+typedef struct {
+    const char* bytes;
+    size_t length;
+} SCCompactBlocklistString;
+
+static int SCCompareCompactBlocklistStrings(const void* a, const void* b) {
+    const SCCompactBlocklistString* stringA = a;
+    const SCCompactBlocklistString* stringB = b;
+    int result = memcmp(stringA->bytes, stringB->bytes, MIN(stringA->length, stringB->length));
+    if (result != 0) return result;
+    if (stringA->length == stringB->length) return 0;
+    return (stringA->length < stringB->length) ? -1 : 1;
+}
+
+static uint32_t SCReadLittleUInt32(const uint8_t* bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static uint16_t SCReadLittleUInt16(const uint8_t* bytes) {
+    uint16_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt16LittleToHost(value);
+}
+
+static void SCAppendLittleUInt32(NSMutableData* data, uint32_t value) {
+    uint32_t littleValue = CFSwapInt32HostToLittle(value);
+    [data appendBytes: &littleValue length: sizeof(littleValue)];
+}
+
+static void SCAppendLittleUInt16(NSMutableData* data, uint16_t value) {
+    uint16_t littleValue = CFSwapInt16HostToLittle(value);
+    [data appendBytes: &littleValue length: sizeof(littleValue)];
+}
+
+@interface SCCompactBlocklist () {
+    NSData* data_;
+    const uint8_t* kinds_;
+    const uint8_t* offsets_;
+    const uint8_t* strings_;
+    uint32_t stringsLength_;
+    NSUInteger count_;
+    BOOL isAllowlist_;
+}
+@end
+
+@implementation SCCompactBlocklist
+
++ (BOOL)isCompactBlocklistData:(NSData*)data {
+    return data.length >= sizeof(kCompactBlocklistMagic) && memcmp(data.bytes, kCompactBlocklistMagic, sizeof(kCompactBlocklistMagic)) == 0;
+}
+
++ (SCCompactBlocklistEntryKind)kindOfEntry:(NSString*)entry {
+    if ([entry hasPrefix: @"app:"]) return SCCompactBlocklistEntryKindApp;
+    if ([entry rangeOfCharacterFromSet: [NSCharacterSet characterSetWithCharactersInString: @"/:"]].location != NSNotFound) {
+        return SCCompactBlocklistEntryKindNetwork;
+    }
+    return SCCompactBlocklistEntryKindHost;
+}
+
++ (NSData*)dataWithBlocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist {
+    NSArray<NSString*>* uniqueEntries = [[NSSet setWithArray: blocklist] allObjects];
+    NSUInteger count = uniqueEntries.count;
+
+    // the UTF8String buffers live as long as the strings in uniqueEntries do
+    SCCompactBlocklistString* sortedStrings = malloc(MAX(count, 1) * sizeof(SCCompactBlocklistString));
+    for (NSUInteger i = 0; i < count; i++) {
+        const char* bytes = uniqueEntries[i].UTF8String;
+        sortedStrings[i] = (SCCompactBlocklistString){ bytes, strlen(bytes) };
+    }
+    qsort(sortedStrings, count, sizeof(SCCompactBlocklistString), SCCompareCompactBlocklistStrings);
+
+    // different NSStrings can still encode to the same bytes
+    NSUInteger uniqueCount = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (uniqueCount > 0 && SCCompareCompactBlocklistStrings(&sortedStrings[uniqueCount - 1], &sortedStrings[i]) == 0) continue;
+        sortedStrings[uniqueCount++] = sortedStrings[i];
+    }
+
+    NSMutableData* kinds = [NSMutableData dataWithCapacity: uniqueCount];
+    NSMutableData* offsets = [NSMutableData dataWithCapacity: (uniqueCount + 1) * sizeof(uint32_t)];
+    NSMutableData* strings = [NSMutableData data];
+    for (NSUInteger i = 0; i < uniqueCount; i++) {
+        SCAppendLittleUInt32(offsets, (uint32_t)strings.length);
+        [strings appendBytes: sortedStrings[i].bytes length: sortedStrings[i].length];
+
+        NSString* entry = [[NSString alloc] initWithBytesNoCopy: (void*)sortedStrings[i].bytes
+                                                         length: sortedStrings[i].length
+                                                       encoding: NSUTF8StringEncoding
+                                                   freeWhenDone: NO];
+        uint8_t kind = [SCCompactBlocklist kindOfEntry: entry];
+        [kinds appendBytes: &kind length: 1];
+    }
+    SCAppendLittleUInt32(offsets, (uint32_t)strings.length);
+    free(sortedStrings);
+
+    uint32_t kindsOffset = (uint32_t)kCompactBlocklistHeaderLength;
+    // keeps the offset table 4-byte aligned
+    uint32_t offsetsOffset = (kindsOffset + (uint32_t)kinds.length + 3) & ~(uint32_t)3;
+    uint32_t stringsOffset = offsetsOffset + (uint32_t)offsets.length;
+
+    NSMutableData* data = [NSMutableData dataWithCapacity: stringsOffset + strings.length];
+    [data appendBytes: kCompactBlocklistMagic length: sizeof(kCompactBlocklistMagic)];
+    SCAppendLittleUInt16(data, kCompactBlocklistVersion);
+    SCAppendLittleUInt16(data, isAllowlist ? kCompactBlocklistFlagAllowlist : 0);
+    SCAppendLittleUInt32(data, (uint32_t)uniqueCount);
+    SCAppendLittleUInt32(data, kindsOffset);
+    SCAppendLittleUInt32(data, offsetsOffset);
+    SCAppendLittleUInt32(data, stringsOffset);
+    SCAppendLittleUInt32(data, (uint32_t)strings.length);
+    SCAppendLittleUInt32(data, 0);
+    [data appendData: kinds];
+    [data setLength: offsetsOffset];
+    [data appendData: offsets];
+    [data appendData: strings];
+
+    return data;
+}
+
++ (nullable instancetype)blocklistWithContentsOfURL:(NSURL*)fileURL error:(NSError**)error {
+    NSData* data = [NSData dataWithContentsOfURL: fileURL options: NSDataReadingMappedIfSafe error: error];
+    if (data == nil) return nil;
+
+    return [self blocklistWithData: data error: error];
+}
+
++ (nullable instancetype)blocklistWithData:(NSData*)data error:(NSError**)error {
+    return [[SCCompactBlocklist alloc] initWithData: data error: error];
+}
+
+- (nullable instancetype)initWithData:(NSData*)data error:(NSError**)error {
+    if (![SCCompactBlocklist isCompactBlocklistData: data] || data.length < kCompactBlocklistHeaderLength) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain: @"SCCompactBlocklist" code: 1 userInfo: @{
+                NSLocalizedDescriptionKey: @"Not a compact blocklist file."
+            }];
+        }
+        return nil;
+    }
+
+    const uint8_t* bytes = data.bytes;
+    uint16_t version = SCReadLittleUInt16(bytes + 4);
+    if (version != kCompactBlocklistVersion) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain: @"SCCompactBlocklist" code: 2 userInfo: @{
+                NSLocalizedDescriptionKey: [NSString stringWithFormat: @"Unsupported compact blocklist version %d.", version]
+            }];
+        }
+        return nil;
+    }
+
+    uint16_t flags = SCReadLittleUInt16(bytes + 6);
+    uint32_t count = SCReadLittleUInt32(bytes + 8);
+    uint32_t kindsOffset = SCReadLittleUInt32(bytes + 12);
+    uint32_t offsetsOffset = SCReadLittleUInt32(bytes + 16);
+    uint32_t stringsOffset = SCReadLittleUInt32(bytes + 20);
+    uint32_t stringsLength = SCReadLittleUInt32(bytes + 24);
+
+    // only the sections' bounds are checked here; each entry's offsets are checked as it's read
+    uint64_t length = data.length;
+    BOOL sectionsFit = (uint64_t)kindsOffset + count <= length
+        && (uint64_t)offsetsOffset + ((uint64_t)count + 1) * sizeof(uint32_t) <= length
+        && (uint64_t)stringsOffset + stringsLength <= length;
+    if (!sectionsFit) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain: @"SCCompactBlocklist" code: 3 userInfo: @{
+                NSLocalizedDescriptionKey: @"The compact blocklist file is truncated or corrupt."
+            }];
+        }
+        return nil;
+    }
+
+    if (self = [super init]) {
+        data_ = data;
+        count_ = count;
+        isAllowlist_ = (flags & kCompactBlocklistFlagAllowlist) != 0;
+        kinds_ = bytes + kindsOffset;
+        offsets_ = bytes + offsetsOffset;
+        strings_ = bytes + stringsOffset;
+        stringsLength_ = stringsLength;
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    return count_;
+}
+
+- (BOOL)isAllowlist {
+    return isAllowlist_;
+}
+
+// NO if the entry's offsets don't fit in the string table
+- (BOOL)getBytes:(const char**)bytes length:(size_t*)length ofEntryAtIndex:(NSUInteger)index {
+    if (index >= count_) return NO;
+
+    uint32_t start = SCReadLittleUInt32(offsets_ + index * sizeof(uint32_t));
+    uint32_t end = SCReadLittleUInt32(offsets_ + (index + 1) * sizeof(uint32_t));
+    if (start > end || end > stringsLength_) return NO;
+
+    *bytes = (const char*)strings_ + start;
+    *length = end - start;
+    return YES;
+}
+
+- (nullable NSString*)entryAtIndex:(NSUInteger)index {
+    const char* bytes;
+    size_t length;
+    if (![self getBytes: &bytes length: &length ofEntryAtIndex: index]) return nil;
+
+    // copies, so the entry outlives the mapping
+    return [[NSString alloc] initWithBytes: bytes length: length encoding: NSUTF8StringEncoding];
+}
+
+- (SCCompactBlocklistEntryKind)kindOfEntryAtIndex:(NSUInteger)index {
+    if (index >= count_) return SCCompactBlocklistEntryKindHost;
+    return kinds_[index];
+}
+
+- (BOOL)containsEntry:(NSString*)entry {
+    const char* utf8 = entry.UTF8String;
+    if (utf8 == NULL) return NO;
+    SCCompactBlocklistString target = { utf8, strlen(utf8) };
+
+    NSUInteger lo = 0, hi = count_;
+    while (lo < hi) {
+        NSUInteger mid = lo + (hi - lo) / 2;
+        SCCompactBlocklistString candidate;
+        if (![self getBytes: &candidate.bytes length: &candidate.length ofEntryAtIndex: mid]) return NO;
+
+        int comparison = SCCompareCompactBlocklistStrings(&candidate, &target);
+        if (comparison == 0) return YES;
+        if (comparison < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NO;
+}
+
+- (void)enumerateEntriesUsingBlock:(void (^)(NSString* entry, SCCompactBlocklistEntryKind kind, BOOL* stop))block {
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < count_ && !stop; i++) {
+        @autoreleasepool {
+            NSString* entry = [self entryAtIndex: i];
+            if (entry == nil) continue;
+            block(entry, kinds_[i], &stop);
+        }
+    }
+}
+
+- (NSArray<NSString*>*)allEntries {
+    NSMutableArray<NSString*>* entries = [NSMutableArray arrayWithCapacity: count_];
+    for (NSUInteger i = 0; i < count_; i++) {
+        NSString* entry = [self entryAtIndex: i];
+        if (entry != nil) [entries addObject: entry];
+    }
+    return entries;
+}
+
+@end
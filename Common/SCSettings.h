@@ -31,6 +31,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setValue:(id)value forKey:(NSString*)key stopPropagation:(BOOL)stopPropagation;
 - (void)setValue:(nullable id)value forKey:(NSString*)key;
 
+// Sets several values as a single change: one version bump, one change notification
+// (carrying the whole change set) and one pending sync. Use NSNull to unset a key.
+- (void)setValuesForKeys:(NSDictionary<NSString*, id>*)keyedValues stopPropagation:(BOOL)stopPropagation;
+- (void)setValuesForKeys:(NSDictionary<NSString*, id>*)keyedValues;
+
 - (id)valueForKey:(NSString*)key;
 - (BOOL)boolForKey:(NSString*)key;
 
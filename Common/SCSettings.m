@@ -6,6 +6,8 @@
 //
 
 #import "SCSettings.h"
+#import "SCSettingsJournal.h"
+#import "SCSettingsSharedSegment.h"
 #import <AppKit/AppKit.h>
 
 // Only include Sentry if available and not testing
@@ -19,15 +21,40 @@
 float const SYNC_INTERVAL_SECS = 30;
 float const SYNC_LEEWAY_SECS = 30;
 NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
+// once the journal grows past this, the next write compacts it into a fresh snapshot
+unsigned long long const JOURNAL_COMPACTION_THRESHOLD_BYTES = 256 * 1024;
 
 @interface SCSettings ()
 
 // Private vars
 @property (readonly) NSMutableDictionary* settingsDict;
+
+// immutable copy of settingsDict with defaults filled in, replaced (never mutated) on every change.
+// readers grab the current pointer and look things up without taking the lock
+@property (atomic, strong) NSDictionary* readSnapshot;
+
+// root instances publish every snapshot here; read-only instances (app/CLI) map it
+// and pick up the daemon's latest settings without notifications or disk reloads
+@property (nullable) SCSettingsSharedSegment* sharedSegment;
+@property uint64_t sharedSegmentSequence;
+@property uint64_t sharedSegmentEpoch;
+// NO until we've adopted a publish, or if the last one we looked at was older than what we
+// already had - reloads and change notifications then go the old way (disk) until the next one
+@property BOOL followingSharedSegment;
+// root instances publish at most once per burst of changes, not on every setValue:
+@property BOOL sharedSegmentPublishPending;
+// read-only instances: when we last checked the segment file was still the one we have mapped
+@property (nonatomic) CFAbsoluteTime lastSharedSegmentAttachmentCheck;
 @property NSDate* lastSynchronizedWithDisk;
 @property dispatch_source_t syncTimer;
 @property dispatch_source_t debouncedChangeTimer;
 
+// keys changed in memory since the last write; these go into the next journal record
+@property (readonly) NSMutableSet<NSString*>* pendingJournalKeys;
+// set when memory can't be described as a change set on top of disk (e.g. brand-new settings)
+@property BOOL needsSnapshotWrite;
+@property BOOL settingsDirectoryPrepared;
+
 @end
 
 @implementation SCSettings
@@ -59,6 +86,7 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
 #endif
 
         _settingsDict = nil;
+        _pendingJournalKeys = [NSMutableSet set];
         
         [[NSDistributedNotificationCenter defaultCenter] addObserver: self
                                                             selector: @selector(onSettingChanged:)
@@ -89,9 +117,54 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
 
     return filePath;
 }
++ (NSString*)sharedSegmentPath {
+    return [SCSettings.securedSettingsFilePath stringByAppendingString: @".shm"];
+}
++ (SCSettingsJournal*)settingsJournal {
+    static SCSettingsJournal* journal = nil;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        journal = [SCSettingsJournal journalWithPath: [SCSettings.securedSettingsFilePath stringByAppendingString: @".journal"]];
+    });
+
+    return journal;
+}
+
+// the on-disk state is the last snapshot plus everything appended to the journal since
++ (NSDictionary*)settingsDictionaryFromDisk {
+    NSDictionary* snapshot = [NSDictionary dictionaryWithContentsOfFile: SCSettings.securedSettingsFilePath];
+    if (snapshot == nil) {
+        // the snapshot is always written before anything is journaled, so a journal without one
+        // means the snapshot was deleted out from under us (i.e. an emergency wipe).
+        // Replaying it onto nothing would bring back whatever block the wipe just cleared.
+        SCSettingsJournal* journal = SCSettings.settingsJournal;
+        if (journal.journalSize > 0) {
+            NSLog(@"WARNING: Found a settings journal with no snapshot, ignoring it");
+            if (geteuid() == 0) {
+                NSError* truncateErr;
+                if (![journal truncate: &truncateErr]) {
+                    NSLog(@"WARNING: Couldn't truncate orphaned settings journal: %@", truncateErr);
+                }
+            }
+        }
+        return nil;
+    }
+
+    return [SCSettings.settingsJournal dictionaryByReplayingOntoSnapshot: snapshot];
+}
 
 // NOTE: there should be a default setting for each valid setting, even if it's nil/zero/etc
 - (NSDictionary*)defaultSettingsDict {
+    // defaults can't change while we're running, so build them (and ask the system about crash reporting) just once
+    static NSDictionary* defaultSettings = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        defaultSettings = [self buildDefaultSettingsDict];
+    });
+    return defaultSettings;
+}
+- (NSDictionary*)buildDefaultSettingsDict {
     return @{
         @"BlockEndDate": [NSDate distantPast],
         @"ActiveBlocklist": @[],
@@ -125,7 +198,21 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         @synchronized (self) {
-            self->_settingsDict = [NSMutableDictionary dictionaryWithContentsOfFile: SCSettings.securedSettingsFilePath];
+            if (!self.readOnly) {
+                // a crash mid-append can leave half a record at the end of the journal;
+                // cut it off before we start appending after it
+                [SCSettings.settingsJournal discardTornTail: nil];
+            }
+            [self openSharedSegmentIfNeeded];
+
+            // if the daemon has already published its settings, that's the latest state - no need to touch disk
+            NSDictionary* sharedSettings = self.readOnly ? [self.sharedSegment readSettingsWithSequence: &self->_sharedSegmentSequence epoch: &self->_sharedSegmentEpoch] : nil;
+            if (sharedSettings != nil) {
+                self->_settingsDict = [sharedSettings mutableCopy];
+                self.followingSharedSegment = YES;
+            } else {
+                self->_settingsDict = [[SCSettings settingsDictionaryFromDisk] mutableCopy];
+            }
             
             BOOL isTest = [[NSUserDefaults standardUserDefaults] boolForKey: @"isTest"];
             if (isTest) NSLog(@"Ignoring settings on disk because we're unit-testing");
@@ -135,12 +222,16 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
             // also if we're running tests, just use the default dict
             if (self->_settingsDict == nil || isTest) {
                 self->_settingsDict = [[self defaultSettingsDict] mutableCopy];
+                self.needsSnapshotWrite = YES;
+                [self publishReadSnapshot];
                 
                 // write out our brand-new settings to disk!
                 if (!self.readOnly) {
                     [self writeSettings];
                 }
                 [SCSentry addBreadcrumb: @"Initialized SCSettings to default settings" category: @"settings"];
+            } else {
+                [self publishReadSnapshot];
             }
             
             // we're now current with disk!
@@ -158,17 +249,131 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     return _settingsDict;
 }
 
-- (NSDictionary*)dictionaryRepresentation {
-    NSMutableDictionary* dictCopy = [self.settingsDict mutableCopy];
-    
-    // fill in any gaps with default values (like we did if they called valueForKey:)
-    for (NSString* key in [[self defaultSettingsDict] allKeys]) {
-        if (dictCopy[key] == nil) {
-            dictCopy[key] = [self defaultSettingsDict][key];
+// Rebuilds the read snapshot from settingsDict. Caller must hold the lock on self.
+// Defaults fill in any gaps, and NSNull values read as unset (i.e. fall back to the default)
+- (void)publishReadSnapshot {
+    NSMutableDictionary* snapshot = [[self defaultSettingsDict] mutableCopy];
+    [_settingsDict enumerateKeysAndObjectsUsingBlock:^(id _Nonnull key, id _Nonnull obj, BOOL * _Nonnull stop) {
+        if (obj == [NSNull null]) return;
+        snapshot[key] = obj;
+    }];
+    self.readSnapshot = [snapshot copy];
+
+    if (!self.readOnly && self.sharedSegment != nil && !self.sharedSegmentPublishPending) {
+        // serializing every setting is far more work than the change itself, so coalesce
+        // a burst of changes into one publish of whatever the snapshot is by then
+        self.sharedSegmentPublishPending = YES;
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            @synchronized (self) {
+                [self publishToSharedSegmentIfPending];
+            }
+        });
+    }
+}
+
+// Caller must hold the lock on self
+- (void)publishToSharedSegmentIfPending {
+    if (!self.sharedSegmentPublishPending) return;
+    self.sharedSegmentPublishPending = NO;
+    [self.sharedSegment publishSettings: self.readSnapshot];
+}
+
+- (void)openSharedSegmentIfNeeded {
+#if TESTING
+    return;
+#endif
+    if (self.sharedSegment != nil) return;
+
+    // reads can get here from any thread now, so only one of them opens it
+    @synchronized (self) {
+        if (self.sharedSegment != nil) return;
+
+        if (self.readOnly) {
+            self.sharedSegment = [SCSettingsSharedSegment readerWithPath: SCSettings.sharedSegmentPath];
+            self.sharedSegmentSequence = 0;
+            self.sharedSegmentEpoch = 0;
+            self.followingSharedSegment = NO;
+        } else if (geteuid() == 0) {
+            self.sharedSegment = [SCSettingsSharedSegment publisherWithPath: SCSettings.sharedSegmentPath];
         }
     }
+}
+
+// Read-only instances: if the daemon has published since we last looked, adopt its settings.
+// Returns YES if we're following a shared segment (whether or not anything changed), NO if
+// the caller should get its settings some other way.
+- (BOOL)refreshFromSharedSegment {
+    SCSettingsSharedSegment* segment = self.sharedSegment;
+    if (!self.readOnly || segment == nil) return NO;
 
-    return dictCopy;
+    // the common case: one atomic load, nothing to do
+    if (segment.sequence == self.sharedSegmentSequence) return self.followingSharedSegment;
+
+    @synchronized (self) {
+        uint64_t sequence = 0, epoch = 0;
+        NSDictionary* sharedSettings = [segment readSettingsWithSequence: &sequence epoch: &epoch];
+        if (sharedSettings == nil) return NO;
+        if (sequence == self.sharedSegmentSequence) return self.followingSharedSegment;
+
+        // a new epoch means the daemon restarted or reset its settings, so its version numbers
+        // start over and can't be compared with ours - whatever it publishes now is the truth
+        BOOL newEpoch = (epoch != self.sharedSegmentEpoch);
+        int sharedVersion = [sharedSettings[@"SettingsVersionNumber"] intValue];
+        int memoryVersion = [_settingsDict[@"SettingsVersionNumber"] intValue];
+        self.sharedSegmentSequence = sequence;
+        self.sharedSegmentEpoch = epoch;
+        self.followingSharedSegment = (_settingsDict == nil || newEpoch || sharedVersion >= memoryVersion);
+        if (self.followingSharedSegment) {
+            _settingsDict = [sharedSettings mutableCopy];
+            [self publishReadSnapshot];
+            self.lastSynchronizedWithDisk = [NSDate date];
+        }
+        return self.followingSharedSegment;
+    }
+}
+
+// Read-only instances: an emergency wipe deletes the segment file out from under us, and a
+// restarted daemon publishes into a new one, so let go of ours if it's no longer at the path
+- (void)reopenSharedSegmentIfDetached {
+    if (!self.readOnly || self.sharedSegment == nil || !self.sharedSegment.isDetachedFromPath) return;
+
+    @synchronized (self) {
+        NSLog(@"SCSettings: Shared settings segment was removed or replaced, reopening");
+        self.sharedSegment = nil;
+        [self openSharedSegmentIfNeeded];
+    }
+}
+
+// Read-only instances: reopen the segment if it's been replaced (or first appears), at most
+// once a second. Reads are far too frequent to stat() the file on every one, but a restarted
+// daemon's settings should still show up right away rather than at the next sync.
+- (void)checkSharedSegmentAttachmentIfDue {
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    if (fabs(now - self.lastSharedSegmentAttachmentCheck) < 1.0) return;
+    self.lastSharedSegmentAttachmentCheck = now;
+
+    [self reopenSharedSegmentIfDetached];
+    [self openSharedSegmentIfNeeded];
+}
+
+- (NSDictionary*)currentSnapshot {
+    NSDictionary* snapshot = self.readSnapshot;
+    if (snapshot == nil) {
+        [self initializeSettingsDict];
+        snapshot = self.readSnapshot;
+    } else if (self.readOnly) {
+        [self checkSharedSegmentAttachmentIfDue];
+        if (self.sharedSegment != nil) {
+            [self refreshFromSharedSegment];
+            snapshot = self.readSnapshot;
+        }
+    }
+    return snapshot;
+}
+
+// this is immutable and won't change under the caller, so it's safe (and cheap) to hold onto
+- (NSDictionary*)dictionaryRepresentation {
+    return [self currentSnapshot];
 }
 
 // both reloadSettings and writeSettings are synchronized with the same object, so
@@ -183,8 +388,14 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
         return;
     }
 
+    // read-only instances follow the daemon's shared segment when there is one,
+    // which is always at least as new as what's on disk
+    [self reopenSharedSegmentIfDetached];
+    [self openSharedSegmentIfNeeded];
+    if ([self refreshFromSharedSegment]) return;
+
     @synchronized (self) {
-        NSDictionary* settingsFromDisk = [NSDictionary dictionaryWithContentsOfFile: SCSettings.securedSettingsFilePath];
+        NSDictionary* settingsFromDisk = [SCSettings settingsDictionaryFromDisk];
         
         int diskSettingsVersion = [settingsFromDisk[@"SettingsVersionNumber"] intValue];
         int memorySettingsVersion = [[self valueForKey: @"SettingsVersionNumber"] intValue];
@@ -215,6 +426,8 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
 
         if (diskMoreRecentThanMemory) {
             _settingsDict = [settingsFromDisk mutableCopy];
+            [self.pendingJournalKeys removeAllObjects];
+            [self publishReadSnapshot];
             self.lastSynchronizedWithDisk = [NSDate date];
             NSLog(@"Newer SCSettings found on disk (version %d vs %d with time interval %f), updating...", diskSettingsVersion, memorySettingsVersion, [diskSettingsLastUpdated timeIntervalSinceDate: memorySettingsLastUpdated]);
             [SCSentry addBreadcrumb: @"Updated SCSettings to newer settings found on disk" category: @"settings"];
@@ -226,16 +439,22 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     // Bypasses version number checking - always reloads from disk.
     // Use this when you KNOW the disk has authoritative data (e.g., after clearBlockForDebug).
     @synchronized (self) {
-        NSDictionary* settingsFromDisk = [NSDictionary dictionaryWithContentsOfFile: SCSettings.securedSettingsFilePath];
+        NSDictionary* settingsFromDisk = [SCSettings settingsDictionaryFromDisk];
+        [self.pendingJournalKeys removeAllObjects];
         if (settingsFromDisk != nil) {
             _settingsDict = [settingsFromDisk mutableCopy];
             NSLog(@"SCSettings: Force-reloaded from disk (version %d)", [settingsFromDisk[@"SettingsVersionNumber"] intValue]);
         } else {
             // File doesn't exist or is corrupted - reinitialize with defaults
-            _settingsDict = nil;
-            [self initializeSettingsDict];
+            // (initializeSettingsDict only ever runs once, so we can't lean on it here)
+            _settingsDict = [[self defaultSettingsDict] mutableCopy];
+            self.needsSnapshotWrite = YES;
             NSLog(@"SCSettings: Force-reload found no file, reinitialized with defaults");
         }
+        // our version number may have gone backwards, so readers mustn't compare against it
+        [self.sharedSegment startNewEpoch];
+        [self publishReadSnapshot];
+        [self publishToSharedSegmentIfPending];
         self.lastSynchronizedWithDisk = [NSDate date];
     }
 }
@@ -252,6 +471,9 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
             return;
         }
 
+        // readers shouldn't lag behind what's on disk
+        [self publishToSharedSegmentIfPending];
+
 #if TESTING
         // no writing to disk during unit tests
         NSLog(@"Would write settings to disk now (but no writing during unit tests)");
@@ -259,81 +481,131 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
         return;
 #endif
         
-        // don't spend time on the main thread writing out files - it's OK for this to happen without blocking other things
-        dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            NSError* serializationErr;
-            NSData* plistData = [NSPropertyListSerialization dataWithPropertyList: self.settingsDict
-                                                                           format: NSPropertyListBinaryFormat_v1_0
-                                                                          options: kNilOptions
-                                                                            error: &serializationErr];
-                            
-            if (plistData == nil) {
+        // only write out what changed since last time, unless we need a full snapshot
+        // (first write, or the journal has grown enough that it's time to compact it)
+        BOOL compact = self.needsSnapshotWrite || SCSettings.settingsJournal.journalSize > JOURNAL_COMPACTION_THRESHOLD_BYTES;
+        NSMutableDictionary* changedValues = [NSMutableDictionary dictionary];
+        NSMutableArray<NSString*>* unsetKeys = [NSMutableArray array];
+        NSData* snapshotData = nil;
+        NSError* serializationErr;
+        if (compact) {
+            snapshotData = [NSPropertyListSerialization dataWithPropertyList: self.settingsDict
+                                                                      format: NSPropertyListBinaryFormat_v1_0
+                                                                     options: kNilOptions
+                                                                       error: &serializationErr];
+            if (snapshotData == nil) {
                 NSLog(@"NSPropertyListSerialization error: %@", serializationErr);
+                [SCSentry captureError: serializationErr];
                 if (completionBlock != nil) completionBlock(serializationErr);
                 return;
             }
-            
-            NSError* createDirectoryErr;
-            BOOL createDirectorySuccessful = [[NSFileManager defaultManager] createDirectoryAtURL: [NSURL fileURLWithPath: SETTINGS_FILE_DIR]
-                                                                      withIntermediateDirectories: YES
-                                                                                       attributes: @{
-                                                                                           NSFileOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
-                                                                                           NSFileGroupOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
-                                                                                           NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
-                                                                                       }
-                                                                                            error: &createDirectoryErr];
-            if (!createDirectorySuccessful) {
-                NSLog(@"WARNING: Failed to create %@ folder to store SCSettings. Error was %@", SETTINGS_FILE_DIR, createDirectoryErr);
-                [SCSentry addBreadcrumb: [NSString stringWithFormat: @"Failed to create directory for SCSettings with error %@", createDirectoryErr] category:@"settings"];
+        } else {
+            for (NSString* key in self.pendingJournalKeys) {
+                id value = self.settingsDict[key];
+                if (value == nil) {
+                    [unsetKeys addObject: key];
+                } else {
+                    changedValues[key] = value;
+                }
             }
+        }
+        [self.pendingJournalKeys removeAllObjects];
 
-            NSError* chmodDirectoryErr;
-            BOOL chmodDirectorySuccessful = [[NSFileManager defaultManager]
-                                             setAttributes: @{
-                                                 NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
-                                             }
-                                             ofItemAtPath: SETTINGS_FILE_DIR
-                                             error: &chmodDirectoryErr];
-            if (!chmodDirectorySuccessful) {
-                NSLog(@"WARNING: Failed to set permissions on %@ folder to store SCSettings. Error was %@", SETTINGS_FILE_DIR, chmodDirectoryErr);
-                [SCSentry addBreadcrumb: [NSString stringWithFormat: @"Failed to set directory permissions for SCSettings with error %@", chmodDirectoryErr] category:@"settings"];
-            }
+        // don't spend time on the main thread writing out files - it's OK for this to happen without blocking other things
+        dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [self prepareSettingsDirectoryIfNeeded];
 
             NSError* writeErr;
-            BOOL writeSuccessful = [plistData writeToFile: SCSettings.securedSettingsFilePath
-                                                  options: NSDataWritingAtomic
-                                                    error: &writeErr
-                                    ];
-            
-            NSError* chmodErr;
-            BOOL chmodSuccessful = [[NSFileManager defaultManager]
-                                    setAttributes: @{
-                                        NSFileOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
-                                        NSFileGroupOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
-                                        NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
-                                    }
-                                    ofItemAtPath: SCSettings.securedSettingsFilePath
-                                    error: &chmodErr];
+            BOOL writeSuccessful;
+            if (compact) {
+                writeSuccessful = [self writeSnapshotData: snapshotData andTruncateJournal: &writeErr];
+            } else if (changedValues.count == 0 && unsetKeys.count == 0) {
+                writeSuccessful = YES;
+            } else {
+                writeSuccessful = [SCSettings.settingsJournal appendChangeSetWithValues: changedValues
+                                                                              unsetKeys: unsetKeys
+                                                                                  error: &writeErr];
+            }
 
             if (writeSuccessful) {
                 self.lastSynchronizedWithDisk = [NSDate date];
-            }
-
-            if (!writeSuccessful) {
-                NSLog(@"Failed to write secured settings to file %@", SCSettings.securedSettingsFilePath);
+                [SCSentry addBreadcrumb: compact ? @"Successfully wrote SCSettings snapshot out to file" : @"Successfully appended SCSettings changes to journal" category: @"settings"];
+                if (completionBlock != nil) completionBlock(nil);
+            } else {
+                NSLog(@"Failed to write secured settings to file %@ with error %@", SCSettings.securedSettingsFilePath, writeErr);
                 [SCSentry captureError: writeErr];
+
+                // if the journal append failed we've lost track of exactly what changed, so fall back to a snapshot next time
+                self.needsSnapshotWrite = YES;
                 if (completionBlock != nil) completionBlock(writeErr);
-            } else if (!chmodSuccessful) {
-                NSLog(@"Failed to change secured settings file owner/permissions secured settings for file %@ with error %@", SCSettings.securedSettingsFilePath, chmodErr);
-                [SCSentry captureError: chmodErr];
-                if (completionBlock != nil) completionBlock(chmodErr);
-            } else {
-                [SCSentry addBreadcrumb: @"Successfully wrote SCSettings out to file" category: @"settings"];
-                if (completionBlock != nil) completionBlock(nil);
             }
         });
     }
 }
+
+// Creating/chmod'ing the settings folder only needs to happen once per process
+- (void)prepareSettingsDirectoryIfNeeded {
+    if (self.settingsDirectoryPrepared) return;
+
+    NSError* createDirectoryErr;
+    BOOL createDirectorySuccessful = [[NSFileManager defaultManager] createDirectoryAtURL: [NSURL fileURLWithPath: SETTINGS_FILE_DIR]
+                                                              withIntermediateDirectories: YES
+                                                                               attributes: @{
+                                                                                   NSFileOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
+                                                                                   NSFileGroupOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
+                                                                                   NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
+                                                                               }
+                                                                                    error: &createDirectoryErr];
+    if (!createDirectorySuccessful) {
+        NSLog(@"WARNING: Failed to create %@ folder to store SCSettings. Error was %@", SETTINGS_FILE_DIR, createDirectoryErr);
+        [SCSentry addBreadcrumb: [NSString stringWithFormat: @"Failed to create directory for SCSettings with error %@", createDirectoryErr] category:@"settings"];
+        return;
+    }
+
+    NSError* chmodDirectoryErr;
+    BOOL chmodDirectorySuccessful = [[NSFileManager defaultManager]
+                                     setAttributes: @{
+                                         NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
+                                     }
+                                     ofItemAtPath: SETTINGS_FILE_DIR
+                                     error: &chmodDirectoryErr];
+    if (!chmodDirectorySuccessful) {
+        NSLog(@"WARNING: Failed to set permissions on %@ folder to store SCSettings. Error was %@", SETTINGS_FILE_DIR, chmodDirectoryErr);
+        [SCSentry addBreadcrumb: [NSString stringWithFormat: @"Failed to set directory permissions for SCSettings with error %@", chmodDirectoryErr] category:@"settings"];
+        return;
+    }
+
+    self.settingsDirectoryPrepared = YES;
+}
+
+// Compaction: write the full settings dictionary as the new snapshot, then empty the journal.
+// If we crash in between, replay skips the journal records the snapshot already contains.
+- (BOOL)writeSnapshotData:(NSData*)plistData andTruncateJournal:(NSError**)error {
+    if (![plistData writeToFile: SCSettings.securedSettingsFilePath options: NSDataWritingAtomic error: error]) {
+        return NO;
+    }
+
+    // atomic writes replace the file, so the new one needs its owner/permissions set again
+    BOOL chmodSuccessful = [[NSFileManager defaultManager]
+                            setAttributes: @{
+                                NSFileOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
+                                NSFileGroupOwnerAccountID: [NSNumber numberWithUnsignedLong: 0],
+                                NSFilePosixPermissions: [NSNumber numberWithShort: 0755]
+                            }
+                            ofItemAtPath: SCSettings.securedSettingsFilePath
+                            error: error];
+    if (!chmodSuccessful) {
+        NSLog(@"Failed to change secured settings file owner/permissions secured settings for file %@", SCSettings.securedSettingsFilePath);
+        return NO;
+    }
+
+    if (![SCSettings.settingsJournal truncate: error]) {
+        return NO;
+    }
+
+    self.needsSnapshotWrite = NO;
+    return YES;
+}
 - (void)writeSettings {
     // by default, just log all errors
     [self writeSettingsWithCompletion:^(NSError * _Nullable err) {
@@ -422,6 +694,9 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
         int newVersionNumber = [[self valueForKey: @"SettingsVersionNumber"] intValue] + 1;
         [self.settingsDict setValue: [NSNumber numberWithInt: newVersionNumber] forKey: @"SettingsVersionNumber"];
         [self.settingsDict setValue: [NSDate date] forKey: @"LastSettingsUpdate"];
+
+        [self.pendingJournalKeys addObjectsFromArray: @[key, @"SettingsVersionNumber", @"LastSettingsUpdate"]];
+        [self publishReadSnapshot];
     }
     
     // notify other instances (presumably in other processes)
@@ -445,20 +720,63 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     [self setValue: value forKey: key stopPropagation: NO];
 }
 
-- (id)valueForKey:(NSString*)key {
-    id value = [self.settingsDict valueForKey: key];
-    
-    // when we get an NSNull we have to unwrap it and remember that means nil
-    if ([value isEqual: [NSNull null]]) {
-        value = nil;
+- (void)setValuesForKeys:(NSDictionary<NSString*, id>*)keyedValues stopPropagation:(BOOL)stopPropagation {
+    if (self.readOnly && !stopPropagation) {
+        NSLog(@"WARNING: Read-only SCSettings instance can't update values (setting %@)", keyedValues);
+        return;
     }
-    
-    // if we don't have a value in our dictionary but we do have a default value, use that instead!
-    if (value == nil && [self defaultSettingsDict][key] != nil) {
-        value = [self defaultSettingsDict][key];
+    if (keyedValues.count == 0) return;
+
+    // nils can't travel in a distributed notification either, so unset keys are sent separately
+    NSMutableDictionary* setValues = [NSMutableDictionary dictionaryWithCapacity: keyedValues.count];
+    NSMutableArray<NSString*>* unsetKeys = [NSMutableArray array];
+    for (NSString* key in keyedValues) {
+        id value = keyedValues[key];
+        if ([value isEqual: [NSNull null]]) {
+            [unsetKeys addObject: key];
+        } else {
+            setValues[key] = value;
+        }
+    }
+
+    NSNumber* versionNumber;
+    @synchronized (self) {
+        [self.settingsDict addEntriesFromDictionary: setValues];
+        [self.settingsDict removeObjectsForKeys: unsetKeys];
+
+        // record the update - once for the whole batch
+        int newVersionNumber = [[self valueForKey: @"SettingsVersionNumber"] intValue] + 1;
+        versionNumber = [NSNumber numberWithInt: newVersionNumber];
+        [self.settingsDict setValue: versionNumber forKey: @"SettingsVersionNumber"];
+        [self.settingsDict setValue: [NSDate date] forKey: @"LastSettingsUpdate"];
+
+        [self.pendingJournalKeys addObjectsFromArray: keyedValues.allKeys];
+        [self.pendingJournalKeys addObjectsFromArray: @[@"SettingsVersionNumber", @"LastSettingsUpdate"]];
+        [self publishReadSnapshot];
     }
 
-    return value;
+    if (!stopPropagation) {
+        [[NSDistributedNotificationCenter defaultCenter] postNotificationName: @"org.eyebeam.SelfControl.SCSettingsValueChanged"
+                                                                       object: self.description
+                                                                     userInfo: @{
+                                                                                 @"values": setValues,
+                                                                                 @"unsetKeys": unsetKeys,
+                                                                                 @"versionNumber": versionNumber,
+                                                                                 @"date": [NSDate date]
+                                                                                 }
+                                                                      options: NSNotificationDeliverImmediately | NSNotificationPostToAllSessions
+         ];
+    }
+}
+
+- (void)setValuesForKeys:(NSDictionary<NSString*, id>*)keyedValues {
+    [self setValuesForKeys: keyedValues stopPropagation: NO];
+}
+
+- (id)valueForKey:(NSString*)key {
+    // no lock or allocation needed: the snapshot is immutable, and already has
+    // NSNulls unwrapped and default values filled in
+    return [self currentSnapshot][key];
 }
 - (BOOL)boolForKey:(NSString*)key {
     return [[self valueForKey: key] boolValue];
@@ -496,14 +814,7 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
 - (void)updateSentryContext {
     // make sure Sentry has the latest context in the event of a crash
     
-    NSMutableDictionary* dictCopy = [self.settingsDict mutableCopy];
-    
-    // fill in any gaps with default values (like we did if they called valueForKey:)
-    for (NSString* key in [[self defaultSettingsDict] allKeys]) {
-        if (dictCopy[key] == nil) {
-            dictCopy[key] = [self defaultSettingsDict][key];
-        }
-    }
+    NSMutableDictionary* dictCopy = [[self currentSnapshot] mutableCopy];
     
     // eliminate privacy-sensitive data (i.e. blocklist)
     // but store the blocklist length as a useful piece of debug info
@@ -536,8 +847,20 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
         // we don't need to listen to our own notifications
         return;
     }
+
+    // a change notification is the first sign of a restarted daemon, which may have a new segment
+    [self reopenSharedSegmentIfDetached];
+    [self openSharedSegmentIfNeeded];
+
+    // if we're following the daemon's shared segment and already have this change, there's no
+    // need to apply it or go back to disk. The daemon coalesces its publishes, so a change can
+    // arrive here first - in that case apply it now, and the publish will catch up with us
+    if ([self refreshFromSharedSegment] && [note.userInfo[@"versionNumber"] intValue] <= [[self valueForKey: @"SettingsVersionNumber"] intValue]) {
+        return;
+    }
     
-    if (note.userInfo[@"key"] == nil) {
+    BOOL isBatch = (note.userInfo[@"values"] != nil);
+    if (note.userInfo[@"key"] == nil && !isBatch) {
         // something's wrong - we don't have a key to set
         return;
     }
@@ -560,10 +883,22 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     if (!noteMoreRecentThanSettings) {
         NSLog(@"Ignoring setting change notification as %@ is older than %@", noteSettingUpdated, ourSettingsLastUpdated);
     } else {
-        NSLog(@"Accepting propagated change (%@ --> %@) since version %d is newer than %d and/or %@ is newer than %@", note.userInfo[@"key"], note.userInfo[@"value"], noteVersionNumber, ourSettingsVersionNumber, noteSettingUpdated, ourSettingsLastUpdated);
-        
-        // mirror the change on our own instance - but don't propagate the change to avoid loopin
-        [self setValue: note.userInfo[@"value"] forKey: note.userInfo[@"key"] stopPropagation: YES];
+        if (isBatch) {
+            NSLog(@"Accepting propagated change set (%@, unset %@) since version %d is newer than %d and/or %@ is newer than %@", note.userInfo[@"values"], note.userInfo[@"unsetKeys"], noteVersionNumber, ourSettingsVersionNumber, noteSettingUpdated, ourSettingsLastUpdated);
+
+            NSMutableDictionary* keyedValues = [note.userInfo[@"values"] mutableCopy];
+            for (NSString* key in note.userInfo[@"unsetKeys"]) {
+                keyedValues[key] = [NSNull null];
+            }
+
+            // mirror the whole change set on our own instance - but don't propagate it to avoid loopin
+            [self setValuesForKeys: keyedValues stopPropagation: YES];
+        } else {
+            NSLog(@"Accepting propagated change (%@ --> %@) since version %d is newer than %d and/or %@ is newer than %@", note.userInfo[@"key"], note.userInfo[@"value"], noteVersionNumber, ourSettingsVersionNumber, noteSettingUpdated, ourSettingsLastUpdated);
+            
+            // mirror the change on our own instance - but don't propagate the change to avoid loopin
+            [self setValue: note.userInfo[@"value"] forKey: note.userInfo[@"key"] stopPropagation: YES];
+        }
     }
     
     // regardless of which is more recent, we should really go get the new deal from disk
@@ -586,14 +921,9 @@ NSString* const SETTINGS_FILE_DIR = @"/usr/local/etc/";
     // we _basically_ just copy the default settings dict in,
     // except we leave the settings version number and last settings update
     // intact - that helps keep us in sync with any other instances
-    NSDictionary* defaultSettings = [self defaultSettingsDict];
-    for (NSString* key in defaultSettings) {
-        if ([key isEqualToString: @"SettingsVersionNumber"] || [key isEqualToString: @"LastSettingsUpdate"]) {
-            continue;
-        }
-        
-        [self setValue: defaultSettings[key] forKey: key];
-    }
+    NSMutableDictionary* defaultSettings = [[self defaultSettingsDict] mutableCopy];
+    [defaultSettings removeObjectsForKeys: @[@"SettingsVersionNumber", @"LastSettingsUpdate"]];
+    [self setValuesForKeys: defaultSettings];
 }
 
 - (void)dealloc {
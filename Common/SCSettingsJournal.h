@@ -0,0 +1,46 @@
+//
+//  SCSettingsJournal.h
+//  SelfControl
+//
+//  Append-only write-ahead journal for SCSettings. Each record holds one change set
+//  (keys set + keys unset); the full settings plist is only rewritten on compaction.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCSettingsJournal : NSObject
+
+@property (readonly) NSString* journalPath;
+
+/// Current size of the journal file in bytes (0 if it doesn't exist)
+@property (readonly) unsigned long long journalSize;
+
+/// Number of intact records found the last time the journal was replayed or appended to
+@property (readonly) NSUInteger recordCount;
+
++ (instancetype)journalWithPath:(NSString*)path;
+
+/// Appends one change set as a single checksummed record and fsyncs it.
+/// Values must be property list objects.
+- (BOOL)appendChangeSetWithValues:(NSDictionary<NSString*, id>*)values
+                        unsetKeys:(NSArray<NSString*>*)unsetKeys
+                            error:(NSError**)error;
+
+/// Returns the snapshot with every intact journal record applied in order.
+/// Replay stops at the first torn or corrupt record (i.e. a write interrupted by a crash).
+/// Records whose SettingsVersionNumber isn't newer than the snapshot's are skipped, since
+/// they were already folded into it by a compaction that crashed before truncating the journal.
+- (NSMutableDictionary*)dictionaryByReplayingOntoSnapshot:(nullable NSDictionary*)snapshot;
+
+/// Truncates the journal to the end of its last intact record, so new appends
+/// don't land behind a torn one. Only the writer should call this.
+- (BOOL)discardTornTail:(NSError**)error;
+
+/// Empties the journal. Call after its contents have been compacted into a snapshot.
+- (BOOL)truncate:(NSError**)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,183 @@
+//
+//  SCSettingsJournal.m
+//  SelfControl
+//
+
+#import "SCSettingsJournal.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// each record is: [uint32 payload length][uint32 FNV-1a checksum of payload][payload]
+// where the payload is a binary plist of @{ @"set": {...}, @"unset": [...] }
+// both header fields are little-endian
+static const size_t kJournalRecordHeaderSize = 8;
+static const uint32_t kJournalMaxRecordSize = 64 * 1024 * 1024;
+
+static uint32_t SCJournalChecksum(const uint8_t* bytes, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+@interface SCSettingsJournal ()
+@property (readwrite) NSString* journalPath;
+@property (readwrite) NSUInteger recordCount;
+@end
+
+@implementation SCSettingsJournal
+
++ (instancetype)journalWithPath:(NSString*)path {
+    SCSettingsJournal* journal = [SCSettingsJournal new];
+    journal.journalPath = path;
+    return journal;
+}
+
+- (unsigned long long)journalSize {
+    struct stat st;
+    if (stat(self.journalPath.fileSystemRepresentation, &st) != 0) return 0;
+    return (unsigned long long)st.st_size;
+}
+
+- (NSError*)posixErrorWithDescription:(NSString*)description {
+    return [NSError errorWithDomain: NSPOSIXErrorDomain
+                               code: errno
+                           userInfo: @{ NSLocalizedDescriptionKey: [NSString stringWithFormat: @"%@ (%@): %s", description, self.journalPath, strerror(errno)] }];
+}
+
+- (int)openForAppending:(NSError**)error {
+    int fd = open(self.journalPath.fileSystemRepresentation, O_WRONLY | O_APPEND);
+    if (fd < 0 && errno == ENOENT) {
+        // first record since the last compaction: create the file with the same
+        // owner/permissions as the settings snapshot. We only pay for this once per journal.
+        fd = open(self.journalPath.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT | O_EXCL, 0755);
+        if (fd >= 0) {
+            fchmod(fd, 0755);
+            if (geteuid() == 0) fchown(fd, 0, 0);
+        } else if (errno == EEXIST) {
+            fd = open(self.journalPath.fileSystemRepresentation, O_WRONLY | O_APPEND);
+        }
+    }
+
+    if (fd < 0 && error != NULL) {
+        *error = [self posixErrorWithDescription: @"Couldn't open settings journal"];
+    }
+    return fd;
+}
+
+- (BOOL)appendChangeSetWithValues:(NSDictionary<NSString*, id>*)values unsetKeys:(NSArray<NSString*>*)unsetKeys error:(NSError**)error {
+    NSData* payload = [NSPropertyListSerialization dataWithPropertyList: @{ @"set": values ?: @{}, @"unset": unsetKeys ?: @[] }
+                                                                 format: NSPropertyListBinaryFormat_v1_0
+                                                                options: kNilOptions
+                                                                  error: error];
+    if (payload == nil) return NO;
+
+    uint32_t header[2] = {
+        CFSwapInt32HostToLittle((uint32_t)payload.length),
+        CFSwapInt32HostToLittle(SCJournalChecksum(payload.bytes, payload.length))
+    };
+    NSMutableData* record = [NSMutableData dataWithCapacity: kJournalRecordHeaderSize + payload.length];
+    [record appendBytes: header length: sizeof(header)];
+    [record appendData: payload];
+
+    int fd = [self openForAppending: error];
+    if (fd < 0) return NO;
+
+    // one write() per record, so a crash can only ever leave a torn record at the very end
+    ssize_t written = write(fd, record.bytes, record.length);
+    BOOL success = (written == (ssize_t)record.length) && (fsync(fd) == 0);
+    if (!success && error != NULL) {
+        *error = [self posixErrorWithDescription: @"Couldn't append to settings journal"];
+    }
+    close(fd);
+
+    if (success) self.recordCount++;
+    return success;
+}
+
+// calls recordBlock for each intact record and returns the byte offset just past the last one
+- (unsigned long long)enumerateRecordsInData:(NSData*)data usingBlock:(void(^)(NSDictionary* record))recordBlock {
+    const uint8_t* bytes = data.bytes;
+    unsigned long long length = data.length;
+    unsigned long long offset = 0;
+    NSUInteger count = 0;
+
+    while (offset + kJournalRecordHeaderSize <= length) {
+        uint32_t header[2];
+        memcpy(header, bytes + offset, sizeof(header));
+        uint32_t payloadLength = CFSwapInt32LittleToHost(header[0]);
+        uint32_t checksum = CFSwapInt32LittleToHost(header[1]);
+
+        if (payloadLength > kJournalMaxRecordSize || offset + kJournalRecordHeaderSize + payloadLength > length) break;
+
+        const uint8_t* payloadBytes = bytes + offset + kJournalRecordHeaderSize;
+        if (SCJournalChecksum(payloadBytes, payloadLength) != checksum) break;
+
+        NSData* payload = [NSData dataWithBytesNoCopy: (void*)payloadBytes length: payloadLength freeWhenDone: NO];
+        NSDictionary* record = [NSPropertyListSerialization propertyListWithData: payload options: NSPropertyListImmutable format: NULL error: nil];
+        if (![record isKindOfClass: [NSDictionary class]]) break;
+
+        recordBlock(record);
+        count++;
+        offset += kJournalRecordHeaderSize + payloadLength;
+    }
+
+    if (offset < length) {
+        NSLog(@"WARNING: SCSettingsJournal found %llu bytes of torn/corrupt data after %lu intact records in %@", length - offset, (unsigned long)count, self.journalPath);
+    }
+
+    self.recordCount = count;
+    return offset;
+}
+
+- (NSMutableDictionary*)dictionaryByReplayingOntoSnapshot:(NSDictionary*)snapshot {
+    NSMutableDictionary* dict = [NSMutableDictionary dictionaryWithDictionary: snapshot ?: @{}];
+
+    NSData* data = [NSData dataWithContentsOfFile: self.journalPath options: NSDataReadingMappedIfSafe error: nil];
+    if (data.length == 0) {
+        self.recordCount = 0;
+        return dict;
+    }
+
+    int snapshotVersion = [snapshot[@"SettingsVersionNumber"] intValue];
+    [self enumerateRecordsInData: data usingBlock:^(NSDictionary* record) {
+        NSDictionary* values = record[@"set"];
+        NSNumber* recordVersion = values[@"SettingsVersionNumber"];
+        if (snapshot != nil && recordVersion != nil && [recordVersion intValue] <= snapshotVersion) {
+            return;
+        }
+
+        [dict addEntriesFromDictionary: values];
+        [dict removeObjectsForKeys: record[@"unset"]];
+    }];
+
+    return dict;
+}
+
+- (BOOL)discardTornTail:(NSError**)error {
+    NSData* data = [NSData dataWithContentsOfFile: self.journalPath options: NSDataReadingMappedIfSafe error: nil];
+    if (data.length == 0) return YES;
+
+    unsigned long long validLength = [self enumerateRecordsInData: data usingBlock:^(NSDictionary* record) {}];
+    if (validLength == data.length) return YES;
+
+    if (truncate(self.journalPath.fileSystemRepresentation, (off_t)validLength) != 0) {
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't discard torn settings journal tail"];
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)truncate:(NSError**)error {
+    if (truncate(self.journalPath.fileSystemRepresentation, 0) != 0 && errno != ENOENT) {
+        if (error != NULL) *error = [self posixErrorWithDescription: @"Couldn't truncate settings journal"];
+        return NO;
+    }
+    self.recordCount = 0;
+    return YES;
+}
+
+@end
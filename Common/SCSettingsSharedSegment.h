@@ -0,0 +1,54 @@
+//
+//  SCSettingsSharedSegment.h
+//  SelfControl
+//
+//  Memory-mapped copy of the current settings, published by the root daemon and
+//  mapped read-only by the app and CLI. A seqlock-style sequence counter in the
+//  header lets readers notice changes with a single load and copy out a consistent
+//  version without any IPC or re-reading the settings plist/journal.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCSettingsSharedSegment : NSObject
+
+@property (readonly) NSString* segmentPath;
+
+/// Opens (creating if necessary) the segment for publishing. Only root should publish.
++ (nullable instancetype)publisherWithPath:(NSString*)path;
+
+/// Maps an existing segment read-only. Returns nil if nobody has published one yet.
++ (nullable instancetype)readerWithPath:(NSString*)path;
+
+/// Current sequence number. Even when the segment is stable, odd while a publish is in progress.
+/// This is a single atomic load from shared memory, so it's cheap enough to check on every read.
+@property (readonly) uint64_t sequence;
+
+/// Identifies this publisher's run of settings. Every publisher starts a new epoch, so readers
+/// can tell a restarted daemon (whose version numbers may have gone backwards) from a stale publish.
+@property (readonly) uint64_t publisherEpoch;
+
+/// Starts a new epoch, for when the publisher's settings no longer follow on from what it
+/// published before (e.g. they were reset to defaults)
+- (void)startNewEpoch;
+
+/// YES if the segment file has been deleted or replaced since it was opened (e.g. by an emergency
+/// wipe), so this mapping will never see another publish. Costs one stat().
+@property (readonly) BOOL isDetachedFromPath;
+
+/// Serializes settings into the segment. Concurrent publishers (in any process) are serialized with a file lock.
+- (BOOL)publishSettings:(NSDictionary*)settings;
+
+/// Copies out the most recently published settings, retrying if a publish races with us.
+/// Returns nil if nothing has been published or we can't get a consistent copy.
+/// outSequence is set to the sequence number the returned settings correspond to.
+- (nullable NSDictionary*)readSettingsWithSequence:(nullable uint64_t*)outSequence;
+
+/// As readSettingsWithSequence:, also returning the epoch of the publisher that wrote the settings
+- (nullable NSDictionary*)readSettingsWithSequence:(nullable uint64_t*)outSequence epoch:(nullable uint64_t*)outEpoch;
+
+@end
+
+NS_ASSUME_NONNULL_END
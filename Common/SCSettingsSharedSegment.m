@@ -0,0 +1,260 @@
+//
+//  SCSettingsSharedSegment.m
+//  SelfControl
+//
+
+#import "SCSettingsSharedSegment.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <stdatomic.h>
+
+static const uint32_t kSegmentMagic = 0x53435353; // "SCSS"
+static const uint32_t kSegmentFormatVersion = 2;
+static const size_t kSegmentMinimumSize = 1024 * 1024;
+static const int kSegmentMaxReadAttempts = 64;
+
+// the header lives at the start of the file; the payload (a binary plist) follows it
+typedef struct {
+    uint32_t magic;
+    uint32_t formatVersion;
+    _Atomic uint64_t sequence;
+    _Atomic uint64_t payloadLength;
+    _Atomic uint64_t segmentSize;
+    _Atomic uint64_t epoch; // written with the payload, under the seqlock
+} SCSettingsSegmentHeader;
+
+static const size_t kSegmentHeaderSize = 64;
+_Static_assert(sizeof(SCSettingsSegmentHeader) <= 64, "segment header must fit in its reserved space");
+
+@interface SCSettingsSharedSegment () {
+    int fd_;
+    void* map_;
+    size_t mapSize_;
+    BOOL writable_;
+    uint64_t epoch_;
+
+    // readers check the sequence number without any lock, so a reader that grows its
+    // mapping keeps the old one around until dealloc rather than pulling it out from under them
+    NSMutableArray<NSValue*>* retiredMaps_;
+}
+@property (readwrite) NSString* segmentPath;
+@end
+
+static uint64_t SCNewSegmentEpoch(void) {
+    uint64_t epoch = 0;
+    // 0 is what a never-published header holds
+    while (epoch == 0) arc4random_buf(&epoch, sizeof(epoch));
+    return epoch;
+}
+
+@implementation SCSettingsSharedSegment
+
++ (instancetype)publisherWithPath:(NSString*)path {
+    int fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        NSLog(@"WARNING: Couldn't open shared settings segment %@ for publishing: %s", path, strerror(errno));
+        return nil;
+    }
+    // readers in other (non-root) processes need to be able to map it, but never write to it
+    fchmod(fd, 0644);
+    if (geteuid() == 0) fchown(fd, 0, 0);
+
+    SCSettingsSharedSegment* segment = [[SCSettingsSharedSegment alloc] initWithFileDescriptor: fd path: path writable: YES];
+    if (segment == nil) return nil;
+    segment->epoch_ = SCNewSegmentEpoch();
+
+    // first publisher to touch the file sets up the header
+    SCSettingsSegmentHeader* header = segment->map_;
+    if (header->magic != kSegmentMagic || header->formatVersion != kSegmentFormatVersion) {
+        flock(fd, LOCK_EX);
+        header->magic = kSegmentMagic;
+        header->formatVersion = kSegmentFormatVersion;
+        atomic_store(&header->payloadLength, 0);
+        atomic_store(&header->segmentSize, segment->mapSize_);
+        flock(fd, LOCK_UN);
+    }
+
+    return segment;
+}
+
++ (instancetype)readerWithPath:(NSString*)path {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if (fd < 0) return nil;
+
+    return [[SCSettingsSharedSegment alloc] initWithFileDescriptor: fd path: path writable: NO];
+}
+
+- (instancetype)initWithFileDescriptor:(int)fd path:(NSString*)path writable:(BOOL)writable {
+    if (self = [super init]) {
+        fd_ = fd;
+        writable_ = writable;
+        _segmentPath = path;
+
+        // on any failure below, dealloc takes care of closing the file
+        struct stat st;
+        if (fstat(fd, &st) != 0) return nil;
+
+        size_t size = (size_t)st.st_size;
+        if (writable && size < kSegmentMinimumSize) {
+            size = kSegmentMinimumSize;
+            if (ftruncate(fd, (off_t)size) != 0) {
+                NSLog(@"WARNING: Couldn't size shared settings segment %@: %s", path, strerror(errno));
+                return nil;
+            }
+        }
+        if (size < kSegmentHeaderSize || ![self mapSize: size]) return nil;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (NSValue* retired in retiredMaps_) {
+        NSRange range = retired.rangeValue;
+        munmap((void*)range.location, range.length);
+    }
+    if (map_ != NULL) munmap(map_, mapSize_);
+    if (fd_ >= 0) close(fd_);
+}
+
+- (BOOL)mapSize:(size_t)size {
+    int prot = writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* map = mmap(NULL, size, prot, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        NSLog(@"WARNING: Couldn't map shared settings segment %@: %s", self.segmentPath, strerror(errno));
+        return NO;
+    }
+    if (map_ != NULL) {
+        if (writable_) {
+            munmap(map_, mapSize_);
+        } else {
+            if (retiredMaps_ == nil) retiredMaps_ = [NSMutableArray array];
+            [retiredMaps_ addObject: [NSValue valueWithRange: NSMakeRange((NSUInteger)map_, mapSize_)]];
+        }
+    }
+    map_ = map;
+    mapSize_ = size;
+    return YES;
+}
+
+- (SCSettingsSegmentHeader*)header {
+    return (SCSettingsSegmentHeader*)map_;
+}
+
+- (uint64_t)sequence {
+    return atomic_load_explicit(&self.header->sequence, memory_order_acquire);
+}
+
+- (uint64_t)publisherEpoch {
+    return epoch_;
+}
+
+- (void)startNewEpoch {
+    epoch_ = SCNewSegmentEpoch();
+}
+
+- (BOOL)isDetachedFromPath {
+    struct stat pathStat, fileStat;
+    if (stat(self.segmentPath.fileSystemRepresentation, &pathStat) != 0) return YES;
+    if (fstat(fd_, &fileStat) != 0) return YES;
+    return pathStat.st_dev != fileStat.st_dev || pathStat.st_ino != fileStat.st_ino;
+}
+
+- (BOOL)publishSettings:(NSDictionary*)settings {
+    if (!writable_) return NO;
+
+    NSError* serializationErr;
+    NSData* payload = [NSPropertyListSerialization dataWithPropertyList: settings
+                                                                 format: NSPropertyListBinaryFormat_v1_0
+                                                                options: kNilOptions
+                                                                  error: &serializationErr];
+    if (payload == nil) {
+        NSLog(@"WARNING: Couldn't serialize settings for shared segment: %@", serializationErr);
+        return NO;
+    }
+
+    // the segment only ever grows, so readers that mapped a smaller size never see the file shrink under them
+    flock(fd_, LOCK_EX);
+    size_t neededSize = kSegmentHeaderSize + payload.length;
+    size_t currentSize = MAX(mapSize_, (size_t)atomic_load(&self.header->segmentSize));
+    if (neededSize > mapSize_ || currentSize > mapSize_) {
+        size_t newSize = MAX(currentSize, kSegmentMinimumSize);
+        while (newSize < neededSize) newSize *= 2;
+        if ((newSize > currentSize && ftruncate(fd_, (off_t)newSize) != 0) || ![self mapSize: newSize]) {
+            NSLog(@"WARNING: Couldn't grow shared settings segment to %zu bytes: %s", newSize, strerror(errno));
+            flock(fd_, LOCK_UN);
+            return NO;
+        }
+        atomic_store(&self.header->segmentSize, newSize);
+    }
+
+    SCSettingsSegmentHeader* header = self.header;
+    uint64_t seq = atomic_load_explicit(&header->sequence, memory_order_relaxed);
+    // a publisher that crashed mid-write leaves the sequence odd; just carry on from there
+    if (seq & 1) seq++;
+
+    // seqlock write: odd sequence, payload, then even sequence
+    atomic_store_explicit(&header->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy((uint8_t*)map_ + kSegmentHeaderSize, payload.bytes, payload.length);
+    atomic_store_explicit(&header->payloadLength, payload.length, memory_order_relaxed);
+    atomic_store_explicit(&header->epoch, epoch_, memory_order_relaxed);
+    atomic_store_explicit(&header->sequence, seq + 2, memory_order_release);
+
+    flock(fd_, LOCK_UN);
+    return YES;
+}
+
+- (NSDictionary*)readSettingsWithSequence:(uint64_t*)outSequence {
+    return [self readSettingsWithSequence: outSequence epoch: NULL];
+}
+
+- (NSDictionary*)readSettingsWithSequence:(uint64_t*)outSequence epoch:(uint64_t*)outEpoch {
+    SCSettingsSegmentHeader* header = self.header;
+    if (header->magic != kSegmentMagic || header->formatVersion != kSegmentFormatVersion) return nil;
+
+    for (int attempt = 0; attempt < kSegmentMaxReadAttempts; attempt++) {
+        uint64_t seqBefore = atomic_load_explicit(&header->sequence, memory_order_acquire);
+        if (seqBefore & 1) {
+            // publish in progress
+            usleep(50);
+            continue;
+        }
+        if (seqBefore == 0) return nil; // nothing published yet
+
+        // the publisher may have grown the segment since we mapped it
+        size_t segmentSize = (size_t)atomic_load_explicit(&header->segmentSize, memory_order_relaxed);
+        if (segmentSize > mapSize_) {
+            if (![self mapSize: segmentSize]) return nil;
+            header = self.header;
+            continue;
+        }
+
+        uint64_t payloadLength = atomic_load_explicit(&header->payloadLength, memory_order_relaxed);
+        if (payloadLength == 0 || payloadLength > mapSize_ - kSegmentHeaderSize) continue;
+
+        NSData* payload = [NSData dataWithBytes: (uint8_t*)map_ + kSegmentHeaderSize length: (NSUInteger)payloadLength];
+        uint64_t epoch = atomic_load_explicit(&header->epoch, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t seqAfter = atomic_load_explicit(&header->sequence, memory_order_relaxed);
+        if (seqBefore != seqAfter) continue; // torn copy, try again
+
+        NSDictionary* settings = [NSPropertyListSerialization propertyListWithData: payload
+                                                                          options: NSPropertyListImmutable
+                                                                           format: NULL
+                                                                            error: nil];
+        if (![settings isKindOfClass: [NSDictionary class]]) return nil;
+
+        if (outSequence != NULL) *outSequence = seqBefore;
+        if (outEpoch != NULL) *outEpoch = epoch;
+        return settings;
+    }
+
+    NSLog(@"WARNING: Couldn't get a consistent read of shared settings segment %@", self.segmentPath);
+    return nil;
+}
+
+@end
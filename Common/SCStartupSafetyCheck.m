@@ -126,7 +126,7 @@ static const NSTimeInterval kEmergencyTestBlockDurationSeconds = 300.0; // 5 min
 
 - (instancetype)init {
     if (self = [super init]) {
-        _xpc = [[SCXPCClient alloc] init];
+        _xpc = [SCXPCClient sharedClient];
         _cancelled = NO;
     }
     return self;
@@ -220,7 +220,7 @@ static const NSTimeInterval kEmergencyTestBlockDurationSeconds = 300.0; // 5 min
     };
 
     // startBlockWithControllingUID already uses connectAndExecuteCommandBlock internally,
-    // so we don't need refreshConnectionAndRun (which was causing connection invalidation issues)
+    // so there's no need to refresh the connection first
     [self.xpc startBlockWithControllingUID:getuid()
                                  blocklist:testBlocklist
                                isAllowlist:NO
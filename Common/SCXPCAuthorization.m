@@ -110,7 +110,9 @@ static NSDictionary* kAuthorizationRuleAuthenticateAsAdmin2MinTimeout;
         
         sCommandInfo = @{
             NSStringFromSelector(@selector(startBlockWithControllingUID:blocklist:isAllowlist:endDate:blockSettings:authorization:reply:)) : startBlockCommandInfo,
+            NSStringFromSelector(@selector(startBlockWithControllingUID:blocklistFile:blocklistDigest:endDate:blockSettings:authorization:reply:)) : startBlockCommandInfo,
             NSStringFromSelector(@selector(updateBlocklist:authorization:reply:)) : modifyBlockCommandInfo,
+            NSStringFromSelector(@selector(updateBlocklistFromFile:blocklistDigest:authorization:reply:)) : modifyBlockCommandInfo,
             NSStringFromSelector(@selector(updateBlockEndDate:authorization:reply:)) : modifyBlockCommandInfo
             #pragma clang diagnostic pop
         };
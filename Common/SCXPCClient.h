@@ -11,12 +11,21 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface SCXPCClient : NSObject
 
+// One long-lived session for everything in the process that talks to the daemon, so commands
+// share a connection and an authorization instead of setting up their own. NSXPC delivers a
+// connection's messages to the daemon in the order they were sent, so callers can send commands
+// back to back (e.g. register then start) without waiting on each reply. An interrupted connection
+// is re-established with backoff.
++ (instancetype)sharedClient;
+
 @property (readonly, getter=isConnected) BOOL connected;
 @property (atomic, assign, readonly) BOOL connectionIsValid;
 
 - (void)connectToHelperTool;
 - (void)forceDisconnect;
 - (void)installDaemon:(void(^)(NSError*))callback;
+// Makes sure there's a live connection (e.g. to a daemon installDaemon: just replaced), then
+// runs callback. A connection that's still valid is kept, since other callers share it.
 - (void)refreshConnectionAndRun:(void(^)(void))callback;
 - (void)connectAndExecuteCommandBlock:(void(^)(NSError *))commandBlock;
 
@@ -33,6 +42,14 @@ NS_ASSUME_NONNULL_BEGIN
              controllingUID:(uid_t)controllingUID
                          reply:(void(^)(NSError* error))reply;
 
+// Registers every segment of a commit in one call; the daemon starts each one itself
+// when it comes due. Values are dictionaries with blocklistDigest, isAllowlist and blockSettings;
+// blocklists maps each digest to its blocklist (see SCBlocklistStore).
+- (void)registerSchedules:(NSDictionary<NSString*, NSDictionary*>*)schedules
+               blocklists:(NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists
+           controllingUID:(uid_t)controllingUID
+                    reply:(void(^)(NSError* error))reply;
+
 - (void)startScheduledBlockWithID:(NSString*)scheduleId
                           endDate:(NSDate*)endDate
                             reply:(void(^)(NSError* error))reply;
@@ -10,9 +10,19 @@
 #import <ServiceManagement/ServiceManagement.h>
 #import "SCXPCAuthorization.h"
 #import "SCErr.h"
+#import "SCBlocklistTransfer.h"
+#import "SCBlocklistStore.h"
+
+// reconnect delays after an interruption double from the initial one up to the max
+static const NSTimeInterval kReconnectInitialDelay = 1.0;
+static const NSTimeInterval kReconnectMaxDelay = 60.0;
+// an interruption this long after the previous one starts the backoff over
+static const NSTimeInterval kReconnectBackoffResetInterval = 300.0;
 
 @interface SCXPCClient () {
     AuthorizationRef    _authRef;
+    NSUInteger          _reconnectAttempts;
+    NSDate*             _lastInterruptionDate;
 }
 
 @property (atomic, strong, readwrite) NSXPCConnection* daemonConnection;
@@ -23,6 +33,15 @@
 
 @implementation SCXPCClient
 
++ (instancetype)sharedClient {
+    static SCXPCClient* sharedClient = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedClient = [SCXPCClient new];
+    });
+    return sharedClient;
+}
+
 - (void)setupAuthorization {
     // this is mostly copied from Apple's Even Better Authorization Sample
 
@@ -126,9 +145,9 @@
             }
 
             // interruptions may have happened because the daemon crashed
-            // so wait a second and try to reconnect
-            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
-                [self connectToHelperTool];
+            // so wait a bit and try to reconnect, backing off if it keeps happening
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self scheduleReconnect];
             });
         };
 
@@ -138,6 +157,23 @@
     }
 }
 
+// main thread only, like connectToHelperTool
+- (void)scheduleReconnect {
+    NSDate* now = [NSDate date];
+    if (_lastInterruptionDate == nil || [now timeIntervalSinceDate: _lastInterruptionDate] > kReconnectBackoffResetInterval) {
+        _reconnectAttempts = 0;
+    }
+    _lastInterruptionDate = now;
+
+    NSTimeInterval delay = MIN(kReconnectInitialDelay * pow(2, _reconnectAttempts), kReconnectMaxDelay);
+    _reconnectAttempts++;
+    NSLog(@"Daemon connection interrupted, reconnecting in %.0f seconds", delay);
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [self connectToHelperTool];
+    });
+}
+
 - (BOOL)isConnected {
     return (self.daemonConnection != nil);
 }
@@ -230,6 +266,8 @@
         return;
     } else {
         NSLog(@"Daemon installed successfully!");
+        // any connection we had was to the daemon that just got replaced
+        [self forceDisconnect];
         callback(nil);
     }
 }
@@ -239,21 +277,23 @@
 }
 
 - (void)refreshConnectionAndRun:(void(^)(void))callback {
-    // Simplified: just force disconnect and call back immediately.
-    // The next connectToHelperTool call will create a fresh connection.
-    // This fixes the bug where calling invalidate on an already-invalidated
-    // connection would do nothing, causing the callback to never fire.
-    [self forceDisconnect];
-    callback();
+    // Only a dead connection gets replaced. This is the shared client, so a live one may have
+    // other callers' replies outstanding, and invalidating it would fail them. installDaemon:
+    // already drops the connection to a daemon it replaced.
+    [self connectAndExecuteCommandBlock:^(NSError* connectError) {
+        callback();
+    }];
 }
 
 // Also copied from Apple's EvenBetterAuthorizationSample
-// Connects to the helper tool and then executes the supplied command block on the
-// main thread, passing it an error indicating if the connection was successful.
+// Connects to the helper tool and then executes the supplied command block,
+// passing it an error indicating if the connection was successful.
 - (void)connectAndExecuteCommandBlock:(void(^)(NSError *))commandBlock {
-    // Ensure that there's a helper tool connection in place.
-    
-    [self performSelectorOnMainThread: @selector(connectToHelperTool) withObject:nil waitUntilDone: YES];
+    // Ensure that there's a helper tool connection in place. A live one is used as-is,
+    // so back-to-back commands from other threads don't each wait on the main thread.
+    if (self.daemonConnection == nil || !self.connectionIsValid) {
+        [self performSelectorOnMainThread: @selector(connectToHelperTool) withObject:nil waitUntilDone: YES];
+    }
 
     // Run the command block.  Note that we never error in this case because, if there is
     // an error connecting to the helper tool, it will be delivered to the error handler
@@ -263,6 +303,17 @@
     commandBlock(nil);
 }
 
+// The connection can be invalidated between connecting and sending. Messaging a nil proxy
+// would silently drop the command (and its reply), so report that like any other proxy error.
+- (nullable id<SCDaemonProtocol>)daemonProxyWithErrorHandler:(void(^)(NSError* error))handler {
+    NSXPCConnection* connection = self.daemonConnection;
+    if (connection == nil) {
+        handler([NSError errorWithDomain: NSCocoaErrorDomain code: NSXPCConnectionInvalid userInfo: nil]);
+        return nil;
+    }
+    return [connection remoteObjectProxyWithErrorHandler: handler];
+}
+
 - (void)getVersion:(void(^)(NSString* version, NSError* error))reply {
     [self connectAndExecuteCommandBlock:^(NSError * connectError) {
         if (connectError != nil) {
@@ -270,7 +321,7 @@
             [SCSentry captureError: connectError];
             reply(nil, connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Failed to get daemon version with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(nil, proxyError);
@@ -281,6 +332,20 @@
     }];
 }
 
+// Large blocklists go to the daemon as a file rather than an archived array (see SCBlocklistTransfer).
+// Returns nil when the blocklist is small enough to send as-is, or if the file couldn't be written,
+// in which case the array is sent after all.
+- (nullable NSFileHandle*)transferFileForBlocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist {
+    if (![SCBlocklistTransfer shouldTransferBlocklist: blocklist]) return nil;
+
+    NSError* error;
+    NSFileHandle* blocklistFile = [SCBlocklistTransfer fileHandleForBlocklist: blocklist isAllowlist: isAllowlist error: &error];
+    if (blocklistFile == nil) {
+        NSLog(@"WARNING: Couldn't write blocklist transfer file, sending the blocklist inline instead: %@", error);
+    }
+    return blocklistFile;
+}
+
 - (void)startBlockWithControllingUID:(uid_t)controllingUID blocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist endDate:(NSDate*)endDate blockSettings:(NSDictionary*)blockSettings reply:(void(^)(NSError* error))reply {
     [self connectAndExecuteCommandBlock:^(NSError * connectError) {
         if (connectError != nil) {
@@ -288,17 +353,25 @@
             NSLog(@"Start block command failed with connection error: %@", connectError);
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            id<SCDaemonProtocol> daemon = [self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Start block command failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
-            }] startBlockWithControllingUID: controllingUID blocklist: blocklist isAllowlist:isAllowlist endDate:endDate blockSettings: blockSettings authorization: self.authorization reply:^(NSError* error) {
+            }];
+            void (^startReply)(NSError*) = ^(NSError* error) {
                 if (error != nil && ![SCMiscUtilities errorIsAuthCanceled: error]) {
                     NSLog(@"Start block failed with error = %@\n", error);
                     [SCSentry captureError: error];
                 }
                 reply(error);
-            }];
+            };
+
+            NSFileHandle* blocklistFile = [self transferFileForBlocklist: blocklist isAllowlist: isAllowlist];
+            if (blocklistFile != nil) {
+                [daemon startBlockWithControllingUID: controllingUID blocklistFile: blocklistFile blocklistDigest: [SCBlocklistStore digestForBlocklist: blocklist] endDate: endDate blockSettings: blockSettings authorization: self.authorization reply: startReply];
+            } else {
+                [daemon startBlockWithControllingUID: controllingUID blocklist: blocklist isAllowlist:isAllowlist endDate:endDate blockSettings: blockSettings authorization: self.authorization reply: startReply];
+            }
         }
     }];
 }
@@ -310,17 +383,26 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            id<SCDaemonProtocol> daemon = [self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Blocklist update command failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
-            }] updateBlocklist: newBlocklist authorization: self.authorization reply:^(NSError* error) {
+            }];
+            void (^updateReply)(NSError*) = ^(NSError* error) {
                 if (error != nil && ![SCMiscUtilities errorIsAuthCanceled: error]) {
                     NSLog(@"Blocklist update failed with error = %@\n", error);
                     [SCSentry captureError: error];
                 }
                 reply(error);
-            }];
+            };
+
+            // the daemon keeps the running block's allowlist setting, so the file's flag doesn't matter
+            NSFileHandle* blocklistFile = [self transferFileForBlocklist: newBlocklist isAllowlist: NO];
+            if (blocklistFile != nil) {
+                [daemon updateBlocklistFromFile: blocklistFile blocklistDigest: [SCBlocklistStore digestForBlocklist: newBlocklist] authorization: self.authorization reply: updateReply];
+            } else {
+                [daemon updateBlocklist: newBlocklist authorization: self.authorization reply: updateReply];
+            }
         }
     }];
 }
@@ -332,7 +414,7 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Block end date update command failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
@@ -361,22 +443,65 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            id<SCDaemonProtocol> daemon = [self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Register schedule failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
-            }] registerScheduleWithID: scheduleId
-                            blocklist: blocklist
-                          isAllowlist: isAllowlist
-                        blockSettings: blockSettings
-                        controllingUID: controllingUID
-                        authorization: self.authorization
-                                reply:^(NSError* error) {
+            }];
+            void (^registerReply)(NSError*) = ^(NSError* error) {
                 if (error != nil && ![SCMiscUtilities errorIsAuthCanceled: error]) {
                     NSLog(@"Register schedule failed with error = %@\n", error);
                     [SCSentry captureError: error];
                 }
                 reply(error);
+            };
+
+            NSFileHandle* blocklistFile = [self transferFileForBlocklist: blocklist isAllowlist: isAllowlist];
+            if (blocklistFile != nil) {
+                [daemon registerScheduleWithID: scheduleId
+                                 blocklistFile: blocklistFile
+                               blocklistDigest: [SCBlocklistStore digestForBlocklist: blocklist]
+                                 blockSettings: blockSettings
+                                controllingUID: controllingUID
+                                 authorization: self.authorization
+                                         reply: registerReply];
+            } else {
+                [daemon registerScheduleWithID: scheduleId
+                                     blocklist: blocklist
+                                   isAllowlist: isAllowlist
+                                 blockSettings: blockSettings
+                                controllingUID: controllingUID
+                                 authorization: self.authorization
+                                         reply: registerReply];
+            }
+        }
+    }];
+}
+
+- (void)registerSchedules:(NSDictionary<NSString*, NSDictionary*>*)schedules
+               blocklists:(NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists
+           controllingUID:(uid_t)controllingUID
+                    reply:(void(^)(NSError* error))reply {
+    [self connectAndExecuteCommandBlock:^(NSError * connectError) {
+        if (connectError != nil) {
+            NSLog(@"Register schedules failed with connection error: %@", connectError);
+            [SCSentry captureError: connectError];
+            reply(connectError);
+        } else {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
+                NSLog(@"Register schedules failed with remote object proxy error: %@", proxyError);
+                [SCSentry captureError: proxyError];
+                reply(proxyError);
+            }] registerSchedules: schedules
+                      blocklists: blocklists
+                  controllingUID: controllingUID
+                   authorization: self.authorization
+                           reply:^(NSError* error) {
+                if (error != nil && ![SCMiscUtilities errorIsAuthCanceled: error]) {
+                    NSLog(@"Register schedules failed with error = %@\n", error);
+                    [SCSentry captureError: error];
+                }
+                reply(error);
             }];
         }
     }];
@@ -392,7 +517,7 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Start scheduled block failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
@@ -417,7 +542,7 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Unregister schedule failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
@@ -441,7 +566,7 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Clear all approved schedules failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
@@ -464,7 +589,7 @@
             [SCSentry captureError: connectError];
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Clear block for debug failed with remote object proxy error: %@", proxyError);
                 [SCSentry captureError: proxyError];
                 reply(proxyError);
@@ -486,7 +611,7 @@
             NSLog(@"isPFBlockActive failed with connection error: %@", connectError);
             reply(NO, connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"isPFBlockActive failed with remote object proxy error: %@", proxyError);
                 reply(NO, proxyError);
             }] isPFBlockActiveWithReply:^(BOOL active) {
@@ -503,7 +628,7 @@
             NSLog(@"Stop test block failed with connection error: %@", connectError);
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Stop test block failed with remote object proxy error: %@", proxyError);
                 reply(proxyError);
             }] stopTestBlockWithReply:^(NSError* error) {
@@ -524,7 +649,7 @@
             NSLog(@"Clear expired block failed with connection error: %@", connectError);
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Clear expired block failed with remote object proxy error: %@", proxyError);
                 reply(proxyError);
             }] clearExpiredBlockWithReply:^(NSError* error) {
@@ -545,7 +670,7 @@
             NSLog(@"Cleanup stale schedule failed with connection error: %@", connectError);
             reply(connectError);
         } else {
-            [[self.daemonConnection remoteObjectProxyWithErrorHandler:^(NSError * proxyError) {
+            [[self daemonProxyWithErrorHandler:^(NSError * proxyError) {
                 NSLog(@"Cleanup stale schedule failed with remote object proxy error: %@", proxyError);
                 reply(proxyError);
             }] cleanupStaleScheduleWithID:scheduleId reply:^(NSError* error) {
@@ -66,11 +66,13 @@
 }
 
 + (void) removeBlockFromSettings {
-    SCSettings* settings = [SCSettings sharedSettings];
-    [settings setValue: @NO forKey: @"BlockIsRunning"];
-    [settings setValue: nil forKey: @"BlockEndDate"];
-    [settings setValue: nil forKey: @"ActiveBlocklist"];
-    [settings setValue: nil forKey: @"ActiveBlockAsWhitelist"];
+    [[SCSettings sharedSettings] setValuesForKeys: @{
+        @"BlockIsRunning": @NO,
+        @"BlockEndDate": [NSNull null],
+        @"ActiveBlocklist": [NSNull null],
+        @"ActiveBlockAsWhitelist": [NSNull null],
+        @"ActiveScheduleID": [NSNull null]
+    }];
 }
 
 @end
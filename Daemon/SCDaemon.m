@@ -11,8 +11,11 @@
 #import "SCDaemonBlockMethods.h"
 #import "SCFileWatcher.h"
 #import "SCScheduleManager.h"
+#import "SCScheduleTimeline.h"
+#import "SCSegmentScheduler.h"
 #import "SCSettings.h"
 #import "SCMiscUtilities.h"
+#import "SCBlocklistStore.h"
 #include <pwd.h>
 
 static NSString* serviceName = @"org.eyebeam.selfcontrold";
@@ -34,6 +37,7 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
 @property (nonatomic, strong, readwrite) NSDate* lastActivityDate;
 
 @property (nonatomic, strong) SCFileWatcher* hostsFileWatcher;
+@property (nonatomic, strong) SCSegmentScheduler* segmentScheduler;
 
 @end
 
@@ -69,6 +73,18 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
         [self startCheckupTimer];
     }
 
+    // Start approved schedule segments ourselves when they come due, rather than
+    // relying on a launchd job per segment to launch the CLI
+    dispatch_queue_t schedulerQueue = dispatch_queue_create("org.eyebeam.selfcontrold.segmentscheduler", DISPATCH_QUEUE_SERIAL);
+    self.segmentScheduler = [[SCSegmentScheduler alloc] initWithQueue: schedulerQueue activationHandler:^(NSString* segmentID, NSDate* endDate) {
+        [SCDaemonBlockMethods startApprovedScheduleWithID: segmentID endDate: endDate reply:^(NSError* error) {
+            if (error != nil) {
+                NSLog(@"SCDaemon: Scheduled start of segment %@ failed: %@", segmentID, error);
+            }
+        }];
+    }];
+    [self reloadScheduledSegments];
+
     // Check for missed scheduled blocks (e.g., after reboot during scheduled window)
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
         [self startMissedBlockIfNeeded];
@@ -152,6 +168,27 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
     }
 }
 
+#pragma mark - Segment Scheduling
+
+- (void)reloadScheduledSegments {
+    SCSettings* settings = [SCSettings sharedSettings];
+    NSDictionary* approvedSchedules = [settings valueForKey: @"ApprovedSchedules"];
+    [self.segmentScheduler scheduleApprovedSchedules: approvedSchedules ?: @{}];
+
+    // every change to ApprovedSchedules ends up here, so this is where blocklists
+    // that no schedule refers to any more get dropped
+    SCBlocklistStore* blocklistStore = [[SCBlocklistStore alloc] initWithBlocklists: [settings valueForKey: @"ApprovedBlocklists"]];
+    NSUInteger removedCount = [blocklistStore removeBlocklistsUnreferencedByApprovedSchedules: approvedSchedules];
+    if (removedCount > 0) {
+        [settings setValue: blocklistStore.blocklists forKey: @"ApprovedBlocklists"];
+        [settings synchronizeSettings];
+        NSLog(@"SCDaemon: Removed %lu unreferenced blocklists, %lu left", (unsigned long)removedCount, (unsigned long)blocklistStore.count);
+    }
+
+    NSLog(@"SCDaemon: Scheduled %lu approved segments, next at %@",
+          (unsigned long)self.segmentScheduler.segmentCount, self.segmentScheduler.nextActivationDate);
+}
+
 #pragma mark - Missed Block Recovery
 
 /// Checks if we're inside a scheduled block window but no block is running.
@@ -229,12 +266,40 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
     NSString *launchAgentsDir = [homeDir stringByAppendingPathComponent:@"Library/LaunchAgents"];
     [debugLog appendFormat:@"launchAgentsDir: %@\n", launchAgentsDir];
 
-    // Find all SelfControl schedule jobs
+    NSDate *now = [NSDate date];
+    NSString *activeSegmentID = nil;
+    NSDate *activeEndDate = nil;
+
+    // Segments registered with their window are already in our own scheduler
+    activeSegmentID = [self.segmentScheduler segmentIDActiveAtDate:now endDate:&activeEndDate];
+    if (activeSegmentID) {
+        [debugLog appendFormat:@"scheduler: segment %@ active until %@\n", activeSegmentID, activeEndDate];
+    }
+
+    // The app's compiled timeline answers "what's active now" with a binary search.
+    // It's user-writable, so it only tells us which segment to look at: the segment
+    // must be approved, and its times come from our own ApprovedSchedules.
+    SCScheduleTimeline *timeline = activeSegmentID ? nil : [SCScheduleTimeline timelineWithContentsOfURL:[SCScheduleTimeline timelineURLForHomeDirectory:homeDir] error:nil];
+    SCTimelineSegment *timelineSegment = [timeline segmentAtDate:now];
+    if (timelineSegment) {
+        NSDictionary *approvedSettings = approvedSchedules[timelineSegment.segmentID][@"blockSettings"];
+        NSDate *approvedStart = approvedSettings[@"SegmentStartDate"];
+        NSDate *approvedEnd = approvedSettings[@"SegmentEndDate"];
+        if ([approvedStart isKindOfClass:[NSDate class]] && [approvedEnd isKindOfClass:[NSDate class]] &&
+            [approvedStart timeIntervalSinceDate:now] <= 0 && [approvedEnd timeIntervalSinceDate:now] > 0) {
+            activeSegmentID = timelineSegment.segmentID;
+            activeEndDate = approvedEnd;
+            [debugLog appendFormat:@"timeline: segment %@ active until %@\n", activeSegmentID, activeEndDate];
+        } else {
+            [debugLog appendFormat:@"timeline: segment %@ not approved for now, scanning jobs\n", timelineSegment.segmentID];
+        }
+    }
+
+    // Find all SelfControl schedule jobs (no need if the timeline already found the segment)
     NSFileManager *fm = [NSFileManager defaultManager];
-    NSArray *files = [fm contentsOfDirectoryAtPath:launchAgentsDir error:nil];
+    NSArray *files = activeSegmentID ? @[] : [fm contentsOfDirectoryAtPath:launchAgentsDir error:nil];
     NSString *jobPrefix = @"org.eyebeam.selfcontrol.schedule.merged-";
 
-    NSDate *now = [NSDate date];
     NSCalendar *calendar = [NSCalendar currentCalendar];
     NSDateComponents *nowComponents = [calendar components:(NSCalendarUnitWeekday | NSCalendarUnitHour | NSCalendarUnitMinute)
                                                   fromDate:now];
@@ -244,8 +309,6 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
     NSInteger nowMinutes = nowComponents.hour * 60 + nowComponents.minute;
     [debugLog appendFormat:@"now: %@ (weekday=%ld, minutes=%ld)\n", now, (long)nowWeekday, (long)nowMinutes];
 
-    NSString *activeSegmentID = nil;
-    NSDate *activeEndDate = nil;
     NSInteger activeStartMinutes = -1;  // Track start time for "most recent" comparison
 
     for (NSString *file in files) {
@@ -353,7 +416,7 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
 
     // Start the block using the approved schedule
     NSDictionary *schedule = approvedSchedules[activeSegmentID];
-    NSArray *blocklist = schedule[@"blocklist"];
+    NSArray *blocklist = [SCBlocklistStore blocklistForApprovedSchedule:schedule inBlocklists:[settings valueForKey:@"ApprovedBlocklists"]];
     BOOL isAllowlist = [schedule[@"isAllowlist"] boolValue];
     NSDictionary *blockSettings = schedule[@"blockSettings"];
     uid_t controllingUID = [schedule[@"controllingUID"] unsignedIntValue];
@@ -371,6 +434,7 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
             NSLog(@"SCDaemon: Failed to start approved segment %@: %@", activeSegmentID, error);
         } else {
             NSLog(@"SCDaemon: Successfully started approved segment %@", activeSegmentID);
+            [settings setValue: activeSegmentID forKey: @"ActiveScheduleID"];
         }
     }];
 }
@@ -390,6 +454,7 @@ float const INACTIVITY_LIMIT_SECS = 60 * 2; // 2 minutes
         [settings setValue:approved forKey:@"ApprovedSchedules"];
         [settings synchronizeSettings];
         NSLog(@"SCDaemon: Removed %@ from ApprovedSchedules", scheduleId);
+        [self reloadScheduledSegments];
     }
 
     // 2. Find and remove launchd job plist
@@ -18,6 +18,9 @@ NS_ASSUME_NONNULL_BEGIN
 // Starts a block
 + (void)startBlockWithControllingUID:(uid_t)controllingUID blocklist:(NSArray<NSString*>*)blocklist isAllowlist:(BOOL)isAllowlist endDate:(NSDate*)endDate blockSettings:(NSDictionary*)blockSettings authorization:(NSData *)authData reply:(void(^)(NSError* error))reply;
 
+// Starts a pre-approved schedule segment (no authorization needed)
++ (void)startApprovedScheduleWithID:(NSString*)scheduleId endDate:(NSDate*)endDate reply:(void(^)(NSError* error))reply;
+
 // Checks whether the block is expired or compromised, and takes action to fix
 + (void)checkupBlock;
 
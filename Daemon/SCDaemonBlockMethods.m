@@ -14,10 +14,16 @@
 #import "LaunchctlHelper.h"
 #import "HostFileBlockerSet.h"
 #import "AppBlocker.h"
+#import "SCBlocklistDelta.h"
+#import "SCBlocklistStore.h"
+#import "SCSegmentTransition.h"
 
 NSTimeInterval METHOD_LOCK_TIMEOUT = 5.0;
 NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for checkups, because we'd prefer not to have tons pile up
 
+// set (under daemonMethodLock) while a checkup is resolving a segment transition outside the lock
+static BOOL segmentTransitionInProgress = NO;
+
 @implementation SCDaemonBlockMethods
 
 + (NSLock*)daemonMethodLock {
@@ -82,23 +88,26 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
     }
 
     SCSettings* settings = [SCSettings sharedSettings];
-    // update SCSettings with the blocklist and end date that've been requested
-    [settings setValue: blocklist forKey: @"ActiveBlocklist"];
-    [settings setValue: @(isAllowlist) forKey: @"ActiveBlockAsWhitelist"];
-    [settings setValue: endDate forKey: @"BlockEndDate"];
-    
-    // update all the settings for the block, which we're basically just copying from defaults to settings
-    [settings setValue: blockSettings[@"ClearCaches"] forKey: @"ClearCaches"];
-    [settings setValue: blockSettings[@"AllowLocalNetworks"] forKey: @"AllowLocalNetworks"];
-    [settings setValue: blockSettings[@"EvaluateCommonSubdomains"] forKey: @"EvaluateCommonSubdomains"];
-    [settings setValue: blockSettings[@"IncludeLinkedDomains"] forKey: @"IncludeLinkedDomains"];
-    [settings setValue: blockSettings[@"BlockSoundShouldPlay"] forKey: @"BlockSoundShouldPlay"];
-    [settings setValue: blockSettings[@"BlockSound"] forKey: @"BlockSound"];
-    [settings setValue: blockSettings[@"EnableErrorReporting"] forKey: @"EnableErrorReporting"];
-
-    // Track if this is a test block (can be stopped without emergency unlock)
-    BOOL isTestBlock = [blockSettings[@"IsTestBlock"] boolValue];
-    [settings setValue: @(isTestBlock) forKey: @"IsTestBlock"];
+    // update SCSettings with the blocklist and end date that've been requested,
+    // plus all the settings for the block, which we're basically just copying from defaults to settings.
+    // this goes in as one change so other processes never see a half-configured block
+    NSNull* unset = [NSNull null];
+    [settings setValuesForKeys: @{
+        @"ActiveBlocklist": blocklist ?: unset,
+        @"ActiveBlockAsWhitelist": @(isAllowlist),
+        @"BlockEndDate": endDate ?: unset,
+
+        @"ClearCaches": blockSettings[@"ClearCaches"] ?: unset,
+        @"AllowLocalNetworks": blockSettings[@"AllowLocalNetworks"] ?: unset,
+        @"EvaluateCommonSubdomains": blockSettings[@"EvaluateCommonSubdomains"] ?: unset,
+        @"IncludeLinkedDomains": blockSettings[@"IncludeLinkedDomains"] ?: unset,
+        @"BlockSoundShouldPlay": blockSettings[@"BlockSoundShouldPlay"] ?: unset,
+        @"BlockSound": blockSettings[@"BlockSound"] ?: unset,
+        @"EnableErrorReporting": blockSettings[@"EnableErrorReporting"] ?: unset,
+
+        // Track if this is a test block (can be stopped without emergency unlock)
+        @"IsTestBlock": @([blockSettings[@"IsTestBlock"] boolValue])
+    }];
 
     if(([blocklist count] <= 0 && !isAllowlist) || [SCBlockUtilities currentBlockIsExpired]) {
         NSLog(@"ERROR: Blocklist is empty, or block end date is in the past");
@@ -198,25 +207,23 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
     }
     
     NSArray* activeBlocklist = [settings valueForKey: @"ActiveBlocklist"];
-    NSMutableArray* added = [NSMutableArray arrayWithArray: newBlocklist];
-    [added removeObjectsInArray: activeBlocklist];
-    NSMutableArray* removed = [NSMutableArray arrayWithArray: activeBlocklist];
-    [removed removeObjectsInArray: newBlocklist];
-    
+    SCBlocklistDelta* delta = [SCBlocklistDelta deltaFromBlocklist: activeBlocklist toBlocklist: newBlocklist];
+
+    // this path is user-initiated, so it can only ever make the block stricter.
     // throw a warning if something got removed for some reason, since we ignore them
-    if (removed.count > 0) {
-        NSLog(@"WARNING: Active blocklist has removed items; these will not be updated. Removed items are %@", removed);
+    if (delta.hasRemovals) {
+        NSLog(@"WARNING: Active blocklist has removed items; these will not be updated. Removed items are %@", delta.removedEntries);
     }
     
     BlockManager* blockManager = [[BlockManager alloc] initAsAllowlist: [settings boolForKey: @"ActiveBlockAsWhitelist"]
-                                                            allowLocal: [settings boolForKey: @"EvaluateCommonSubdomains"]
-                                               includeCommonSubdomains: [settings boolForKey: @"AllowLocalNetworks"]
+                                                            allowLocal: [settings boolForKey: @"AllowLocalNetworks"]
+                                               includeCommonSubdomains: [settings boolForKey: @"EvaluateCommonSubdomains"]
                                                   includeLinkedDomains: [settings boolForKey: @"IncludeLinkedDomains"]];
-    [blockManager enterAppendMode];
-    [blockManager addBlockEntriesFromStrings: added];
-    [blockManager finishAppending];
+    NSArray* enforcedBlocklist = [delta blocklistByApplyingAdditionsToBlocklist: activeBlocklist];
+    [blockManager applyBlocklistDelta: [delta deltaByDroppingRemovals] toBlocklist: enforcedBlocklist];
     
-    [settings setValue: newBlocklist forKey: @"ActiveBlocklist"];
+    // record what's actually enforced, which includes anything we refused to remove
+    [settings setValue: enforcedBlocklist forKey: @"ActiveBlocklist"];
     
     // make sure everyone knows about our new list
     NSError* syncErr = [settings syncSettingsAndWait: 5];
@@ -334,6 +341,7 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
     }
 
     BOOL shouldRunIntegrityCheck = NO;
+    SCSegmentTransition* pendingTransition = nil;
     if(![SCBlockUtilities anyBlockIsRunning]) {
         // No block appears to be running at all in our settings.
         // Most likely, the user removed it trying to get around the block. Boo!
@@ -360,25 +368,14 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
         // once the checkups stop, the daemon will clear itself in a while due to inactivity
         NSLog(@"CHECKUP: Stopping checkup timer");
         [[SCDaemon sharedDaemon] stopCheckupTimer];
+    } else if ([SCBlockUtilities currentBlockIsExpired] && segmentTransitionInProgress) {
+        // an earlier checkup is still moving this block onto the next segment; leave it be
+    } else if ([SCBlockUtilities currentBlockIsExpired] && (pendingTransition = [SCDaemonBlockMethods transitionForExpiredBlock]) != nil) {
+        // the next approved segment picks up right where this one leaves off.
+        // Resolving its blocklist can take a while, so that happens after we unlock.
+        segmentTransitionInProgress = YES;
     } else if ([SCBlockUtilities currentBlockIsExpired]) {
-        SCSettings* settings = [SCSettings sharedSettings];
-        NSDate* blockEndDate = [settings valueForKey:@"BlockEndDate"];
-        NSArray* blocklist = [settings valueForKey:@"ActiveBlocklist"];
-
-        NSLog(@"=== CHECKUP: BLOCK EXPIRED ===");
-        NSLog(@"CHECKUP: blockEndDate was %@", blockEndDate);
-        NSLog(@"CHECKUP: blocklist had %lu entries: %@", (unsigned long)blocklist.count, blocklist);
-        NSLog(@"CHECKUP: Removing expired block...");
-
-        [SCHelperToolUtilities removeBlock];
-
-        [SCHelperToolUtilities sendConfigurationChangedNotification];
-
-        [SCSentry addBreadcrumb: @"Daemon found and cleared expired block" category: @"daemon"];
-
-        // once the checkups stop, the daemon will clear itself in a while due to inactivity
-        NSLog(@"CHECKUP: Stopping checkup timer (next segment should start via launchd job)");
-        [[SCDaemon sharedDaemon] stopCheckupTimer];
+        [SCDaemonBlockMethods removeExpiredBlock];
     } else if ([[NSDate date] timeIntervalSinceDate: lastBlockIntegrityCheck] > integrityCheckIntervalSecs) {
         lastBlockIntegrityCheck = [NSDate date];
         // The block is still on.  Every once in a while, we should
@@ -390,6 +387,10 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
     [[SCDaemon sharedDaemon] resetInactivityTimer];
     [self.daemonMethodLock unlock];
 
+    if (pendingTransition != nil) {
+        [SCDaemonBlockMethods runSegmentTransition: pendingTransition];
+    }
+
     // if we need to run an integrity check, we need to do it at the very end after we give up our lock
     // because checkBlockIntegrity requests its own lock, and we don't want it to deadlock
     if (shouldRunIntegrityCheck) {
@@ -397,6 +398,166 @@ NSTimeInterval CHECKUP_LOCK_TIMEOUT = 0.5; // use a shorter lock timeout for che
     }
 }
 
+// Starts a schedule segment that was approved at commit time (see registerSchedules: in
+// SCDaemonXPC). Called for the CLI's --schedule-id starts and by the daemon's own segment
+// scheduler; neither needs authorization, since the segment is in root-only settings.
++ (void)startApprovedScheduleWithID:(NSString*)scheduleId endDate:(NSDate*)endDate reply:(void(^)(NSError* error))reply {
+    NSLog(@"INFO: Starting approved schedule %@ until %@", scheduleId, endDate);
+
+    // Look up the approved schedule
+    SCSettings* settings = [SCSettings sharedSettings];
+    NSDictionary* approvedSchedules = [settings valueForKey: @"ApprovedSchedules"];
+    NSDictionary* schedule = approvedSchedules[scheduleId];
+
+    if (schedule == nil) {
+        NSLog(@"ERROR: Schedule %@ isn't one of the %lu approved schedules", scheduleId, (unsigned long)approvedSchedules.count);
+        reply([SCErr errorWithCode: 403 subDescription: @"Schedule not registered or unauthorized"]);
+        return;
+    }
+
+    // Extract schedule parameters
+    NSArray* blocklist = [SCBlocklistStore blocklistForApprovedSchedule: schedule inBlocklists: [settings valueForKey: @"ApprovedBlocklists"]];
+    BOOL isAllowlist = [schedule[@"isAllowlist"] boolValue];
+    NSDictionary* blockSettings = schedule[@"blockSettings"];
+    uid_t controllingUID = [schedule[@"controllingUID"] unsignedIntValue];
+
+    NSLog(@"INFO: Schedule %@ has %lu %@ entries for UID %u", scheduleId, (unsigned long)blocklist.count, isAllowlist ? @"allowlist" : @"blocklist", controllingUID);
+    if (blocklist.count == 0) {
+        NSLog(@"WARNING: Schedule %@ has an empty blocklist", scheduleId);
+    }
+
+    // if the daemon already moved the running block onto this segment (see
+    // +[SCDaemonBlockMethods checkupBlock]), there's nothing left to start
+    if ([SCBlockUtilities modernBlockIsRunning] && [[settings valueForKey: @"ActiveScheduleID"] isEqual: scheduleId]) {
+        NSLog(@"INFO: Schedule %@ is already the active block, nothing to do", scheduleId);
+        reply(nil);
+        return;
+    }
+
+    // a block that should've ended already (e.g. the checkup timer didn't run across sleep)
+    // would otherwise make startBlock refuse this one. selfcontrol-cli used to clear it
+    // before calling us, but its fast start path doesn't read settings any more.
+    if ([SCBlockUtilities anyBlockIsRunning] && [SCBlockUtilities currentBlockIsExpired]) {
+        NSLog(@"INFO: Clearing expired block before starting schedule %@", scheduleId);
+        [SCHelperToolUtilities removeBlock];
+    }
+
+    // Start the block without authorization (it was pre-approved)
+    [SCDaemonBlockMethods startBlockWithControllingUID: controllingUID
+                                             blocklist: blocklist
+                                           isAllowlist: isAllowlist
+                                               endDate: endDate
+                                         blockSettings: blockSettings
+                                         authorization: nil
+                                                 reply:^(NSError *error) {
+        if (error) {
+            NSLog(@"ERROR: Couldn't start schedule %@: %@", scheduleId, error);
+        } else {
+            NSLog(@"INFO: Started schedule %@", scheduleId);
+            [settings setValue: scheduleId forKey: @"ActiveScheduleID"];
+        }
+        reply(error);
+    }];
+}
+
+// Must be called with daemonMethodLock held
++ (void)removeExpiredBlock {
+    SCSettings* settings = [SCSettings sharedSettings];
+    NSDate* blockEndDate = [settings valueForKey:@"BlockEndDate"];
+    NSArray* blocklist = [settings valueForKey:@"ActiveBlocklist"];
+
+    NSLog(@"=== CHECKUP: BLOCK EXPIRED ===");
+    NSLog(@"CHECKUP: blockEndDate was %@", blockEndDate);
+    NSLog(@"CHECKUP: blocklist had %lu entries: %@", (unsigned long)blocklist.count, blocklist);
+    NSLog(@"CHECKUP: Removing expired block...");
+
+    [SCHelperToolUtilities removeBlock];
+
+    [SCHelperToolUtilities sendConfigurationChangedNotification];
+
+    [SCSentry addBreadcrumb: @"Daemon found and cleared expired block" category: @"daemon"];
+
+    // once the checkups stop, the daemon will clear itself in a while due to inactivity
+    NSLog(@"CHECKUP: Stopping checkup timer (next segment should start via launchd job)");
+    [[SCDaemon sharedDaemon] stopCheckupTimer];
+}
+
+// The approved segment continuing the expired scheduled block, if there is one.
+// Must be called with daemonMethodLock held.
++ (SCSegmentTransition*)transitionForExpiredBlock {
+    SCSettings* settings = [SCSettings sharedSettings];
+    if ([settings boolForKey: @"ActiveBlockAsWhitelist"]) {
+        return nil;
+    }
+
+    return [SCSegmentTransition transitionFromScheduleID: [settings valueForKey: @"ActiveScheduleID"]
+                                               blocklist: [settings valueForKey: @"ActiveBlocklist"]
+                                                endingAt: [settings valueForKey: @"BlockEndDate"]
+                                       approvedSchedules: [settings valueForKey: @"ApprovedSchedules"]
+                                      approvedBlocklists: [settings valueForKey: @"ApprovedBlocklists"]
+                                                     now: [NSDate date]];
+}
+
+// Moves an expired scheduled block directly onto the next approved segment, applying
+// only the blocklist delta instead of removing the block and waiting for the next
+// launchd job to start a new one. Must be called WITHOUT daemonMethodLock held:
+// BlockManager looks up every new entry in DNS first, and a slow resolver would
+// otherwise stall every XPC method. The lock is only taken to swap the hosts file,
+// pf rules and settings over, once the block is known not to have changed meanwhile.
++ (void)runSegmentTransition:(SCSegmentTransition*)transition {
+    SCSettings* settings = [SCSettings sharedSettings];
+    NSLog(@"INFO: Transitioning block from segment %@ to %@ in place (%@)", transition.fromScheduleID, transition.segmentID, transition.delta);
+
+    BlockManager* blockManager = [[BlockManager alloc] initAsAllowlist: NO
+                                                            allowLocal: [settings boolForKey: @"AllowLocalNetworks"]
+                                               includeCommonSubdomains: [settings boolForKey: @"EvaluateCommonSubdomains"]
+                                                  includeLinkedDomains: [settings boolForKey: @"IncludeLinkedDomains"]];
+    BOOL resolved = [blockManager resolveBlocklistDelta: transition.delta toBlocklist: transition.blocklist];
+
+    // the expired block stays up until we land, so wait our turn rather than time out
+    [self.daemonMethodLock lock];
+    segmentTransitionInProgress = NO;
+
+    if (![SCBlockUtilities anyBlockIsRunning] ||
+        ![transition isCurrentForScheduleID: [settings valueForKey: @"ActiveScheduleID"]
+                                  blocklist: [settings valueForKey: @"ActiveBlocklist"]
+                                    endDate: [settings valueForKey: @"BlockEndDate"]]) {
+        NSLog(@"INFO: Block changed while transitioning to segment %@; leaving it to the next checkup", transition.segmentID);
+        [self.daemonMethodLock unlock];
+        return;
+    }
+
+    if (!resolved || ![blockManager commitResolvedBlocklistDelta]) {
+        NSLog(@"WARNING: Failed to apply blocklist delta for segment %@; falling back to removing the block", transition.segmentID);
+        [SCDaemonBlockMethods removeExpiredBlock];
+        [self.daemonMethodLock unlock];
+        return;
+    }
+
+    [settings setValuesForKeys: @{
+        @"ActiveBlocklist": transition.blocklist,
+        @"BlockEndDate": transition.endDate,
+        @"ActiveScheduleID": transition.segmentID
+    }];
+
+    NSError* syncErr = [settings syncSettingsAndWait: 5];
+    if (syncErr != nil) {
+        NSLog(@"WARNING: Sync failed or timed out with error %@ after transitioning block", syncErr);
+        [SCSentry captureError: syncErr];
+    }
+
+    [SCHelperToolUtilities sendConfigurationChangedNotification];
+    [SCHelperToolUtilities clearCachesIfRequested];
+
+    // the next approved segment picked up right where this one left off,
+    // so the block is still running (with a new blocklist and end date)
+    [SCSentry addBreadcrumb: @"Daemon moved expired block onto next scheduled segment" category: @"daemon"];
+    NSLog(@"INFO: Block now running for segment %@ until %@", transition.segmentID, transition.endDate);
+
+    [[SCDaemon sharedDaemon] resetInactivityTimer];
+    [self.daemonMethodLock unlock];
+}
+
 + (void)checkBlockIntegrity {
     if (![SCDaemonBlockMethods lockOrTimeout: nil timeout: CHECKUP_LOCK_TIMEOUT]) {
         return;
@@ -17,6 +17,12 @@ NS_ASSUME_NONNULL_BEGIN
 // XPC method to add to blocklist
 - (void)updateBlocklist:(NSArray<NSString*>*)newBlocklist authorization:(NSData *)authData reply:(void(^)(NSError* error))reply;
 
+// Bulk-transfer versions of the two methods above, for large blocklists: the blocklist arrives
+// as a read-only file in the compact format (which also records isAllowlist) plus its digest.
+// See SCBlocklistTransfer. Same authorization as the array versions.
+- (void)startBlockWithControllingUID:(uid_t)controllingUID blocklistFile:(NSFileHandle*)blocklistFile blocklistDigest:(NSString*)blocklistDigest endDate:(NSDate*)endDate blockSettings:(NSDictionary*)blockSettings authorization:(NSData *)authData reply:(void(^)(NSError* error))reply;
+- (void)updateBlocklistFromFile:(NSFileHandle*)blocklistFile blocklistDigest:(NSString*)blocklistDigest authorization:(NSData *)authData reply:(void(^)(NSError* error))reply;
+
 // XPC method to extend block
 - (void)updateBlockEndDate:(NSDate*)newEndDate authorization:(NSData *)authData reply:(void(^)(NSError* error))reply;
 
@@ -32,6 +38,24 @@ NS_ASSUME_NONNULL_BEGIN
                  authorization:(NSData *)authData
                          reply:(void(^)(NSError* error))reply;
 
+// Bulk-transfer version of registerScheduleWithID (see SCBlocklistTransfer)
+- (void)registerScheduleWithID:(NSString*)scheduleId
+                 blocklistFile:(NSFileHandle*)blocklistFile
+               blocklistDigest:(NSString*)blocklistDigest
+                 blockSettings:(NSDictionary*)blockSettings
+                controllingUID:(uid_t)controllingUID
+                 authorization:(NSData *)authData
+                         reply:(void(^)(NSError* error))reply;
+
+// XPC method to register all of a commit's segments at once; the daemon then starts
+// each one itself when its SegmentStartDate arrives (same authorization as registerScheduleWithID).
+// Segments refer to their blocklist by digest; blocklists holds each distinct one once.
+- (void)registerSchedules:(NSDictionary<NSString*, NSDictionary*>*)schedules
+               blocklists:(NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists
+           controllingUID:(uid_t)controllingUID
+            authorization:(NSData *)authData
+                    reply:(void(^)(NSError* error))reply;
+
 // XPC method to start a pre-registered schedule (NO authorization required)
 - (void)startScheduledBlockWithID:(NSString*)scheduleId
                           endDate:(NSDate*)endDate
@@ -10,6 +10,9 @@
 #import "SCDaemonBlockMethods.h"
 #import "SCXPCAuthorization.h"
 #import "SCHelperToolUtilities.h"
+#import "SCBlocklistStore.h"
+#import "SCBlocklistTransfer.h"
+#import "SCSegmentScheduler.h"
 
 @implementation SCDaemonXPC
 
@@ -49,6 +52,62 @@
     [SCDaemonBlockMethods updateBlocklist: newBlocklist authorization: authData reply: reply];
 }
 
+- (void)startBlockWithControllingUID:(uid_t)controllingUID blocklistFile:(NSFileHandle*)blocklistFile blocklistDigest:(NSString*)blocklistDigest endDate:(NSDate*)endDate blockSettings:(NSDictionary*)blockSettings authorization:(NSData *)authData reply:(void(^)(NSError* error))reply {
+    NSLog(@"XPC method called: startBlockWithControllingUID (blocklist file)");
+
+    NSError* error = [SCXPCAuthorization checkAuthorization: authData command: _cmd];
+    if (error != nil) {
+        if (![SCMiscUtilities errorIsAuthCanceled: error]) {
+            NSLog(@"ERROR: XPC authorization failed due to error %@", error);
+            [SCSentry captureError: error];
+        }
+        reply(error);
+        return;
+    }
+
+    BOOL isAllowlist = NO;
+    NSArray<NSString*>* blocklist = [self blocklistFromFile: blocklistFile digest: blocklistDigest isAllowlist: &isAllowlist];
+    if (blocklist == nil) {
+        reply([SCErr errorWithCode: 312]);
+        return;
+    }
+
+    [SCDaemonBlockMethods startBlockWithControllingUID: controllingUID blocklist: blocklist isAllowlist: isAllowlist endDate: endDate blockSettings: blockSettings authorization: authData reply: reply];
+}
+
+- (void)updateBlocklistFromFile:(NSFileHandle*)blocklistFile blocklistDigest:(NSString*)blocklistDigest authorization:(NSData *)authData reply:(void(^)(NSError* error))reply {
+    NSLog(@"XPC method called: updateBlocklistFromFile");
+
+    NSError* error = [SCXPCAuthorization checkAuthorization: authData command: _cmd];
+    if (error != nil) {
+        if (![SCMiscUtilities errorIsAuthCanceled: error]) {
+            NSLog(@"ERROR: XPC authorization failed due to error %@", error);
+            [SCSentry captureError: error];
+        }
+        reply(error);
+        return;
+    }
+
+    NSArray<NSString*>* newBlocklist = [self blocklistFromFile: blocklistFile digest: blocklistDigest isAllowlist: NULL];
+    if (newBlocklist == nil) {
+        reply([SCErr errorWithCode: 312]);
+        return;
+    }
+
+    [SCDaemonBlockMethods updateBlocklist: newBlocklist authorization: authData reply: reply];
+}
+
+// Decodes a bulk-transferred blocklist, or logs why it couldn't and returns nil
+- (NSArray<NSString*>*)blocklistFromFile:(NSFileHandle*)blocklistFile digest:(NSString*)digest isAllowlist:(BOOL*)isAllowlist {
+    NSError* error;
+    NSArray<NSString*>* blocklist = [SCBlocklistTransfer blocklistFromFileHandle: blocklistFile digest: digest isAllowlist: isAllowlist error: &error];
+    if (blocklist == nil) {
+        NSLog(@"ERROR: Couldn't read transferred blocklist: %@", error);
+        [SCSentry captureError: error];
+    }
+    return blocklist;
+}
+
 - (void)updateBlockEndDate:(NSDate*)newEndDate authorization:(NSData *)authData reply:(void(^)(NSError* error))reply {
     NSLog(@"XPC method called: updateBlockEndDate");
     
@@ -98,84 +157,136 @@
         approvedSchedules = [NSMutableDictionary new];
     }
 
+    // The blocklist goes in the blocklist store (once, however many schedules share it)
+    SCBlocklistStore* blocklistStore = [[SCBlocklistStore alloc] initWithBlocklists: [settings valueForKey: @"ApprovedBlocklists"]];
+    NSString* blocklistDigest = [blocklistStore addBlocklist: blocklist ?: @[]];
+
     // Store schedule details keyed by scheduleId
     approvedSchedules[scheduleId] = @{
-        @"blocklist": blocklist ?: @[],
+        @"blocklistDigest": blocklistDigest,
         @"isAllowlist": @(isAllowlist),
         @"blockSettings": blockSettings ?: @{},
         @"controllingUID": @(controllingUID),
         @"registeredAt": [NSDate date]
     };
 
+    [settings setValue: blocklistStore.blocklists forKey: @"ApprovedBlocklists"];
     [settings setValue: approvedSchedules forKey: @"ApprovedSchedules"];
     [settings synchronizeSettings];
 
     NSLog(@"INFO: Schedule %@ registered successfully", scheduleId);
+    [[SCDaemon sharedDaemon] reloadScheduledSegments];
     reply(nil);
 }
 
-// Start a pre-registered schedule - NO authorization required (schedule was pre-approved)
-- (void)startScheduledBlockWithID:(NSString*)scheduleId
-                          endDate:(NSDate*)endDate
-                            reply:(void(^)(NSError* error))reply {
-    NSLog(@"=== DAEMON: startScheduledBlockWithID ===");
-    NSLog(@"DAEMON: scheduleId = %@", scheduleId);
-    NSLog(@"DAEMON: requested endDate = %@", endDate);
+// Bulk-transfer version of the above, same trust model
+- (void)registerScheduleWithID:(NSString*)scheduleId
+                 blocklistFile:(NSFileHandle*)blocklistFile
+               blocklistDigest:(NSString*)blocklistDigest
+                 blockSettings:(NSDictionary*)blockSettings
+                controllingUID:(uid_t)controllingUID
+                 authorization:(NSData *)authData
+                         reply:(void(^)(NSError* error))reply {
+    BOOL isAllowlist = NO;
+    NSArray<NSString*>* blocklist = [self blocklistFromFile: blocklistFile digest: blocklistDigest isAllowlist: &isAllowlist];
+    if (blocklist == nil) {
+        reply([SCErr errorWithCode: 312]);
+        return;
+    }
 
-    // NO authorization check - we trust the schedule because it was pre-approved
-    // and stored in root-only settings file
+    [self registerScheduleWithID: scheduleId
+                       blocklist: blocklist
+                     isAllowlist: isAllowlist
+                   blockSettings: blockSettings
+                  controllingUID: controllingUID
+                   authorization: authData
+                           reply: reply];
+}
 
-    // Look up the approved schedule
-    SCSettings* settings = [SCSettings sharedSettings];
-    NSDictionary* approvedSchedules = [settings valueForKey: @"ApprovedSchedules"];
-    NSLog(@"DAEMON: ApprovedSchedules count = %lu", (unsigned long)approvedSchedules.count);
-    NSLog(@"DAEMON: ApprovedSchedules keys = %@", [approvedSchedules allKeys]);
+// Register every segment of a commit in one call - same trust model as registerScheduleWithID:
+// (authorization was verified by installDaemon: just before). Each value holds the segment's
+// blocklistDigest, isAllowlist and blockSettings, and blocklists carries each distinct blocklist
+// once, keyed by digest. Everything is written with a single settings sync.
+- (void)registerSchedules:(NSDictionary<NSString*, NSDictionary*>*)schedules
+               blocklists:(NSDictionary<NSString*, NSArray<NSString*>*>*)blocklists
+           controllingUID:(uid_t)controllingUID
+            authorization:(NSData *)authData
+                    reply:(void(^)(NSError* error))reply {
+    NSLog(@"XPC method called: registerSchedules: %lu segments, %lu blocklists (auth verified by installDaemon)",
+          (unsigned long)schedules.count, (unsigned long)blocklists.count);
 
-    NSDictionary* schedule = approvedSchedules[scheduleId];
+    SCSettings* settings = [SCSettings sharedSettings];
 
-    if (schedule == nil) {
-        NSLog(@"DAEMON ERROR: Schedule ID %@ NOT FOUND in approved schedules!", scheduleId);
-        NSLog(@"DAEMON: Available schedules: %@", approvedSchedules);
-        reply([SCErr errorWithCode: 403 subDescription: @"Schedule not registered or unauthorized"]);
-        return;
+    // digests are only trusted once we've checked them against the contents
+    SCBlocklistStore* blocklistStore = [[SCBlocklistStore alloc] initWithBlocklists: [settings valueForKey: @"ApprovedBlocklists"]];
+    for (NSString* digest in blocklists) {
+        if (![blocklistStore addBlocklist: blocklists[digest] withDigest: digest]) {
+            reply([SCErr errorWithCode: 311]);
+            return;
+        }
+    }
+    for (NSString* scheduleId in schedules) {
+        NSString* digest = schedules[scheduleId][@"blocklistDigest"];
+        if (![digest isKindOfClass: [NSString class]] || [blocklistStore blocklistForDigest: digest] == nil) {
+            NSLog(@"ERROR: Schedule %@ refers to a blocklist that wasn't sent", scheduleId);
+            reply([SCErr errorWithCode: 311]);
+            return;
+        }
     }
 
-    NSLog(@"DAEMON: Found approved schedule %@", scheduleId);
+    NSMutableDictionary* approvedSchedules = [[settings valueForKey: @"ApprovedSchedules"] mutableCopy];
+    if (approvedSchedules == nil) {
+        approvedSchedules = [NSMutableDictionary new];
+    }
 
-    // Extract schedule parameters
-    NSArray* blocklist = schedule[@"blocklist"];
-    BOOL isAllowlist = [schedule[@"isAllowlist"] boolValue];
-    NSDictionary* blockSettings = schedule[@"blockSettings"];
-    uid_t controllingUID = [schedule[@"controllingUID"] unsignedIntValue];
+    // drop segments that have already ended while we're rewriting the list anyway
+    NSDate* now = [NSDate date];
+    for (NSString* scheduleId in [approvedSchedules allKeys]) {
+        NSDate* segmentEndDate = approvedSchedules[scheduleId][@"blockSettings"][@"SegmentEndDate"];
+        if ([segmentEndDate isKindOfClass: [NSDate class]] && [segmentEndDate timeIntervalSinceDate: now] <= 0) {
+            [approvedSchedules removeObjectForKey: scheduleId];
+        }
+    }
 
-    NSLog(@"DAEMON: blocklist count = %lu", (unsigned long)blocklist.count);
-    NSLog(@"DAEMON: blocklist = %@", blocklist);
-    NSLog(@"DAEMON: isAllowlist = %d", isAllowlist);
-    NSLog(@"DAEMON: controllingUID = %u", controllingUID);
-    NSLog(@"DAEMON: blockSettings = %@", blockSettings);
+    NSDate* registeredAt = [NSDate date];
+    for (NSString* scheduleId in schedules) {
+        NSDictionary* schedule = schedules[scheduleId];
+        approvedSchedules[scheduleId] = @{
+            @"blocklistDigest": schedule[@"blocklistDigest"],
+            @"isAllowlist": schedule[@"isAllowlist"] ?: @NO,
+            @"blockSettings": schedule[@"blockSettings"] ?: @{},
+            @"controllingUID": @(controllingUID),
+            @"registeredAt": registeredAt
+        };
+    }
 
-    if (blocklist.count == 0) {
-        NSLog(@"DAEMON WARNING: Blocklist is EMPTY! Block may not do anything.");
+    // the segment scheduler and the checkup's segment transitions assume at most one segment at a time
+    NSArray<NSString*>* overlappingIDs = [SCSegmentScheduler overlappingSegmentIDsInApprovedSchedules: approvedSchedules];
+    if (overlappingIDs != nil) {
+        NSLog(@"ERROR: Not registering schedules because segments %@ and %@ overlap", overlappingIDs[0], overlappingIDs[1]);
+        reply([SCErr errorWithCode: 313]);
+        return;
     }
 
-    NSLog(@"DAEMON: Calling startBlockWithControllingUID...");
-
-    // Start the block without authorization (it was pre-approved)
-    [SCDaemonBlockMethods startBlockWithControllingUID: controllingUID
-                                             blocklist: blocklist
-                                           isAllowlist: isAllowlist
-                                               endDate: endDate
-                                         blockSettings: blockSettings
-                                         authorization: nil
-                                                 reply:^(NSError *error) {
-        if (error) {
-            NSLog(@"DAEMON ERROR: startBlock failed: %@", error);
-        } else {
-            NSLog(@"DAEMON: Block started successfully for schedule %@", scheduleId);
-        }
-        NSLog(@"=== DAEMON: startScheduledBlockWithID COMPLETE ===");
-        reply(error);
-    }];
+    // blocklists of the segments pruned above are collected by reloadScheduledSegments
+    [settings setValue: blocklistStore.blocklists forKey: @"ApprovedBlocklists"];
+    [settings setValue: approvedSchedules forKey: @"ApprovedSchedules"];
+    [settings synchronizeSettings];
+
+    NSLog(@"INFO: Registered %lu schedules", (unsigned long)schedules.count);
+    [[SCDaemon sharedDaemon] reloadScheduledSegments];
+    reply(nil);
+}
+
+// Start a pre-registered schedule - NO authorization required (schedule was pre-approved)
+- (void)startScheduledBlockWithID:(NSString*)scheduleId
+                          endDate:(NSDate*)endDate
+                            reply:(void(^)(NSError* error))reply {
+    NSLog(@"XPC method called: startScheduledBlockWithID: %@", scheduleId);
+
+    // NO authorization check - we trust the schedule because it was pre-approved
+    // and stored in root-only settings file
+    [SCDaemonBlockMethods startApprovedScheduleWithID: scheduleId endDate: endDate reply: reply];
 }
 
 // Unregister a schedule - requires authorization
@@ -203,6 +314,7 @@
     }
 
     NSLog(@"INFO: Schedule %@ unregistered successfully", scheduleId);
+    [[SCDaemon sharedDaemon] reloadScheduledSegments];
     reply(nil);
 }
 
@@ -225,6 +337,7 @@
     [settings synchronizeSettings];
 
     NSLog(@"INFO: All approved schedules cleared successfully");
+    [[SCDaemon sharedDaemon] reloadScheduledSegments];
     reply(nil);
 }
 
@@ -0,0 +1,45 @@
+//
+//  SCSegmentScheduler.h
+//  selfcontrold
+//
+//  Keeps the approved schedule segments in start order and arms a single wall-clock
+//  timer for the next one to start, so the daemon starts scheduled blocks itself
+//  instead of waiting for a launchd job to launch selfcontrol-cli.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^SCSegmentActivationHandler)(NSString* segmentID, NSDate* endDate);
+
+@interface SCSegmentScheduler : NSObject
+
+// handler is called on queue when a segment's start date arrives, or right away
+// for a segment that's already in progress when it gets scheduled
+- (instancetype)initWithQueue:(dispatch_queue_t)queue activationHandler:(SCSegmentActivationHandler)handler;
+
+// Replaces everything scheduled with the approved schedules (ApprovedSchedules format)
+// that record their window in blockSettings' SegmentStartDate/SegmentEndDate.
+// Schedules registered without a window, and ones that have already ended, are ignored.
+// Segments must not overlap; one that starts before the segment ahead of it ends is dropped.
+- (void)scheduleApprovedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules;
+
+// Two segments (ApprovedSchedules format) whose windows overlap, or nil if none do.
+// Windows are half-open, so a segment starting as another ends doesn't overlap it.
++ (nullable NSArray<NSString*>*)overlappingSegmentIDsInApprovedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules;
+
+// The scheduled segment whose window contains date, or nil if there isn't one
+- (nullable NSString*)segmentIDActiveAtDate:(NSDate*)date endDate:(NSDate* _Nullable * _Nullable)endDate;
+
+@property (readonly) NSUInteger segmentCount;
+
+// Start date of the next segment the timer is armed for (nil if nothing is left)
+@property (readonly, nullable) NSDate* nextActivationDate;
+
+// Stops the timer for good
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,198 @@
+//
+//  SCSegmentScheduler.m
+//  selfcontrold
+//
+
+#import "SCSegmentScheduler.h"
+
+// how late the timer is allowed to fire; segments are minute-aligned, so a second is plenty
+static const uint64_t kActivationLeewayNsecs = NSEC_PER_SEC;
+
+@interface SCScheduledSegment : NSObject
+@property (nonatomic, copy) NSString* segmentID;
+@property (nonatomic, strong) NSDate* startDate;
+@property (nonatomic, strong) NSDate* endDate;
+@end
+
+@implementation SCScheduledSegment
+@end
+
+@interface SCSegmentScheduler () {
+    dispatch_queue_t queue_;
+    dispatch_source_t timer_;
+    SCSegmentActivationHandler handler_;
+
+    // sorted by start date; everything before nextIndex_ has already been activated or skipped
+    NSArray<SCScheduledSegment*>* segments_;
+    NSUInteger nextIndex_;
+}
+@end
+
+@implementation SCSegmentScheduler
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue activationHandler:(SCSegmentActivationHandler)handler {
+    if (self = [super init]) {
+        queue_ = queue;
+        handler_ = [handler copy];
+        segments_ = @[];
+
+        timer_ = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+        __weak SCSegmentScheduler* weakSelf = self;
+        dispatch_source_set_event_handler(timer_, ^{
+            [weakSelf activateDueSegments];
+        });
+        dispatch_source_set_timer(timer_, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, kActivationLeewayNsecs);
+        dispatch_resume(timer_);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self invalidate];
+}
+
+- (void)invalidate {
+    @synchronized (self) {
+        if (timer_ != nil) {
+            dispatch_source_cancel(timer_);
+            timer_ = nil;
+        }
+    }
+}
+
+// The segments with a window (ApprovedSchedules format), sorted by start date
++ (NSArray<SCScheduledSegment*>*)sortedSegmentsInApprovedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules {
+    NSMutableArray<SCScheduledSegment*>* segments = [NSMutableArray arrayWithCapacity: approvedSchedules.count];
+    for (NSString* segmentID in approvedSchedules) {
+        NSDictionary* blockSettings = approvedSchedules[segmentID][@"blockSettings"];
+        NSDate* startDate = blockSettings[@"SegmentStartDate"];
+        NSDate* endDate = blockSettings[@"SegmentEndDate"];
+        if (![startDate isKindOfClass: [NSDate class]] || ![endDate isKindOfClass: [NSDate class]]) continue;
+
+        SCScheduledSegment* segment = [SCScheduledSegment new];
+        segment.segmentID = segmentID;
+        segment.startDate = startDate;
+        segment.endDate = endDate;
+        [segments addObject: segment];
+    }
+    [segments sortUsingComparator:^NSComparisonResult(SCScheduledSegment* a, SCScheduledSegment* b) {
+        return [a.startDate compare: b.startDate];
+    }];
+    return segments;
+}
+
++ (nullable NSArray<NSString*>*)overlappingSegmentIDsInApprovedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules {
+    // in start order, a segment overlaps something earlier exactly when it starts before the latest end so far
+    SCScheduledSegment* latestEnding = nil;
+    for (SCScheduledSegment* segment in [self sortedSegmentsInApprovedSchedules: approvedSchedules]) {
+        if (latestEnding != nil && [segment.startDate compare: latestEnding.endDate] == NSOrderedAscending) {
+            return @[latestEnding.segmentID, segment.segmentID];
+        }
+        if (latestEnding == nil || [segment.endDate compare: latestEnding.endDate] == NSOrderedDescending) {
+            latestEnding = segment;
+        }
+    }
+    return nil;
+}
+
+- (void)scheduleApprovedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules {
+    NSDate* now = [NSDate date];
+    NSMutableArray<SCScheduledSegment*>* segments = [NSMutableArray arrayWithCapacity: approvedSchedules.count];
+    for (SCScheduledSegment* segment in [SCSegmentScheduler sortedSegmentsInApprovedSchedules: approvedSchedules]) {
+        if ([segment.endDate timeIntervalSinceDate: now] <= 0) continue;
+
+        // activateDueSegments and segmentIDActiveAtDate: rely on the segments not overlapping.
+        // registerSchedules: refuses overlapping segments, so this only catches older settings.
+        SCScheduledSegment* previous = segments.lastObject;
+        if (previous != nil && [segment.startDate compare: previous.endDate] == NSOrderedAscending) {
+            NSLog(@"WARNING: SCSegmentScheduler: Segment %@ overlaps %@, not scheduling it", segment.segmentID, previous.segmentID);
+            continue;
+        }
+        [segments addObject: segment];
+    }
+
+    @synchronized (self) {
+        segments_ = segments;
+        nextIndex_ = 0;
+    }
+
+    // picks up an in-progress segment straight away, then arms the timer for the next one
+    __weak SCSegmentScheduler* weakSelf = self;
+    dispatch_async(queue_, ^{
+        [weakSelf activateDueSegments];
+    });
+}
+
+// Must be called on queue_
+- (void)activateDueSegments {
+    NSDate* now = [NSDate date];
+    SCScheduledSegment* due = nil;
+
+    @synchronized (self) {
+        // segments don't overlap (see scheduleApprovedSchedules:), so of everything that's started only the latest can still be running
+        while (nextIndex_ < segments_.count && [segments_[nextIndex_].startDate timeIntervalSinceDate: now] <= 0) {
+            SCScheduledSegment* segment = segments_[nextIndex_++];
+            due = ([segment.endDate timeIntervalSinceDate: now] > 0) ? segment : nil;
+        }
+        [self armTimer];
+    }
+
+    if (due != nil) {
+        NSLog(@"SCSegmentScheduler: Activating segment %@ until %@", due.segmentID, due.endDate);
+        handler_(due.segmentID, due.endDate);
+    }
+}
+
+// Must be called while synchronized on self
+- (void)armTimer {
+    if (timer_ == nil) return;
+
+    if (nextIndex_ >= segments_.count) {
+        dispatch_source_set_timer(timer_, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, kActivationLeewayNsecs);
+        return;
+    }
+
+    // wall clock rather than uptime, so sleeping through a start still fires on wake
+    NSTimeInterval startInterval = segments_[nextIndex_].startDate.timeIntervalSince1970;
+    struct timespec startSpec = {
+        .tv_sec = (time_t)floor(startInterval),
+        .tv_nsec = (long)((startInterval - floor(startInterval)) * NSEC_PER_SEC)
+    };
+    dispatch_source_set_timer(timer_, dispatch_walltime(&startSpec, 0), DISPATCH_TIME_FOREVER, kActivationLeewayNsecs);
+}
+
+- (nullable NSString*)segmentIDActiveAtDate:(NSDate*)date endDate:(NSDate* _Nullable * _Nullable)endDate {
+    @synchronized (self) {
+        // last segment starting at or before date
+        NSUInteger lo = 0, hi = segments_.count;
+        while (lo < hi) {
+            NSUInteger mid = lo + (hi - lo) / 2;
+            if ([segments_[mid].startDate timeIntervalSinceDate: date] <= 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == 0 || [segments_[lo - 1].endDate timeIntervalSinceDate: date] <= 0) {
+            return nil;
+        }
+
+        SCScheduledSegment* segment = segments_[lo - 1];
+        if (endDate != NULL) *endDate = segment.endDate;
+        return segment.segmentID;
+    }
+}
+
+- (NSUInteger)segmentCount {
+    @synchronized (self) {
+        return segments_.count;
+    }
+}
+
+- (nullable NSDate*)nextActivationDate {
+    @synchronized (self) {
+        return (nextIndex_ < segments_.count) ? segments_[nextIndex_].startDate : nil;
+    }
+}
+
+@end
@@ -0,0 +1,46 @@
+//
+//  SCSegmentTransition.h
+//  selfcontrold
+//
+//  Plan for moving an expiring scheduled block straight onto the approved segment
+//  that continues it. Planning doesn't touch settings, so the daemon can resolve the
+//  new blocklist without holding its method lock and only lock for the swap.
+//
+
+#import <Foundation/Foundation.h>
+
+@class SCBlocklistDelta;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCSegmentTransition : NSObject
+
+@property (readonly, copy) NSString* fromScheduleID;
+@property (readonly) NSDate* fromEndDate;
+
+@property (readonly, copy) NSString* segmentID;
+@property (readonly, copy) NSArray<NSString*>* blocklist;
+@property (readonly) NSDate* endDate;
+
+// From the running block's blocklist to the segment's
+@property (readonly) SCBlocklistDelta* delta;
+
+// The transition for a scheduled block ending at blockEndDate, or nil if no approved
+// blocklist segment (ApprovedSchedules format) starts within the launchd gap after it
+// and hasn't ended by now. Segments registered without a window never match.
++ (nullable instancetype)transitionFromScheduleID:(nullable NSString*)activeScheduleID
+                                        blocklist:(nullable NSArray<NSString*>*)activeBlocklist
+                                         endingAt:(nullable NSDate*)blockEndDate
+                                approvedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules
+                               approvedBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)approvedBlocklists
+                                              now:(NSDate*)now;
+
+// YES if the running block is still the one this transition was planned from
+// (nothing started, extended or edited it in the meantime)
+- (BOOL)isCurrentForScheduleID:(nullable NSString*)activeScheduleID
+                     blocklist:(nullable NSArray<NSString*>*)activeBlocklist
+                       endDate:(nullable NSDate*)blockEndDate;
+
+@end
+
+NS_ASSUME_NONNULL_END
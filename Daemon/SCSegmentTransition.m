@@ -0,0 +1,90 @@
+//
+//  SCSegmentTransition.m
+//  selfcontrold
+//
+
+#import "SCSegmentTransition.h"
+#import "SCBlocklistDelta.h"
+#import "SCBlocklistStore.h"
+#import "SCScheduleTimeline.h"
+
+@interface SCSegmentTransition ()
+@property (readwrite, copy) NSString* fromScheduleID;
+@property (readwrite, copy) NSArray<NSString*>* fromBlocklist;
+@property (readwrite) NSDate* fromEndDate;
+@property (readwrite, copy) NSString* segmentID;
+@property (readwrite, copy) NSArray<NSString*>* blocklist;
+@property (readwrite) NSDate* endDate;
+@property (readwrite) SCBlocklistDelta* delta;
+@end
+
+@implementation SCSegmentTransition
+
++ (nullable NSString*)segmentIDContinuingBlockEndingAt:(NSDate*)blockEndDate approvedSchedules:(NSDictionary<NSString*, NSDictionary*>*)approvedSchedules now:(NSDate*)now {
+    NSString* bestSegmentID = nil;
+    NSDate* bestStartDate = nil;
+    for (NSString* segmentID in approvedSchedules) {
+        NSDictionary* blockSettings = approvedSchedules[segmentID][@"blockSettings"];
+        NSDate* startDate = blockSettings[@"SegmentStartDate"];
+        NSDate* endDate = blockSettings[@"SegmentEndDate"];
+        if (![startDate isKindOfClass: [NSDate class]] || ![endDate isKindOfClass: [NSDate class]]) continue;
+        if ([approvedSchedules[segmentID][@"isAllowlist"] boolValue]) continue;
+
+        if ([endDate timeIntervalSinceDate: now] <= 0) continue;
+        if ([startDate timeIntervalSinceDate: blockEndDate] > kScheduleTimelineMaxContinuationGapSecs) continue;
+        if ([startDate timeIntervalSinceDate: now] > kScheduleTimelineMaxContinuationGapSecs) continue;
+
+        if (bestStartDate == nil || [startDate compare: bestStartDate] == NSOrderedDescending) {
+            bestSegmentID = segmentID;
+            bestStartDate = startDate;
+        }
+    }
+
+    return bestSegmentID;
+}
+
++ (nullable instancetype)transitionFromScheduleID:(nullable NSString*)activeScheduleID
+                                        blocklist:(nullable NSArray<NSString*>*)activeBlocklist
+                                         endingAt:(nullable NSDate*)blockEndDate
+                                approvedSchedules:(nullable NSDictionary<NSString*, NSDictionary*>*)approvedSchedules
+                               approvedBlocklists:(nullable NSDictionary<NSString*, NSArray<NSString*>*>*)approvedBlocklists
+                                              now:(NSDate*)now {
+    if (activeScheduleID == nil || ![blockEndDate isKindOfClass: [NSDate class]]) {
+        return nil;
+    }
+
+    NSString* segmentID = [self segmentIDContinuingBlockEndingAt: blockEndDate approvedSchedules: approvedSchedules now: now];
+    if (segmentID == nil || [segmentID isEqualToString: activeScheduleID]) {
+        return nil;
+    }
+
+    NSDictionary* schedule = approvedSchedules[segmentID];
+    NSArray<NSString*>* newBlocklist = [SCBlocklistStore blocklistForApprovedSchedule: schedule inBlocklists: approvedBlocklists];
+    if (newBlocklist.count == 0) {
+        return nil;
+    }
+
+    SCSegmentTransition* transition = [self new];
+    transition.fromScheduleID = activeScheduleID;
+    transition.fromBlocklist = activeBlocklist ?: @[];
+    transition.fromEndDate = blockEndDate;
+    transition.segmentID = segmentID;
+    transition.blocklist = newBlocklist;
+    transition.endDate = schedule[@"blockSettings"][@"SegmentEndDate"];
+    transition.delta = [SCBlocklistDelta deltaFromBlocklist: activeBlocklist toBlocklist: newBlocklist];
+    return transition;
+}
+
+- (BOOL)isCurrentForScheduleID:(nullable NSString*)activeScheduleID
+                     blocklist:(nullable NSArray<NSString*>*)activeBlocklist
+                       endDate:(nullable NSDate*)blockEndDate {
+    return [self.fromScheduleID isEqual: activeScheduleID]
+        && [self.fromEndDate isEqual: blockEndDate]
+        && [self.fromBlocklist isEqualToArray: activeBlocklist ?: @[]];
+}
+
+- (NSString*)description {
+    return [NSString stringWithFormat: @"<SCSegmentTransition %@ -> %@ until %@ (%@)>", self.fromScheduleID, self.segmentID, self.endDate, self.delta];
+}
+
+@end
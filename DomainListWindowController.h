@@ -35,6 +35,14 @@
 	IBOutlet NSTableView* domainListTableView_;
     IBOutlet NSMatrix* allowlistRadioMatrix_;
 	NSUserDefaults* defaults_;
+
+	// Display title and validity per entry string, so scrolling and editing
+	// don't re-parse every visible row
+	NSCache* entryDisplayCache_;
+
+	// Edits are written back to the defaults in batches, see scheduleBlocklistSave:
+	BOOL blocklistSaveScheduled_;
+	BOOL blocklistSaveShouldNotify_;
 }
 
 @property (getter=isReadOnly) BOOL readOnly;
@@ -45,13 +53,17 @@
 
 - (void)refreshDomainList;
 
+// Writes any edits still waiting in the current batch to the defaults. Anything that reads
+// or replaces the Blocklist default while the domain list is open should call this first.
+- (void)saveBlocklistNow;
+
 // Called when the add button is clicked.  Adds a new empty string to the domain
-// list, reloads the table view, and highlights and opens that cell for editing.
+// list, inserts its row, and highlights and opens that cell for editing.
 - (IBAction)addDomain:(id)sender;
 
 // Called when the remove button is clicked (or when the delete key is pressed,
-// which just maps to the remove button).  Deletes all selected rows and reloads
-// the table view.  Sends a SCConfigurationChangedNotification.
+// which just maps to the remove button).  Deletes all selected rows.  Sends a
+// SCConfigurationChangedNotification once the change is saved.
 - (IBAction)removeDomain:(id)sender;
 
 // Called by the table view on it's data source object (this) to determine how
@@ -66,8 +78,8 @@
 
 // Called by the table view on it's data source object (this) to set the value
 // of the cell at a given row index.  Sets the value of the corresponding object
-// in the domain list array and reloads the table view.  Sends a
-// SCConfigurationChangedNotification.
+// in the domain list array and reloads that row.  Sends a
+// SCConfigurationChangedNotification once the change is saved.
 - (void)tableView:(NSTableView *)aTableView
    setObjectValue:(id)theObject
    forTableColumn:(NSTableColumn *)aTableColumn
@@ -90,24 +102,24 @@
 // Called when the button-menu item is clicked to import all incoming mail
 // servers from Thunderbird.  Adds to the domain list array all incoming mail
 // servers from the Thunderbird default profile that haven't already been added,
-// and reloads the table view.  Sends a SCConfigurationChangedNotification.
+// and inserts their rows.  Sends a SCConfigurationChangedNotification.
 - (IBAction)importIncomingMailServersFromThunderbird:(id)sender;
 
 // Called when the button-menu item is clicked to import all outgoing mail
 // servers from Thunderbird.  Adds to the domain list array all outgoing mail
 // servers from the Thunderbird default profile that haven't already been added,
-// and reloads the table view.  Sends a SCConfigurationChangedNotification.
+// and inserts their rows.  Sends a SCConfigurationChangedNotification.
 - (IBAction)importOutgoingMailServersFromThunderbird:(id)sender;
 
 // Called when the button-menu item is clicked to import all incoming mail
 // servers from Mail.app.  Adds to the domain list array all incoming mail
-// servers Mail.app that haven't already been added, and reloads the table view.
+// servers Mail.app that haven't already been added, and inserts their rows.
 // Sends a SCConfigurationChangedNotification.
 - (IBAction)importIncomingMailServersFromMail:(id)sender;
 
 // Called when the button-menu item is clicked to import all outgoing mail
 // servers from Mail.app.  Adds to the domain list array all outgoing mail
-// servers Mail.app that haven't already been added, and reloads the table view.
+// servers Mail.app that haven't already been added, and inserts their rows.
 // Sends a SCConfigurationChangedNotification.
 - (IBAction)importOutgoingMailServersFromMail:(id)sender;
 
@@ -26,6 +26,10 @@
 #import "SCUIUtilities.h"
 #import <UniformTypeIdentifiers/UniformTypeIdentifiers.h>
 
+// How long edits wait before the whole blocklist is written back to the defaults.
+// Each edit restarts the wait, so a burst of edits is saved (and announced) once.
+static const NSTimeInterval kBlocklistSaveDelay = 0.5;
+
 @implementation DomainListWindowController
 
 - (DomainListWindowController*)init {
@@ -40,10 +44,22 @@
 			domainList_ = [curArray mutableCopy];
 
         [defaults_ setValue: domainList_ forKey: @"Blocklist"];
+
+		entryDisplayCache_ = [NSCache new];
+
+		// don't lose edits still waiting to be saved
+		[[NSNotificationCenter defaultCenter] addObserver: self
+												 selector: @selector(saveBlocklistNow)
+													 name: NSApplicationWillTerminateNotification
+												   object: nil];
 	}
 
 	return self;
 }
+
+- (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver: self];
+}
 - (void)awakeFromNib  {
     NSInteger indexToSelect = [defaults_ boolForKey: @"BlockAsWhitelist"] ? 1 : 0;
     [allowlistRadioMatrix_ selectCellAtRow: indexToSelect column: 0];
@@ -63,14 +79,59 @@
     }
     
     [[self window] makeFirstResponder: self];
-    domainList_ = [[defaults_ arrayForKey: @"Blocklist"] mutableCopy];
+    [self saveBlocklistNow];
+
+    // this gets called for every configuration change, including our own saves,
+    // so don't throw away all the rows unless the list really changed underneath us
+    NSArray* savedList = [defaults_ arrayForKey: @"Blocklist"];
+    if (savedList != nil && [savedList isEqualToArray: domainList_]) return;
+
+    domainList_ = [savedList mutableCopy];
     [domainListTableView_ reloadData];
 }
 
+#pragma mark - Saving
+
+- (void)scheduleBlocklistSave:(BOOL)notify {
+    blocklistSaveShouldNotify_ = blocklistSaveShouldNotify_ || notify;
+    blocklistSaveScheduled_ = YES;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget: self selector: @selector(saveBlocklistNow) object: nil];
+    // common modes, so the save still happens while a menu is tracking or a modal panel is up
+    [self performSelector: @selector(saveBlocklistNow)
+               withObject: nil
+               afterDelay: kBlocklistSaveDelay
+                  inModes: @[NSRunLoopCommonModes]];
+}
+
+- (void)saveBlocklistNow {
+    if (![NSThread isMainThread]) {
+        dispatch_sync(dispatch_get_main_queue(), ^{
+            [self saveBlocklistNow];
+        });
+        return;
+    }
+    if (!blocklistSaveScheduled_) return;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget: self selector: @selector(saveBlocklistNow) object: nil];
+    blocklistSaveScheduled_ = NO;
+    BOOL notify = blocklistSaveShouldNotify_;
+    blocklistSaveShouldNotify_ = NO;
+
+    [defaults_ setValue: [domainList_ copy] forKey: @"Blocklist"];
+
+    if (notify) {
+        [[NSNotificationCenter defaultCenter] postNotificationName: @"SCConfigurationChangedNotification"
+                                                            object: self];
+    }
+}
+
 - (void)showWindow:(id)sender {
 	// If displayEntries was provided (e.g., from menu bar during active block),
 	// use those instead of NSUserDefaults
 	if (self.displayEntries) {
+		// any pending save is for the list we're about to replace
+		[self saveBlocklistNow];
 		domainList_ = [self.displayEntries mutableCopy];
 		[domainListTableView_ reloadData];
 	}
@@ -94,9 +155,9 @@
 - (IBAction)addDomain:(id)sender
 {
 	[domainList_ addObject:@""];
-    [defaults_ setValue: domainList_ forKey: @"Blocklist"];
-	[domainListTableView_ reloadData];
+    [self scheduleBlocklistSave: NO];
 	NSIndexSet* rowIndex = [NSIndexSet indexSetWithIndex: [domainList_ count] - 1];
+	[domainListTableView_ insertRowsAtIndexes: rowIndex withAnimation: NSTableViewAnimationEffectNone];
 	[domainListTableView_ selectRowIndexes: rowIndex
 					  byExtendingSelection: NO];
 	[domainListTableView_ editColumn: 0 row:((NSInteger)[domainList_ count] - 1)
@@ -106,27 +167,18 @@
 
 - (IBAction)removeDomain:(id)sender
 {
-	NSIndexSet* selected = [domainListTableView_ selectedRowIndexes];
 	[domainListTableView_ abortEditing];
 
-	// This isn't the most efficient way to do this, but the code is much cleaner
-	// than other methods and the domain blocklist will probably never be large
-	// enough for it to be an issue.
-	NSUInteger index = [selected firstIndex];
-	NSUInteger shift = 0;
-	while (index != NSNotFound) {
-		if ((index - shift) >= [domainList_ count])
-			break;
-		[domainList_ removeObjectAtIndex: index - shift];
-		shift++;
-		index = [selected indexGreaterThanIndex: index];
-	}
+	NSUInteger count = [domainList_ count];
+	NSIndexSet* selected = [[domainListTableView_ selectedRowIndexes] indexesPassingTest:^BOOL(NSUInteger idx, BOOL* stop) {
+		return idx < count;
+	}];
+	if ([selected count] == 0) return;
 
-    [defaults_ setValue: domainList_ forKey: @"Blocklist"];
-	[domainListTableView_ reloadData];
+	[domainList_ removeObjectsAtIndexes: selected];
+	[domainListTableView_ removeRowsAtIndexes: selected withAnimation: NSTableViewAnimationEffectNone];
 
-	[[NSNotificationCenter defaultCenter] postNotificationName: @"SCConfigurationChangedNotification"
-														object: self];
+	[self scheduleBlocklistSave: YES];
 }
 
 - (NSUInteger)numberOfRowsInTableView:(NSTableView *)aTableView {
@@ -155,11 +207,8 @@
 		[domainListTableView_ beginUpdates];
 		[domainListTableView_ removeRowsAtIndexes: indexSet withAnimation: NSTableViewAnimationSlideUp];
 		[domainList_ removeObjectAtIndex: (NSUInteger)editedRow];
-        [defaults_ setValue: domainList_ forKey: @"Blocklist"];
-		[domainListTableView_ reloadData];
 		[domainListTableView_ endUpdates];
-        [[NSNotificationCenter defaultCenter] postNotificationName: @"SCConfigurationChangedNotification"
-        object: self];
+        [self scheduleBlocklistSave: YES];
 		return;
 	}
 }
@@ -181,11 +230,18 @@
             [domainList_ insertObject: entry atIndex: (NSUInteger)rowIndex + i];
         }
     }
-    
-    [defaults_ setValue: domainList_ forKey: @"Blocklist"];
-    [domainListTableView_ reloadData];
-    [[NSNotificationCenter defaultCenter] postNotificationName: @"SCConfigurationChangedNotification"
-    object: self];
+
+    // only this row changed, plus any extra entries it was split into right after it
+    [domainListTableView_ beginUpdates];
+    [domainListTableView_ reloadDataForRowIndexes: [NSIndexSet indexSetWithIndex: (NSUInteger)rowIndex]
+                                    columnIndexes: [NSIndexSet indexSetWithIndexesInRange: NSMakeRange(0, (NSUInteger)domainListTableView_.numberOfColumns)]];
+    if (cleanedEntries.count > 1) {
+        [domainListTableView_ insertRowsAtIndexes: [NSIndexSet indexSetWithIndexesInRange: NSMakeRange((NSUInteger)rowIndex + 1, cleanedEntries.count - 1)]
+                                    withAnimation: NSTableViewAnimationEffectNone];
+    }
+    [domainListTableView_ endUpdates];
+
+    [self scheduleBlocklistSave: YES];
 }
 
 - (void)tableView:(NSTableView *)tableView
@@ -197,88 +253,107 @@
 	NSString* str = [[cell title] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
 	if([str isEqual: @""]) return;
 
+    NSDictionary* displayInfo = [self displayInfoForEntry: str];
+
     // Handle app entries - show them in purple with app name
     if ([str hasPrefix:@"app:"]) {
-        NSString* bundleID = [str substringFromIndex:4];
-        NSString* appName = [self appNameForBundleID:bundleID];
-        if (appName) {
-            [cell setStringValue:[NSString stringWithFormat:@"[App] %@ (%@)", appName, bundleID]];
+        NSString* appTitle = displayInfo[@"title"];
+        if (appTitle) {
+            [cell setStringValue: appTitle];
         }
         [cell setTextColor:[NSColor systemPurpleColor]];
         return;
     }
 
-	if([defaults_ boolForKey: @"HighlightInvalidHosts"]) {
-		// Validate the value as either an IP or a hostname.  In case of failure,
-		// we'll make its text color red.
+	if([defaults_ boolForKey: @"HighlightInvalidHosts"] && ![displayInfo[@"valid"] boolValue]) {
+		[cell setTextColor: NSColor.redColor];
+	}
+}
 
-		int maskLength = -1;
-		int portNum = -1;
+// Looks up (and caches) what a row shows for an entry: the display title for app
+// entries, and whether host entries are valid. Keyed by the entry itself, so an
+// edited row misses the cache and gets looked up again.
+- (NSDictionary*)displayInfoForEntry:(NSString*)str {
+    NSDictionary* displayInfo = [entryDisplayCache_ objectForKey: str];
+    if (displayInfo != nil) return displayInfo;
 
-		NSArray* splitString = [str componentsSeparatedByString: @"/"];
+    if ([str hasPrefix:@"app:"]) {
+        NSString* bundleID = [str substringFromIndex:4];
+        NSString* appName = [self appNameForBundleID:bundleID];
+        displayInfo = appName ? @{ @"title": [NSString stringWithFormat:@"[App] %@ (%@)", appName, bundleID] } : @{};
+    } else {
+        displayInfo = @{ @"valid": @([self isValidHostEntry: str]) };
+    }
 
-		str = [splitString[0] lowercaseString];
+    [entryDisplayCache_ setObject: displayInfo forKey: str];
+    return displayInfo;
+}
 
-		NSString* stringToSearchForPort = str;
+// Validate the value as either an IP or a hostname, with an optional CIDR mask
+// length or port.
+- (BOOL)isValidHostEntry:(NSString*)str {
+    static NSPredicate* ipRegexTester;
+    static NSPredicate* hostnameRegexTester;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+		NSString* ipValidationRegex = @"^([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])$";
+		ipRegexTester = [NSPredicate predicateWithFormat:@"SELF MATCHES %@", ipValidationRegex];
 
-		if([splitString count] >= 2) {
-			maskLength = [splitString[1] intValue];
-			// If the int value is 0, we couldn't find a valid integer representation
-			// in the split off string
-			if(maskLength == 0)
-				maskLength = -1;
+		NSString* hostnameValidationRegex = @"^([a-zA-Z0-9]([a-zA-Z0-9\\-]{0,61}[a-zA-Z0-9])?\\.)+[a-zA-Z]{2,6}$";
+		hostnameRegexTester = [NSPredicate predicateWithFormat:@"SELF MATCHES %@", hostnameValidationRegex];
+    });
 
-			stringToSearchForPort = splitString[1];
-		}
+	int maskLength = -1;
+	int portNum = -1;
 
-		splitString = [stringToSearchForPort componentsSeparatedByString: @":"];
+	NSArray* splitString = [str componentsSeparatedByString: @"/"];
 
-		if(stringToSearchForPort == str) {
-			str = splitString[0];
-		}
+	str = [splitString[0] lowercaseString];
 
-		if([splitString count] >= 2) {
-			portNum = [splitString[1] intValue];
-			// If the int value is 0, we couldn't find a valid integer representation
-			// in the split off string
-			if(portNum == 0)
-				portNum = -1;
-		}
+	NSString* stringToSearchForPort = str;
 
-		BOOL isIP;
+	if([splitString count] >= 2) {
+		maskLength = [splitString[1] intValue];
+		// If the int value is 0, we couldn't find a valid integer representation
+		// in the split off string
+		if(maskLength == 0)
+			maskLength = -1;
 
-		NSString* ipValidationRegex = @"^([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])\\.([0-9]|[1-9][0-9]|1[0-9]{2}|2[0-4][0-9]|25[0-5])$";
-		NSPredicate *ipRegexTester = [NSPredicate
-									  predicateWithFormat:@"SELF MATCHES %@",
-									  ipValidationRegex];
-		isIP = [ipRegexTester evaluateWithObject: str];
-
-		if(!isIP) {
-			NSString* hostnameValidationRegex = @"^([a-zA-Z0-9]([a-zA-Z0-9\\-]{0,61}[a-zA-Z0-9])?\\.)+[a-zA-Z]{2,6}$";
-			NSPredicate *hostnameRegexTester = [NSPredicate
-												predicateWithFormat:@"SELF MATCHES %@",
-												hostnameValidationRegex
-												];
-
-			if(![hostnameRegexTester evaluateWithObject: str] && ![str isEqualToString: @"*"] && ![str isEqualToString: @""]) {
-				[cell setTextColor: NSColor.redColor];
-				return;
-			}
-		}
+		stringToSearchForPort = splitString[1];
+	}
 
-		// We shouldn't have a mask length if it's not an IP, fail
-		if(!isIP && maskLength != -1) {
-			[cell setTextColor: NSColor.redColor];
-			return;
-		}
+	splitString = [stringToSearchForPort componentsSeparatedByString: @":"];
+
+	if(stringToSearchForPort == str) {
+		str = splitString[0];
+	}
+
+	if([splitString count] >= 2) {
+		portNum = [splitString[1] intValue];
+		// If the int value is 0, we couldn't find a valid integer representation
+		// in the split off string
+		if(portNum == 0)
+			portNum = -1;
+	}
 
-		if(([str isEqualToString: @"*"] || [str isEqualToString: @""]) && portNum == -1) {
-			[cell setTextColor: NSColor.redColor];
-			return;
+	BOOL isIP = [ipRegexTester evaluateWithObject: str];
+
+	if(!isIP) {
+		if(![hostnameRegexTester evaluateWithObject: str] && ![str isEqualToString: @"*"] && ![str isEqualToString: @""]) {
+			return NO;
 		}
+	}
+
+	// We shouldn't have a mask length if it's not an IP, fail
+	if(!isIP && maskLength != -1) {
+		return NO;
+	}
 
-		[cell setTextColor: NSColor.textColor];
+	if(([str isEqualToString: @"*"] || [str isEqualToString: @""]) && portNum == -1) {
+		return NO;
 	}
+
+	return YES;
 }
 
 - (IBAction)allowlistOptionChanged:(NSMatrix*)sender {
@@ -323,15 +398,20 @@
 }
 
 - (void)addHostArray:(NSArray*)arr {
+	NSUInteger firstNewRow = [domainList_ count];
+	NSMutableSet* existingEntries = [NSMutableSet setWithArray: domainList_];
 	for(NSUInteger i = 0; i < [arr count]; i++) {
 		// Check for dupes
-		if(![domainList_ containsObject: arr[i]])
+		if(![existingEntries containsObject: arr[i]]) {
 			[domainList_ addObject: arr[i]];
+			[existingEntries addObject: arr[i]];
+		}
 	}
-	[defaults_ setValue: domainList_ forKey: @"Blocklist"];
-	[domainListTableView_ reloadData];
-	[[NSNotificationCenter defaultCenter] postNotificationName: @"SCConfigurationChangedNotification"
-														object: self];
+	if ([domainList_ count] == firstNewRow) return;
+
+	[domainListTableView_ insertRowsAtIndexes: [NSIndexSet indexSetWithIndexesInRange: NSMakeRange(firstNewRow, [domainList_ count] - firstNewRow)]
+								withAnimation: NSTableViewAnimationEffectNone];
+	[self scheduleBlocklistSave: YES];
 }
 
 - (IBAction)importCommonDistractingWebsites:(id)sender {
@@ -4,8 +4,10 @@
 //
 
 #import "SCCalendarGridView.h"
+#import "SCCalendarLaneLayout.h"
 #import "Block Management/SCBlockBundle.h"
 #import "Block Management/SCTimeRange.h"
+#import "Block Management/SCIntervalSet.h"
 
 // Layout constants
 static const CGFloat kDayHeaderHeight = 40.0;
@@ -22,6 +24,8 @@ static const CGFloat kDimmedOpacity = 0.2;
 
 #pragma mark - SCBlockLayoutInfo (Private)
 
+@class SCBlockViewKey;
+
 /// Holds computed layout information for a single allow block
 @interface SCBlockLayoutInfo : NSObject
 @property (nonatomic, assign) NSInteger bundleIndex;
@@ -32,11 +36,48 @@ static const CGFloat kDimmedOpacity = 0.2;
 @property (nonatomic, assign) NSInteger laneSlot;        // 0-based horizontal slot
 @property (nonatomic, assign) NSInteger bundleDisplayOrder;
 @property (nonatomic, copy) NSString *bundleID;
+@property (nonatomic, strong) SCTimeRange *range;        // Window as laid out (drag override applied)
+@property (nonatomic, strong) SCBlockViewKey *key;       // (bundleID, windowIndex)
 @end
 
 @implementation SCBlockLayoutInfo
 @end
 
+#pragma mark - SCBlockViewKey (Private)
+
+/// Identifies a block view across reloads: its bundle and its window index for the day
+@interface SCBlockViewKey : NSObject <NSCopying>
+@property (nonatomic, copy, readonly) NSString *bundleID;
+@property (nonatomic, assign, readonly) NSInteger windowIndex;
++ (instancetype)keyWithBundleID:(NSString *)bundleID windowIndex:(NSInteger)windowIndex;
+@end
+
+@implementation SCBlockViewKey
+
++ (instancetype)keyWithBundleID:(NSString *)bundleID windowIndex:(NSInteger)windowIndex {
+    SCBlockViewKey *key = [[SCBlockViewKey alloc] init];
+    key->_bundleID = [bundleID copy];
+    key->_windowIndex = windowIndex;
+    return key;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;  // Immutable
+}
+
+- (BOOL)isEqual:(id)object {
+    if (object == self) return YES;
+    if (![object isKindOfClass:[SCBlockViewKey class]]) return NO;
+    SCBlockViewKey *other = object;
+    return self.windowIndex == other.windowIndex && [self.bundleID isEqualToString:other.bundleID];
+}
+
+- (NSUInteger)hash {
+    return [self.bundleID hash] ^ (NSUInteger)self.windowIndex;
+}
+
+@end
+
 #pragma mark - SCAllowBlockView (Private)
 
 @interface SCAllowBlockView : NSView
@@ -100,6 +141,11 @@ static const CGFloat kDimmedOpacity = 0.2;
     [self updateAppearance];
 }
 
+- (void)setIsCommitted:(BOOL)isCommitted {
+    _isCommitted = isCommitted;
+    [self updateAppearance];
+}
+
 - (void)drawRect:(NSRect)dirtyRect {
     [super drawRect:dirtyRect];
 
@@ -204,7 +250,11 @@ static const CGFloat kDimmedOpacity = 0.2;
 @end
 
 @implementation SCCalendarDayColumn {
-    NSMutableArray<SCAllowBlockView *> *_blockViews;
+    NSMutableArray<SCAllowBlockView *> *_blockViews;  // On-screen blocks in hit-test order, overlay last
+    NSMutableDictionary<SCBlockViewKey *, SCAllowBlockView *> *_blockViewsByKey;
+    SCAllowBlockView *_overlayBlockView;  // Drag/creation preview
+    NSMutableArray<SCAllowBlockView *> *_reusableBlockViews;
+    SCCalendarLaneLayout *_laneLayout;  // Lanes cached between reloads
     NSTrackingArea *_trackingArea;
 }
 
@@ -212,6 +262,9 @@ static const CGFloat kDimmedOpacity = 0.2;
     self = [super initWithFrame:frame];
     if (self) {
         _blockViews = [NSMutableArray array];
+        _blockViewsByKey = [NSMutableDictionary dictionary];
+        _reusableBlockViews = [NSMutableArray array];
+        _laneLayout = [[SCCalendarLaneLayout alloc] init];
         _selectedBlockIndex = -1;
         _timelineHeight = frame.size.height;
         self.wantsLayer = YES;
@@ -272,16 +325,6 @@ static const CGFloat kDimmedOpacity = 0.2;
 }
 
 - (void)reloadBlocks {
-    // Remove old block views
-    for (SCAllowBlockView *block in _blockViews) {
-        [block removeFromSuperview];
-    }
-    [_blockViews removeAllObjects];
-
-    if (self.bundles.count == 0) {
-        return;
-    }
-
     CGFloat totalWidth = self.bounds.size.width;
 
     // During drag operations, compute layout for EXISTING blocks only (not the dragging one)
@@ -291,131 +334,175 @@ static const CGFloat kDimmedOpacity = 0.2;
     BOOL isCreatingNewBlock = self.isCreatingBlock && self.draggingRange && self.draggingBundleID;
 
     // Compute layouts for all blocks (excluding the one being dragged if applicable)
-    NSArray<SCBlockLayoutInfo *> *layouts = [self computeBlockLayoutsIncludingDragRange:nil
-                                                                            forBundleID:nil
-                                                                            windowIndex:-1
-                                                                             isNewBlock:NO];
-
-    // Build lookup: "bundleID:windowIndex" -> layout
-    NSMutableDictionary<NSString *, SCBlockLayoutInfo *> *layoutLookup = [NSMutableDictionary dictionary];
-    for (SCBlockLayoutInfo *layout in layouts) {
-        NSString *key = [NSString stringWithFormat:@"%@:%ld", layout.bundleID, (long)layout.windowIndex];
-        layoutLookup[key] = layout;
+    NSArray<SCBlockLayoutInfo *> *layouts = @[];
+    if (self.bundles.count > 0) {
+        layouts = [self computeBlockLayoutsIncludingDragRange:nil
+                                                  forBundleID:nil
+                                                  windowIndex:-1
+                                                   isNewBlock:NO];
     }
 
-    // Render existing blocks using computed layouts
-    for (SCBlockBundle *bundle in self.bundles) {
-        SCWeeklySchedule *schedule = self.schedules[bundle.bundleID];
-        if (!schedule) continue;
-
-        NSArray<SCTimeRange *> *windows = [schedule allowedWindowsForDay:self.day];
+    // Diff against the views already on screen: views whose (bundleID, window index) is
+    // still laid out are updated in place, new ones come from the reuse pool, and
+    // whatever is left over goes back to the pool. A drag only touches the views that move.
+    NSMutableDictionary<SCBlockViewKey *, SCAllowBlockView *> *previousViews = _blockViewsByKey;
+    _blockViewsByKey = [NSMutableDictionary dictionaryWithCapacity:layouts.count];
+    [_blockViews removeAllObjects];
 
-        for (NSInteger i = 0; i < (NSInteger)windows.count; i++) {
-            SCTimeRange *range = windows[i];
+    for (SCBlockLayoutInfo *layout in layouts) {
+        // Skip rendering the block being dragged here - it will be rendered as overlay
+        BOOL isTheDraggedBlock = isDraggingExistingBlock &&
+            [layout.bundleID isEqualToString:self.draggingBundleID] &&
+            layout.windowIndex == self.selectedBlockIndex;
 
-            // Skip rendering the block being dragged here - it will be rendered as overlay
-            BOOL isTheDraggedBlock = isDraggingExistingBlock &&
-                [bundle.bundleID isEqualToString:self.draggingBundleID] &&
-                i == self.selectedBlockIndex;
+        if (isTheDraggedBlock) {
+            continue;  // Will render as overlay below
+        }
 
-            if (isTheDraggedBlock) {
-                continue;  // Will render as overlay below
-            }
+        SCBlockBundle *bundle = self.bundles[layout.bundleIndex];
 
-            // Get layout info for this block
-            NSString *key = [NSString stringWithFormat:@"%@:%ld", bundle.bundleID, (long)i];
-            SCBlockLayoutInfo *layout = layoutLookup[key];
+        // Calculate position and size using dynamic layout
+        CGFloat laneWidth = (totalWidth - kLanePadding * 2) / MAX(layout.maxOverlap, 1);
+        CGFloat laneX = kLanePadding + layout.laneSlot * laneWidth;
 
-            // Calculate position and size using dynamic layout
-            CGFloat laneWidth, laneX;
-            if (layout && layout.maxOverlap > 0) {
-                laneWidth = (totalWidth - kLanePadding * 2) / layout.maxOverlap;
-                laneX = kLanePadding + layout.laneSlot * laneWidth;
-            } else {
-                // Fallback: full width if no layout info
-                laneWidth = totalWidth - kLanePadding * 2;
-                laneX = kLanePadding;
-            }
+        CGFloat y = [self yFromMinutes:layout.startMinutes];
+        CGFloat height = [self yFromMinutes:layout.endMinutes] - y;
 
-            CGFloat y = [self yFromMinutes:[range startMinutes]];
-            CGFloat height = [self yFromMinutes:[range endMinutes]] - y;
+        SCBlockViewKey *key = layout.key;
+        SCAllowBlockView *blockView = previousViews[key];
+        if (blockView) {
+            [previousViews removeObjectForKey:key];
+        } else {
+            blockView = [self dequeueReusableBlockView];
+        }
 
-            NSRect blockFrame = NSMakeRect(laneX, y, laneWidth - kLanePadding, height);
-            SCAllowBlockView *blockView = [[SCAllowBlockView alloc] initWithFrame:blockFrame];
-            blockView.timeRange = range;
-            blockView.color = bundle.color;
-            blockView.bundleID = bundle.bundleID;
-            blockView.isCommitted = self.isCommitted;
+        // Dimmed if not focused bundle (and we have a focused bundle)
+        BOOL isDimmed = self.focusedBundleID && ![bundle.bundleID isEqualToString:self.focusedBundleID];
+        BOOL isSelected = [bundle.bundleID isEqualToString:self.selectedBundleID] && layout.windowIndex == self.selectedBlockIndex;
 
-            // Dimmed if not focused bundle (and we have a focused bundle)
-            if (self.focusedBundleID && ![bundle.bundleID isEqualToString:self.focusedBundleID]) {
-                blockView.isDimmed = YES;
-            }
+        [self configureBlockView:blockView
+                           frame:NSMakeRect(laneX, y, laneWidth - kLanePadding, height)
+                           range:layout.range
+                          bundle:bundle
+                        isDimmed:isDimmed
+                      isSelected:isSelected
+                     isCommitted:self.isCommitted];
 
-            // Selected state
-            if ([bundle.bundleID isEqualToString:self.selectedBundleID] && i == self.selectedBlockIndex) {
-                blockView.isSelected = YES;
-            }
+        _blockViewsByKey[key] = blockView;
+        [_blockViews addObject:blockView];
+    }
 
-            [self addSubview:blockView];
-            [_blockViews addObject:blockView];
-        }
+    for (SCAllowBlockView *staleView in previousViews.allValues) {
+        [self enqueueReusableBlockView:staleView];
     }
 
     // Calculate unified display mode for all blocks (use the most constrained)
     NSInteger unifiedDisplayMode = [self calculateUnifiedDisplayModeForBlocks:_blockViews];
     for (SCAllowBlockView *blockView in _blockViews) {
-        blockView.timeLabelDisplayMode = unifiedDisplayMode;
-    }
-
-    // Render dragged existing block as overlay (during move/resize)
-    if (isDraggingExistingBlock && self.draggingRange) {
-        SCBlockBundle *dragBundle = [self bundleForID:self.draggingBundleID];
-        if (dragBundle) {
-            // During drag, show at full width as overlay
-            CGFloat laneWidth = totalWidth - kLanePadding * 2;
-            CGFloat laneX = kLanePadding;
-
-            CGFloat y = [self yFromMinutes:[self.draggingRange startMinutes]];
-            CGFloat height = [self yFromMinutes:[self.draggingRange endMinutes]] - y;
-
-            NSRect blockFrame = NSMakeRect(laneX, y, laneWidth - kLanePadding, height);
-            SCAllowBlockView *blockView = [[SCAllowBlockView alloc] initWithFrame:blockFrame];
-            blockView.timeRange = self.draggingRange;
-            blockView.color = dragBundle.color;
-            blockView.bundleID = dragBundle.bundleID;
-            blockView.isCommitted = NO;
-            blockView.isSelected = YES;  // Highlight the dragging block
-
-            [self addSubview:blockView];
-            [_blockViews addObject:blockView];
-        }
+        [self setDisplayMode:unifiedDisplayMode forBlockView:blockView];
     }
 
-    // Render creation preview block (drag-to-create new block)
-    if (isCreatingNewBlock) {
-        SCBlockBundle *previewBundle = [self bundleForID:self.draggingBundleID];
-        if (previewBundle) {
-            // During creation, show at full width as overlay
-            CGFloat laneWidth = totalWidth - kLanePadding * 2;
-            CGFloat laneX = kLanePadding;
-
-            CGFloat y = [self yFromMinutes:[self.draggingRange startMinutes]];
-            CGFloat height = [self yFromMinutes:[self.draggingRange endMinutes]] - y;
-
-            NSRect blockFrame = NSMakeRect(laneX, y, laneWidth - kLanePadding, height);
-            SCAllowBlockView *blockView = [[SCAllowBlockView alloc] initWithFrame:blockFrame];
-            blockView.timeRange = self.draggingRange;
-            blockView.color = previewBundle.color;
-            blockView.bundleID = previewBundle.bundleID;
-            blockView.isCommitted = NO;
-
-            [self addSubview:blockView];
-            [_blockViews addObject:blockView];
+    // Dragged existing block (move/resize) or creation preview, at full width as overlay
+    SCBlockBundle *overlayBundle = nil;
+    if ((isDraggingExistingBlock && self.draggingRange) || isCreatingNewBlock) {
+        overlayBundle = [self bundleForID:self.draggingBundleID];
+    }
+
+    if (overlayBundle) {
+        if (!_overlayBlockView) {
+            _overlayBlockView = [self dequeueReusableBlockView];
         }
+
+        CGFloat laneWidth = totalWidth - kLanePadding * 2;
+        CGFloat y = [self yFromMinutes:[self.draggingRange startMinutes]];
+        CGFloat height = [self yFromMinutes:[self.draggingRange endMinutes]] - y;
+
+        [self configureBlockView:_overlayBlockView
+                           frame:NSMakeRect(kLanePadding, y, laneWidth - kLanePadding, height)
+                           range:self.draggingRange
+                          bundle:overlayBundle
+                        isDimmed:NO
+                      isSelected:isDraggingExistingBlock  // Highlight the dragging block
+                     isCommitted:NO];
+        [self setDisplayMode:0 forBlockView:_overlayBlockView];
+
+        // Keep it above blocks added since it was shown
+        if (self.subviews.lastObject != _overlayBlockView) {
+            [self addSubview:_overlayBlockView positioned:NSWindowAbove relativeTo:nil];
+        }
+        [_blockViews addObject:_overlayBlockView];
+    } else if (_overlayBlockView) {
+        [self enqueueReusableBlockView:_overlayBlockView];
+        _overlayBlockView = nil;
+    }
+}
+
+#pragma mark - Block View Reuse
+
+- (SCAllowBlockView *)dequeueReusableBlockView {
+    SCAllowBlockView *blockView = _reusableBlockViews.lastObject;
+    if (blockView) {
+        [_reusableBlockViews removeLastObject];
+    } else {
+        blockView = [[SCAllowBlockView alloc] initWithFrame:NSZeroRect];
+    }
+    [self addSubview:blockView];
+    return blockView;
+}
+
+- (void)enqueueReusableBlockView:(SCAllowBlockView *)blockView {
+    [blockView removeFromSuperview];
+    [_reusableBlockViews addObject:blockView];
+}
+
+/// Only touches what changed, so unchanged blocks neither redraw nor rebuild their layer state
+- (void)configureBlockView:(SCAllowBlockView *)blockView
+                     frame:(NSRect)frame
+                     range:(SCTimeRange *)range
+                    bundle:(SCBlockBundle *)bundle
+                  isDimmed:(BOOL)isDimmed
+                isSelected:(BOOL)isSelected
+               isCommitted:(BOOL)isCommitted {
+    BOOL needsRedraw = NO;
+
+    if (!NSEqualRects(blockView.frame, frame)) {
+        BOOL sizeChanged = !NSEqualSizes(blockView.frame.size, frame.size);
+        blockView.frame = frame;
+        needsRedraw = needsRedraw || sizeChanged;
+    }
+
+    // Always take the schedule's own range object (selection looks it up by equality, but
+    // drags copy it); only a different time needs the labels redrawn
+    needsRedraw = needsRedraw || ![blockView.timeRange isEqual:range];
+    blockView.timeRange = range;
+
+    if (![blockView.bundleID isEqualToString:bundle.bundleID]) {
+        blockView.bundleID = bundle.bundleID;
+    }
+    if (![blockView.color isEqual:bundle.color]) {
+        blockView.color = bundle.color;
+    }
+    if (blockView.isDimmed != isDimmed) {
+        blockView.isDimmed = isDimmed;
+        needsRedraw = YES;  // Label color
+    }
+    if (blockView.isSelected != isSelected) {
+        blockView.isSelected = isSelected;
+    }
+    if (blockView.isCommitted != isCommitted) {
+        blockView.isCommitted = isCommitted;
     }
 
-    [self setNeedsDisplay:YES];
+    if (needsRedraw) {
+        [blockView setNeedsDisplay:YES];
+    }
+}
+
+- (void)setDisplayMode:(NSInteger)displayMode forBlockView:(SCAllowBlockView *)blockView {
+    if (blockView.timeLabelDisplayMode != displayMode) {
+        blockView.timeLabelDisplayMode = displayMode;
+        [blockView setNeedsDisplay:YES];
+    }
 }
 
 - (void)drawRect:(NSRect)dirtyRect {
@@ -536,7 +623,7 @@ static const CGFloat kDimmedOpacity = 0.2;
             [self reloadBlocks];
 
             // Make grid view first responder so it receives keyboard events (for Delete key)
-            // DayColumn is transient; grid view is stable and can route keys appropriately
+            // DayColumns can be removed on reloadData; grid view is stable and can route keys appropriately
             NSView *gridView = self.superview;
             while (gridView && ![gridView isKindOfClass:[SCCalendarGridView class]]) {
                 gridView = gridView.superview;
@@ -647,7 +734,7 @@ static const CGFloat kDimmedOpacity = 0.2;
                                                          end:[self timeStringFromMinutes:self.dragStartMinutes + 60]];
 
             // Make the grid view (not DayColumn) first responder so ESC key works after block creation
-            // DayColumn is transient (destroyed on reloadData), but grid view is stable
+            // A DayColumn goes away when its day drops out of the week, but grid view is stable
             NSView *gridView = self.superview;
             while (gridView && ![gridView isKindOfClass:[SCCalendarGridView class]]) {
                 gridView = gridView.superview;
@@ -844,29 +931,8 @@ static const CGFloat kDimmedOpacity = 0.2;
 - (NSArray<SCTimeRange *> *)mergeOverlappingRanges:(NSArray<SCTimeRange *> *)ranges {
     if (ranges.count <= 1) return ranges;
 
-    // Sort by start time
-    NSArray *sorted = [ranges sortedArrayUsingComparator:^NSComparisonResult(SCTimeRange *a, SCTimeRange *b) {
-        return [@([a startMinutes]) compare:@([b startMinutes])];
-    }];
-
-    NSMutableArray *merged = [NSMutableArray array];
-    SCTimeRange *current = [sorted.firstObject copy];
-
-    for (NSInteger i = 1; i < sorted.count; i++) {
-        SCTimeRange *next = sorted[i];
-        if ([next startMinutes] <= [current endMinutes]) {
-            // Overlapping - merge
-            NSInteger newEnd = MAX([current endMinutes], [next endMinutes]);
-            current = [SCTimeRange rangeWithStart:current.startTime
-                                              end:[self timeStringFromMinutes:newEnd]];
-        } else {
-            [merged addObject:current];
-            current = [next copy];
-        }
-    }
-    [merged addObject:current];
-
-    return merged;
+    // Overlapping and touching ranges come back as one, sorted by start time
+    return [[SCIntervalSet setWithTimeRanges:ranges] timeRanges];
 }
 
 - (nullable SCBlockBundle *)bundleForID:(NSString *)bundleID {
@@ -924,13 +990,17 @@ static const CGFloat kDimmedOpacity = 0.2;
 
 #pragma mark - Dynamic Layout Computation
 
-/// Computes layout info for all blocks, optionally including a drag preview range
+/// Computes layout info for all blocks, optionally including a drag preview range.
+/// Lanes come from the column's SCCalendarLaneLayout, which only relays out the overlap
+/// clusters whose blocks changed since the last call; on most drag frames that's none.
 - (NSArray<SCBlockLayoutInfo *> *)computeBlockLayoutsIncludingDragRange:(SCTimeRange *)dragRange
                                                             forBundleID:(NSString *)dragBundleID
                                                             windowIndex:(NSInteger)dragWindowIndex
                                                            isNewBlock:(BOOL)isNewBlock {
     NSMutableArray<SCBlockLayoutInfo *> *blocks = [NSMutableArray array];
 
+    [_laneLayout beginUpdates];
+
     // Step 1: Collect all blocks from all bundles
     for (NSInteger bundleIndex = 0; bundleIndex < self.bundles.count; bundleIndex++) {
         SCBlockBundle *bundle = self.bundles[bundleIndex];
@@ -950,15 +1020,20 @@ static const CGFloat kDimmedOpacity = 0.2;
             }
 
             SCBlockLayoutInfo *info = [[SCBlockLayoutInfo alloc] init];
+            info.range = range;
             info.bundleIndex = bundleIndex;
             info.windowIndex = windowIndex;
             info.startMinutes = [range startMinutes];
             info.endMinutes = [range endMinutes];
-            info.maxOverlap = 1;
-            info.laneSlot = 0;
             info.bundleDisplayOrder = bundle.displayOrder;
             info.bundleID = bundle.bundleID;
+            info.key = [SCBlockViewKey keyWithBundleID:bundle.bundleID windowIndex:windowIndex];
 
+            [_laneLayout setBlockForKey:info.key
+                           startMinutes:info.startMinutes
+                             endMinutes:info.endMinutes
+                           displayOrder:info.bundleDisplayOrder
+                                  order:bundleIndex];
             [blocks addObject:info];
         }
     }
@@ -968,113 +1043,35 @@ static const CGFloat kDimmedOpacity = 0.2;
         SCBlockBundle *previewBundle = [self bundleForID:dragBundleID];
         if (previewBundle) {
             SCBlockLayoutInfo *previewInfo = [[SCBlockLayoutInfo alloc] init];
+            previewInfo.range = dragRange;
             previewInfo.bundleIndex = -1;  // Special marker for preview
             previewInfo.windowIndex = -1;
             previewInfo.startMinutes = [dragRange startMinutes];
             previewInfo.endMinutes = [dragRange endMinutes];
-            previewInfo.maxOverlap = 1;
-            previewInfo.laneSlot = 0;
             previewInfo.bundleDisplayOrder = previewBundle.displayOrder;
             previewInfo.bundleID = dragBundleID;
+            previewInfo.key = [SCBlockViewKey keyWithBundleID:dragBundleID windowIndex:-1];
 
+            [_laneLayout setBlockForKey:previewInfo.key
+                           startMinutes:previewInfo.startMinutes
+                             endMinutes:previewInfo.endMinutes
+                           displayOrder:previewInfo.bundleDisplayOrder
+                                  order:self.bundles.count];
             [blocks addObject:previewInfo];
         }
     }
 
-    if (blocks.count == 0) return blocks;
-
-    // Step 2: Sweep-line algorithm to compute maxOverlap for each block
-    [self computeMaxOverlapForBlocks:blocks];
-
-    // Step 3: Greedy packing to assign lane slots
-    [self assignLaneSlotsUsingGreedyPacking:blocks];
-
-    return blocks;
-}
+    // Step 2: Blocks that weren't set above are dropped, changed clusters relaid out
+    [_laneLayout endUpdates];
 
-/// Sweep-line algorithm to compute maxOverlap for each block
-- (void)computeMaxOverlapForBlocks:(NSMutableArray<SCBlockLayoutInfo *> *)blocks {
-    // Build sweep events
-    NSMutableArray *events = [NSMutableArray array];
-    for (SCBlockLayoutInfo *block in blocks) {
-        [events addObject:@{@"time": @(block.startMinutes), @"type": @(0), @"block": block}];  // 0 = START
-        [events addObject:@{@"time": @(block.endMinutes), @"type": @(1), @"block": block}];    // 1 = END
-    }
-
-    // Sort: by time, then END (1) before START (0) at same time
-    // This ensures adjacent blocks (one ends when another starts) don't count as overlapping
-    [events sortUsingComparator:^NSComparisonResult(NSDictionary *a, NSDictionary *b) {
-        NSComparisonResult timeCompare = [a[@"time"] compare:b[@"time"]];
-        if (timeCompare != NSOrderedSame) return timeCompare;
-        // END (1) before START (0) at same time
-        return [b[@"type"] compare:a[@"type"]];
-    }];
-
-    // Sweep through events
-    NSMutableSet<SCBlockLayoutInfo *> *activeBlocks = [NSMutableSet set];
-
-    for (NSDictionary *event in events) {
-        SCBlockLayoutInfo *block = event[@"block"];
-        NSInteger type = [event[@"type"] integerValue];
-
-        if (type == 0) {  // START
-            [activeBlocks addObject:block];
-            NSInteger overlapCount = activeBlocks.count;
-            // Update maxOverlap for all currently active blocks
-            for (SCBlockLayoutInfo *active in activeBlocks) {
-                if (active.maxOverlap < overlapCount) {
-                    active.maxOverlap = overlapCount;
-                }
-            }
-        } else {  // END
-            [activeBlocks removeObject:block];
-        }
+    for (SCBlockLayoutInfo *info in blocks) {
+        NSInteger laneSlot = 0, maxOverlap = 1;
+        [_laneLayout getLaneSlot:&laneSlot maxOverlap:&maxOverlap forKey:info.key];
+        info.laneSlot = laneSlot;
+        info.maxOverlap = maxOverlap;
     }
-}
-
-/// Greedy packing algorithm to assign lane slots respecting displayOrder
-- (void)assignLaneSlotsUsingGreedyPacking:(NSMutableArray<SCBlockLayoutInfo *> *)blocks {
-    // Sort blocks by displayOrder (primary), then startMinutes (secondary)
-    NSArray *sortedBlocks = [blocks sortedArrayUsingComparator:^NSComparisonResult(SCBlockLayoutInfo *a, SCBlockLayoutInfo *b) {
-        if (a.bundleDisplayOrder != b.bundleDisplayOrder) {
-            return a.bundleDisplayOrder < b.bundleDisplayOrder ? NSOrderedAscending : NSOrderedDescending;
-        }
-        if (a.startMinutes != b.startMinutes) {
-            return a.startMinutes < b.startMinutes ? NSOrderedAscending : NSOrderedDescending;
-        }
-        return NSOrderedSame;
-    }];
-
-    // Each lane is a list of blocks that don't overlap
-    NSMutableArray<NSMutableArray<SCBlockLayoutInfo *> *> *lanes = [NSMutableArray array];
-
-    for (SCBlockLayoutInfo *block in sortedBlocks) {
-        NSInteger assignedLane = -1;
-
-        // Try to fit into existing lanes
-        for (NSInteger i = 0; i < lanes.count; i++) {
-            BOOL overlapsAny = NO;
-            for (SCBlockLayoutInfo *placed in lanes[i]) {
-                // Check time overlap: a.start < b.end && b.start < a.end
-                if (block.startMinutes < placed.endMinutes && placed.startMinutes < block.endMinutes) {
-                    overlapsAny = YES;
-                    break;
-                }
-            }
-            if (!overlapsAny) {
-                [lanes[i] addObject:block];
-                block.laneSlot = i;
-                assignedLane = i;
-                break;
-            }
-        }
 
-        // Create new lane if needed
-        if (assignedLane == -1) {
-            [lanes addObject:[NSMutableArray arrayWithObject:block]];
-            block.laneSlot = lanes.count - 1;
-        }
-    }
+    return blocks;
 }
 
 @end
@@ -1191,13 +1188,6 @@ static const CGFloat kDimmedOpacity = 0.2;
 }
 
 - (void)reloadData {
-    // Rescue first responder if it's a column we're about to destroy
-    // (DayColumns are transient - destroyed and recreated on each reload)
-    NSResponder *fr = self.window.firstResponder;
-    if ([fr isKindOfClass:[NSView class]] && [(NSView *)fr isDescendantOf:self]) {
-        [self.window makeFirstResponder:self];
-    }
-
     // Get days to display
     NSArray<NSNumber *> *days;
     if (self.showOnlyRemainingDays && self.weekOffset == 0) {
@@ -1206,100 +1196,94 @@ static const CGFloat kDimmedOpacity = 0.2;
         days = [SCWeeklySchedule allDaysStartingMonday:YES];
     }
 
-    // Remove old day labels and columns
-    for (NSTextField *label in self.dayLabels) {
-        [label removeFromSuperview];
-    }
-    [self.dayLabels removeAllObjects];
-
-    for (SCCalendarDayColumn *col in self.dayColumns) {
-        [col removeFromSuperview];
+    // Day columns and labels are kept across reloads and matched up by day, so a reload
+    // only reconfigures them; just the days that drop out (end of the week) are removed
+    NSMutableDictionary<NSNumber *, SCCalendarDayColumn *> *previousColumns = [NSMutableDictionary dictionary];
+    NSMutableDictionary<NSNumber *, NSTextField *> *previousLabels = [NSMutableDictionary dictionary];
+    for (NSInteger i = 0; i < (NSInteger)self.dayColumns.count; i++) {
+        NSNumber *day = @(self.dayColumns[i].day);
+        previousColumns[day] = self.dayColumns[i];
+        previousLabels[day] = self.dayLabels[i];
     }
     [self.dayColumns removeAllObjects];
-
-    if (days.count == 0) return;
+    [self.dayLabels removeAllObjects];
 
     // Calculate column width and timeline height from scrollView (source of truth for available space)
     CGFloat availableWidth = self.headerContainer.bounds.size.width;
-    CGFloat columnWidth = availableWidth / days.count;
+    CGFloat columnWidth = days.count > 0 ? availableWidth / days.count : 0;
     CGFloat timelineHeight = self.scrollView.contentSize.height;
 
     // Update hour label container and labels for new height
-    self.hourLabelContainer.frame = NSMakeRect(0, 0, kHourLabelWidth, timelineHeight);
-    [self setupHourLabels];
+    if (self.hourLabelContainer.frame.size.height != timelineHeight) {
+        self.hourLabelContainer.frame = NSMakeRect(0, 0, kHourLabelWidth, timelineHeight);
+        [self setupHourLabels];
+    }
 
     // Determine today's day
     SCDayOfWeek today = [SCWeeklySchedule today];
 
-    // Create day labels and columns
-    for (NSInteger i = 0; i < days.count; i++) {
+    // Create or update day labels and columns
+    for (NSInteger i = 0; i < (NSInteger)days.count; i++) {
         SCDayOfWeek day = [days[i] integerValue];
         CGFloat x = i * columnWidth;
         BOOL isToday = (day == today && self.weekOffset == 0);
 
         // Day label in header
-        NSTextField *label = [[NSTextField alloc] initWithFrame:NSMakeRect(x, 0, columnWidth, kDayHeaderHeight)];
-        label.stringValue = [SCWeeklySchedule shortNameForDay:day];
+        NSTextField *label = previousLabels[days[i]];
+        if (label) {
+            [previousLabels removeObjectForKey:days[i]];
+        } else {
+            label = [self makeDayLabelForDay:day];
+            [self.headerContainer addSubview:label];
+        }
+        label.frame = NSMakeRect(x, 0, columnWidth, kDayHeaderHeight);
         label.font = [NSFont systemFontOfSize:13 weight:isToday ? NSFontWeightBold : NSFontWeightMedium];
         label.textColor = isToday ? [NSColor systemBlueColor] : [NSColor labelColor];
-        label.bezeled = NO;
-        label.editable = NO;
-        label.drawsBackground = NO;
-        label.alignment = NSTextAlignmentCenter;
-        [self.headerContainer addSubview:label];
         [self.dayLabels addObject:label];
 
         // Day column
-        SCCalendarDayColumn *column = [[SCCalendarDayColumn alloc] initWithFrame:NSMakeRect(x, 0, columnWidth, timelineHeight)];
-        column.day = day;
+        SCCalendarDayColumn *column = previousColumns[days[i]];
+        if (column) {
+            [previousColumns removeObjectForKey:days[i]];
+            column.frame = NSMakeRect(x, 0, columnWidth, timelineHeight);
+
+            // A reload starts from a clean slate, as a fresh column would
+            column.selectedBlockIndex = -1;
+            column.selectedBundleID = nil;
+        } else {
+            column = [self makeDayColumnForDay:day frame:NSMakeRect(x, 0, columnWidth, timelineHeight)];
+            [self.columnsContainer addSubview:column];
+        }
         column.bundles = self.bundles;
         column.schedules = self.schedules;
         column.focusedBundleID = self.focusedBundleID;
         column.isCommitted = self.isCommitted;
-        column.isToday = isToday;
-        column.timelineHeight = timelineHeight;
-
-        // Set callbacks
-        __weak typeof(self) weakSelf = self;
-        SCDayOfWeek capturedDay = day;  // Capture day for callbacks
-        column.onScheduleUpdated = ^(NSString *bundleID, SCWeeklySchedule *schedule) {
-            if (!weakSelf) return;
-            weakSelf.lastClickedDay = capturedDay;
-            [weakSelf handleScheduleUpdate:schedule forBundleID:bundleID];
-        };
-        column.onEmptyAreaClicked = ^{
-            weakSelf.lastClickedDay = capturedDay;
-            if ([weakSelf.delegate respondsToSelector:@selector(calendarGridDidClickEmptyArea:)]) {
-                [weakSelf.delegate calendarGridDidClickEmptyArea:weakSelf];
-            }
-        };
-        column.onBlockDoubleClicked = ^(SCBlockBundle *bundle) {
-            weakSelf.lastClickedDay = capturedDay;
-            if ([weakSelf.delegate respondsToSelector:@selector(calendarGrid:didRequestEditBundle:forDay:)]) {
-                [weakSelf.delegate calendarGrid:weakSelf didRequestEditBundle:bundle forDay:day];
-            }
-        };
-        column.onNoFocusInteraction = ^{
-            weakSelf.lastClickedDay = capturedDay;
-            if ([weakSelf.delegate respondsToSelector:@selector(calendarGridDidAttemptInteractionWithoutFocus:)]) {
-                [weakSelf.delegate calendarGridDidAttemptInteractionWithoutFocus:weakSelf];
-            }
-        };
-        column.onColumnClicked = ^{
-            weakSelf.lastClickedDay = capturedDay;
-        };
-        column.onBlockSelected = ^{
-            // Clear selection in ALL columns (single selection only)
-            for (SCCalendarDayColumn *col in weakSelf.dayColumns) {
-                [col clearSelection];
-            }
-        };
+        // Layer-backed columns don't redraw with the grid, and today's NOW line moves
+        // with the clock, so today's column is redrawn on every reload
+        if (isToday || column.isToday != isToday || column.timelineHeight != timelineHeight) {
+            column.isToday = isToday;
+            column.timelineHeight = timelineHeight;
+            [column setNeedsDisplay:YES];  // Hour lines and NOW line
+        }
 
         [column reloadBlocks];
-        [self.columnsContainer addSubview:column];
         [self.dayColumns addObject:column];
     }
 
+    // Rescue first responder if it's in a column we're about to remove
+    NSResponder *fr = self.window.firstResponder;
+    for (SCCalendarDayColumn *column in previousColumns.allValues) {
+        if ([fr isKindOfClass:[NSView class]] && [(NSView *)fr isDescendantOf:column]) {
+            [self.window makeFirstResponder:self];
+        }
+        [column removeFromSuperview];
+    }
+    for (NSTextField *label in previousLabels.allValues) {
+        [label removeFromSuperview];
+    }
+
+    if (days.count == 0) return;
+
     // Update columns container size
     self.columnsContainer.frame = NSMakeRect(0, 0, availableWidth, timelineHeight);
 
@@ -1307,6 +1291,59 @@ static const CGFloat kDimmedOpacity = 0.2;
     [self updateEmptyStateVisibility];
 }
 
+- (NSTextField *)makeDayLabelForDay:(SCDayOfWeek)day {
+    NSTextField *label = [[NSTextField alloc] initWithFrame:NSZeroRect];
+    label.stringValue = [SCWeeklySchedule shortNameForDay:day];
+    label.bezeled = NO;
+    label.editable = NO;
+    label.drawsBackground = NO;
+    label.alignment = NSTextAlignmentCenter;
+    return label;
+}
+
+- (SCCalendarDayColumn *)makeDayColumnForDay:(SCDayOfWeek)day frame:(NSRect)frame {
+    SCCalendarDayColumn *column = [[SCCalendarDayColumn alloc] initWithFrame:frame];
+    column.day = day;
+
+    // Set callbacks
+    __weak typeof(self) weakSelf = self;
+    SCDayOfWeek capturedDay = day;  // Capture day for callbacks
+    column.onScheduleUpdated = ^(NSString *bundleID, SCWeeklySchedule *schedule) {
+        if (!weakSelf) return;
+        weakSelf.lastClickedDay = capturedDay;
+        [weakSelf handleScheduleUpdate:schedule forBundleID:bundleID];
+    };
+    column.onEmptyAreaClicked = ^{
+        weakSelf.lastClickedDay = capturedDay;
+        if ([weakSelf.delegate respondsToSelector:@selector(calendarGridDidClickEmptyArea:)]) {
+            [weakSelf.delegate calendarGridDidClickEmptyArea:weakSelf];
+        }
+    };
+    column.onBlockDoubleClicked = ^(SCBlockBundle *bundle) {
+        weakSelf.lastClickedDay = capturedDay;
+        if ([weakSelf.delegate respondsToSelector:@selector(calendarGrid:didRequestEditBundle:forDay:)]) {
+            [weakSelf.delegate calendarGrid:weakSelf didRequestEditBundle:bundle forDay:capturedDay];
+        }
+    };
+    column.onNoFocusInteraction = ^{
+        weakSelf.lastClickedDay = capturedDay;
+        if ([weakSelf.delegate respondsToSelector:@selector(calendarGridDidAttemptInteractionWithoutFocus:)]) {
+            [weakSelf.delegate calendarGridDidAttemptInteractionWithoutFocus:weakSelf];
+        }
+    };
+    column.onColumnClicked = ^{
+        weakSelf.lastClickedDay = capturedDay;
+    };
+    column.onBlockSelected = ^{
+        // Clear selection in ALL columns (single selection only)
+        for (SCCalendarDayColumn *col in weakSelf.dayColumns) {
+            [col clearSelection];
+        }
+    };
+
+    return column;
+}
+
 - (void)updateEmptyStateVisibility {
     // Check if any schedules have any windows
     BOOL hasAnyBlocks = NO;
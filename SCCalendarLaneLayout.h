@@ -0,0 +1,46 @@
+//
+//  SCCalendarLaneLayout.h
+//  SelfControl
+//
+//  Side-by-side lane layout for the blocks in a calendar day column. Blocks live in an
+//  interval tree, and a change only relays out the overlap clusters it touches; every
+//  other block keeps its cached lane between updates.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SCCalendarLaneLayout : NSObject
+
+/// Adds the block for key, or moves it. Blocks are [startMinutes, endMinutes); blocks that
+/// only touch don't overlap. Lanes are packed first-fit in displayOrder, then start time,
+/// then order. Setting a block to what it already is costs a lookup and nothing else.
+/// Outside a begin/endUpdates batch the layout is brought up to date straight away.
+- (void)setBlockForKey:(id<NSCopying>)key
+          startMinutes:(NSInteger)startMinutes
+            endMinutes:(NSInteger)endMinutes
+          displayOrder:(NSInteger)displayOrder
+                 order:(NSInteger)order;
+
+- (void)removeBlockForKey:(id<NSCopying>)key;
+
+- (void)removeAllBlocks;
+
+/// Batches changes into one relayout. Between the two calls, set every block that should
+/// stay: endUpdates removes the blocks that weren't set, then relays out what changed.
+- (void)beginUpdates;
+- (void)endUpdates;
+
+/// NO if there's no block for key. maxOverlap is the most blocks (including this one) that
+/// overlap at any point while it runs; the lane width is the column's width / maxOverlap.
+- (BOOL)getLaneSlot:(nullable NSInteger *)laneSlot maxOverlap:(nullable NSInteger *)maxOverlap forKey:(id<NSCopying>)key;
+
+@property (nonatomic, readonly) NSUInteger blockCount;
+
+/// How many blocks the last relayout recomputed (0 if nothing had changed)
+@property (nonatomic, readonly) NSUInteger lastRelayoutBlockCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,407 @@
+//
+//  SCCalendarLaneLayout.m
+//  SelfControl
+//
+
+#import "SCCalendarLaneLayout.h"
+#import "Block Management/SCIntervalSet.h"
+
+#pragma mark - SCLaneLayoutNode (Private)
+
+/// One block, and its node in the interval tree (a treap ordered by start, augmented with
+/// the largest end in each subtree so overlap queries can skip whole subtrees)
+@interface SCLaneLayoutNode : NSObject
+@property (nonatomic, assign) NSInteger startMinutes;
+@property (nonatomic, assign) NSInteger endMinutes;
+@property (nonatomic, assign) NSInteger displayOrder;
+@property (nonatomic, assign) NSInteger order;
+@property (nonatomic, assign) NSInteger laneSlot;
+@property (nonatomic, assign) NSInteger maxOverlap;
+@property (nonatomic, assign) NSUInteger generation;     // Last batch that set this block
+
+// Tree
+@property (nonatomic, assign) NSUInteger uid;            // Breaks ties between equal starts
+@property (nonatomic, assign) uint32_t priority;
+@property (nonatomic, assign) NSInteger subtreeMaxEnd;
+@property (nonatomic, strong, nullable) SCLaneLayoutNode *left;
+@property (nonatomic, strong, nullable) SCLaneLayoutNode *right;
+@end
+
+@implementation SCLaneLayoutNode
+@end
+
+static NSComparisonResult SCCompareLaneLayoutNodes(SCLaneLayoutNode *a, SCLaneLayoutNode *b) {
+    if (a.startMinutes != b.startMinutes) return a.startMinutes < b.startMinutes ? NSOrderedAscending : NSOrderedDescending;
+    if (a.uid != b.uid) return a.uid < b.uid ? NSOrderedAscending : NSOrderedDescending;
+    return NSOrderedSame;
+}
+
+static void SCUpdateSubtreeMaxEnd(SCLaneLayoutNode *node) {
+    NSInteger maxEnd = node.endMinutes;
+    if (node.left) maxEnd = MAX(maxEnd, node.left.subtreeMaxEnd);
+    if (node.right) maxEnd = MAX(maxEnd, node.right.subtreeMaxEnd);
+    node.subtreeMaxEnd = maxEnd;
+}
+
+static SCLaneLayoutNode *SCRotateRight(SCLaneLayoutNode *node) {
+    SCLaneLayoutNode *pivot = node.left;
+    node.left = pivot.right;
+    pivot.right = node;
+    SCUpdateSubtreeMaxEnd(node);
+    SCUpdateSubtreeMaxEnd(pivot);
+    return pivot;
+}
+
+static SCLaneLayoutNode *SCRotateLeft(SCLaneLayoutNode *node) {
+    SCLaneLayoutNode *pivot = node.right;
+    node.right = pivot.left;
+    pivot.left = node;
+    SCUpdateSubtreeMaxEnd(node);
+    SCUpdateSubtreeMaxEnd(pivot);
+    return pivot;
+}
+
+static SCLaneLayoutNode *SCTreapInsert(SCLaneLayoutNode *root, SCLaneLayoutNode *node) {
+    if (!root) {
+        node.left = nil;
+        node.right = nil;
+        SCUpdateSubtreeMaxEnd(node);
+        return node;
+    }
+
+    if (SCCompareLaneLayoutNodes(node, root) == NSOrderedAscending) {
+        root.left = SCTreapInsert(root.left, node);
+        if (root.left.priority > root.priority) root = SCRotateRight(root);
+    } else {
+        root.right = SCTreapInsert(root.right, node);
+        if (root.right.priority > root.priority) root = SCRotateLeft(root);
+    }
+    SCUpdateSubtreeMaxEnd(root);
+    return root;
+}
+
+// Every node in left sorts before every node in right
+static SCLaneLayoutNode *SCTreapMerge(SCLaneLayoutNode *left, SCLaneLayoutNode *right) {
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left.priority > right.priority) {
+        left.right = SCTreapMerge(left.right, right);
+        SCUpdateSubtreeMaxEnd(left);
+        return left;
+    }
+    right.left = SCTreapMerge(left, right.left);
+    SCUpdateSubtreeMaxEnd(right);
+    return right;
+}
+
+// node's start must still be the one it was inserted with
+static SCLaneLayoutNode *SCTreapRemove(SCLaneLayoutNode *root, SCLaneLayoutNode *node) {
+    if (!root) return nil;
+    if (root == node) {
+        SCLaneLayoutNode *merged = SCTreapMerge(node.left, node.right);
+        node.left = nil;
+        node.right = nil;
+        return merged;
+    }
+
+    if (SCCompareLaneLayoutNodes(node, root) == NSOrderedAscending) {
+        root.left = SCTreapRemove(root.left, node);
+    } else {
+        root.right = SCTreapRemove(root.right, node);
+    }
+    SCUpdateSubtreeMaxEnd(root);
+    return root;
+}
+
+/// Adds every non-empty block overlapping [lo, hi) to results
+static void SCTreapCollectOverlapping(SCLaneLayoutNode *root, NSInteger lo, NSInteger hi, NSMutableArray<SCLaneLayoutNode *> *results) {
+    if (!root || root.subtreeMaxEnd <= lo) return;
+
+    SCTreapCollectOverlapping(root.left, lo, hi, results);
+    if (root.startMinutes < hi) {
+        if (root.endMinutes > lo && root.endMinutes > root.startMinutes) {
+            [results addObject:root];
+        }
+        SCTreapCollectOverlapping(root.right, lo, hi, results);
+    }
+}
+
+typedef struct {
+    NSInteger time;
+    NSInteger type;  // 0 = START, 1 = END
+    NSUInteger index;
+} SCLaneLayoutEvent;
+
+static int SCCompareLaneLayoutEvents(const void *a, const void *b) {
+    const SCLaneLayoutEvent *eventA = a;
+    const SCLaneLayoutEvent *eventB = b;
+    if (eventA->time != eventB->time) return eventA->time < eventB->time ? -1 : 1;
+    // END before START at the same time, so touching blocks don't count as overlapping
+    if (eventA->type != eventB->type) return eventA->type > eventB->type ? -1 : 1;
+    return 0;
+}
+
+#pragma mark - SCCalendarLaneLayout
+
+@implementation SCCalendarLaneLayout {
+    NSMutableDictionary<id<NSCopying>, SCLaneLayoutNode *> *_nodes;
+    SCLaneLayoutNode *_root;
+    NSUInteger _nextUID;
+    NSUInteger _generation;
+    NSInteger _batchDepth;
+
+    // What the next relayout has to look at: ranges blocks were moved out of or into,
+    // and the blocks themselves (an empty block overlaps nothing, so no range finds it)
+    NSMutableArray<NSValue *> *_dirtyRanges;
+    NSMutableSet<SCLaneLayoutNode *> *_dirtyNodes;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _nodes = [NSMutableDictionary dictionary];
+        _dirtyRanges = [NSMutableArray array];
+        _dirtyNodes = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (NSUInteger)blockCount {
+    return _nodes.count;
+}
+
+#pragma mark - Updates
+
+- (void)setBlockForKey:(id<NSCopying>)key
+          startMinutes:(NSInteger)startMinutes
+            endMinutes:(NSInteger)endMinutes
+          displayOrder:(NSInteger)displayOrder
+                 order:(NSInteger)order {
+    endMinutes = MAX(endMinutes, startMinutes);
+
+    SCLaneLayoutNode *node = _nodes[key];
+    if (node) {
+        node.generation = _generation;
+        if (node.startMinutes == startMinutes && node.endMinutes == endMinutes &&
+            node.displayOrder == displayOrder && node.order == order) {
+            return;  // Unchanged - keeps its cached lane
+        }
+
+        [self markRangeDirtyFrom:node.startMinutes to:node.endMinutes];
+        _root = SCTreapRemove(_root, node);
+    } else {
+        node = [[SCLaneLayoutNode alloc] init];
+        node.uid = _nextUID++;
+        node.priority = arc4random();
+        node.generation = _generation;
+        _nodes[key] = node;
+    }
+
+    node.startMinutes = startMinutes;
+    node.endMinutes = endMinutes;
+    node.displayOrder = displayOrder;
+    node.order = order;
+    _root = SCTreapInsert(_root, node);
+
+    [self markRangeDirtyFrom:startMinutes to:endMinutes];
+    [_dirtyNodes addObject:node];
+
+    if (_batchDepth == 0) {
+        [self relayoutDirtyClusters];
+    }
+}
+
+- (void)removeBlockForKey:(id<NSCopying>)key {
+    SCLaneLayoutNode *node = _nodes[key];
+    if (!node) return;
+
+    [self removeNode:node forKey:key];
+    if (_batchDepth == 0) {
+        [self relayoutDirtyClusters];
+    }
+}
+
+- (void)removeNode:(SCLaneLayoutNode *)node forKey:(id<NSCopying>)key {
+    [self markRangeDirtyFrom:node.startMinutes to:node.endMinutes];
+    [_dirtyNodes removeObject:node];
+    _root = SCTreapRemove(_root, node);
+    [_nodes removeObjectForKey:key];
+}
+
+- (void)removeAllBlocks {
+    [_nodes removeAllObjects];
+    [_dirtyRanges removeAllObjects];
+    [_dirtyNodes removeAllObjects];
+    _root = nil;
+}
+
+- (void)beginUpdates {
+    if (_batchDepth++ == 0) {
+        _generation++;
+    }
+}
+
+- (void)endUpdates {
+    NSAssert(_batchDepth > 0, @"endUpdates without beginUpdates");
+    if (--_batchDepth > 0) return;
+
+    NSMutableArray<id<NSCopying>> *unsetKeys = [NSMutableArray array];
+    [_nodes enumerateKeysAndObjectsUsingBlock:^(id<NSCopying> key, SCLaneLayoutNode *node, BOOL *stop) {
+        if (node.generation != self->_generation) [unsetKeys addObject:key];
+    }];
+    for (id<NSCopying> key in unsetKeys) {
+        [self removeNode:_nodes[key] forKey:key];
+    }
+
+    [self relayoutDirtyClusters];
+}
+
+- (void)markRangeDirtyFrom:(NSInteger)startMinutes to:(NSInteger)endMinutes {
+    if (endMinutes <= startMinutes) return;
+    [_dirtyRanges addObject:[NSValue valueWithRange:NSMakeRange(startMinutes, endMinutes - startMinutes)]];
+}
+
+#pragma mark - Layout
+
+- (void)relayoutDirtyClusters {
+    if (_dirtyRanges.count == 0 && _dirtyNodes.count == 0) {
+        _lastRelayoutBlockCount = 0;
+        return;
+    }
+
+    // Everything in the clusters a dirty range touches. A cluster is a run of blocks
+    // chained together by overlaps, so growing the range to cover whatever overlaps it
+    // until it stops growing collects whole clusters and nothing past them.
+    NSMutableSet<SCLaneLayoutNode *> *affected = [_dirtyNodes mutableCopy];
+    NSMutableArray<SCLaneLayoutNode *> *overlapping = [NSMutableArray array];
+    for (NSValue *dirtyRange in _dirtyRanges) {
+        NSInteger lo = dirtyRange.rangeValue.location;
+        NSInteger hi = NSMaxRange(dirtyRange.rangeValue);
+
+        while (YES) {
+            [overlapping removeAllObjects];
+            SCTreapCollectOverlapping(_root, lo, hi, overlapping);
+
+            NSInteger grownLo = lo, grownHi = hi;
+            for (SCLaneLayoutNode *node in overlapping) {
+                grownLo = MIN(grownLo, node.startMinutes);
+                grownHi = MAX(grownHi, node.endMinutes);
+            }
+            if (grownLo == lo && grownHi == hi) break;
+            lo = grownLo;
+            hi = grownHi;
+        }
+        [affected addObjectsFromArray:overlapping];
+    }
+    [_dirtyRanges removeAllObjects];
+    [_dirtyNodes removeAllObjects];
+
+    NSArray<SCLaneLayoutNode *> *sorted = [affected.allObjects sortedArrayUsingComparator:^NSComparisonResult(SCLaneLayoutNode *a, SCLaneLayoutNode *b) {
+        return SCCompareLaneLayoutNodes(a, b);
+    }];
+
+    // Split into clusters and lay each out on its own. Blocks in different clusters never
+    // overlap, so they can't affect each other's lanes or overlap counts.
+    NSMutableArray<SCLaneLayoutNode *> *cluster = [NSMutableArray array];
+    NSInteger clusterEnd = 0;
+    for (SCLaneLayoutNode *node in sorted) {
+        if (node.endMinutes <= node.startMinutes) {
+            // Empty blocks overlap nothing
+            node.maxOverlap = 1;
+            node.laneSlot = 0;
+            continue;
+        }
+        if (cluster.count > 0 && node.startMinutes >= clusterEnd) {
+            [self layoutCluster:cluster];
+            [cluster removeAllObjects];
+        }
+        clusterEnd = (cluster.count == 0) ? node.endMinutes : MAX(clusterEnd, node.endMinutes);
+        [cluster addObject:node];
+    }
+    if (cluster.count > 0) {
+        [self layoutCluster:cluster];
+    }
+
+    _lastRelayoutBlockCount = affected.count;
+}
+
+- (void)layoutCluster:(NSArray<SCLaneLayoutNode *> *)cluster {
+    NSUInteger count = cluster.count;
+    if (count == 1) {
+        cluster[0].maxOverlap = 1;
+        cluster[0].laneSlot = 0;
+        return;
+    }
+
+    // Sweep line for each block's maxOverlap: at every start, all running blocks see the running count
+    SCLaneLayoutEvent *events = malloc(count * 2 * sizeof(SCLaneLayoutEvent));
+    NSUInteger *active = malloc(count * sizeof(NSUInteger));
+    for (NSUInteger i = 0; i < count; i++) {
+        cluster[i].maxOverlap = 1;
+        events[i * 2] = (SCLaneLayoutEvent){ cluster[i].startMinutes, 0, i };
+        events[i * 2 + 1] = (SCLaneLayoutEvent){ cluster[i].endMinutes, 1, i };
+    }
+    qsort(events, count * 2, sizeof(SCLaneLayoutEvent), SCCompareLaneLayoutEvents);
+
+    NSUInteger activeCount = 0;
+    for (NSUInteger e = 0; e < count * 2; e++) {
+        if (events[e].type == 0) {
+            active[activeCount++] = events[e].index;
+            for (NSUInteger a = 0; a < activeCount; a++) {
+                SCLaneLayoutNode *running = cluster[active[a]];
+                if (running.maxOverlap < (NSInteger)activeCount) running.maxOverlap = activeCount;
+            }
+        } else {
+            for (NSUInteger a = 0; a < activeCount; a++) {
+                if (active[a] == events[e].index) {
+                    active[a] = active[--activeCount];
+                    break;
+                }
+            }
+        }
+    }
+    free(events);
+    free(active);
+
+    // Greedy packing by displayOrder (primary), then startMinutes, then order
+    NSArray<SCLaneLayoutNode *> *packingOrder = [cluster sortedArrayUsingComparator:^NSComparisonResult(SCLaneLayoutNode *a, SCLaneLayoutNode *b) {
+        if (a.displayOrder != b.displayOrder) return a.displayOrder < b.displayOrder ? NSOrderedAscending : NSOrderedDescending;
+        if (a.startMinutes != b.startMinutes) return a.startMinutes < b.startMinutes ? NSOrderedAscending : NSOrderedDescending;
+        if (a.order != b.order) return a.order < b.order ? NSOrderedAscending : NSOrderedDescending;
+        return NSOrderedSame;
+    }];
+
+    // Each lane is the set of minutes already taken by the blocks placed in it
+    NSMutableArray<SCIntervalSet *> *lanes = [NSMutableArray array];
+    for (SCLaneLayoutNode *node in packingOrder) {
+        NSRange blockMinutes = NSMakeRange(node.startMinutes, node.endMinutes - node.startMinutes);
+        NSInteger assignedLane = -1;
+
+        for (NSInteger i = 0; i < (NSInteger)lanes.count; i++) {
+            if (![lanes[i] intersectsInterval:blockMinutes]) {
+                lanes[i] = [lanes[i] setByAddingInterval:blockMinutes];
+                assignedLane = i;
+                break;
+            }
+        }
+        if (assignedLane == -1) {
+            [lanes addObject:[SCIntervalSet setWithInterval:blockMinutes]];
+            assignedLane = lanes.count - 1;
+        }
+        node.laneSlot = assignedLane;
+    }
+}
+
+#pragma mark - Queries
+
+- (BOOL)getLaneSlot:(NSInteger *)laneSlot maxOverlap:(NSInteger *)maxOverlap forKey:(id<NSCopying>)key {
+    SCLaneLayoutNode *node = _nodes[key];
+    if (!node) return NO;
+
+    if (laneSlot) *laneSlot = node.laneSlot;
+    if (maxOverlap) *maxOverlap = node.maxOverlap;
+    return YES;
+}
+
+@end
@@ -4,6 +4,7 @@
 //
 
 #import "SCDayScheduleEditorController.h"
+#import "Block Management/SCIntervalSet.h"
 
 // Constants for timeline view (scaled 33% larger)
 static const CGFloat kTimelineHeight = 533.0;  // 400 * 1.33
@@ -1072,53 +1073,43 @@ static const CGFloat kDragThreshold = 5.0;  // Pixels to move before starting dr
 
 - (BOOL)hasOverlappingBlocks {
     NSArray<SCTimeRange *> *windows = self.timelineView.allowedWindows;
-    for (NSUInteger i = 0; i < windows.count; i++) {
-        for (NSUInteger j = i + 1; j < windows.count; j++) {
-            if ([self range:windows[i] overlapsWithRange:windows[j]]) {
-                return YES;
-            }
-        }
-    }
-    return NO;
-}
+    if (windows.count < 2) return NO;
 
-- (BOOL)range:(SCTimeRange *)a overlapsWithRange:(SCTimeRange *)b {
-    NSInteger aStart = [a startMinutes];
-    NSInteger aEnd = [a endMinutes];
-    NSInteger bStart = [b startMinutes];
-    NSInteger bEnd = [b endMinutes];
-    // Overlaps if not disjoint (a ends before b starts or b ends before a starts)
-    return !(aEnd <= bStart || bEnd <= aStart);
+    // Blocks overlap exactly when their union covers less time than their durations add up to
+    // (blocks that only touch don't count, same as before)
+    NSInteger totalDuration = 0;
+    for (SCTimeRange *window in windows) {
+        totalDuration += [window durationMinutes];
+    }
+    return (NSInteger)[[SCIntervalSet setWithTimeRanges:windows] totalLength] < totalDuration;
 }
 
 - (void)mergeOverlappingBlocks {
     NSMutableArray<SCTimeRange *> *windows = self.timelineView.allowedWindows;
     if (windows.count < 2) return;
 
-    // Sort by start time
-    [windows sortUsingComparator:^NSComparisonResult(SCTimeRange *a, SCTimeRange *b) {
-        return [@([a startMinutes]) compare:@([b startMinutes])];
-    }];
+    // Overlapping or adjacent blocks come back as one, sorted by start time
+    NSMutableArray<SCTimeRange *> *merged = [[[SCIntervalSet setWithTimeRanges:windows] timeRanges] mutableCopy];
+
+    // The interval set has no empty intervals, so zero-length blocks would silently
+    // vanish. Keep the ones that don't fall within (or touch) a merged block.
+    for (SCTimeRange *window in windows) {
+        if ([window durationMinutes] != 0) continue;
 
-    NSMutableArray<SCTimeRange *> *merged = [NSMutableArray array];
-    SCTimeRange *current = [windows[0] copy];
-
-    for (NSUInteger i = 1; i < windows.count; i++) {
-        SCTimeRange *next = windows[i];
-        if ([next startMinutes] <= [current endMinutes]) {
-            // Overlapping or adjacent - extend current
-            if ([next endMinutes] > [current endMinutes]) {
-                NSInteger endMins = [next endMinutes];
-                current.endTime = [NSString stringWithFormat:@"%02ld:%02ld",
-                                   (long)(endMins / 60), (long)(endMins % 60)];
+        BOOL absorbed = NO;
+        for (SCTimeRange *range in merged) {
+            if ([range startMinutes] <= [window startMinutes] && [window startMinutes] <= [range endMinutes]) {
+                absorbed = YES;
+                break;
             }
-        } else {
-            // No overlap - save current and start new
-            [merged addObject:current];
-            current = [next copy];
+        }
+        if (!absorbed) {
+            [merged addObject:[window copy]];
         }
     }
-    [merged addObject:current];
+    [merged sortUsingComparator:^NSComparisonResult(SCTimeRange *a, SCTimeRange *b) {
+        return [@([a startMinutes]) compare:@([b startMinutes])];
+    }];
 
     [self.timelineView.allowedWindows removeAllObjects];
     [self.timelineView.allowedWindows addObjectsFromArray:merged];
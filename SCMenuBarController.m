@@ -7,6 +7,7 @@
 #import "Block Management/SCScheduleManager.h"
 #import "Block Management/SCBlockBundle.h"
 #import "Block Management/SCWeeklySchedule.h"
+#import "Block Management/SCScheduleStatusService.h"
 #import "SCLogger.h"
 #import "Common/SCLicenseManager.h"
 #import "SCLicenseWindowController.h"
@@ -20,7 +21,6 @@
 
 @property (nonatomic, strong) NSStatusItem *statusItem;
 @property (nonatomic, strong) NSMenu *statusMenu;
-@property (nonatomic, strong) NSTimer *updateTimer;
 @property (nonatomic, strong, nullable) SCLicenseWindowController *licenseWindowController;
 @property (nonatomic, strong, nullable) SCTestBlockWindowController *testBlockWindowController;
 
@@ -42,25 +42,19 @@
     if (self) {
         _isVisible = NO;
 
-        // Listen for schedule changes
+        // The status service refreshes on schedule changes, wake from sleep and
+        // at every block boundary, so there's nothing to poll
         [[NSNotificationCenter defaultCenter] addObserver:self
-                                                 selector:@selector(scheduleDidChange:)
-                                                     name:SCScheduleManagerDidChangeNotification
+                                                 selector:@selector(scheduleStatusDidUpdate:)
+                                                     name:SCScheduleStatusServiceDidUpdateNotification
                                                    object:nil];
-
-        // Listen for wake from sleep to refresh status
-        [[[NSWorkspace sharedWorkspace] notificationCenter] addObserver:self
-                                                               selector:@selector(systemDidWake:)
-                                                                   name:NSWorkspaceDidWakeNotification
-                                                                 object:nil];
+        [SCScheduleStatusService sharedService];
     }
     return self;
 }
 
 - (void)dealloc {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
-    [[[NSWorkspace sharedWorkspace] notificationCenter] removeObserver:self];
-    [self.updateTimer invalidate];
 }
 
 #pragma mark - Visibility
@@ -72,10 +66,8 @@
 
     if (visible) {
         [self createStatusItem];
-        [self startUpdateTimer];
     } else {
         [self removeStatusItem];
-        [self stopUpdateTimer];
     }
 }
 
@@ -108,12 +100,14 @@
     self.statusMenu.delegate = self;
 
     SCScheduleManager *manager = [SCScheduleManager sharedManager];
+    SCScheduleStatusService *statusService = [SCScheduleStatusService sharedService];
 
     // Only show bundle status pills when committed (like week schedule window)
     if (manager.isCommitted) {
         for (SCBlockBundle *bundle in manager.bundles) {
-            BOOL allowed = [manager wouldBundleBeAllowed:bundle.bundleID];
-            NSString *statusStr = [manager statusStringForBundleID:bundle.bundleID];
+            SCBundleStatus *status = [statusService statusForBundleID:bundle.bundleID];
+            BOOL allowed = status ? status.isAllowed : YES;
+            NSString *statusStr = status.statusString ?: @"";
 
             // Skip bundles with no schedule for current week
             if (statusStr.length == 0) continue;
@@ -323,12 +317,14 @@
 
 - (NSString *)blocklistMenuTitle {
     SCScheduleManager *manager = [SCScheduleManager sharedManager];
+    SCScheduleStatusService *statusService = [SCScheduleStatusService sharedService];
     NSInteger siteCount = 0;
     NSInteger appCount = 0;
 
     // Count entries from bundles currently blocking (not in allowed window)
     for (SCBlockBundle *bundle in manager.bundles) {
-        if ([manager wouldBundleBeAllowed:bundle.bundleID]) {
+        SCBundleStatus *status = [statusService statusForBundleID:bundle.bundleID];
+        if (!status || status.isAllowed) {
             continue; // Skip bundles in allowed window
         }
         for (id entry in bundle.entries) {
@@ -396,40 +392,11 @@
     self.statusItem.menu = self.statusMenu;
 }
 
-- (void)startUpdateTimer {
-    [self.updateTimer invalidate];
-
-    // Update every 15 seconds to catch block state changes
-    self.updateTimer = [NSTimer scheduledTimerWithTimeInterval:15.0
-                                                        target:self
-                                                      selector:@selector(timerFired:)
-                                                      userInfo:nil
-                                                       repeats:YES];
-    [[NSRunLoop currentRunLoop] addTimer:self.updateTimer forMode:NSRunLoopCommonModes];
-}
-
-- (void)stopUpdateTimer {
-    [self.updateTimer invalidate];
-    self.updateTimer = nil;
-}
-
-- (void)timerFired:(NSTimer *)timer {
-    [self updateStatus];
-}
-
 #pragma mark - Notifications
 
-- (void)scheduleDidChange:(NSNotification *)note {
-    dispatch_async(dispatch_get_main_queue(), ^{
-        [self updateStatus];
-    });
-}
-
-- (void)systemDidWake:(NSNotification *)note {
-    // Refresh status after wake from sleep - block state may have changed
-    dispatch_async(dispatch_get_main_queue(), ^{
-        [self updateStatus];
-    });
+- (void)scheduleStatusDidUpdate:(NSNotification *)note {
+    // Posted on the main queue
+    [self updateStatus];
 }
 
 #pragma mark - NSMenuDelegate
@@ -486,7 +486,7 @@ typedef NS_ENUM(NSInteger, SCTestBlockState) {
     self.startButton.enabled = NO;
     self.startButton.title = @"Starting...";
 
-    SCXPCClient* xpc = [[SCXPCClient alloc] init];
+    SCXPCClient* xpc = [SCXPCClient sharedClient];
 
     // First install daemon (may require password)
     [xpc installDaemon:^(NSError* installError) {
@@ -534,7 +534,7 @@ typedef NS_ENUM(NSInteger, SCTestBlockState) {
     self.stopButton.enabled = NO;
     self.stopButton.title = @"Stopping...";
 
-    SCXPCClient* xpc = [[SCXPCClient alloc] init];
+    SCXPCClient* xpc = [SCXPCClient sharedClient];
     [xpc stopTestBlock:^(NSError* error) {
         dispatch_async(dispatch_get_main_queue(), ^{
             [self.updateTimer invalidate];
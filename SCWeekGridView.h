@@ -57,7 +57,8 @@ NS_ASSUME_NONNULL_BEGIN
 /// Schedules (one per bundle)
 @property (nonatomic, copy, nullable) NSArray<SCWeeklySchedule *> *schedules;
 
-/// Reloads the grid with current data
+/// Reloads the grid with current data. Re-renders the grid only if bundles or schedules
+/// changed; otherwise it just moves the NOW line.
 - (void)reloadData;
 
 /// Returns the schedule for a specific bundle
@@ -25,6 +25,12 @@ static const CGFloat kTimelineHeight = 48.0;
 @property (nonatomic, assign) NSInteger hoveredDayIndex;
 @property (nonatomic, assign) BOOL isHoveringBundleLabel;
 
+// Grid, labels and timelines, rendered once and blitted for every dirty rect. Hover, the
+// copy/paste highlight and the NOW line are drawn over it, so they only dirty their own rects.
+@property (nonatomic, strong, nullable) NSImage *staticContentImage;
+@property (nonatomic, copy, nullable) NSArray *staticContentSignature;
+@property (nonatomic, assign) NSRect nowLineRect;
+
 @end
 
 @implementation SCWeekGridView
@@ -73,9 +79,64 @@ static const CGFloat kTimelineHeight = 48.0;
 #pragma mark - Data
 
 - (void)reloadData {
+    // Called on every refresh tick, so only re-render the grid if something it shows changed
+    NSArray *signature = [self signatureForStaticContent:[self daysToShow]];
+    if (![signature isEqualToArray:self.staticContentSignature]) {
+        [self invalidateStaticContent];
+    } else {
+        [self updateNowLine];
+    }
+}
+
+/// Everything the static content depends on, other than size and appearance
+- (NSArray *)signatureForStaticContent:(NSArray<NSNumber *> *)days {
+    NSMutableArray *signature = [NSMutableArray arrayWithObjects:days, @(self.weekOffset), @([SCWeeklySchedule today]), nil];
+    for (SCBlockBundle *bundle in self.bundles) {
+        [signature addObject:bundle.bundleID ?: @""];
+        [signature addObject:bundle.name ?: @""];
+        [signature addObject:bundle.color ?: [NSNull null]];
+
+        SCWeeklySchedule *schedule = [self scheduleForBundle:bundle];
+        if (!schedule) {
+            [signature addObject:[NSNull null]];
+            continue;
+        }
+        for (NSNumber *day in days) {
+            NSMutableArray<NSNumber *> *minutes = [NSMutableArray array];
+            for (SCTimeRange *window in [schedule allowedWindowsForDay:day.integerValue]) {
+                [minutes addObject:@([window startMinutes])];
+                [minutes addObject:@([window endMinutes])];
+            }
+            [signature addObject:minutes];
+        }
+    }
+    return signature;
+}
+
+- (void)invalidateStaticContent {
+    self.staticContentImage = nil;
+    self.staticContentSignature = nil;
     [self setNeedsDisplay:YES];
 }
 
+- (void)setFrameSize:(NSSize)newSize {
+    BOOL sizeChanged = !NSEqualSizes(newSize, self.frame.size);
+    [super setFrameSize:newSize];
+    if (sizeChanged) {
+        [self invalidateStaticContent];
+    }
+}
+
+- (void)viewDidChangeBackingProperties {
+    [super viewDidChangeBackingProperties];
+    [self invalidateStaticContent];
+}
+
+- (void)viewDidChangeEffectiveAppearance {
+    [super viewDidChangeEffectiveAppearance];
+    [self invalidateStaticContent];
+}
+
 - (nullable SCWeeklySchedule *)scheduleForBundle:(SCBlockBundle *)bundle {
     for (SCWeeklySchedule *schedule in self.schedules) {
         if ([schedule.bundleID isEqualToString:bundle.bundleID]) {
@@ -123,11 +184,60 @@ static const CGFloat kTimelineHeight = 48.0;
 - (void)drawRect:(NSRect)dirtyRect {
     [super drawRect:dirtyRect];
 
+    NSArray<NSNumber *> *days = [self daysToShow];
+
+    if (!self.staticContentImage) {
+        self.staticContentImage = [self renderStaticContent:days];
+        self.staticContentSignature = [self signatureForStaticContent:days];
+    }
+    [self.staticContentImage drawInRect:dirtyRect
+                               fromRect:dirtyRect
+                              operation:NSCompositingOperationCopy
+                               fraction:1.0
+                         respectFlipped:YES
+                                  hints:nil];
+
+    if (days.count == 0) return;
+
+    [self drawDecorationsInRect:dirtyRect days:days];
+
+    // Draw continuous NOW line across all bundles for today
+    self.nowLineRect = [self rectForNowLine:days];
+    if (NSIntersectsRect(self.nowLineRect, dirtyRect)) {
+        [self drawNowLineInRect:self.nowLineRect];
+    }
+}
+
+/// Renders the grid without hover, highlight or NOW line into a bitmap at the view's backing scale
+- (NSImage *)renderStaticContent:(NSArray<NSNumber *> *)days {
+    NSRect backingRect = [self convertRectToBacking:self.bounds];
+    NSBitmapImageRep *rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+                                                                    pixelsWide:MAX(1, (NSInteger)ceil(NSWidth(backingRect)))
+                                                                    pixelsHigh:MAX(1, (NSInteger)ceil(NSHeight(backingRect)))
+                                                                 bitsPerSample:8
+                                                               samplesPerPixel:4
+                                                                      hasAlpha:YES
+                                                                      isPlanar:NO
+                                                                colorSpaceName:NSCalibratedRGBColorSpace
+                                                                   bytesPerRow:0
+                                                                  bitsPerPixel:0];
+    rep.size = self.bounds.size;
+
+    [NSGraphicsContext saveGraphicsState];
+    [NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:rep]];
+    [self drawStaticContent:days];
+    [NSGraphicsContext restoreGraphicsState];
+
+    NSImage *image = [[NSImage alloc] initWithSize:self.bounds.size];
+    [image addRepresentation:rep];
+    return image;
+}
+
+- (void)drawStaticContent:(NSArray<NSNumber *> *)days {
     // Background
     [[NSColor windowBackgroundColor] setFill];
-    NSRectFill(dirtyRect);
+    NSRectFill(self.bounds);
 
-    NSArray<NSNumber *> *days = [self daysToShow];
     NSUInteger dayCount = days.count;
 
     if (dayCount == 0) return;
@@ -141,7 +251,7 @@ static const CGFloat kTimelineHeight = 48.0;
         SCWeeklySchedule *schedule = [self scheduleForBundle:bundle];
 
         // Draw bundle label
-        [self drawBundleLabel:bundle atIndex:i];
+        [self drawBundleLabel:bundle atIndex:i isHovered:NO];
 
         // Draw cells for each day
         for (NSUInteger j = 0; j < dayCount; j++) {
@@ -151,15 +261,53 @@ static const CGFloat kTimelineHeight = 48.0;
                                 day:day
                         bundleIndex:i
                            dayIndex:j
-                           dayCount:dayCount];
+                           dayCount:dayCount
+                    backgroundColor:[NSColor controlBackgroundColor]];
         }
     }
 
     // Draw grid lines
     [self drawGridLines:days];
+}
 
-    // Draw continuous NOW line across all bundles for today
-    [self drawNowLine:days];
+/// Draws the hovered label or cell and the highlighted cell over the static content
+- (void)drawDecorationsInRect:(NSRect)dirtyRect days:(NSArray<NSNumber *> *)days {
+    NSUInteger dayCount = days.count;
+    NSColor *hoverColor = [[NSColor controlBackgroundColor] blendedColorWithFraction:0.15 ofColor:[NSColor blackColor]];
+
+    for (NSUInteger i = 0; i < self.bundles.count; i++) {
+        SCBlockBundle *bundle = self.bundles[i];
+        BOOL isHoveredRow = (self.hoveredBundleIndex == (NSInteger)i);
+        BOOL isHighlightedRow = [self.highlightedBundleID isEqualToString:bundle.bundleID];
+        if (!isHoveredRow && !isHighlightedRow) continue;
+
+        if (isHoveredRow && self.isHoveringBundleLabel &&
+            NSIntersectsRect([self rectForBundleLabel:i], dirtyRect)) {
+            [self drawBundleLabel:bundle atIndex:i isHovered:YES];
+        }
+
+        for (NSUInteger j = 0; j < dayCount; j++) {
+            SCDayOfWeek day = [days[j] integerValue];
+
+            // Highlight (for copy/paste) wins over hover
+            NSColor *backgroundColor = nil;
+            if (isHighlightedRow && self.highlightedDay == day) {
+                backgroundColor = [NSColor selectedContentBackgroundColor];
+            } else if (isHoveredRow && !self.isHoveringBundleLabel && self.hoveredDayIndex == (NSInteger)j) {
+                // Darker background on hover
+                backgroundColor = hoverColor;
+            }
+            if (!backgroundColor || !NSIntersectsRect([self rectForCell:i dayIndex:j dayCount:dayCount], dirtyRect)) continue;
+
+            [self drawCellForBundle:bundle
+                           schedule:[self scheduleForBundle:bundle]
+                                day:day
+                        bundleIndex:i
+                           dayIndex:j
+                           dayCount:dayCount
+                    backgroundColor:backgroundColor];
+        }
+    }
 }
 
 - (void)drawDayHeaders:(NSArray<NSNumber *> *)days {
@@ -204,12 +352,9 @@ static const CGFloat kTimelineHeight = 48.0;
     }
 }
 
-- (void)drawBundleLabel:(SCBlockBundle *)bundle atIndex:(NSUInteger)index {
+- (void)drawBundleLabel:(SCBlockBundle *)bundle atIndex:(NSUInteger)index isHovered:(BOOL)isHovered {
     NSRect labelRect = [self rectForBundleLabel:index];
 
-    // Check if this label is hovered
-    BOOL isHovered = (self.hoveredBundleIndex == (NSInteger)index && self.isHoveringBundleLabel);
-
     // Draw hover background
     if (isHovered) {
         NSRect hoverRect = NSInsetRect(labelRect, 4, 4);
@@ -254,29 +399,14 @@ static const CGFloat kTimelineHeight = 48.0;
                       day:(SCDayOfWeek)day
               bundleIndex:(NSUInteger)bundleIndex
                  dayIndex:(NSUInteger)dayIndex
-                 dayCount:(NSUInteger)dayCount {
+                 dayCount:(NSUInteger)dayCount
+          backgroundColor:(NSColor *)backgroundColor {
 
     NSRect cellRect = [self rectForCell:bundleIndex dayIndex:dayIndex dayCount:dayCount];
     NSRect innerRect = NSInsetRect(cellRect, kCellPadding, kCellPadding);
 
-    // Check if this cell is highlighted (for copy/paste)
-    BOOL isHighlighted = [self.highlightedBundleID isEqualToString:bundle.bundleID] &&
-                         self.highlightedDay == day;
-
-    // Check if this cell is hovered
-    BOOL isHovered = (self.hoveredBundleIndex == (NSInteger)bundleIndex &&
-                      self.hoveredDayIndex == (NSInteger)dayIndex &&
-                      !self.isHoveringBundleLabel);
-
     // Cell background
-    if (isHighlighted) {
-        [[NSColor selectedContentBackgroundColor] setFill];
-    } else if (isHovered) {
-        // Darker background on hover
-        [[[NSColor controlBackgroundColor] blendedColorWithFraction:0.15 ofColor:[NSColor blackColor]] setFill];
-    } else {
-        [[NSColor controlBackgroundColor] setFill];
-    }
+    [backgroundColor setFill];
     NSBezierPath *bgPath = [NSBezierPath bezierPathWithRoundedRect:innerRect xRadius:6 yRadius:6];
     [bgPath fill];
 
@@ -335,9 +465,10 @@ static const CGFloat kTimelineHeight = 48.0;
     // NOW line is drawn separately at grid level for continuity across rows
 }
 
-- (void)drawNowLine:(NSArray<NSNumber *> *)days {
+/// The area the NOW line covers, NSZeroRect when it isn't shown
+- (NSRect)rectForNowLine:(NSArray<NSNumber *> *)days {
     // Only draw the NOW line for current week
-    if (self.weekOffset != 0) return;
+    if (self.weekOffset != 0) return NSZeroRect;
 
     // Find if today is visible
     SCDayOfWeek today = [SCWeeklySchedule today];
@@ -350,7 +481,7 @@ static const CGFloat kTimelineHeight = 48.0;
         }
     }
 
-    if (todayIndex < 0 || self.bundles.count == 0) return;
+    if (todayIndex < 0 || self.bundles.count == 0) return NSZeroRect;
 
     // Calculate current time as percentage of day
     NSCalendar *calendar = [NSCalendar currentCalendar];
@@ -371,15 +502,30 @@ static const CGFloat kTimelineHeight = 48.0;
     CGFloat topY = self.bounds.size.height - kHeaderHeight;
     CGFloat bottomY = self.bounds.size.height - kHeaderHeight - self.bundles.count * kRowHeight;
 
+    // 2pt line, centered on nowX
+    return NSMakeRect(nowX - 1.0, bottomY, 2.0, topY - bottomY);
+}
+
+- (void)drawNowLineInRect:(NSRect)lineRect {
     // Draw the continuous red line
     [[NSColor systemRedColor] setStroke];
     NSBezierPath *nowPath = [NSBezierPath bezierPath];
     [nowPath setLineWidth:2.0];
-    [nowPath moveToPoint:NSMakePoint(nowX, bottomY)];
-    [nowPath lineToPoint:NSMakePoint(nowX, topY)];
+    [nowPath moveToPoint:NSMakePoint(NSMidX(lineRect), NSMinY(lineRect))];
+    [nowPath lineToPoint:NSMakePoint(NSMidX(lineRect), NSMaxY(lineRect))];
     [nowPath stroke];
 }
 
+/// Moves the NOW line by dirtying only where it was and where it is now
+- (void)updateNowLine {
+    NSRect newRect = [self rectForNowLine:[self daysToShow]];
+    if (NSEqualRects(newRect, self.nowLineRect)) return;
+
+    [self setNeedsDisplayInRect:self.nowLineRect];
+    [self setNeedsDisplayInRect:newRect];
+    self.nowLineRect = newRect;
+}
+
 - (void)drawGridLines:(NSArray<NSNumber *> *)days {
     [[NSColor separatorColor] setStroke];
     NSBezierPath *gridPath = [NSBezierPath bezierPath];
@@ -407,11 +553,21 @@ static const CGFloat kTimelineHeight = 48.0;
 }
 
 - (void)mouseExited:(NSEvent *)event {
+    [self setNeedsDisplayInRect:[self rectForHoveredElement]];
     self.hoveredBundleIndex = -1;
     self.hoveredDayIndex = -1;
     self.isHoveringBundleLabel = NO;
     [[NSCursor arrowCursor] set];
-    [self setNeedsDisplay:YES];
+}
+
+/// The label or cell currently under the mouse, NSZeroRect if none
+- (NSRect)rectForHoveredElement {
+    if (self.hoveredBundleIndex < 0) return NSZeroRect;
+    if (self.isHoveringBundleLabel) {
+        return [self rectForBundleLabel:self.hoveredBundleIndex];
+    }
+    if (self.hoveredDayIndex < 0) return NSZeroRect;
+    return [self rectForCell:self.hoveredBundleIndex dayIndex:self.hoveredDayIndex dayCount:[self daysToShow].count];
 }
 
 - (void)updateHoverStateForPoint:(NSPoint)point {
@@ -449,9 +605,12 @@ static const CGFloat kTimelineHeight = 48.0;
         newDayIndex != self.hoveredDayIndex ||
         newIsHoveringLabel != self.isHoveringBundleLabel) {
 
+        // Only the element losing hover and the one gaining it need redrawing
+        [self setNeedsDisplayInRect:[self rectForHoveredElement]];
         self.hoveredBundleIndex = newBundleIndex;
         self.hoveredDayIndex = newDayIndex;
         self.isHoveringBundleLabel = newIsHoveringLabel;
+        [self setNeedsDisplayInRect:[self rectForHoveredElement]];
 
         // Update cursor
         if (newBundleIndex >= 0) {
@@ -459,8 +618,6 @@ static const CGFloat kTimelineHeight = 48.0;
         } else {
             [[NSCursor arrowCursor] set];
         }
-
-        [self setNeedsDisplay:YES];
     }
 }
 
@@ -519,15 +676,31 @@ static const CGFloat kTimelineHeight = 48.0;
 #pragma mark - Highlighting
 
 - (void)highlightCellForBundle:(NSString *)bundleID day:(SCDayOfWeek)day {
+    [self setNeedsDisplayInRect:[self rectForHighlightedCell]];
     self.highlightedBundleID = bundleID;
     self.highlightedDay = day;
-    [self setNeedsDisplay:YES];
+    [self setNeedsDisplayInRect:[self rectForHighlightedCell]];
 }
 
 - (void)clearCellHighlight {
+    [self setNeedsDisplayInRect:[self rectForHighlightedCell]];
     self.highlightedBundleID = nil;
     self.highlightedDay = -1;
-    [self setNeedsDisplay:YES];
+}
+
+- (NSRect)rectForHighlightedCell {
+    if (!self.highlightedBundleID) return NSZeroRect;
+
+    NSArray<NSNumber *> *days = [self daysToShow];
+    NSUInteger dayIndex = [days indexOfObject:@(self.highlightedDay)];
+    if (dayIndex == NSNotFound) return NSZeroRect;
+
+    for (NSUInteger i = 0; i < self.bundles.count; i++) {
+        if ([self.bundles[i].bundleID isEqualToString:self.highlightedBundleID]) {
+            return [self rectForCell:i dayIndex:dayIndex dayCount:days.count];
+        }
+    }
+    return NSZeroRect;
 }
 
 #pragma mark - Intrinsic Size
@@ -15,6 +15,7 @@
 #import "Block Management/SCScheduleManager.h"
 #import "Block Management/SCBlockBundle.h"
 #import "Block Management/SCWeeklySchedule.h"
+#import "Block Management/SCScheduleStatusService.h"
 #import "Common/SCLicenseManager.h"
 #import "SCLicenseWindowController.h"
 
@@ -63,6 +64,9 @@
 // Feature flag to switch between old grid and new calendar UI
 static BOOL const kUseCalendarUI = YES;
 
+// KVO context for the in-flight commit's NSProgress
+static void *kCommitProgressContext = &kCommitProgressContext;
+
 @interface SCWeekScheduleWindowController () <SCWeekGridViewDelegate,
                                                SCBundleSidebarViewDelegate,
                                                SCCalendarGridViewDelegate,
@@ -81,6 +85,10 @@ static BOOL const kUseCalendarUI = YES;
 @property (nonatomic, strong) NSButton *emergencyUnlockButton;
 @property (nonatomic, strong) NSButton *commitButton;
 @property (nonatomic, strong) NSTextField *commitmentLabel;
+@property (nonatomic, strong) NSProgressIndicator *commitProgressIndicator;
+
+// Commit running in the background (nil when there isn't one)
+@property (nonatomic, strong, nullable) NSProgress *commitProgress;
 
 // New Calendar UI Elements
 @property (nonatomic, strong) SCBundleSidebarView *bundleSidebar;
@@ -137,6 +145,7 @@ static BOOL const kUseCalendarUI = YES;
 }
 
 - (void)dealloc {
+    [self stopObservingCommitProgress];
     [[NSNotificationCenter defaultCenter] removeObserver:self];
     [[[NSWorkspace sharedWorkspace] notificationCenter] removeObserver:self];
     [self.refreshTimer invalidate];
@@ -322,6 +331,16 @@ static BOOL const kUseCalendarUI = YES;
     self.commitmentLabel.drawsBackground = NO;
     self.commitmentLabel.autoresizingMask = NSViewMinXMargin | NSViewMaxYMargin; // Stay at bottom-right
     [contentView addSubview:self.commitmentLabel];
+
+    // Commit progress bar - just above the commit button, only shown while committing
+    self.commitProgressIndicator = [[NSProgressIndicator alloc] initWithFrame:NSMakeRect(contentView.bounds.size.width - padding - 150, buttonY + 34, 150, 8)];
+    self.commitProgressIndicator.style = NSProgressIndicatorStyleBar;
+    self.commitProgressIndicator.indeterminate = NO;
+    self.commitProgressIndicator.minValue = 0.0;
+    self.commitProgressIndicator.maxValue = 1.0;
+    self.commitProgressIndicator.hidden = YES;
+    self.commitProgressIndicator.autoresizingMask = NSViewMinXMargin | NSViewMaxYMargin; // Stay at bottom-right
+    [contentView addSubview:self.commitProgressIndicator];
 }
 
 - (void)setupMenuBar {
@@ -336,6 +355,12 @@ static BOOL const kUseCalendarUI = YES;
                                                  name:SCScheduleManagerDidChangeNotification
                                                object:nil];
 
+    // Status pills follow the shared status service, which refreshes at each block boundary
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(scheduleStatusDidUpdate:)
+                                                 name:SCScheduleStatusServiceDidUpdateNotification
+                                               object:nil];
+
     // Observe window resize to update grid layout
     [[NSNotificationCenter defaultCenter] addObserver:self
                                              selector:@selector(windowDidResize:)
@@ -354,7 +379,7 @@ static BOOL const kUseCalendarUI = YES;
                                                                name:NSWorkspaceDidWakeNotification
                                                              object:nil];
 
-    // 5-minute timer to refresh NOW line and status (block boundaries are covered by SCScheduleManagerDidChangeNotification)
+    // 5-minute timer to refresh the NOW line (status changes come from SCScheduleStatusServiceDidUpdateNotification)
     self.refreshTimer = [NSTimer scheduledTimerWithTimeInterval:300.0  // 5 minutes
                                                          target:self
                                                        selector:@selector(refreshTimerFired:)
@@ -372,6 +397,11 @@ static BOOL const kUseCalendarUI = YES;
     [self reloadData];
 }
 
+- (void)scheduleStatusDidUpdate:(NSNotification *)note {
+    // Posted on the main queue
+    [self updateStatusLabel];
+}
+
 - (void)systemDidWake:(NSNotification *)note {
     // Refresh UI after wake from sleep - NOW line position and status may have changed
     dispatch_async(dispatch_get_main_queue(), ^{
@@ -390,8 +420,8 @@ static BOOL const kUseCalendarUI = YES;
 #pragma mark - Data
 
 - (void)reloadData {
+    BOOL isCommitted = [self isEditingLockedForWeekOffset:self.currentWeekOffset];
     SCScheduleManager *manager = [SCScheduleManager sharedManager];
-    BOOL isCommitted = [manager isCommittedForWeekOffset:self.currentWeekOffset];
 
     if (kUseCalendarUI) {
         // NEW CALENDAR UI: Update sidebar and calendar
@@ -483,9 +513,11 @@ static BOOL const kUseCalendarUI = YES;
         return;
     }
 
+    SCScheduleStatusService *statusService = [SCScheduleStatusService sharedService];
     for (SCBlockBundle *bundle in manager.bundles) {
-        BOOL allowed = [manager wouldBundleBeAllowed:bundle.bundleID];
-        NSString *statusStr = [manager statusStringForBundleID:bundle.bundleID];
+        SCBundleStatus *status = [statusService statusForBundleID:bundle.bundleID];
+        BOOL allowed = status ? status.isAllowed : YES;
+        NSString *statusStr = status.statusString ?: @"";
 
         // Skip bundles with no schedule for current week
         if (statusStr.length == 0) continue;
@@ -573,6 +605,12 @@ static BOOL const kUseCalendarUI = YES;
 
 - (void)updateCommitmentUI {
     SCScheduleManager *manager = [SCScheduleManager sharedManager];
+
+    if (self.commitProgress) {
+        [self updateCommitProgressUI];
+        return;
+    }
+    self.commitProgressIndicator.hidden = YES;
     BOOL isCommitted = [manager isCommittedForWeekOffset:self.currentWeekOffset];
 
     // Update emergency unlock button
@@ -676,6 +714,13 @@ static BOOL const kUseCalendarUI = YES;
 - (void)commitClicked:(id)sender {
     SCScheduleManager *manager = [SCScheduleManager sharedManager];
 
+    // While a commit is running, the commit button cancels it
+    if (self.commitProgress) {
+        [self.commitProgress cancel];
+        [self updateCommitProgressUI];
+        return;
+    }
+
     if (manager.bundles.count == 0) {
         NSAlert *alert = [[NSAlert alloc] init];
         alert.messageText = @"No Bundles";
@@ -762,15 +807,90 @@ static BOOL const kUseCalendarUI = YES;
         [self removeCmdQMonitor];
 
         if (returnCode == NSAlertFirstButtonReturn) {
-            [manager commitToWeekWithOffset:weekOffset];
-            [self reloadData];
-            // Restore focus after auth dialog closes
-            [self.window makeKeyAndOrderFront:nil];
-            [NSApp activateIgnoringOtherApps:YES];
+            [self beginCommitToWeekWithOffset:weekOffset];
         }
     }];
 }
 
+#pragma mark - Commit Progress
+
+/// The schedule can't be edited once committed, or while a commit is working from it
+- (BOOL)isEditingLockedForWeekOffset:(NSInteger)weekOffset {
+    return self.commitProgress != nil || [[SCScheduleManager sharedManager] isCommittedForWeekOffset:weekOffset];
+}
+
+- (void)beginCommitToWeekWithOffset:(NSInteger)weekOffset {
+    __weak typeof(self) weakSelf = self;
+    NSProgress *progress = [[SCScheduleManager sharedManager] commitToWeekWithOffset:weekOffset completion:^(NSError *error) {
+        [weakSelf commitDidFinishWithError:error];
+    }];
+
+    self.commitProgress = progress;
+    for (NSString *keyPath in @[@"fractionCompleted", @"localizedDescription", @"cancellable"]) {
+        [progress addObserver:self forKeyPath:keyPath options:0 context:kCommitProgressContext];
+    }
+    // locks the calendar until the commit finishes
+    [self reloadData];
+}
+
+- (void)stopObservingCommitProgress {
+    if (!self.commitProgress) return;
+    for (NSString *keyPath in @[@"fractionCompleted", @"localizedDescription", @"cancellable"]) {
+        [self.commitProgress removeObserver:self forKeyPath:keyPath context:kCommitProgressContext];
+    }
+    self.commitProgress = nil;
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath
+                      ofObject:(id)object
+                        change:(NSDictionary<NSKeyValueChangeKey, id> *)change
+                       context:(void *)context {
+    if (context != kCommitProgressContext) {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+
+    // The commit's stages report from a background queue
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (object == self.commitProgress) {
+            [self updateCommitProgressUI];
+        }
+    });
+}
+
+- (void)updateCommitProgressUI {
+    NSProgress *progress = self.commitProgress;
+    if (!progress) return;
+
+    self.commitProgressIndicator.hidden = NO;
+    self.commitProgressIndicator.doubleValue = progress.fractionCompleted;
+
+    if (progress.isCancelled) {
+        self.commitButton.title = @"Cancelling…";
+        self.commitButton.enabled = NO;
+    } else {
+        self.commitButton.title = @"Cancel";
+        self.commitButton.enabled = progress.isCancellable;
+    }
+    self.commitmentLabel.stringValue = progress.localizedDescription ?: @"";
+    self.commitmentLabel.textColor = [NSColor secondaryLabelColor];
+}
+
+- (void)commitDidFinishWithError:(nullable NSError *)error {
+    [self stopObservingCommitProgress];
+    [self reloadData];
+
+    // Restore focus after auth dialog closes
+    [self.window makeKeyAndOrderFront:nil];
+    [NSApp activateIgnoringOtherApps:YES];
+
+    BOOL cancelled = [error.domain isEqualToString:NSCocoaErrorDomain] && error.code == NSUserCancelledError;
+    if (error && !cancelled) {
+        NSAlert *alert = [NSAlert alertWithError:error];
+        [alert beginSheetModalForWindow:self.window completionHandler:nil];
+    }
+}
+
 #pragma mark - Cmd+Q Monitor for Alert Sheets
 
 - (void)setupCmdQMonitor {
@@ -921,6 +1041,7 @@ static BOOL const kUseCalendarUI = YES;
             [defaults removeObjectForKey:key];
         }
     }
+    [defaults removeObjectForKey:@"SCCommitmentWeekKeys"];
     [defaults removeObjectForKey:@"SCIsCommitted"];
     [defaults synchronize];
 
@@ -958,7 +1079,7 @@ static BOOL const kUseCalendarUI = YES;
     self.editingWeekOffset = self.currentWeekOffset;
 
     // Block opening editor when committed - schedule is locked
-    if ([manager isCommittedForWeekOffset:self.editingWeekOffset]) {
+    if ([self isEditingLockedForWeekOffset:self.editingWeekOffset]) {
         NSAlert *alert = [[NSAlert alloc] init];
         alert.messageText = @"Schedule Locked";
         alert.informativeText = @"You're committed to this week. The schedule cannot be modified.";
@@ -1100,7 +1221,7 @@ static BOOL const kUseCalendarUI = YES;
                                                                             schedule:schedule
                                                                                  day:day];
     self.dayEditorController.delegate = self;
-    self.dayEditorController.isCommitted = [manager isCommittedForWeekOffset:self.editingWeekOffset];
+    self.dayEditorController.isCommitted = [self isEditingLockedForWeekOffset:self.editingWeekOffset];
 
     [self.dayEditorController beginSheetModalForWindow:self.window completionHandler:nil];
 }
@@ -0,0 +1,269 @@
+//
+//  AllowlistScraperTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "AllowlistScraper.h"
+#import "SCBlockEntry.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Stands in for the sites on an allowlist: a minimal HTTP/1.1 server on 127.0.0.1 that
+// serves canned pages by path, keeps connections alive, can hold every response back for
+// a while, and counts connections and concurrent requests.
+@interface SCTestHTTPServer : NSObject
+
+@property (readonly) uint16_t port;
+@property (atomic) NSTimeInterval responseDelay;
+@property (readonly) NSUInteger connectionCount;
+@property (readonly) NSUInteger requestCount;
+@property (readonly) NSUInteger maxConcurrentRequests;
+
+- (void)setPage:(NSString*)html forPath:(NSString*)path;
+- (void)stop;
+
+@end
+
+@implementation SCTestHTTPServer {
+    dispatch_queue_t _queue;
+    int _listenSocket;
+    dispatch_source_t _acceptSource;
+    NSMutableArray<dispatch_source_t>* _connectionSources;
+    NSMutableIndexSet* _openConnections;
+    NSMutableDictionary<NSString*, NSString*>* _pages;
+    NSUInteger _inFlightRequests;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _queue = dispatch_queue_create("SCTestHTTPServer", DISPATCH_QUEUE_SERIAL);
+        _connectionSources = [NSMutableArray array];
+        _openConnections = [NSMutableIndexSet indexSet];
+        _pages = [NSMutableDictionary dictionary];
+
+        _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        struct sockaddr_in address = { .sin_len = sizeof(address), .sin_family = AF_INET, .sin_port = 0 };
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(_listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(_listenSocket, 64) != 0) {
+            close(_listenSocket);
+            return nil;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(_listenSocket, (struct sockaddr*)&address, &length);
+        _port = ntohs(address.sin_port);
+
+        _acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)_listenSocket, 0, _queue);
+        __weak SCTestHTTPServer* weakSelf = self;
+        dispatch_source_set_event_handler(_acceptSource, ^{
+            [weakSelf acceptConnection];
+        });
+        dispatch_resume(_acceptSource);
+    }
+    return self;
+}
+
+- (void)setPage:(NSString*)html forPath:(NSString*)path {
+    dispatch_sync(_queue, ^{
+        self->_pages[path] = html;
+    });
+}
+
+- (void)acceptConnection {
+    int connection = accept(_listenSocket, NULL, NULL);
+    if (connection < 0) return;
+    int noSigPipe = 1;
+    setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    [_openConnections addIndex: (NSUInteger)connection];
+    _connectionCount++;
+
+    NSMutableData* buffer = [NSMutableData data];
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)connection, 0, _queue);
+    __weak SCTestHTTPServer* weakSelf = self;
+    __weak dispatch_source_t weakSource = source;
+    NSMutableIndexSet* openConnections = _openConnections;
+    dispatch_source_set_event_handler(source, ^{
+        uint8_t bytes[4096];
+        ssize_t count = read(connection, bytes, sizeof(bytes));
+        if (count <= 0) {
+            dispatch_source_cancel(weakSource);
+            return;
+        }
+        [buffer appendBytes: bytes length: (NSUInteger)count];
+        [weakSelf handleRequestsInBuffer: buffer connection: connection];
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+        [openConnections removeIndex: (NSUInteger)connection];
+        close(connection);
+    });
+    [_connectionSources addObject: source];
+    dispatch_resume(source);
+}
+
+// Requests are GETs without bodies, so each one ends at its blank line
+- (void)handleRequestsInBuffer:(NSMutableData*)buffer connection:(int)connection {
+    NSData* terminator = [@"\r\n\r\n" dataUsingEncoding: NSUTF8StringEncoding];
+    NSRange end;
+    while ((end = [buffer rangeOfData: terminator options: 0 range: NSMakeRange(0, buffer.length)]).location != NSNotFound) {
+        NSString* head = [[NSString alloc] initWithData: [buffer subdataWithRange: NSMakeRange(0, end.location)] encoding: NSUTF8StringEncoding];
+        [buffer replaceBytesInRange: NSMakeRange(0, NSMaxRange(end)) withBytes: NULL length: 0];
+
+        NSArray<NSString*>* requestLine = [[head componentsSeparatedByString: @"\r\n"].firstObject componentsSeparatedByString: @" "];
+        NSString* path = requestLine.count > 1 ? requestLine[1] : @"/";
+        NSString* page = _pages[path];
+
+        _requestCount++;
+        _inFlightRequests++;
+        _maxConcurrentRequests = MAX(_maxConcurrentRequests, _inFlightRequests);
+
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.responseDelay * NSEC_PER_SEC)), _queue, ^{
+            NSData* body = [page ?: @"not found" dataUsingEncoding: NSUTF8StringEncoding];
+            NSString* header = [NSString stringWithFormat: @"HTTP/1.1 %@\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: %lu\r\nConnection: keep-alive\r\nCache-Control: no-store\r\n\r\n",
+                                page != nil ? @"200 OK" : @"404 Not Found", (unsigned long)body.length];
+            NSMutableData* response = [[header dataUsingEncoding: NSUTF8StringEncoding] mutableCopy];
+            [response appendData: body];
+            // the client may have given up (and the descriptor been reused) in the meantime
+            if ([self->_openConnections containsIndex: (NSUInteger)connection]) {
+                write(connection, response.bytes, response.length);
+            }
+            self->_inFlightRequests--;
+        });
+    }
+}
+
+- (void)stop {
+    dispatch_sync(_queue, ^{
+        dispatch_source_cancel(self->_acceptSource);
+        for (dispatch_source_t source in self->_connectionSources) {
+            dispatch_source_cancel(source);
+        }
+        [self->_connectionSources removeAllObjects];
+    });
+    close(_listenSocket);
+}
+
+@end
+
+@interface AllowlistScraperTests : XCTestCase
+
+@property (nonatomic, strong) SCTestHTTPServer* server;
+
+@end
+
+@implementation AllowlistScraperTests
+
+- (void)setUp {
+    self.server = [SCTestHTTPServer new];
+    XCTAssertNotNil(self.server);
+}
+
+- (void)tearDown {
+    [self.server stop];
+}
+
+// "domain" as the scraper takes it: the server's address, plus a path so each site gets its own page
+- (NSString*)domainForSite:(NSUInteger)site {
+    return [NSString stringWithFormat: @"127.0.0.1:%d/site%lu", self.server.port, (unsigned long)site];
+}
+
+- (void)serveSiteCount:(NSUInteger)count {
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString* html = [NSString stringWithFormat: @"<a href=\"https://cdn%lu.example.com/app.js\">x</a> <a href=\"https://twitter.com/share\">share</a> <a href=\"http://127.0.0.1/self\">self</a>", (unsigned long)i];
+        [self.server setPage: html forPath: [NSString stringWithFormat: @"/site%lu", (unsigned long)i]];
+    }
+}
+
+// scrapes every site, returning site -> hosts found
+- (NSDictionary<NSNumber*, NSSet<NSString*>*>*)scrapeSiteCount:(NSUInteger)count withScraper:(AllowlistScraper*)scraper {
+    NSMutableDictionary<NSNumber*, NSSet<NSString*>*>* results = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < count; i++) {
+        [scraper scrapeDomain: [self domainForSite: i] completionHandler:^(NSSet<SCBlockEntry*>* relatedEntries) {
+            @synchronized (results) {
+                results[@(i)] = [NSSet setWithArray: [[relatedEntries allObjects] valueForKey: @"hostname"]];
+            }
+        }];
+    }
+    [scraper waitUntilFinished];
+    return results;
+}
+
+- (void) testRelatedEntriesInHTML {
+    // only links in attributes count, not URLs in the text
+    NSString* html = @"<a href=\"http://docs.example.com/a\">docs</a> <a href=\"https://www.facebook.com/x\">like</a> <a href=\"http://example.com/\">home</a> <a href=\"ftp://files.example.com\">files</a> see http://blog.example.com";
+    NSSet<SCBlockEntry*>* entries = [AllowlistScraper relatedBlockEntriesInHTML: html rootHost: @"example.com"];
+    XCTAssertEqualObjects(entries, [NSSet setWithObject: [SCBlockEntry entryWithHostname: @"docs.example.com"]]);
+}
+
+- (void) testScrapesEverySiteWithBoundedConcurrencyAndReusedConnections {
+    [self serveSiteCount: 24];
+    self.server.responseDelay = 0.05;
+
+    AllowlistScraper* scraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: 4 timeLimit: 30];
+    NSDictionary<NSNumber*, NSSet<NSString*>*>* results = [self scrapeSiteCount: 24 withScraper: scraper];
+
+    XCTAssertEqual(results.count, 24);
+    for (NSUInteger i = 0; i < 24; i++) {
+        XCTAssertEqualObjects(results[@(i)], [NSSet setWithObject: [NSString stringWithFormat: @"cdn%lu.example.com", (unsigned long)i]]);
+    }
+    XCTAssertEqual(self.server.requestCount, 24);
+    XCTAssertLessThanOrEqual(self.server.maxConcurrentRequests, 4);
+    // keep-alive: far fewer connections than requests
+    XCTAssertLessThanOrEqual(self.server.connectionCount, 8);
+}
+
+- (void) testMissingPageCompletesWithNoEntries {
+    AllowlistScraper* scraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: 2 timeLimit: 30];
+    NSDictionary<NSNumber*, NSSet<NSString*>*>* results = [self scrapeSiteCount: 1 withScraper: scraper];
+    XCTAssertEqualObjects(results[@0], [NSSet set]);
+}
+
+- (void) testTimeLimitCoversTheWholeScrape {
+    [self serveSiteCount: 10];
+    self.server.responseDelay = 3;
+
+    AllowlistScraper* scraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: 2 timeLimit: 0.5];
+    NSDate* started = [NSDate date];
+    NSDictionary<NSNumber*, NSSet<NSString*>*>* results = [self scrapeSiteCount: 10 withScraper: scraper];
+
+    // every handler ran, empty-handed, long before even one response (let alone five rounds of them)
+    XCTAssertLessThan([[NSDate date] timeIntervalSinceDate: started], 2.0);
+    XCTAssertEqual(results.count, 10);
+    for (NSSet* hosts in results.allValues) {
+        XCTAssertEqual(hosts.count, 0);
+    }
+}
+
+- (void) testCancelFinishesQueuedAndRunningScrapes {
+    [self serveSiteCount: 10];
+    self.server.responseDelay = 3;
+
+    AllowlistScraper* scraper = [[AllowlistScraper alloc] initWithMaxConcurrentFetches: 2 timeLimit: 30];
+    __block NSUInteger finished = 0;
+    for (NSUInteger i = 0; i < 10; i++) {
+        [scraper scrapeDomain: [self domainForSite: i] completionHandler:^(NSSet<SCBlockEntry*>* relatedEntries) {
+            XCTAssertEqual(relatedEntries.count, 0);
+            @synchronized (self) {
+                finished++;
+            }
+        }];
+    }
+
+    NSDate* started = [NSDate date];
+    [scraper cancel];
+    [scraper waitUntilFinished];
+    XCTAssertLessThan([[NSDate date] timeIntervalSinceDate: started], 2.0);
+    XCTAssertEqual(finished, 10);
+
+    // and nothing starts after a cancel
+    __block BOOL lateScrapeFinished = NO;
+    [scraper scrapeDomain: [self domainForSite: 0] completionHandler:^(NSSet<SCBlockEntry*>* relatedEntries) {
+        lateScrapeFinished = (relatedEntries.count == 0);
+    }];
+    [scraper waitUntilFinished];
+    XCTAssert(lateScrapeFinished);
+}
+
+@end
@@ -0,0 +1,156 @@
+//
+//  SCBlocklistStoreTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCBlocklistStore.h"
+#import "SCScheduleTimeline.h"
+
+@interface SCBlocklistStoreTests : XCTestCase
+
+@end
+
+@implementation SCBlocklistStoreTests
+
+- (NSArray<NSString*>*)blocklistWithCount:(NSUInteger)count prefix:(NSString*)prefix {
+    NSMutableArray<NSString*>* blocklist = [NSMutableArray arrayWithCapacity: count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [blocklist addObject: [NSString stringWithFormat: @"%@%lu.example.com", prefix, (unsigned long)i]];
+    }
+    return blocklist;
+}
+
+// A week of segments cycling through a few bundle combinations, as ApprovedSchedules
+// entries that carry their blocklist inline
+- (NSDictionary<NSString*, NSDictionary*>*)inlineApprovedSchedulesWithSegmentCount:(NSUInteger)segmentCount
+                                                                        combinations:(NSArray<NSArray<NSString*>*>*)combinations {
+    NSMutableDictionary<NSString*, NSDictionary*>* schedules = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < segmentCount; i++) {
+        schedules[[NSString stringWithFormat: @"segment-%lu", (unsigned long)i]] = @{
+            @"blocklist": combinations[i % combinations.count],
+            @"isAllowlist": @NO,
+            @"blockSettings": @{ @"ClearCaches": @NO }
+        };
+    }
+    return schedules;
+}
+
+- (void) testDigestIgnoresOrderAndDuplicates {
+    NSString* digest = [SCBlocklistStore digestForBlocklist: @[@"a.com", @"b.com", @"c.com"]];
+    XCTAssertEqual(digest.length, 32);
+    XCTAssertEqualObjects([SCBlocklistStore digestForBlocklist: @[@"c.com", @"a.com", @"b.com", @"a.com"]], digest);
+    XCTAssertNotEqualObjects([SCBlocklistStore digestForBlocklist: @[@"a.com", @"b.com"]], digest);
+
+    // segments' content hashes are the same digests the store uses
+    XCTAssertEqualObjects([SCScheduleTimeline contentHashForBlocklist: @[@"b.com", @"c.com", @"a.com"]], digest);
+}
+
+- (void) testStoresEachBlocklistOnce {
+    SCBlocklistStore* store = [[SCBlocklistStore alloc] init];
+    NSString* first = [store addBlocklist: @[@"b.com", @"a.com"]];
+    NSString* second = [store addBlocklist: @[@"a.com", @"b.com", @"b.com"]];
+    NSString* other = [store addBlocklist: @[@"c.com"]];
+
+    XCTAssertEqualObjects(first, second);
+    XCTAssertNotEqualObjects(first, other);
+    XCTAssertEqual(store.count, 2);
+    XCTAssertEqualObjects([store blocklistForDigest: first], (@[@"a.com", @"b.com"]));
+
+    // and it round-trips through its settings representation
+    SCBlocklistStore* reloaded = [[SCBlocklistStore alloc] initWithBlocklists: store.blocklists];
+    XCTAssertEqualObjects([reloaded blocklistForDigest: other], @[@"c.com"]);
+}
+
+- (void) testRejectsBlocklistsThatDontMatchTheirDigest {
+    SCBlocklistStore* store = [[SCBlocklistStore alloc] init];
+    NSArray<NSString*>* blocklist = @[@"a.com", @"b.com"];
+    NSString* digest = [SCBlocklistStore digestForBlocklist: blocklist];
+
+    XCTAssertFalse([store addBlocklist: @[@"a.com", @"evil.com"] withDigest: digest]);
+    XCTAssertFalse([store addBlocklist: (NSArray*)@[@1, @2] withDigest: digest]);
+    XCTAssertEqual(store.count, 0);
+
+    XCTAssert([store addBlocklist: @[@"b.com", @"a.com"] withDigest: digest]);
+    XCTAssertEqualObjects([store blocklistForDigest: digest], blocklist);
+}
+
+- (void) testGarbageCollectsUnreferencedBlocklists {
+    SCBlocklistStore* store = [[SCBlocklistStore alloc] init];
+    NSString* shared = [store addBlocklist: @[@"shared.com"]];
+    NSString* single = [store addBlocklist: @[@"single.com"]];
+    [store addBlocklist: @[@"orphan.com"]];
+
+    NSMutableDictionary* approvedSchedules = [@{
+        @"one": @{ @"blocklistDigest": shared },
+        @"two": @{ @"blocklistDigest": shared },
+        @"three": @{ @"blocklistDigest": single },
+        @"legacy": @{ @"blocklist": @[@"inline.com"] }
+    } mutableCopy];
+
+    NSCountedSet* counts = [SCBlocklistStore referenceCountsForApprovedSchedules: approvedSchedules];
+    XCTAssertEqual([counts countForObject: shared], 2);
+    XCTAssertEqual([counts countForObject: single], 1);
+
+    XCTAssertEqual([store removeBlocklistsUnreferencedByApprovedSchedules: approvedSchedules], 1);
+    XCTAssertEqual(store.count, 2);
+
+    // still referenced once
+    [approvedSchedules removeObjectForKey: @"one"];
+    XCTAssertEqual([store removeBlocklistsUnreferencedByApprovedSchedules: approvedSchedules], 0);
+    XCTAssertNotNil([store blocklistForDigest: shared]);
+
+    [approvedSchedules removeObjectForKey: @"two"];
+    [approvedSchedules removeObjectForKey: @"three"];
+    XCTAssertEqual([store removeBlocklistsUnreferencedByApprovedSchedules: approvedSchedules], 2);
+    XCTAssertEqual(store.count, 0);
+}
+
+- (void) testResolvesDigestAndInlineSchedules {
+    SCBlocklistStore* store = [[SCBlocklistStore alloc] init];
+    NSString* digest = [store addBlocklist: @[@"a.com"]];
+
+    XCTAssertEqualObjects([SCBlocklistStore blocklistForApprovedSchedule: @{ @"blocklistDigest": digest } inBlocklists: store.blocklists], @[@"a.com"]);
+    XCTAssertEqualObjects([SCBlocklistStore blocklistForApprovedSchedule: @{ @"blocklist": @[@"b.com"] } inBlocklists: store.blocklists], @[@"b.com"]);
+    XCTAssertNil([SCBlocklistStore blocklistForApprovedSchedule: @{ @"blocklistDigest": @"missing" } inBlocklists: store.blocklists]);
+    XCTAssertNil([SCBlocklistStore blocklistForApprovedSchedule: @{} inBlocklists: nil]);
+}
+
+// A week's worth of segments over a handful of bundle combinations should cost about
+// one copy per combination in settings, not one per segment
+- (void) testSettingsSizeWithSharedBlocklists {
+    NSArray<NSArray<NSString*>*>* combinations = @[
+        [self blocklistWithCount: 300 prefix: @"social"],
+        [self blocklistWithCount: 500 prefix: @"news"],
+        [[self blocklistWithCount: 300 prefix: @"social"] arrayByAddingObjectsFromArray: [self blocklistWithCount: 500 prefix: @"news"]]
+    ];
+    NSDictionary<NSString*, NSDictionary*>* inlineSchedules = [self inlineApprovedSchedulesWithSegmentCount: 42 combinations: combinations];
+
+    SCBlocklistStore* store = [[SCBlocklistStore alloc] init];
+    NSMutableDictionary<NSString*, NSDictionary*>* digestSchedules = [NSMutableDictionary dictionary];
+    for (NSString* segmentID in inlineSchedules) {
+        NSMutableDictionary* schedule = [inlineSchedules[segmentID] mutableCopy];
+        schedule[@"blocklistDigest"] = [store addBlocklist: schedule[@"blocklist"]];
+        [schedule removeObjectForKey: @"blocklist"];
+        digestSchedules[segmentID] = schedule;
+    }
+    XCTAssertEqual(store.count, combinations.count);
+
+    NSData* inlineData = [NSPropertyListSerialization dataWithPropertyList: @{ @"ApprovedSchedules": inlineSchedules }
+                                                                    format: NSPropertyListBinaryFormat_v1_0 options: 0 error: nil];
+    NSData* storeData = [NSPropertyListSerialization dataWithPropertyList: @{ @"ApprovedSchedules": digestSchedules, @"ApprovedBlocklists": store.blocklists }
+                                                                   format: NSPropertyListBinaryFormat_v1_0 options: 0 error: nil];
+    NSLog(@"ApprovedSchedules for 42 segments: %lu bytes inline, %lu bytes with shared blocklists",
+          (unsigned long)inlineData.length, (unsigned long)storeData.length);
+
+    // binary plists already unique identical strings, so the saving is in the references
+    // to them; the XML the settings are synced as shows the full difference
+    XCTAssertLessThan(storeData.length, inlineData.length);
+    NSData* inlineXML = [NSPropertyListSerialization dataWithPropertyList: @{ @"ApprovedSchedules": inlineSchedules }
+                                                                   format: NSPropertyListXMLFormat_v1_0 options: 0 error: nil];
+    NSData* storeXML = [NSPropertyListSerialization dataWithPropertyList: @{ @"ApprovedSchedules": digestSchedules, @"ApprovedBlocklists": store.blocklists }
+                                                                  format: NSPropertyListXMLFormat_v1_0 options: 0 error: nil];
+    XCTAssertLessThan(storeXML.length * 5, inlineXML.length);
+}
+
+@end
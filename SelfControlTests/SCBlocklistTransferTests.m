@@ -0,0 +1,124 @@
+//
+//  SCBlocklistTransferTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCBlocklistTransfer.h"
+#import "SCBlocklistStore.h"
+#include <fcntl.h>
+
+@interface SCBlocklistTransferTests : XCTestCase
+
+@end
+
+@implementation SCBlocklistTransferTests
+
+- (NSArray<NSString*>*)blocklistWithCount:(NSUInteger)count {
+    NSMutableArray<NSString*>* blocklist = [NSMutableArray arrayWithCapacity: count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [blocklist addObject: [NSString stringWithFormat: @"site%lu.example.com", (unsigned long)i]];
+    }
+    return blocklist;
+}
+
+- (void) testRoundTrip {
+    NSArray<NSString*>* blocklist = @[@"b.com", @"a.com", @"b.com", @"app:com.apple.Terminal", @"10.0.0.0/8"];
+    NSError* err = nil;
+    NSFileHandle* fileHandle = [SCBlocklistTransfer fileHandleForBlocklist: blocklist isAllowlist: YES error: &err];
+    XCTAssertNotNil(fileHandle, @"%@", err);
+
+    // what gets sent is read-only
+    XCTAssertEqual(fcntl(fileHandle.fileDescriptor, F_GETFL) & O_ACCMODE, O_RDONLY);
+
+    BOOL isAllowlist = NO;
+    NSArray<NSString*>* received = [SCBlocklistTransfer blocklistFromFileHandle: fileHandle
+                                                                         digest: [SCBlocklistStore digestForBlocklist: blocklist]
+                                                                    isAllowlist: &isAllowlist
+                                                                          error: &err];
+    XCTAssertEqualObjects(received, [SCBlocklistStore canonicalBlocklist: blocklist], @"%@", err);
+    XCTAssert(isAllowlist);
+}
+
+- (void) testRejectsWrongDigest {
+    NSArray<NSString*>* blocklist = @[@"a.com", @"b.com"];
+    NSFileHandle* fileHandle = [SCBlocklistTransfer fileHandleForBlocklist: blocklist isAllowlist: NO error: nil];
+
+    NSError* err = nil;
+    XCTAssertNil([SCBlocklistTransfer blocklistFromFileHandle: fileHandle
+                                                       digest: [SCBlocklistStore digestForBlocklist: @[@"a.com"]]
+                                                  isAllowlist: NULL
+                                                        error: &err]);
+    XCTAssertEqualObjects(err.domain, @"SCBlocklistTransfer");
+    XCTAssertEqual(err.code, 2);
+}
+
+- (void) testRejectsNonRegularFile {
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    NSFileHandle* readEnd = [[NSFileHandle alloc] initWithFileDescriptor: fds[0] closeOnDealloc: YES];
+    close(fds[1]);
+
+    NSError* err = nil;
+    XCTAssertNil([SCBlocklistTransfer blocklistFromFileHandle: readEnd digest: @"" isAllowlist: NULL error: &err]);
+    XCTAssertEqual(err.code, 1);
+}
+
+- (void) testThreshold {
+    XCTAssertFalse([SCBlocklistTransfer shouldTransferBlocklist: [self blocklistWithCount: SCBlocklistTransferMinimumCount - 1]]);
+    XCTAssert([SCBlocklistTransfer shouldTransferBlocklist: [self blocklistWithCount: SCBlocklistTransferMinimumCount]]);
+}
+
+#pragma mark - Performance
+
+// Both sides of each path, without the XPC hop itself: an archived array is what NSXPC
+// secure-codes for the array methods, and the file path is encode, write, map and decode.
+
+- (void)measureArchivedArrayWithCount:(NSUInteger)count {
+    NSArray<NSString*>* blocklist = [self blocklistWithCount: count];
+    NSSet* allowedClasses = [NSSet setWithObjects: [NSArray class], [NSString class], nil];
+
+    [self measureBlock:^{
+        NSData* message = [NSKeyedArchiver archivedDataWithRootObject: blocklist requiringSecureCoding: YES error: nil];
+        NSArray* received = [NSKeyedUnarchiver unarchivedObjectOfClasses: allowedClasses fromData: message error: nil];
+        XCTAssertEqual(received.count, count);
+    }];
+}
+
+- (void)measureTransferFileWithCount:(NSUInteger)count {
+    NSArray<NSString*>* blocklist = [self blocklistWithCount: count];
+
+    [self measureBlock:^{
+        // the digest is part of what the sender pays
+        NSString* digest = [SCBlocklistStore digestForBlocklist: blocklist];
+        NSFileHandle* fileHandle = [SCBlocklistTransfer fileHandleForBlocklist: blocklist isAllowlist: NO error: nil];
+        NSArray* received = [SCBlocklistTransfer blocklistFromFileHandle: fileHandle digest: digest isAllowlist: NULL error: nil];
+        XCTAssertEqual(received.count, count);
+    }];
+}
+
+- (void) testPerformanceArchivedArray1k {
+    [self measureArchivedArrayWithCount: 1000];
+}
+
+- (void) testPerformanceTransferFile1k {
+    [self measureTransferFileWithCount: 1000];
+}
+
+- (void) testPerformanceArchivedArray10k {
+    [self measureArchivedArrayWithCount: 10000];
+}
+
+- (void) testPerformanceTransferFile10k {
+    [self measureTransferFileWithCount: 10000];
+}
+
+- (void) testPerformanceArchivedArray100k {
+    [self measureArchivedArrayWithCount: 100000];
+}
+
+- (void) testPerformanceTransferFile100k {
+    [self measureTransferFileWithCount: 100000];
+}
+
+@end
@@ -0,0 +1,244 @@
+//
+//  SCCalendarLaneLayoutTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCCalendarLaneLayout.h"
+#import "SCIntervalSet.h"
+
+// Start minute of a dragged 90-minute block at each mouseDragged: event of a move gesture,
+// recorded from a day column and already snapped to the 15-minute grid the column uses.
+// The block starts at 9:00, is dragged down past lunch, hesitates, then comes back to 10:30.
+static const NSInteger kRecordedDragStarts[] = {
+    540, 540, 540, 555, 555, 555, 570, 570, 585, 585, 600, 600, 615, 630, 630, 645,
+    660, 675, 675, 690, 705, 720, 720, 735, 750, 765, 765, 780, 780, 795, 795, 795,
+    795, 795, 780, 780, 780, 765, 765, 750, 735, 735, 720, 720, 705, 690, 690, 675,
+    675, 660, 660, 645, 645, 645, 630, 630, 630, 630, 630, 630, 630, 630, 630, 630
+};
+
+@interface SCCalendarLaneLayoutTests : XCTestCase
+
+@end
+
+@implementation SCCalendarLaneLayoutTests
+
+// Lanes and overlaps recomputed from scratch, as the day column did before the layout engine:
+// a sweep over every block for maxOverlap and greedy packing of all of them for lanes
+- (NSDictionary<NSString *, NSArray<NSNumber *> *> *)referenceLayoutForBlocks:(NSDictionary<NSString *, NSArray<NSNumber *> *> *)blocks {
+    NSMutableDictionary<NSString *, NSNumber *> *maxOverlaps = [NSMutableDictionary dictionary];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSString *key in blocks) {
+        maxOverlaps[key] = @1;
+        [events addObject:@[blocks[key][0], @0, key]];
+        [events addObject:@[blocks[key][1], @1, key]];
+    }
+    [events sortUsingComparator:^NSComparisonResult(NSArray *a, NSArray *b) {
+        NSComparisonResult timeCompare = [a[0] compare:b[0]];
+        if (timeCompare != NSOrderedSame) return timeCompare;
+        return [b[1] compare:a[1]];
+    }];
+    NSMutableSet<NSString *> *active = [NSMutableSet set];
+    for (NSArray *event in events) {
+        if ([event[1] integerValue] == 0) {
+            [active addObject:event[2]];
+            for (NSString *key in active) {
+                if ([maxOverlaps[key] integerValue] < (NSInteger)active.count) maxOverlaps[key] = @(active.count);
+            }
+        } else {
+            [active removeObject:event[2]];
+        }
+    }
+
+    // displayOrder, then start, then order
+    NSArray<NSString *> *packingOrder = [blocks.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *a, NSString *b) {
+        for (NSNumber *field in @[@2, @0, @3]) {
+            NSComparisonResult result = [blocks[a][field.integerValue] compare:blocks[b][field.integerValue]];
+            if (result != NSOrderedSame) return result;
+        }
+        return NSOrderedSame;
+    }];
+    NSMutableArray<SCIntervalSet *> *lanes = [NSMutableArray array];
+    NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *layout = [NSMutableDictionary dictionary];
+    for (NSString *key in packingOrder) {
+        NSInteger start = [blocks[key][0] integerValue];
+        NSRange minutes = NSMakeRange(start, [blocks[key][1] integerValue] - start);
+        NSInteger lane = -1;
+        for (NSInteger i = 0; i < (NSInteger)lanes.count; i++) {
+            if (![lanes[i] intersectsInterval:minutes]) {
+                lanes[i] = [lanes[i] setByAddingInterval:minutes];
+                lane = i;
+                break;
+            }
+        }
+        if (lane == -1) {
+            [lanes addObject:[SCIntervalSet setWithInterval:minutes]];
+            lane = lanes.count - 1;
+        }
+        layout[key] = @[@(lane), maxOverlaps[key]];
+    }
+    return layout;
+}
+
+- (void)assertLayout:(SCCalendarLaneLayout *)layout matchesReferenceForBlocks:(NSDictionary<NSString *, NSArray<NSNumber *> *> *)blocks {
+    NSDictionary<NSString *, NSArray<NSNumber *> *> *reference = [self referenceLayoutForBlocks:blocks];
+    XCTAssertEqual(layout.blockCount, blocks.count);
+    for (NSString *key in blocks) {
+        NSInteger laneSlot = -1, maxOverlap = -1;
+        XCTAssert([layout getLaneSlot:&laneSlot maxOverlap:&maxOverlap forKey:key]);
+        XCTAssertEqual(laneSlot, [reference[key][0] integerValue], @"lane of %@", key);
+        XCTAssertEqual(maxOverlap, [reference[key][1] integerValue], @"overlap of %@", key);
+    }
+}
+
+// blocks: key -> @[start, end, displayOrder, order]
+- (void)setBlocks:(NSDictionary<NSString *, NSArray<NSNumber *> *> *)blocks inLayout:(SCCalendarLaneLayout *)layout {
+    [layout beginUpdates];
+    for (NSString *key in blocks) {
+        [layout setBlockForKey:key
+                  startMinutes:[blocks[key][0] integerValue]
+                    endMinutes:[blocks[key][1] integerValue]
+                  displayOrder:[blocks[key][2] integerValue]
+                         order:[blocks[key][3] integerValue]];
+    }
+    [layout endUpdates];
+}
+
+// A day column: bundleCount bundles, each with a morning and an evening window
+- (NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *)dayWithBundleCount:(NSUInteger)bundleCount {
+    NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *blocks = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < bundleCount; i++) {
+        NSInteger morning = 360 + (i % 8) * 30;
+        NSInteger evening = 1080 + (i % 5) * 45;
+        blocks[[NSString stringWithFormat:@"b%lu:0", (unsigned long)i]] = @[@(morning), @(morning + 120), @(i), @(i)];
+        blocks[[NSString stringWithFormat:@"b%lu:1", (unsigned long)i]] = @[@(evening), @(evening + 90), @(i), @(i)];
+    }
+    return blocks;
+}
+
+- (void) testTouchingBlocksShareALane {
+    SCCalendarLaneLayout *layout = [[SCCalendarLaneLayout alloc] init];
+    NSDictionary *blocks = @{
+        @"a": @[@540, @600, @0, @0],
+        @"b": @[@600, @660, @1, @1],
+        @"c": @[@570, @630, @2, @2]
+    };
+    [self setBlocks:blocks inLayout:layout];
+    [self assertLayout:layout matchesReferenceForBlocks:blocks];
+
+    NSInteger laneSlot, maxOverlap;
+    [layout getLaneSlot:&laneSlot maxOverlap:&maxOverlap forKey:@"b"];
+    XCTAssertEqual(laneSlot, 0);
+    XCTAssertEqual(maxOverlap, 2);
+    XCTAssertFalse([layout getLaneSlot:NULL maxOverlap:NULL forKey:@"missing"]);
+}
+
+- (void) testUnchangedUpdateRelaysOutNothing {
+    SCCalendarLaneLayout *layout = [[SCCalendarLaneLayout alloc] init];
+    NSDictionary *blocks = [self dayWithBundleCount:20];
+    [self setBlocks:blocks inLayout:layout];
+    XCTAssertEqual(layout.lastRelayoutBlockCount, blocks.count);
+
+    [self setBlocks:blocks inLayout:layout];
+    XCTAssertEqual(layout.lastRelayoutBlockCount, 0);
+}
+
+- (void) testMoveOnlyRelaysOutTouchedClusters {
+    SCCalendarLaneLayout *layout = [[SCCalendarLaneLayout alloc] init];
+    NSMutableDictionary *blocks = [@{
+        // morning cluster
+        @"m1": @[@480, @600, @0, @0],
+        @"m2": @[@540, @660, @1, @1],
+        // afternoon cluster
+        @"a1": @[@780, @840, @0, @0],
+        @"a2": @[@800, @900, @1, @1],
+        @"a3": @[@880, @960, @2, @2],
+        // evening, on its own
+        @"e1": @[@1200, @1260, @0, @0]
+    } mutableCopy];
+    [self setBlocks:blocks inLayout:layout];
+
+    // within the afternoon
+    blocks[@"a3"] = @[@890, @970, @2, @2];
+    [self setBlocks:blocks inLayout:layout];
+    XCTAssertEqual(layout.lastRelayoutBlockCount, 3);
+    [self assertLayout:layout matchesReferenceForBlocks:blocks];
+
+    // out of the afternoon and into the evening: both clusters, the morning is untouched
+    blocks[@"a3"] = @[@1230, @1290, @2, @2];
+    [self setBlocks:blocks inLayout:layout];
+    XCTAssertEqual(layout.lastRelayoutBlockCount, 4);
+    [self assertLayout:layout matchesReferenceForBlocks:blocks];
+
+    // blocks not set in a batch are removed
+    [blocks removeObjectForKey:@"m2"];
+    [self setBlocks:blocks inLayout:layout];
+    XCTAssertEqual(layout.lastRelayoutBlockCount, 1);
+    [self assertLayout:layout matchesReferenceForBlocks:blocks];
+}
+
+- (void) testRandomUpdatesMatchFullRecompute {
+    SCCalendarLaneLayout *layout = [[SCCalendarLaneLayout alloc] init];
+    NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *blocks = [NSMutableDictionary dictionary];
+    srandom(42);
+
+    for (int round = 0; round < 300; round++) {
+        NSString *key = [NSString stringWithFormat:@"k%ld", random() % 40];
+        if (random() % 5 == 0) {
+            [blocks removeObjectForKey:key];
+            [layout removeBlockForKey:key];
+        } else {
+            NSInteger start = (random() % 96) * 15;
+            NSInteger end = MIN(start + 15 * (1 + random() % 16), 1440);
+            NSInteger displayOrder = random() % 10;
+            blocks[key] = @[@(start), @(end), @(displayOrder), @([[key substringFromIndex:1] integerValue])];
+            [layout setBlockForKey:key startMinutes:start endMinutes:end displayOrder:displayOrder order:[blocks[key][3] integerValue]];
+        }
+        [self assertLayout:layout matchesReferenceForBlocks:blocks];
+    }
+}
+
+#pragma mark - Performance
+
+// Replays the recorded gesture as a day column would: every mouseDragged: event sets
+// every block, with the dragged one at its new position, then reads back every lane
+- (void)replayRecordedDragInLayout:(SCCalendarLaneLayout *(^)(void))layoutForFrame blocks:(NSDictionary<NSString *, NSArray<NSNumber *> *> *)blocks {
+    NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *frameBlocks = [blocks mutableCopy];
+    NSArray<NSNumber *> *dragged = blocks[@"b0:0"];
+
+    for (size_t i = 0; i < sizeof(kRecordedDragStarts) / sizeof(kRecordedDragStarts[0]); i++) {
+        NSInteger start = kRecordedDragStarts[i];
+        frameBlocks[@"b0:0"] = @[@(start), @(start + 90), dragged[2], dragged[3]];
+
+        SCCalendarLaneLayout *layout = layoutForFrame();
+        [self setBlocks:frameBlocks inLayout:layout];
+        for (NSString *key in frameBlocks) {
+            [layout getLaneSlot:NULL maxOverlap:NULL forKey:key];
+        }
+    }
+}
+
+- (void) testPerformanceRecordedDragIncremental {
+    NSDictionary *blocks = [self dayWithBundleCount:40];
+    SCCalendarLaneLayout *layout = [[SCCalendarLaneLayout alloc] init];
+    [self setBlocks:blocks inLayout:layout];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [self replayRecordedDragInLayout:^SCCalendarLaneLayout *{ return layout; } blocks:blocks];
+        }
+    }];
+}
+
+// The same gesture with every frame laid out from scratch, as before the layout engine
+- (void) testPerformanceRecordedDragFullRecompute {
+    NSDictionary *blocks = [self dayWithBundleCount:40];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [self replayRecordedDragInLayout:^SCCalendarLaneLayout *{ return [[SCCalendarLaneLayout alloc] init]; } blocks:blocks];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,195 @@
+//
+//  SCCompactBlocklistTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCCompactBlocklist.h"
+#import "SCBlockFileReaderWriter.h"
+
+@interface SCCompactBlocklistTests : XCTestCase
+
+@property (nonatomic, strong) NSURL* directoryURL;
+
+@end
+
+@implementation SCCompactBlocklistTests
+
+- (void)setUp {
+    self.directoryURL = [[NSURL fileURLWithPath: NSTemporaryDirectory()] URLByAppendingPathComponent: [[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtURL: self.directoryURL withIntermediateDirectories: YES attributes: nil error: nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtURL: self.directoryURL error: nil];
+}
+
+- (NSArray<NSString*>*)blocklistWithCount:(NSUInteger)count {
+    NSMutableArray<NSString*>* blocklist = [NSMutableArray arrayWithCapacity: count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [blocklist addObject: [NSString stringWithFormat: @"site%lu.example.com", (unsigned long)i]];
+    }
+    return blocklist;
+}
+
+- (void) testRoundTripSortsAndDeduplicates {
+    NSData* data = [SCCompactBlocklist dataWithBlocklist: @[@"b.com", @"a.com", @"b.com", @"app:com.apple.Terminal", @"10.0.0.0/8", @"c.com:443"]
+                                              isAllowlist: NO];
+    XCTAssert([SCCompactBlocklist isCompactBlocklistData: data]);
+
+    NSError* err = nil;
+    SCCompactBlocklist* blocklist = [SCCompactBlocklist blocklistWithData: data error: &err];
+    XCTAssertNotNil(blocklist, @"%@", err);
+    XCTAssertFalse(blocklist.isAllowlist);
+    XCTAssertEqual(blocklist.count, 5);
+    XCTAssertEqualObjects([blocklist allEntries], (@[@"10.0.0.0/8", @"a.com", @"app:com.apple.Terminal", @"b.com", @"c.com:443"]));
+
+    XCTAssertEqual([blocklist kindOfEntryAtIndex: 0], SCCompactBlocklistEntryKindNetwork);
+    XCTAssertEqual([blocklist kindOfEntryAtIndex: 1], SCCompactBlocklistEntryKindHost);
+    XCTAssertEqual([blocklist kindOfEntryAtIndex: 2], SCCompactBlocklistEntryKindApp);
+    XCTAssertEqual([blocklist kindOfEntryAtIndex: 4], SCCompactBlocklistEntryKindNetwork);
+    XCTAssertNil([blocklist entryAtIndex: 5]);
+}
+
+- (void) testAllowlistFlagAndEmptyList {
+    SCCompactBlocklist* blocklist = [SCCompactBlocklist blocklistWithData: [SCCompactBlocklist dataWithBlocklist: @[] isAllowlist: YES] error: nil];
+    XCTAssertNotNil(blocklist);
+    XCTAssert(blocklist.isAllowlist);
+    XCTAssertEqual(blocklist.count, 0);
+    XCTAssertFalse([blocklist containsEntry: @"a.com"]);
+}
+
+- (void) testContainsEntryIncludingNonASCII {
+    NSArray<NSString*>* entries = @[@"zebra.com", @"bücher.de", @"apple.com", @"例え.jp", @"b.com"];
+    SCCompactBlocklist* blocklist = [SCCompactBlocklist blocklistWithData: [SCCompactBlocklist dataWithBlocklist: entries isAllowlist: NO] error: nil];
+
+    for (NSString* entry in entries) {
+        XCTAssert([blocklist containsEntry: entry], @"missing %@", entry);
+    }
+    XCTAssertFalse([blocklist containsEntry: @"bucher.de"]);
+    XCTAssertFalse([blocklist containsEntry: @"apple.co"]);
+    XCTAssertFalse([blocklist containsEntry: @""]);
+}
+
+- (void) testEnumerationCanStopEarly {
+    SCCompactBlocklist* blocklist = [SCCompactBlocklist blocklistWithData: [SCCompactBlocklist dataWithBlocklist: [self blocklistWithCount: 100] isAllowlist: NO] error: nil];
+
+    __block NSUInteger visited = 0;
+    [blocklist enumerateEntriesUsingBlock:^(NSString* entry, SCCompactBlocklistEntryKind kind, BOOL* stop) {
+        XCTAssertEqual(kind, SCCompactBlocklistEntryKindHost);
+        if (++visited == 10) *stop = YES;
+    }];
+    XCTAssertEqual(visited, 10);
+}
+
+- (void) testRejectsMalformedData {
+    NSError* err = nil;
+    XCTAssertNil([SCCompactBlocklist blocklistWithData: [@"not a blocklist" dataUsingEncoding: NSUTF8StringEncoding] error: &err]);
+    XCTAssertEqual(err.code, 1);
+
+    NSMutableData* data = [[SCCompactBlocklist dataWithBlocklist: [self blocklistWithCount: 50] isAllowlist: NO] mutableCopy];
+
+    NSMutableData* futureVersion = [data mutableCopy];
+    uint16_t version = CFSwapInt16HostToLittle(99);
+    [futureVersion replaceBytesInRange: NSMakeRange(4, 2) withBytes: &version];
+    XCTAssertNil([SCCompactBlocklist blocklistWithData: futureVersion error: &err]);
+    XCTAssertEqual(err.code, 2);
+
+    NSData* truncated = [data subdataWithRange: NSMakeRange(0, data.length - 10)];
+    XCTAssertNil([SCCompactBlocklist blocklistWithData: truncated error: &err]);
+    XCTAssertEqual(err.code, 3);
+
+    // an offset pointing past the string table only loses that entry
+    uint32_t offsetsOffset;
+    [data getBytes: &offsetsOffset range: NSMakeRange(16, 4)];
+    offsetsOffset = CFSwapInt32LittleToHost(offsetsOffset);
+    uint32_t badOffset = CFSwapInt32HostToLittle(UINT32_MAX);
+    [data replaceBytesInRange: NSMakeRange(offsetsOffset + 4, 4) withBytes: &badOffset];
+    SCCompactBlocklist* corrupt = [SCCompactBlocklist blocklistWithData: data error: nil];
+    XCTAssertNotNil(corrupt);
+    XCTAssertNil([corrupt entryAtIndex: 0]);
+    XCTAssertNil([corrupt entryAtIndex: 1]);
+    XCTAssertNotNil([corrupt entryAtIndex: 2]);
+}
+
+- (void) testFileReaderAcceptsBothFormats {
+    NSArray<NSString*>* entries = @[@"b.com", @"a.com"];
+    NSURL* plistURL = [self.directoryURL URLByAppendingPathComponent: @"plist.selfcontrol"];
+    NSURL* compactURL = [self.directoryURL URLByAppendingPathComponent: @"compact.selfcontrol"];
+    NSDictionary* blockInfo = @{ @"Blocklist": entries, @"BlockAsWhitelist": @YES };
+
+    NSError* err = nil;
+    XCTAssert([SCBlockFileReaderWriter writeBlocklistToFileURL: plistURL blockInfo: blockInfo error: &err]);
+    XCTAssert([SCBlockFileReaderWriter writeCompactBlocklistToFileURL: compactURL blockInfo: blockInfo error: &err]);
+
+    NSDictionary* fromPlist = [SCBlockFileReaderWriter readBlocklistFromFile: plistURL];
+    XCTAssertEqualObjects(fromPlist[@"Blocklist"], entries);
+    XCTAssertEqualObjects(fromPlist[@"BlockAsWhitelist"], @YES);
+
+    NSDictionary* fromCompact = [SCBlockFileReaderWriter readBlocklistFromFile: compactURL];
+    XCTAssertEqualObjects(fromCompact[@"Blocklist"], (@[@"a.com", @"b.com"]));
+    XCTAssertEqualObjects(fromCompact[@"BlockAsWhitelist"], @YES);
+
+    NSURL* garbageURL = [self.directoryURL URLByAppendingPathComponent: @"garbage.selfcontrol"];
+    [[@"SCBL" dataUsingEncoding: NSUTF8StringEncoding] writeToURL: garbageURL atomically: YES];
+    XCTAssertNil([SCBlockFileReaderWriter readBlocklistFromFile: garbageURL]);
+}
+
+#pragma mark - Performance
+
+// 100k entries, about the size of a large imported hosts list
+
+- (void) testPerformanceWritePlist100k {
+    NSArray<NSString*>* entries = [self blocklistWithCount: 100000];
+    NSURL* fileURL = [self.directoryURL URLByAppendingPathComponent: @"plist.selfcontrol"];
+
+    [self measureBlock:^{
+        [SCBlockFileReaderWriter writeBlocklistToFileURL: fileURL blockInfo: @{ @"Blocklist": entries, @"BlockAsWhitelist": @NO } error: nil];
+    }];
+}
+
+- (void) testPerformanceWriteCompact100k {
+    NSArray<NSString*>* entries = [self blocklistWithCount: 100000];
+    NSURL* fileURL = [self.directoryURL URLByAppendingPathComponent: @"compact.selfcontrol"];
+
+    [self measureBlock:^{
+        [SCBlockFileReaderWriter writeCompactBlocklistToFileURL: fileURL blockInfo: @{ @"Blocklist": entries, @"BlockAsWhitelist": @NO } error: nil];
+    }];
+}
+
+// What selfcontrol-cli paid per scheduled activation before
+- (void) testPerformanceReadPlist100k {
+    NSURL* fileURL = [self.directoryURL URLByAppendingPathComponent: @"plist.selfcontrol"];
+    [SCBlockFileReaderWriter writeBlocklistToFileURL: fileURL blockInfo: @{ @"Blocklist": [self blocklistWithCount: 100000], @"BlockAsWhitelist": @NO } error: nil];
+
+    [self measureBlock:^{
+        NSDictionary* blockInfo = [SCBlockFileReaderWriter readBlocklistFromFile: fileURL];
+        XCTAssertEqual([blockInfo[@"Blocklist"] count], 100000);
+    }];
+}
+
+// ...and now, still materializing every entry for the daemon
+- (void) testPerformanceReadCompact100k {
+    NSURL* fileURL = [self.directoryURL URLByAppendingPathComponent: @"compact.selfcontrol"];
+    [SCBlockFileReaderWriter writeCompactBlocklistToFileURL: fileURL blockInfo: @{ @"Blocklist": [self blocklistWithCount: 100000], @"BlockAsWhitelist": @NO } error: nil];
+
+    [self measureBlock:^{
+        NSDictionary* blockInfo = [SCBlockFileReaderWriter readBlocklistFromFile: fileURL];
+        XCTAssertEqual([blockInfo[@"Blocklist"] count], 100000);
+    }];
+}
+
+// Mapping the file and answering lookups without creating the entries at all
+- (void) testPerformanceOpenAndLookupCompact100k {
+    NSURL* fileURL = [self.directoryURL URLByAppendingPathComponent: @"compact.selfcontrol"];
+    [SCBlockFileReaderWriter writeCompactBlocklistToFileURL: fileURL blockInfo: @{ @"Blocklist": [self blocklistWithCount: 100000], @"BlockAsWhitelist": @NO } error: nil];
+
+    [self measureBlock:^{
+        SCCompactBlocklist* blocklist = [SCCompactBlocklist blocklistWithContentsOfURL: fileURL error: nil];
+        for (NSUInteger i = 0; i < 1000; i++) {
+            XCTAssert([blocklist containsEntry: [NSString stringWithFormat: @"site%lu.example.com", (unsigned long)(i * 97)]]);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,228 @@
+//
+//  SCIntervalSetTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCIntervalSet.h"
+#import "SCTimeRange.h"
+
+// every generated interval lives inside [0, kUniverse)
+static const NSUInteger kUniverse = 24 * 60;
+
+@interface SCIntervalSetTests : XCTestCase
+
+@end
+
+@implementation SCIntervalSetTests
+
+// Random intervals, with plenty of overlapping, touching and empty ones; also fills in
+// the minutes they cover as plain booleans
+- (SCIntervalSet *)randomSetWithMaxIntervals:(NSUInteger)maxIntervals model:(BOOL *)model {
+    NSUInteger count = lrand48() % (maxIntervals + 1);
+    NSRange *intervals = malloc(sizeof(NSRange) * MAX(count, 1));
+    memset(model, 0, sizeof(BOOL) * kUniverse);
+    for (NSUInteger i = 0; i < count; i++) {
+        NSUInteger start = lrand48() % kUniverse;
+        NSUInteger length = MIN((NSUInteger)(lrand48() % 180), kUniverse - start);
+        intervals[i] = NSMakeRange(start, length);
+        for (NSUInteger m = start; m < start + length; m++) model[m] = YES;
+    }
+    SCIntervalSet *set = [SCIntervalSet setWithIntervals:intervals count:count];
+    free(intervals);
+    return set;
+}
+
+- (void)assertSet:(SCIntervalSet *)set matchesModel:(const BOOL *)model context:(NSString *)context {
+    // normalized: sorted, non-empty, never touching
+    NSUInteger previousEnd = 0;
+    NSUInteger totalLength = 0;
+    for (NSUInteger i = 0; i < set.intervalCount; i++) {
+        NSRange interval = [set intervalAtIndex:i];
+        XCTAssertGreaterThan(interval.length, 0, @"%@", context);
+        if (i > 0) XCTAssertGreaterThan(interval.location, previousEnd, @"%@", context);
+        previousEnd = NSMaxRange(interval);
+        totalLength += interval.length;
+    }
+    XCTAssertEqual(set.totalLength, totalLength, @"%@", context);
+
+    NSUInteger expectedLength = 0;
+    for (NSUInteger m = 0; m < kUniverse; m++) {
+        if ([set containsMinute:m] != model[m]) {
+            XCTFail(@"%@: minute %lu should be %d in %@", context, (unsigned long)m, model[m], set);
+            return;
+        }
+        if (model[m]) expectedLength++;
+    }
+    XCTAssertEqual(set.totalLength, expectedLength, @"%@", context);
+}
+
+- (void) testSetOperationsMatchModel {
+    BOOL *a = calloc(kUniverse, sizeof(BOOL));
+    BOOL *b = calloc(kUniverse, sizeof(BOOL));
+    BOOL *expected = calloc(kUniverse, sizeof(BOOL));
+
+    srand48(34);
+    for (int trial = 0; trial < 300; trial++) {
+        NSString *context = [NSString stringWithFormat:@"trial %d", trial];
+        SCIntervalSet *setA = [self randomSetWithMaxIntervals:(trial % 20) model:a];
+        SCIntervalSet *setB = [self randomSetWithMaxIntervals:((trial / 20) % 20) model:b];
+        [self assertSet:setA matchesModel:a context:context];
+
+        for (NSUInteger m = 0; m < kUniverse; m++) expected[m] = a[m] || b[m];
+        [self assertSet:[setA setByUnioningWithSet:setB] matchesModel:expected context:[context stringByAppendingString:@" union"]];
+
+        for (NSUInteger m = 0; m < kUniverse; m++) expected[m] = a[m] && b[m];
+        [self assertSet:[setA setByIntersectingWithSet:setB] matchesModel:expected context:[context stringByAppendingString:@" intersection"]];
+
+        for (NSUInteger m = 0; m < kUniverse; m++) expected[m] = a[m] && !b[m];
+        [self assertSet:[setA setBySubtractingSet:setB] matchesModel:expected context:[context stringByAppendingString:@" difference"]];
+
+        NSRange bounds = NSMakeRange(lrand48() % 600, 600 + lrand48() % 240);
+        for (NSUInteger m = 0; m < kUniverse; m++) expected[m] = NSLocationInRange(m, bounds) && !a[m];
+        [self assertSet:[setA setByComplementingInInterval:bounds] matchesModel:expected context:[context stringByAppendingString:@" complement"]];
+
+        BOOL subset = YES, intersects = NO;
+        for (NSUInteger m = 0; m < kUniverse; m++) {
+            if (a[m] && !b[m]) subset = NO;
+            if (a[m] && b[m]) intersects = YES;
+        }
+        XCTAssertEqual([setA isSubsetOfSet:setB], subset, @"%@", context);
+        XCTAssertEqual([setA intersectsSet:setB], intersects, @"%@", context);
+        XCTAssertTrue([[setA setByIntersectingWithSet:setB] isSubsetOfSet:setA], @"%@", context);
+
+        NSRange probe = NSMakeRange(lrand48() % kUniverse, lrand48() % 90);
+        BOOL probeHits = NO;
+        for (NSUInteger m = probe.location; m < MIN(NSMaxRange(probe), kUniverse); m++) {
+            if (a[m]) probeHits = YES;
+        }
+        XCTAssertEqual([setA intersectsInterval:probe], probeHits, @"%@ probe %@", context, NSStringFromRange(probe));
+
+        // same minutes, same intervals
+        SCIntervalSet *rebuilt = [[setA setBySubtractingSet:setB] setByUnioningWithSet:[setA setByIntersectingWithSet:setB]];
+        XCTAssertEqualObjects(rebuilt, setA, @"%@", context);
+        XCTAssertEqual(rebuilt.hash, setA.hash, @"%@", context);
+    }
+
+    free(a);
+    free(b);
+    free(expected);
+}
+
+- (void) testTimeRangeConversion {
+    NSArray<SCTimeRange *> *ranges = @[
+        [SCTimeRange rangeWithStart:@"13:00" end:@"14:00"],
+        [SCTimeRange rangeWithStart:@"09:00" end:@"10:30"],
+        [SCTimeRange rangeWithStart:@"10:30" end:@"11:00"],   // touches the one before it
+        [SCTimeRange rangeWithStart:@"09:15" end:@"09:45"],   // inside an earlier one
+        [SCTimeRange rangeWithStart:@"20:00" end:@"20:00"],   // empty
+        [SCTimeRange rangeWithStart:@"22:00" end:@"24:00"]
+    ];
+    SCIntervalSet *set = [SCIntervalSet setWithTimeRanges:ranges];
+    XCTAssertEqual(set.intervalCount, 3);
+    XCTAssertEqual(set.totalLength, 120 + 60 + 120);
+
+    NSArray<SCTimeRange *> *expected = @[
+        [SCTimeRange rangeWithStart:@"09:00" end:@"11:00"],
+        [SCTimeRange rangeWithStart:@"13:00" end:@"14:00"],
+        [SCTimeRange rangeWithStart:@"22:00" end:@"24:00"]
+    ];
+    XCTAssertEqualObjects([set timeRanges], expected);
+    XCTAssertEqualObjects([SCIntervalSet setWithTimeRanges:[set timeRanges]], set);
+
+    // overnight ranges wrap to the start of the day, like durationMinutes
+    SCTimeRange *overnight = [SCTimeRange rangeWithStart:@"23:00" end:@"01:00"];
+    SCIntervalSet *overnightSet = [SCIntervalSet setWithTimeRanges:@[overnight]];
+    XCTAssertEqual(overnightSet.totalLength, (NSUInteger)[overnight durationMinutes]);
+    XCTAssertTrue([overnightSet containsMinute:0]);
+    XCTAssertTrue([overnightSet containsMinute:23 * 60 + 30]);
+    XCTAssertFalse([overnightSet containsMinute:12 * 60]);
+
+    XCTAssertTrue([SCIntervalSet emptySet].isEmpty);
+    XCTAssertEqualObjects([[SCIntervalSet emptySet] timeRanges], @[]);
+    XCTAssertEqualObjects([[SCIntervalSet emptySet] setByComplementingInInterval:NSMakeRange(0, kUniverse)], [SCIntervalSet setWithInterval:NSMakeRange(0, kUniverse)]);
+}
+
+- (void) testTimeRangeMinutesFollowEdits {
+    SCTimeRange *range = [SCTimeRange rangeWithStart:@"09:00" end:@"17:00"];
+    XCTAssertEqual([range startMinutes], 9 * 60);
+    XCTAssertEqual([range endMinutes], 17 * 60);
+
+    range.startTime = @"10:30";
+    range.endTime = @"24:00";
+    XCTAssertEqual([range startMinutes], 10 * 60 + 30);
+    XCTAssertEqual([range endMinutes], 24 * 60);
+
+    SCTimeRange *copy = [range copy];
+    XCTAssertEqual([copy startMinutes], [range startMinutes]);
+
+    NSData *archived = [NSKeyedArchiver archivedDataWithRootObject:range requiringSecureCoding:YES error:nil];
+    SCTimeRange *unarchived = [NSKeyedUnarchiver unarchivedObjectOfClass:[SCTimeRange class] fromData:archived error:nil];
+    XCTAssertEqual([unarchived endMinutes], 24 * 60);
+
+    XCTAssertEqual([[SCTimeRange new] endMinutes], 23 * 60 + 59);
+}
+
+#pragma mark - Performance
+
+- (NSArray<SCIntervalSet *> *)benchmarkSets {
+    BOOL *model = calloc(kUniverse, sizeof(BOOL));
+    NSMutableArray<SCIntervalSet *> *sets = [NSMutableArray array];
+    srand48(3434);
+    for (int i = 0; i < 200; i++) {
+        [sets addObject:[self randomSetWithMaxIntervals:40 model:model]];
+    }
+    free(model);
+    return sets;
+}
+
+- (void) testPerformanceSetOperations {
+    NSArray<SCIntervalSet *> *sets = [self benchmarkSets];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < sets.count; i++) {
+            SCIntervalSet *a = sets[i];
+            SCIntervalSet *b = sets[(i + 1) % sets.count];
+            [a setByUnioningWithSet:b];
+            [a setByIntersectingWithSet:b];
+            [a setBySubtractingSet:b];
+            [a setByComplementingInInterval:NSMakeRange(0, kUniverse)];
+            [a isSubsetOfSet:b];
+        }
+    }];
+}
+
+// The pairwise containment check changeWouldLoosenSchedule: used to do, for comparison
+- (void) testPerformanceNestedLoopContainment {
+    NSArray<SCIntervalSet *> *sets = [self benchmarkSets];
+    NSMutableArray<NSArray<SCTimeRange *> *> *rangeLists = [NSMutableArray array];
+    for (SCIntervalSet *set in sets) [rangeLists addObject:[set timeRanges]];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < rangeLists.count; i++) {
+            NSArray<SCTimeRange *> *newWindows = rangeLists[i];
+            NSArray<SCTimeRange *> *oldWindows = rangeLists[(i + 1) % rangeLists.count];
+            for (SCTimeRange *newRange in newWindows) {
+                for (SCTimeRange *oldRange in oldWindows) {
+                    if ([newRange startMinutes] >= [oldRange startMinutes] && [newRange endMinutes] <= [oldRange endMinutes]) break;
+                }
+            }
+        }
+    }];
+}
+
+- (void) testPerformanceSubsetFromTimeRanges {
+    NSArray<SCIntervalSet *> *sets = [self benchmarkSets];
+    NSMutableArray<NSArray<SCTimeRange *> *> *rangeLists = [NSMutableArray array];
+    for (SCIntervalSet *set in sets) [rangeLists addObject:[set timeRanges]];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < rangeLists.count; i++) {
+            SCIntervalSet *newAllowed = [SCIntervalSet setWithTimeRanges:rangeLists[i]];
+            SCIntervalSet *oldAllowed = [SCIntervalSet setWithTimeRanges:rangeLists[(i + 1) % rangeLists.count]];
+            [newAllowed isSubsetOfSet:oldAllowed];
+        }
+    }];
+}
+
+@end
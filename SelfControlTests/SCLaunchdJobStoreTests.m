@@ -0,0 +1,212 @@
+//
+//  SCLaunchdJobStoreTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCLaunchdJobStore.h"
+
+@interface SCLaunchdJobStoreTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *workDirectory;
+@property (nonatomic, strong) NSURL *agentsDirectory;
+@property (nonatomic, strong) NSURL *indexURL;
+@property (nonatomic, strong) NSURL *invocationLogURL;
+
+@end
+
+@implementation SCLaunchdJobStoreTests
+
+- (void)setUp {
+    [super setUp];
+    self.workDirectory = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.agentsDirectory = [self.workDirectory URLByAppendingPathComponent:@"LaunchAgents"];
+    self.indexURL = [self.workDirectory URLByAppendingPathComponent:@"InstalledJobs.plist"];
+    self.invocationLogURL = [self.workDirectory URLByAppendingPathComponent:@"launchctl.log"];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.agentsDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtURL:self.workDirectory error:nil];
+    [super tearDown];
+}
+
+// Stand-in for launchctl that logs one line per run, then exits with exitStatus
+- (NSString *)fakeLaunchctlExitingWith:(int)exitStatus {
+    NSString *script = [NSString stringWithFormat:@"#!/bin/sh\necho \"$@\" >> '%@'\nexit %d\n", self.invocationLogURL.path, exitStatus];
+    NSURL *scriptURL = [self.workDirectory URLByAppendingPathComponent:[NSString stringWithFormat:@"launchctl-%d", exitStatus]];
+    [script writeToURL:scriptURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:scriptURL.path error:nil];
+    return scriptURL.path;
+}
+
+- (NSArray<NSString *> *)launchctlInvocations {
+    NSString *log = [NSString stringWithContentsOfURL:self.invocationLogURL encoding:NSUTF8StringEncoding error:nil];
+    NSMutableArray<NSString *> *lines = [[log componentsSeparatedByString:@"\n"] mutableCopy];
+    [lines removeObject:@""];
+    return lines;
+}
+
+- (SCLaunchdJobStore *)storeWithLaunchctl:(NSString *)launchctlPath {
+    return [[SCLaunchdJobStore alloc] initWithLaunchAgentsDirectory:self.agentsDirectory
+                                                           indexURL:self.indexURL
+                                                      launchctlPath:launchctlPath];
+}
+
+- (NSDictionary<NSString *, NSDictionary *> *)plistsWithCount:(NSUInteger)count {
+    NSMutableDictionary<NSString *, NSDictionary *> *plists = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *label = [NSString stringWithFormat:@"org.eyebeam.selfcontrol.schedule.merged-%03lu.monday.0900", (unsigned long)i];
+        plists[label] = @{
+            @"Label": label,
+            @"ProgramArguments": @[@"/usr/bin/true", @"start"],
+            @"RunAtLoad": @NO
+        };
+    }
+    return plists;
+}
+
+- (void) testInstallLoadsEveryJobInOneRun {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    NSDictionary<NSString *, NSDictionary *> *plists = [self plistsWithCount:30];
+
+    NSError *error = nil;
+    XCTAssert([store installJobs:plists expirationDates:nil error:&error]);
+    XCTAssertNil(error);
+
+    NSArray<NSString *> *invocations = [self launchctlInvocations];
+    XCTAssertEqual(invocations.count, 1);
+    XCTAssert([invocations.firstObject hasPrefix:@"load "]);
+
+    XCTAssertEqualObjects(store.installedLabels, [plists.allKeys sortedArrayUsingSelector:@selector(compare:)]);
+    for (NSString *label in plists) {
+        NSDictionary *written = [NSDictionary dictionaryWithContentsOfURL:[store plistURLForLabel:label]];
+        XCTAssertEqualObjects(written, plists[label]);
+        XCTAssert([invocations.firstObject containsString:[store plistURLForLabel:label].path]);
+    }
+}
+
+- (void) testBatchesAreSplitAtMaxPlistsPerInvocation {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    store.maxPlistsPerInvocation = 10;
+
+    XCTAssert([store installJobs:[self plistsWithCount:25] expirationDates:nil error:nil]);
+    XCTAssertEqual([self launchctlInvocations].count, 3);
+}
+
+- (void) testIndexIsTheSourceOfTruth {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    XCTAssert([store installJobs:[self plistsWithCount:3] expirationDates:nil error:nil]);
+
+    // a plist the store didn't install isn't one of its jobs
+    NSURL *strayURL = [self.agentsDirectory URLByAppendingPathComponent:@"org.eyebeam.selfcontrol.schedule.stray.plist"];
+    [@{@"Label": @"stray"} writeToURL:strayURL error:nil];
+    XCTAssertEqual(store.installedLabels.count, 3);
+
+    // and a fresh store picks the jobs up from the index, not the directory
+    SCLaunchdJobStore *reopened = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    XCTAssertEqualObjects(reopened.installedLabels, store.installedLabels);
+    XCTAssertEqual([reopened installedLabelsWithPrefix:@"org.eyebeam.selfcontrol.schedule.merged-00"].count, 3);
+    XCTAssertEqual([reopened installedLabelsWithPrefix:@"org.eyebeam.selfcontrol.schedule.other"].count, 0);
+}
+
+- (void) testMissingIndexIsRebuiltFromExistingJobs {
+    NSString *label = @"org.eyebeam.selfcontrol.schedule.merged-ABC.monday.0900";
+    NSDictionary *plist = @{
+        @"Label": label,
+        @"ProgramArguments": @[@"/usr/bin/true", @"start", @"--schedule-id=ABC", @"--enddate=2020-01-06T10:00:00Z"]
+    };
+    [plist writeToURL:[self.agentsDirectory URLByAppendingPathComponent:[label stringByAppendingPathExtension:@"plist"]] error:nil];
+    [@{@"Label": @"com.example.unrelated"} writeToURL:[self.agentsDirectory URLByAppendingPathComponent:@"com.example.unrelated.plist"] error:nil];
+
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    XCTAssertEqualObjects(store.installedLabels, @[label]);
+    XCTAssertEqualObjects([store labelsExpiredBeforeDate:[NSDate date]], @[label]);
+    XCTAssert([[NSFileManager defaultManager] fileExistsAtPath:self.indexURL.path]);
+}
+
+- (void) testRemoveUnloadsInOneRunAndDeletesPlists {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    NSDictionary<NSString *, NSDictionary *> *plists = [self plistsWithCount:20];
+    XCTAssert([store installJobs:plists expirationDates:nil error:nil]);
+
+    NSArray<NSString *> *labels = [plists.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    NSArray<NSString *> *removed = [labels subarrayWithRange:NSMakeRange(0, 12)];
+    XCTAssert([store removeJobsWithLabels:removed error:nil]);
+
+    NSArray<NSString *> *invocations = [self launchctlInvocations];
+    XCTAssertEqual(invocations.count, 2);
+    XCTAssert([invocations.lastObject hasPrefix:@"unload "]);
+
+    XCTAssertEqualObjects(store.installedLabels, [labels subarrayWithRange:NSMakeRange(12, 8)]);
+    for (NSString *label in removed) {
+        XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[store plistURLForLabel:label].path]);
+    }
+}
+
+- (void) testExpiredLabels {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    NSDictionary<NSString *, NSDictionary *> *plists = [self plistsWithCount:4];
+    NSArray<NSString *> *labels = [plists.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    NSDictionary<NSString *, NSDate *> *expirationDates = @{
+        labels[0]: [NSDate dateWithTimeIntervalSinceNow:-3600],
+        labels[1]: [NSDate dateWithTimeIntervalSinceNow:-60],
+        labels[2]: [NSDate dateWithTimeIntervalSinceNow:3600]
+        // labels[3] never expires
+    };
+    XCTAssert([store installJobs:plists expirationDates:expirationDates error:nil]);
+
+    XCTAssertEqualObjects([store labelsExpiredBeforeDate:[NSDate date]], (@[labels[0], labels[1]]));
+    XCTAssertEqualObjects([store labelsExpiredBeforeDate:[NSDate dateWithTimeIntervalSinceNow:-600]], @[labels[0]]);
+    XCTAssertEqual([store labelsExpiredBeforeDate:[NSDate distantFuture]].count, 3);
+}
+
+- (void) testFailedLoadIndexesNothing {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:1]];
+
+    NSError *error = nil;
+    XCTAssertFalse([store installJobs:[self plistsWithCount:5] expirationDates:nil error:&error]);
+    XCTAssertEqualObjects(error.domain, @"SCLaunchdJobStore");
+    XCTAssertEqual(store.installedLabels.count, 0);
+
+    // nothing is left behind for launchd to pick up at the next login
+    NSArray<NSString *> *invocations = [self launchctlInvocations];
+    XCTAssertEqual(invocations.count, 2);
+    XCTAssert([invocations.lastObject hasPrefix:@"unload "]);
+    NSArray *leftovers = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:store.launchAgentsDirectory.path error:nil];
+    XCTAssertEqual(leftovers.count, 0);
+}
+
+- (void) testRejectsLabelsOutsideTheDirectory {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:[self fakeLaunchctlExitingWith:0]];
+    XCTAssertNil([store plistURLForLabel:@"../escape"]);
+    XCTAssertFalse([store installJobs:@{@"../escape": @{}} expirationDates:nil error:nil]);
+    XCTAssertEqual([self launchctlInvocations].count, 0);
+}
+
+#pragma mark - Performance
+
+// 40 jobs, one launchctl run each - how jobs were installed before the store
+- (void) testPerformanceInstallOneJobAtATime {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:@"/usr/bin/true"];
+    NSDictionary<NSString *, NSDictionary *> *plists = [self plistsWithCount:40];
+
+    [self measureBlock:^{
+        for (NSString *label in plists) {
+            [store installJobs:@{label: plists[label]} expirationDates:nil error:nil];
+        }
+        [store removeJobsWithLabels:plists.allKeys error:nil];
+    }];
+}
+
+- (void) testPerformanceInstallBatch {
+    SCLaunchdJobStore *store = [self storeWithLaunchctl:@"/usr/bin/true"];
+    NSDictionary<NSString *, NSDictionary *> *plists = [self plistsWithCount:40];
+
+    [self measureBlock:^{
+        [store installJobs:plists expirationDates:nil error:nil];
+        [store removeJobsWithLabels:plists.allKeys error:nil];
+    }];
+}
+
+@end
@@ -0,0 +1,114 @@
+//
+//  SCLinkHostExtractorTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCLinkHostExtractor.h"
+
+static NSString* const kTestPage = @"<html><head><link rel=\"stylesheet\" HREF=\"HTTPS://CDN.Example.com/a.css\">"
+    @"<script src='//static.example.net/x.js'></script></head><body>\n"
+    @"<img data-src=\"http://lazy.example.org/i.png\" src=http://img.example.org/i.png>\n"
+    @"<a href = \"https://user:pw@secure.example.com:8443/p?q=1\">account</a> <a href=\"/relative\">r</a>\n"
+    @"<a href=\"https://twitter.com/share\">tweet</a> <a href=\"mailto:someone@mail.example.com\">mail</a>\n"
+    @"<a href=\"http://bad_host.example.com/\">bad</a> <a href=\"http://example.com/\">home</a>\n"
+    @"<p>see http://text.example.com or title=\"http://title.example.com\"</p></body></html>";
+
+@interface SCLinkHostExtractorTests : XCTestCase
+
+@end
+
+@implementation SCLinkHostExtractorTests
+
+- (NSSet<NSString*>*)expectedHosts {
+    return [NSSet setWithArray: @[@"cdn.example.com", @"static.example.net", @"img.example.org", @"secure.example.com"]];
+}
+
+- (NSSet<NSString*>*)excludedHosts {
+    return [NSSet setWithArray: @[@"example.com", @"Twitter.com"]];
+}
+
+- (void) testFindsHostsInLinkAttributesOnly {
+    NSData* page = [kTestPage dataUsingEncoding: NSUTF8StringEncoding];
+    XCTAssertEqualObjects([SCLinkHostExtractor hostsInData: page excludingHosts: [self excludedHosts]], [self expectedHosts]);
+
+    NSSet<NSString*>* unexcluded = [SCLinkHostExtractor hostsInData: page excludingHosts: nil];
+    XCTAssert([unexcluded containsObject: @"example.com"]);
+    XCTAssert([unexcluded containsObject: @"twitter.com"]);
+}
+
+- (void) testEveryChunkingGivesTheSameHosts {
+    NSData* page = [kTestPage dataUsingEncoding: NSUTF8StringEncoding];
+    const uint8_t* bytes = page.bytes;
+    srandom(7);
+
+    for (NSUInteger round = 0; round < 200; round++) {
+        SCLinkHostExtractor* extractor = [[SCLinkHostExtractor alloc] initWithExcludedHosts: [self excludedHosts]];
+        NSUInteger offset = 0;
+        while (offset < page.length) {
+            // a byte at a time first, so every attribute is split at every position
+            NSUInteger chunkLength = MIN(round == 0 ? 1 : 1 + (NSUInteger)(random() % 40), page.length - offset);
+            [extractor appendBytes: bytes + offset length: chunkLength];
+            offset += chunkLength;
+        }
+        XCTAssertEqualObjects(extractor.hosts, [self expectedHosts], @"round %lu", (unsigned long)round);
+    }
+}
+
+- (void) testGivesUpOnUnterminatedValues {
+    SCLinkHostExtractor* extractor = [[SCLinkHostExtractor alloc] initWithExcludedHosts: nil];
+    NSMutableData* page = [[@"<a href=\"http://" dataUsingEncoding: NSUTF8StringEncoding] mutableCopy];
+    [page increaseLengthBy: 4096];
+    memset((uint8_t*)page.mutableBytes + page.length - 4096, 'a', 4096);
+    [extractor appendData: page];
+    [extractor appendData: [@"\"> <a href=\"https://after.example.com/\">" dataUsingEncoding: NSUTF8StringEncoding]];
+
+    XCTAssertEqualObjects(extractor.hosts, [NSSet setWithObject: @"after.example.com"]);
+}
+
+#pragma mark - Performance
+
+// A few megabytes of markup, text and links, like a heavy news front page
+- (NSData*)largePage {
+    NSMutableString* page = [NSMutableString stringWithString: @"<html><body>"];
+    for (NSUInteger i = 0; page.length < 4 * 1024 * 1024; i++) {
+        [page appendFormat: @"<div class=\"story story-%lu\"><a href=\"https://www.example.com/news/%lu\">Headline number %lu</a>"
+                            @"<img src=\"https://img%lu.examplecdn.com/t/%lu.jpg\" alt=\"\" width=\"300\" height=\"200\">"
+                            @"<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+                            @"et dolore magna aliqua. Read more at https://www.example.com/news/%lu or share it.</p>"
+                            @"<a href=\"https://twitter.com/intent/tweet?url=%lu\">Tweet</a></div>\n",
+                            (unsigned long)i, (unsigned long)i, (unsigned long)i, (unsigned long)(i % 50), (unsigned long)i, (unsigned long)i, (unsigned long)i];
+    }
+    [page appendString: @"</body></html>"];
+    return [page dataUsingEncoding: NSUTF8StringEncoding];
+}
+
+// The page as the scraper used to handle it: decoded whole, then run through NSDataDetector
+- (void) testPerformanceLargePageDataDetector {
+    NSData* page = [self largePage];
+
+    [self measureBlock:^{
+        NSString* html = [[NSString alloc] initWithData: page encoding: NSUTF8StringEncoding];
+        NSDataDetector* dataDetector = [[NSDataDetector alloc] initWithTypes: NSTextCheckingTypeLink error: nil];
+        NSMutableSet<NSString*>* hosts = [NSMutableSet set];
+        [dataDetector enumerateMatchesInString: html options: kNilOptions range: NSMakeRange(0, html.length) usingBlock:^(NSTextCheckingResult* result, NSMatchingFlags flags, BOOL* stop) {
+            if (result.URL.host.length) [hosts addObject: result.URL.host];
+        }];
+    }];
+}
+
+// The same page fed to the extractor in the 64KB chunks a data task delivers
+- (void) testPerformanceLargePageStreaming {
+    NSData* page = [self largePage];
+    const NSUInteger chunkLength = 64 * 1024;
+
+    [self measureBlock:^{
+        SCLinkHostExtractor* extractor = [[SCLinkHostExtractor alloc] initWithExcludedHosts: nil];
+        for (NSUInteger offset = 0; offset < page.length; offset += chunkLength) {
+            [extractor appendBytes: (const uint8_t*)page.bytes + offset length: MIN(chunkLength, page.length - offset)];
+        }
+        XCTAssertEqual(extractor.hosts.count, 52);
+    }];
+}
+
+@end
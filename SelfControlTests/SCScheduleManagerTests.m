@@ -0,0 +1,187 @@
+//
+//  SCScheduleManagerTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCScheduleManager.h"
+#import "SCScheduleLaunchdBridge.h"
+#import "SCWeeklySchedule.h"
+#import "SCBlockBundle.h"
+#import "SCTimeRange.h"
+
+@interface SCScheduleManager (Testing)
+- (NSArray *)calculateBlockSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
+                                    schedules:(NSArray<SCWeeklySchedule *> *)schedules
+                                   weekOffset:(NSInteger)weekOffset
+                                       bridge:(SCScheduleLaunchdBridge *)bridge;
+- (BOOL)changeWouldLoosenSchedule:(SCWeeklySchedule *)oldSchedule
+                      toSchedule:(SCWeeklySchedule *)newSchedule
+                          forDay:(SCDayOfWeek)day;
+@end
+
+@interface SCScheduleManagerTests : XCTestCase
+
+@end
+
+@implementation SCScheduleManagerTests
+
+// Random allowed windows on 15-minute boundaries, some days left fully blocked
+- (NSArray<SCWeeklySchedule *> *)schedulesForBundles:(NSArray<SCBlockBundle *> *)bundles windowsPerDay:(int)windowsPerDay seed:(long)seed {
+    srand48(seed);
+    NSMutableArray<SCWeeklySchedule *> *schedules = [NSMutableArray array];
+    for (SCBlockBundle *bundle in bundles) {
+        SCWeeklySchedule *schedule = [SCWeeklySchedule emptyScheduleForBundleID:bundle.bundleID];
+        for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
+            if (drand48() < 0.1) continue;
+
+            NSMutableArray<SCTimeRange *> *ranges = [NSMutableArray array];
+            NSInteger minute = 0;
+            for (int w = 0; w < windowsPerDay && minute < 23 * 60; w++) {
+                NSInteger start = minute + 15 * (lrand48() % 8);
+                NSInteger end = MIN(start + 15 * (1 + lrand48() % 8), 23 * 60 + 45);
+                if (end <= start) break;
+                [ranges addObject:[SCTimeRange rangeWithStart:[NSString stringWithFormat:@"%02ld:%02ld", (long)(start / 60), (long)(start % 60)]
+                                                          end:[NSString stringWithFormat:@"%02ld:%02ld", (long)(end / 60), (long)(end % 60)]]];
+                minute = end;
+            }
+            [schedule setAllowedWindows:ranges forDay:day];
+        }
+        [schedules addObject:schedule];
+    }
+    return schedules;
+}
+
+- (NSArray<SCBlockBundle *> *)bundlesWithCount:(NSUInteger)count {
+    NSMutableArray<SCBlockBundle *> *bundles = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        [bundles addObject:[SCBlockBundle bundleWithName:[NSString stringWithFormat:@"Bundle %lu", (unsigned long)i] color:[SCBlockBundle colorBlue]]];
+    }
+    return bundles;
+}
+
+// The original O(T*W*B) merge: every pair of consecutive transition times, checked against every window
+- (NSArray<NSDictionary *> *)bruteForceSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
+                                                schedules:(NSArray<SCWeeklySchedule *> *)schedules
+                                                   bridge:(SCScheduleLaunchdBridge *)bridge {
+    NSMutableArray<NSDictionary *> *allWindows = [NSMutableArray array];
+    for (SCBlockBundle *bundle in bundles) {
+        SCWeeklySchedule *schedule = nil;
+        for (SCWeeklySchedule *s in schedules) {
+            if ([s.bundleID isEqualToString:bundle.bundleID]) {
+                schedule = s;
+                break;
+            }
+        }
+        if (!schedule) schedule = [SCWeeklySchedule emptyScheduleForBundleID:bundle.bundleID];
+
+        for (SCBlockWindow *window in [bridge allBlockWindowsForSchedule:schedule weekOffset:1]) {
+            [allWindows addObject:@{ @"bundle": bundle, @"window": window }];
+        }
+    }
+
+    NSMutableSet<NSDate *> *transitionTimes = [NSMutableSet set];
+    for (NSDictionary *entry in allWindows) {
+        SCBlockWindow *window = entry[@"window"];
+        [transitionTimes addObject:window.startDate];
+        [transitionTimes addObject:window.endDate];
+    }
+    NSArray<NSDate *> *sortedTimes = [[transitionTimes allObjects] sortedArrayUsingSelector:@selector(compare:)];
+
+    NSMutableArray<NSDictionary *> *segments = [NSMutableArray array];
+    for (NSUInteger i = 0; i + 1 < sortedTimes.count; i++) {
+        NSMutableArray<NSString *> *activeBundleIDs = [NSMutableArray array];
+        for (NSDictionary *entry in allWindows) {
+            SCBlockBundle *bundle = entry[@"bundle"];
+            SCBlockWindow *window = entry[@"window"];
+            if ([window.startDate compare:sortedTimes[i]] != NSOrderedDescending &&
+                [window.endDate compare:sortedTimes[i + 1]] != NSOrderedAscending &&
+                ![activeBundleIDs containsObject:bundle.bundleID]) {
+                [activeBundleIDs addObject:bundle.bundleID];
+            }
+        }
+        if (activeBundleIDs.count == 0) continue;
+
+        NSDate *adjustedEnd = [[NSCalendar currentCalendar] dateByAddingUnit:NSCalendarUnitMinute value:-1 toDate:sortedTimes[i + 1] options:0];
+        [segments addObject:@{ @"start": sortedTimes[i], @"end": adjustedEnd, @"bundleIDs": activeBundleIDs }];
+    }
+    return segments;
+}
+
+- (NSArray<NSDictionary *> *)summarizeSegments:(NSArray *)segments {
+    NSMutableArray<NSDictionary *> *summary = [NSMutableArray array];
+    for (id segment in segments) {
+        [summary addObject:@{
+            @"start": [segment valueForKey:@"startDate"],
+            @"end": [segment valueForKey:@"endDate"],
+            @"bundleIDs": [[segment valueForKey:@"activeBundles"] valueForKey:@"bundleID"]
+        }];
+    }
+    return summary;
+}
+
+- (void) testSegmentSweepMatchesBruteForce {
+    SCScheduleManager *manager = [[SCScheduleManager alloc] init];
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+
+    for (long seed = 1; seed <= 5; seed++) {
+        NSMutableArray<SCBlockBundle *> *bundles = [[self bundlesWithCount:8] mutableCopy];
+        NSArray<SCWeeklySchedule *> *schedules = [self schedulesForBundles:bundles windowsPerDay:(int)seed + 1 seed:seed];
+        // a bundle listed twice, and one with no schedule (blocked all week)
+        [bundles addObject:bundles[0]];
+        [bundles addObject:[SCBlockBundle bundleWithName:@"Unscheduled" color:[SCBlockBundle colorRed]]];
+
+        NSArray *segments = [manager calculateBlockSegmentsForBundles:bundles schedules:schedules weekOffset:1 bridge:bridge];
+        NSArray<NSDictionary *> *expected = [self bruteForceSegmentsForBundles:bundles schedules:schedules bridge:bridge];
+        XCTAssertEqualObjects([self summarizeSegments:segments], expected, @"seed %ld", seed);
+    }
+
+    // nothing to merge
+    XCTAssert([manager calculateBlockSegmentsForBundles:@[] schedules:@[] weekOffset:1 bridge:bridge].count == 0);
+}
+
+- (void) testChangeWouldLoosenSchedule {
+    SCScheduleManager *manager = [[SCScheduleManager alloc] init];
+    SCWeeklySchedule *oldSchedule = [SCWeeklySchedule emptyScheduleForBundleID:@"loosen"];
+    [oldSchedule setAllowedWindows:@[[SCTimeRange rangeWithStart:@"09:00" end:@"10:00"],
+                                     [SCTimeRange rangeWithStart:@"10:00" end:@"11:00"],
+                                     [SCTimeRange rangeWithStart:@"14:00" end:@"15:00"]] forDay:SCDayOfWeekMonday];
+
+    BOOL (^loosens)(NSArray<SCTimeRange *> *) = ^BOOL(NSArray<SCTimeRange *> *windows) {
+        SCWeeklySchedule *newSchedule = [oldSchedule copy];
+        [newSchedule setAllowedWindows:windows forDay:SCDayOfWeekMonday];
+        return [manager changeWouldLoosenSchedule:oldSchedule toSchedule:newSchedule forDay:SCDayOfWeekMonday];
+    };
+
+    XCTAssertFalse(loosens(@[]));
+    XCTAssertFalse(loosens([oldSchedule allowedWindowsForDay:SCDayOfWeekMonday]));
+    // straddles two adjacent old windows, but allows nothing new
+    XCTAssertFalse(loosens(@[[SCTimeRange rangeWithStart:@"09:30" end:@"10:30"]]));
+    // the same window twice is still nothing new
+    XCTAssertFalse(loosens(@[[SCTimeRange rangeWithStart:@"14:00" end:@"15:00"], [SCTimeRange rangeWithStart:@"14:00" end:@"15:00"]]));
+    XCTAssertTrue(loosens(@[[SCTimeRange rangeWithStart:@"10:30" end:@"11:30"]]));
+    XCTAssertTrue(loosens(@[[SCTimeRange rangeWithStart:@"12:00" end:@"12:15"]]));
+}
+
+- (void) testPerformanceSegmentSweep {
+    SCScheduleManager *manager = [[SCScheduleManager alloc] init];
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    NSArray<SCBlockBundle *> *bundles = [self bundlesWithCount:50];
+    NSArray<SCWeeklySchedule *> *schedules = [self schedulesForBundles:bundles windowsPerDay:12 seed:42];
+
+    [self measureBlock:^{
+        [manager calculateBlockSegmentsForBundles:bundles schedules:schedules weekOffset:1 bridge:bridge];
+    }];
+}
+
+- (void) testPerformanceSegmentBruteForce {
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    NSArray<SCBlockBundle *> *bundles = [self bundlesWithCount:50];
+    NSArray<SCWeeklySchedule *> *schedules = [self schedulesForBundles:bundles windowsPerDay:12 seed:42];
+
+    [self measureBlock:^{
+        [self bruteForceSegmentsForBundles:bundles schedules:schedules bridge:bridge];
+    }];
+}
+
+@end
@@ -0,0 +1,65 @@
+//
+//  SCScheduleStatusServiceTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCScheduleStatusService.h"
+
+@interface SCScheduleStatusServiceTests : XCTestCase
+
+@end
+
+@implementation SCScheduleStatusServiceTests
+
+- (NSDate *)todayAtHour:(NSInteger)hour minute:(NSInteger)minute {
+    return [[NSCalendar currentCalendar] dateBySettingHour:hour minute:minute second:0 ofDate:[NSDate date] options:0];
+}
+
+- (SCBundleStatus *)statusWithNextChange:(nullable NSDate *)nextChangeDate {
+    return [[SCBundleStatus alloc] initWithBundleID:[[NSUUID UUID] UUIDString]
+                                          isAllowed:NO
+                                       statusString:@""
+                                     nextChangeDate:nextChangeDate];
+}
+
+- (void) testRefreshesAtEarliestTransition {
+    NSDate *now = [self todayAtHour:9 minute:0];
+    NSArray<SCBundleStatus *> *statuses = @[
+        [self statusWithNextChange:[self todayAtHour:17 minute:0]],
+        [self statusWithNextChange:[self todayAtHour:12 minute:30]],
+        [self statusWithNextChange:nil]
+    ];
+
+    NSDate *refreshDate = [SCScheduleStatusService refreshDateForStatuses:statuses
+                                                        commitmentEndDate:[self todayAtHour:20 minute:0]
+                                                                afterDate:now];
+    XCTAssertEqualObjects(refreshDate, [self todayAtHour:12 minute:30]);
+
+    refreshDate = [SCScheduleStatusService refreshDateForStatuses:statuses
+                                                commitmentEndDate:[self todayAtHour:10 minute:0]
+                                                        afterDate:now];
+    XCTAssertEqualObjects(refreshDate, [self todayAtHour:10 minute:0]);
+}
+
+- (void) testIgnoresPastDatesAndFallsBackToMidnight {
+    NSDate *now = [self todayAtHour:9 minute:0];
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    NSDate *midnight = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:[calendar startOfDayForDate:now] options:0];
+
+    // a transition that's already happened, one exactly now, and one days away
+    NSArray<SCBundleStatus *> *statuses = @[
+        [self statusWithNextChange:[self todayAtHour:8 minute:0]],
+        [self statusWithNextChange:now],
+        [self statusWithNextChange:[calendar dateByAddingUnit:NSCalendarUnitDay value:3 toDate:now options:0]]
+    ];
+
+    NSDate *refreshDate = [SCScheduleStatusService refreshDateForStatuses:statuses
+                                                        commitmentEndDate:[self todayAtHour:7 minute:0]
+                                                                afterDate:now];
+    XCTAssertEqualObjects(refreshDate, midnight);
+
+    XCTAssertEqualObjects([SCScheduleStatusService refreshDateForStatuses:@[] commitmentEndDate:nil afterDate:now], midnight);
+}
+
+@end
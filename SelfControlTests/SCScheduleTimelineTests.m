@@ -0,0 +1,253 @@
+//
+//  SCScheduleTimelineTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCScheduleTimeline.h"
+#import "SCScheduleManager.h"
+#import "SCScheduleLaunchdBridge.h"
+#import "SCWeeklySchedule.h"
+#import "SCBlockBundle.h"
+#import "SCTimeRange.h"
+
+@interface SCScheduleManager (Testing)
+- (NSArray *)calculateBlockSegmentsForBundles:(NSArray<SCBlockBundle *> *)bundles
+                                    schedules:(NSArray<SCWeeklySchedule *> *)schedules
+                                weekStartDate:(NSDate *)weekStart
+                                       bridge:(SCScheduleLaunchdBridge *)bridge;
+@end
+
+@interface SCScheduleTimelineTests : XCTestCase
+
+@end
+
+@implementation SCScheduleTimelineTests
+
+// Back-to-back and spaced-out segments over a few weeks, a bundle or two each
+- (NSArray<SCTimelineSegment *> *)randomSegmentsWithCount:(NSUInteger)count startingAt:(NSDate *)origin {
+    NSMutableArray<SCTimelineSegment *> *segments = [NSMutableArray array];
+    NSTimeInterval t = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        t += (lrand48() % 3 == 0) ? 60 : 60 * (1 + lrand48() % 600);
+        NSDate *start = [origin dateByAddingTimeInterval:t];
+        t += 60 * (1 + lrand48() % 300);
+        NSDate *end = [origin dateByAddingTimeInterval:t];
+
+        NSArray<NSString *> *bundleIDs = (lrand48() % 2) ? @[@"a"] : @[@"a", @"b"];
+        [segments addObject:[SCTimelineSegment segmentWithID:[SCScheduleTimeline segmentIDForStartDate:start endDate:end bundleIDs:bundleIDs]
+                                                   startDate:start
+                                                     endDate:end
+                                                 contentHash:[SCScheduleTimeline contentHashForBlocklist:bundleIDs]
+                                                   bundleIDs:bundleIDs]];
+    }
+    return segments;
+}
+
+- (void) testLookupsMatchLinearScan {
+    srand48(35);
+    NSDate *origin = [NSDate dateWithTimeIntervalSince1970:1790000000];
+    NSArray<SCTimelineSegment *> *segments = [self randomSegmentsWithCount:400 startingAt:origin];
+
+    // construction sorts, so hand it shuffled
+    NSMutableArray<SCTimelineSegment *> *shuffled = [segments mutableCopy];
+    for (NSUInteger i = shuffled.count - 1; i > 0; i--) {
+        [shuffled exchangeObjectAtIndex:i withObjectAtIndex:lrand48() % (i + 1)];
+    }
+    SCScheduleTimeline *timeline = [SCScheduleTimeline timelineWithSegments:shuffled];
+    XCTAssertEqual(timeline.count, segments.count);
+
+    NSTimeInterval span = [segments.lastObject.endDate timeIntervalSinceDate:origin] + 3600;
+    for (int probe = 0; probe < 2000; probe++) {
+        NSDate *date = [origin dateByAddingTimeInterval:(lrand48() % (long)span) - 1800];
+
+        SCTimelineSegment *expected = nil;
+        SCTimelineSegment *expectedNext = nil;
+        for (SCTimelineSegment *segment in segments) {
+            if ([segment.startDate timeIntervalSinceDate:date] <= 0 && [segment.endDate timeIntervalSinceDate:date] > 0) {
+                expected = segment;
+            }
+            if (!expectedNext && [segment.startDate timeIntervalSinceDate:date] > 0) {
+                expectedNext = segment;
+            }
+        }
+        XCTAssertEqual([timeline segmentAtDate:date], expected, @"at %@", date);
+        XCTAssertEqual([timeline nextSegmentAfterDate:date], expectedNext, @"at %@", date);
+    }
+
+    for (SCTimelineSegment *segment in segments) {
+        XCTAssertEqual([timeline segmentWithID:segment.segmentID], segment);
+        XCTAssertEqual([timeline segmentAtDate:segment.startDate], segment);
+        XCTAssertNotEqual([timeline segmentAtDate:segment.endDate], segment);
+    }
+    XCTAssertNil([timeline segmentWithID:@"nope"]);
+    XCTAssertNil([[SCScheduleTimeline timelineWithSegments:@[]] segmentAtDate:origin]);
+}
+
+- (void) testWriteAndReadBack {
+    srand48(3535);
+    NSArray<SCTimelineSegment *> *segments = [self randomSegmentsWithCount:50 startingAt:[NSDate dateWithTimeIntervalSince1970:1790000000]];
+    SCScheduleTimeline *timeline = [SCScheduleTimeline timelineWithSegments:segments];
+
+    NSURL *url = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    url = [url URLByAppendingPathComponent:@"ScheduleTimeline.plist"];
+    NSError *error = nil;
+    XCTAssertTrue([timeline writeToURL:url error:&error], @"%@", error);
+
+    SCScheduleTimeline *readBack = [SCScheduleTimeline timelineWithContentsOfURL:url error:&error];
+    XCTAssertNotNil(readBack, @"%@", error);
+    XCTAssertEqual(readBack.count, timeline.count);
+    for (NSUInteger i = 0; i < timeline.count; i++) {
+        SCTimelineSegment *a = timeline.segments[i];
+        SCTimelineSegment *b = readBack.segments[i];
+        XCTAssertEqualObjects(a.segmentID, b.segmentID);
+        XCTAssertEqualObjects(a.startDate, b.startDate);
+        XCTAssertEqualObjects(a.endDate, b.endDate);
+        XCTAssertEqualObjects(a.contentHash, b.contentHash);
+        XCTAssertEqualObjects(a.bundleIDs, b.bundleIDs);
+    }
+
+    // anything that isn't a timeline is rejected rather than half-read
+    [@{@"FormatVersion": @1, @"SegmentIDs": @[@"x"]} writeToURL:url error:nil];
+    XCTAssertNil([SCScheduleTimeline timelineWithContentsOfURL:url error:&error]);
+    XCTAssertEqualObjects(error.domain, @"SCScheduleTimeline");
+
+    [[NSFileManager defaultManager] removeItemAtURL:[url URLByDeletingLastPathComponent] error:nil];
+}
+
+- (void) testIdentityIsDeterministic {
+    NSDate *start = [NSDate dateWithTimeIntervalSince1970:1790000000];
+    NSDate *end = [start dateByAddingTimeInterval:3600];
+
+    NSString *segmentID = [SCScheduleTimeline segmentIDForStartDate:start endDate:end bundleIDs:@[@"a", @"b"]];
+    XCTAssertEqualObjects(segmentID, [SCScheduleTimeline segmentIDForStartDate:start endDate:end bundleIDs:@[@"b", @"a", @"b"]]);
+    XCTAssertNotEqualObjects(segmentID, [SCScheduleTimeline segmentIDForStartDate:start endDate:end bundleIDs:@[@"a"]]);
+    XCTAssertNotEqualObjects(segmentID, [SCScheduleTimeline segmentIDForStartDate:start endDate:[end dateByAddingTimeInterval:60] bundleIDs:@[@"a", @"b"]]);
+    XCTAssertEqual(segmentID.length, 32);
+
+    NSString *contentHash = [SCScheduleTimeline contentHashForBlocklist:@[@"facebook.com", @"app:com.example"]];
+    XCTAssertEqualObjects(contentHash, [SCScheduleTimeline contentHashForBlocklist:@[@"app:com.example", @"facebook.com", @"facebook.com"]]);
+    XCTAssertNotEqualObjects(contentHash, [SCScheduleTimeline contentHashForBlocklist:@[@"facebook.com"]]);
+}
+
+- (void) testBlockEndFollowsBackToBackSegments {
+    NSDate *origin = [NSDate dateWithTimeIntervalSince1970:1790000000];
+    NSDate *(^at)(NSTimeInterval) = ^NSDate *(NSTimeInterval minutes) {
+        return [origin dateByAddingTimeInterval:minutes * 60];
+    };
+    NSArray<NSArray *> *spans = @[
+        @[@0, @59, @[@"a"]],
+        @[@60, @119, @[@"a", @"b"]],   // a carries on across the launchd gap
+        @[@120, @179, @[@"b"]],
+        @[@200, @259, @[@"a"]]         // too far after the last one to be the same block
+    ];
+    NSMutableArray<SCTimelineSegment *> *segments = [NSMutableArray array];
+    for (NSArray *span in spans) {
+        NSDate *start = at([span[0] doubleValue]);
+        NSDate *end = at([span[1] doubleValue]);
+        [segments addObject:[SCTimelineSegment segmentWithID:[SCScheduleTimeline segmentIDForStartDate:start endDate:end bundleIDs:span[2]]
+                                                   startDate:start
+                                                     endDate:end
+                                                 contentHash:@""
+                                                   bundleIDs:span[2]]];
+    }
+    SCScheduleTimeline *timeline = [SCScheduleTimeline timelineWithSegments:segments];
+
+    XCTAssertEqualObjects([timeline blockEndDateForBundleID:@"a" atDate:at(10)], at(119));
+    XCTAssertEqualObjects([timeline blockEndDateForBundleID:@"b" atDate:at(70)], at(179));
+    XCTAssertEqualObjects([timeline blockEndDateForBundleID:@"a" atDate:at(210)], at(259));
+    XCTAssertNil([timeline blockEndDateForBundleID:@"b" atDate:at(10)]);
+    XCTAssertNil([timeline blockEndDateForBundleID:@"a" atDate:at(59.5)]);
+    XCTAssertNil([timeline blockEndDateForBundleID:@"a" atDate:at(190)]);
+}
+
+- (void) testBlockWindowsKeepWallClockTimesAcrossDST {
+    NSTimeZone *originalTimeZone = [NSTimeZone defaultTimeZone];
+    [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneWithName:@"America/New_York"]];
+
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    calendar.timeZone = [NSTimeZone defaultTimeZone];
+    NSDateComponents *components = [[NSDateComponents alloc] init];
+    components.year = 2026;
+    components.month = 3;
+    components.day = 2;   // Monday; clocks go forward on Sunday the 8th
+    NSDate *weekStart = [calendar dateFromComponents:components];
+
+    SCWeeklySchedule *schedule = [SCWeeklySchedule emptyScheduleForBundleID:@"a"];
+    [schedule setAllowedWindows:@[[SCTimeRange rangeWithStart:@"09:00" end:@"17:00"]] forDay:SCDayOfWeekSunday];
+
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    NSArray<SCBlockWindow *> *windows = [bridge blockWindowsForSchedule:schedule day:SCDayOfWeekSunday weekStartDate:weekStart];
+    XCTAssertEqual(windows.count, 2);
+
+    NSDateComponents *firstEnd = [calendar components:(NSCalendarUnitDay | NSCalendarUnitHour | NSCalendarUnitMinute) fromDate:windows[0].endDate];
+    XCTAssertEqual(firstEnd.day, 8);
+    XCTAssertEqual(firstEnd.hour, 9);
+    // midnight to 9:00 is only eight hours that day
+    XCTAssertEqual([windows[0].endDate timeIntervalSinceDate:windows[0].startDate], 8 * 3600);
+
+    NSDateComponents *secondStart = [calendar components:(NSCalendarUnitDay | NSCalendarUnitHour | NSCalendarUnitMinute) fromDate:windows[1].startDate];
+    XCTAssertEqual(secondStart.day, 8);
+    XCTAssertEqual(secondStart.hour, 17);
+    XCTAssertEqual(secondStart.minute, 0);
+    XCTAssertEqual(windows[1].startMinutes, 17 * 60);
+
+    [NSTimeZone setDefaultTimeZone:originalTimeZone];
+}
+
+- (void) testCompilesSeveralWeeks {
+    SCBlockBundle *bundle = [SCBlockBundle bundleWithName:@"Work" color:[SCBlockBundle colorBlue]];
+    bundle.entries = [@[@"facebook.com"] mutableCopy];
+    // no allowed windows at all: blocked around the clock
+    SCWeeklySchedule *schedule = [SCWeeklySchedule emptyScheduleForBundleID:bundle.bundleID];
+
+    SCScheduleManager *manager = [SCScheduleManager sharedManager];
+    SCScheduleLaunchdBridge *bridge = [[SCScheduleLaunchdBridge alloc] init];
+    NSMutableArray<SCTimelineSegment *> *timelineSegments = [NSMutableArray array];
+    for (NSInteger weekOffset = 1; weekOffset <= 3; weekOffset++) {
+        NSDate *weekStart = [SCScheduleLaunchdBridge weekStartDateForOffset:weekOffset];
+        NSArray *segments = [manager calculateBlockSegmentsForBundles:@[bundle] schedules:@[schedule] weekStartDate:weekStart bridge:bridge];
+        XCTAssertGreaterThan(segments.count, 0);
+
+        // compiling the same week again gives the same segment IDs
+        NSArray *again = [manager calculateBlockSegmentsForBundles:@[bundle] schedules:@[schedule] weekStartDate:weekStart bridge:bridge];
+        XCTAssertEqualObjects([segments valueForKey:@"segmentID"], [again valueForKey:@"segmentID"]);
+
+        for (id segment in segments) {
+            [timelineSegments addObject:[SCTimelineSegment segmentWithID:[segment valueForKey:@"segmentID"]
+                                                               startDate:[segment valueForKey:@"startDate"]
+                                                                 endDate:[segment valueForKey:@"endDate"]
+                                                             contentHash:[SCScheduleTimeline contentHashForBlocklist:bundle.entries]
+                                                               bundleIDs:@[bundle.bundleID]]];
+        }
+    }
+    SCScheduleTimeline *timeline = [SCScheduleTimeline timelineWithSegments:timelineSegments];
+
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    NSDate *firstWeek = [SCScheduleLaunchdBridge weekStartDateForOffset:1];
+    XCTAssertEqualObjects([SCScheduleLaunchdBridge weekStartDateForOffset:3],
+                          [calendar dateByAddingUnit:NSCalendarUnitDay value:14 toDate:firstWeek options:0]);
+
+    // a block that never lets up runs to the end of the last compiled week
+    NSDate *tuesday = [calendar dateByAddingUnit:NSCalendarUnitDay value:1 toDate:firstWeek options:0];
+    NSDate *blockEnd = [timeline blockEndDateForBundleID:bundle.bundleID atDate:tuesday];
+    XCTAssertEqualObjects(blockEnd, timeline.segments.lastObject.endDate);
+    XCTAssertGreaterThan([blockEnd timeIntervalSinceDate:firstWeek], 20 * 24 * 3600);
+}
+
+#pragma mark - Performance
+
+- (void) testPerformanceSegmentLookup {
+    srand48(353535);
+    NSDate *origin = [NSDate dateWithTimeIntervalSince1970:1790000000];
+    SCScheduleTimeline *timeline = [SCScheduleTimeline timelineWithSegments:[self randomSegmentsWithCount:5000 startingAt:origin]];
+    NSTimeInterval span = [timeline.segments.lastObject.endDate timeIntervalSinceDate:origin];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 20000; i++) {
+            [timeline segmentAtDate:[origin dateByAddingTimeInterval:(i * 7919) % (long)span]];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,190 @@
+//
+//  SCSegmentSchedulerTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCSegmentScheduler.h"
+
+@interface SCSegmentSchedulerTests : XCTestCase
+
+@end
+
+@implementation SCSegmentSchedulerTests
+
+// ApprovedSchedules-style entry, as registerSchedules: stores it
+- (NSDictionary *)approvedScheduleFrom:(NSDate *)start to:(NSDate *)end {
+    return @{
+        @"blocklist": @[@"example.com"],
+        @"isAllowlist": @NO,
+        @"blockSettings": @{ @"SegmentStartDate": start, @"SegmentEndDate": end },
+        @"controllingUID": @501
+    };
+}
+
+// count hourly segments, each ending a minute before the next starts, the first starting offset seconds from now
+- (NSDictionary<NSString *, NSDictionary *> *)approvedSchedulesWithCount:(NSUInteger)count startingIn:(NSTimeInterval)offset {
+    NSMutableDictionary<NSString *, NSDictionary *> *schedules = [NSMutableDictionary dictionary];
+    NSDate *start = [NSDate dateWithTimeIntervalSinceNow:offset];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSDate *end = [start dateByAddingTimeInterval:3600 - 60];
+        schedules[[NSString stringWithFormat:@"segment-%lu", (unsigned long)i]] = [self approvedScheduleFrom:start to:end];
+        start = [start dateByAddingTimeInterval:3600];
+    }
+    return schedules;
+}
+
+- (void) testActivatesInProgressSegmentImmediately {
+    XCTestExpectation *activated = [self expectationWithDescription:@"in-progress segment activated"];
+    NSDate *end = [NSDate dateWithTimeIntervalSinceNow:600];
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {
+        XCTAssertEqualObjects(segmentID, @"current");
+        XCTAssertEqualObjects(endDate, end);
+        [activated fulfill];
+    }];
+
+    [scheduler scheduleApprovedSchedules:@{
+        @"over": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:-7200] to:[NSDate dateWithTimeIntervalSinceNow:-3600]],
+        @"current": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:-60] to:end],
+        @"later": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:3600] to:[NSDate dateWithTimeIntervalSinceNow:7200]],
+        @"legacy": @{ @"blocklist": @[], @"blockSettings": @{} }
+    }];
+
+    // ended and windowless schedules are never scheduled
+    XCTAssertEqual(scheduler.segmentCount, 2);
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertEqualWithAccuracy(scheduler.nextActivationDate.timeIntervalSinceNow, 3600, 5);
+    [scheduler invalidate];
+}
+
+- (void) testActivatesSegmentsInOrderWhenTheyStart {
+    NSMutableArray<NSString *> *activations = [NSMutableArray array];
+    XCTestExpectation *bothActivated = [self expectationWithDescription:@"both segments activated"];
+    bothActivated.expectedFulfillmentCount = 2;
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {
+        [activations addObject:segmentID];
+        [bothActivated fulfill];
+    }];
+
+    [scheduler scheduleApprovedSchedules:@{
+        // spaced out by more than the timer's leeway, so the first can't be skipped as already over
+        @"second": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:2.5] to:[NSDate dateWithTimeIntervalSinceNow:600]],
+        @"first": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:0.3] to:[NSDate dateWithTimeIntervalSinceNow:2.3]]
+    }];
+    XCTAssertEqual(activations.count, 0);
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqualObjects(activations, (@[@"first", @"second"]));
+    XCTAssertNil(scheduler.nextActivationDate);
+    [scheduler invalidate];
+}
+
+- (void) testRescheduleReplacesSegments {
+    __block NSUInteger activationCount = 0;
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {
+        activationCount++;
+    }];
+
+    [scheduler scheduleApprovedSchedules:@{ @"dropped": [self approvedScheduleFrom:[NSDate dateWithTimeIntervalSinceNow:0.5] to:[NSDate dateWithTimeIntervalSinceNow:600]] }];
+    [scheduler scheduleApprovedSchedules:@{}];
+    XCTAssertEqual(scheduler.segmentCount, 0);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+    XCTAssertEqual(activationCount, 0);
+    [scheduler invalidate];
+}
+
+- (void) testActiveSegmentLookup {
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {}];
+    NSDictionary<NSString *, NSDictionary *> *schedules = [self approvedSchedulesWithCount:200 startingIn:3600];
+    [scheduler scheduleApprovedSchedules:schedules];
+    XCTAssertEqual(scheduler.segmentCount, 200);
+
+    for (NSString *segmentID in schedules) {
+        NSDate *start = schedules[segmentID][@"blockSettings"][@"SegmentStartDate"];
+        NSDate *end = schedules[segmentID][@"blockSettings"][@"SegmentEndDate"];
+
+        NSDate *foundEnd = nil;
+        XCTAssertEqualObjects([scheduler segmentIDActiveAtDate:start endDate:&foundEnd], segmentID);
+        XCTAssertEqualObjects(foundEnd, end);
+        XCTAssertEqualObjects([scheduler segmentIDActiveAtDate:[end dateByAddingTimeInterval:-1] endDate:NULL], segmentID);
+        // the minute between segments belongs to neither
+        XCTAssertNil([scheduler segmentIDActiveAtDate:[end dateByAddingTimeInterval:30] endDate:NULL]);
+    }
+    XCTAssertNil([scheduler segmentIDActiveAtDate:[NSDate date] endDate:NULL]);
+    [scheduler invalidate];
+}
+
+- (void) testOverlappingSegments {
+    NSDate *start = [NSDate dateWithTimeIntervalSinceNow:3600];
+    NSDictionary *first = [self approvedScheduleFrom:start to:[start dateByAddingTimeInterval:3600]];
+    NSDictionary *overlapping = [self approvedScheduleFrom:[start dateByAddingTimeInterval:1800] to:[start dateByAddingTimeInterval:5400]];
+    NSDictionary *inside = [self approvedScheduleFrom:[start dateByAddingTimeInterval:600] to:[start dateByAddingTimeInterval:1200]];
+    NSDictionary *adjacent = [self approvedScheduleFrom:[start dateByAddingTimeInterval:3600] to:[start dateByAddingTimeInterval:7200]];
+
+    // back-to-back segments don't overlap
+    XCTAssertNil([SCSegmentScheduler overlappingSegmentIDsInApprovedSchedules:[self approvedSchedulesWithCount:20 startingIn:3600]]);
+    XCTAssertNil([SCSegmentScheduler overlappingSegmentIDsInApprovedSchedules:(@{ @"first": first, @"adjacent": adjacent })]);
+    XCTAssertEqualObjects([SCSegmentScheduler overlappingSegmentIDsInApprovedSchedules:(@{ @"first": first, @"overlapping": overlapping })], (@[@"first", @"overlapping"]));
+    XCTAssertEqualObjects([SCSegmentScheduler overlappingSegmentIDsInApprovedSchedules:(@{ @"first": first, @"inside": inside })], (@[@"first", @"inside"]));
+
+    // if overlapping segments reach the scheduler anyway, the later one is dropped
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {}];
+    [scheduler scheduleApprovedSchedules:@{ @"first": first, @"overlapping": overlapping, @"adjacent": adjacent }];
+    XCTAssertEqual(scheduler.segmentCount, 2);
+    XCTAssertEqualObjects([scheduler segmentIDActiveAtDate:[start dateByAddingTimeInterval:3000] endDate:NULL], @"first");
+    XCTAssertEqualObjects([scheduler segmentIDActiveAtDate:[start dateByAddingTimeInterval:5000] endDate:NULL], @"adjacent");
+    [scheduler invalidate];
+}
+
+#pragma mark - Performance
+
+// Scheduling a committed week's worth of segments, as reloadScheduledSegments does
+- (void) testPerformanceScheduleApprovedSchedules {
+    NSDictionary<NSString *, NSDictionary *> *schedules = [self approvedSchedulesWithCount:200 startingIn:3600];
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {}];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [scheduler scheduleApprovedSchedules:schedules];
+        }
+    }];
+    XCTAssertEqual(scheduler.segmentCount, 200);
+    [scheduler invalidate];
+}
+
+// The lookup the checkup makes for the segment in progress
+- (void) testPerformanceActiveSegmentLookup {
+    NSDictionary<NSString *, NSDictionary *> *schedules = [self approvedSchedulesWithCount:200 startingIn:3600];
+    SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:dispatch_get_main_queue() activationHandler:^(NSString *segmentID, NSDate *endDate) {}];
+    [scheduler scheduleApprovedSchedules:schedules];
+    NSArray<NSDate *> *starts = [schedules.allValues valueForKeyPath:@"blockSettings.SegmentStartDate"];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 50; i++) {
+            for (NSDate *start in starts) {
+                [scheduler segmentIDActiveAtDate:start endDate:NULL];
+            }
+        }
+    }];
+    [scheduler invalidate];
+}
+
+// From an in-progress segment being scheduled to its activation handler running
+- (void) testPerformanceActivation {
+    dispatch_queue_t queue = dispatch_queue_create("SCSegmentSchedulerTests", DISPATCH_QUEUE_SERIAL);
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            dispatch_semaphore_t activated = dispatch_semaphore_create(0);
+            SCSegmentScheduler *scheduler = [[SCSegmentScheduler alloc] initWithQueue:queue activationHandler:^(NSString *segmentID, NSDate *endDate) {
+                dispatch_semaphore_signal(activated);
+            }];
+            [scheduler scheduleApprovedSchedules:@{ @"now": [self approvedScheduleFrom:[NSDate date] to:[NSDate dateWithTimeIntervalSinceNow:600]] }];
+            dispatch_semaphore_wait(activated, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+            [scheduler invalidate];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,100 @@
+//
+//  SCSegmentTransitionTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCSegmentTransition.h"
+#import "SCBlocklistDelta.h"
+
+@interface SCSegmentTransitionTests : XCTestCase
+
+@end
+
+@implementation SCSegmentTransitionTests
+
+// ApprovedSchedules-style entry, as registerSchedules: stores it
+- (NSDictionary *)approvedScheduleWithBlocklist:(NSArray<NSString *> *)blocklist from:(NSDate *)start to:(NSDate *)end {
+    return @{
+        @"blocklist": blocklist,
+        @"isAllowlist": @NO,
+        @"blockSettings": @{ @"SegmentStartDate": start, @"SegmentEndDate": end },
+        @"controllingUID": @501
+    };
+}
+
+// The checkup at a segment boundary: the running segment has just expired and the
+// next one starts a minute later (launchd's gap between back-to-back blocks)
+- (void) testBoundaryMovesOntoContinuingSegment {
+    NSDate *boundary = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSDate *nextEnd = [boundary dateByAddingTimeInterval:3600];
+    NSDictionary *approvedSchedules = @{
+        @"morning": [self approvedScheduleWithBlocklist:@[@"a.com", @"b.com"] from:[boundary dateByAddingTimeInterval:-3600] to:boundary],
+        @"afternoon": [self approvedScheduleWithBlocklist:@[@"b.com", @"c.com"] from:[boundary dateByAddingTimeInterval:60] to:nextEnd],
+        @"evening": [self approvedScheduleWithBlocklist:@[@"d.com"] from:[boundary dateByAddingTimeInterval:7200] to:[boundary dateByAddingTimeInterval:9000]]
+    };
+
+    SCSegmentTransition *transition = [SCSegmentTransition transitionFromScheduleID:@"morning"
+                                                                          blocklist:@[@"a.com", @"b.com"]
+                                                                           endingAt:boundary
+                                                                  approvedSchedules:approvedSchedules
+                                                                 approvedBlocklists:nil
+                                                                                now:[boundary dateByAddingTimeInterval:1]];
+
+    XCTAssertNotNil(transition);
+    XCTAssertEqualObjects(transition.segmentID, @"afternoon");
+    XCTAssertEqualObjects(transition.blocklist, (@[@"b.com", @"c.com"]));
+    XCTAssertEqualObjects(transition.endDate, nextEnd);
+    XCTAssertEqualObjects(transition.delta.addedEntries, @[@"c.com"]);
+    XCTAssertEqualObjects(transition.delta.removedEntries, @[@"a.com"]);
+}
+
+- (void) testNoTransitionAcrossARealGap {
+    NSDate *boundary = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSDictionary *approvedSchedules = @{
+        @"later": [self approvedScheduleWithBlocklist:@[@"c.com"] from:[boundary dateByAddingTimeInterval:600] to:[boundary dateByAddingTimeInterval:3600]],
+        @"allowlist": @{
+            @"blocklist": @[@"c.com"],
+            @"isAllowlist": @YES,
+            @"blockSettings": @{ @"SegmentStartDate": [boundary dateByAddingTimeInterval:60], @"SegmentEndDate": [boundary dateByAddingTimeInterval:3600] }
+        },
+        @"legacy": @{ @"blocklist": @[@"c.com"], @"blockSettings": @{} }
+    };
+
+    XCTAssertNil([SCSegmentTransition transitionFromScheduleID:@"morning" blocklist:@[@"a.com"] endingAt:boundary
+                                             approvedSchedules:approvedSchedules approvedBlocklists:nil now:boundary]);
+    // blocks that weren't started by the schedule never transition
+    XCTAssertNil([SCSegmentTransition transitionFromScheduleID:nil blocklist:@[@"a.com"] endingAt:boundary
+                                             approvedSchedules:approvedSchedules approvedBlocklists:nil now:boundary]);
+}
+
+// a checkup that runs long after the boundary (e.g. after sleep) mustn't pick up a segment that already ended
+- (void) testNoTransitionOntoEndedSegment {
+    NSDate *boundary = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSDictionary *approvedSchedules = @{
+        @"short": [self approvedScheduleWithBlocklist:@[@"c.com"] from:[boundary dateByAddingTimeInterval:60] to:[boundary dateByAddingTimeInterval:600]]
+    };
+
+    XCTAssertNil([SCSegmentTransition transitionFromScheduleID:@"morning" blocklist:@[@"a.com"] endingAt:boundary
+                                             approvedSchedules:approvedSchedules approvedBlocklists:nil now:[boundary dateByAddingTimeInterval:900]]);
+}
+
+// what the daemon re-checks under its lock once the new blocklist has resolved
+- (void) testTransitionGoesStaleWhenBlockChanges {
+    NSDate *boundary = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSDictionary *approvedSchedules = @{
+        @"afternoon": [self approvedScheduleWithBlocklist:@[@"c.com"] from:[boundary dateByAddingTimeInterval:60] to:[boundary dateByAddingTimeInterval:3600]]
+    };
+    SCSegmentTransition *transition = [SCSegmentTransition transitionFromScheduleID:@"morning" blocklist:@[@"a.com"] endingAt:boundary
+                                                                  approvedSchedules:approvedSchedules approvedBlocklists:nil now:boundary];
+    XCTAssertNotNil(transition);
+
+    XCTAssertTrue([transition isCurrentForScheduleID:@"morning" blocklist:@[@"a.com"] endDate:boundary]);
+    // the segment's own launchd job got there first
+    XCTAssertFalse([transition isCurrentForScheduleID:@"afternoon" blocklist:@[@"c.com"] endDate:[boundary dateByAddingTimeInterval:3600]]);
+    // the block was extended, or had sites added
+    XCTAssertFalse([transition isCurrentForScheduleID:@"morning" blocklist:@[@"a.com"] endDate:[boundary dateByAddingTimeInterval:600]]);
+    XCTAssertFalse([transition isCurrentForScheduleID:@"morning" blocklist:@[@"a.com", @"b.com"] endDate:boundary]);
+}
+
+@end
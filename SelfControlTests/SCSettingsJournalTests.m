@@ -0,0 +1,158 @@
+//
+//  SCSettingsJournalTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCSettingsJournal.h"
+
+@interface SCSettingsJournalTests : XCTestCase
+
+@property NSString* tempDir;
+
+@end
+
+@implementation SCSettingsJournalTests
+
+- (void)setUp {
+    self.tempDir = [NSTemporaryDirectory() stringByAppendingPathComponent: [NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath: self.tempDir withIntermediateDirectories: YES attributes: nil error: nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: self.tempDir error: nil];
+}
+
+- (SCSettingsJournal*)newJournal {
+    return [SCSettingsJournal journalWithPath: [self.tempDir stringByAppendingPathComponent: @"settings.journal"]];
+}
+
+- (void) testJournalReplay {
+    SCSettingsJournal* journal = [self newJournal];
+    NSDictionary* snapshot = @{ @"SettingsVersionNumber": @3, @"BlockIsRunning": @NO, @"ActiveBlocklist": @[@"facebook.com"] };
+
+    // an empty/missing journal replays to exactly the snapshot
+    XCTAssert([[journal dictionaryByReplayingOntoSnapshot: snapshot] isEqualToDictionary: snapshot]);
+
+    NSError* err;
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @4, @"BlockIsRunning": @YES } unsetKeys: @[] error: &err]);
+    XCTAssertNil(err);
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @5 } unsetKeys: @[@"ActiveBlocklist"] error: &err]);
+    XCTAssertNil(err);
+
+    NSDictionary* replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed[@"SettingsVersionNumber"] intValue] == 5);
+    XCTAssert([replayed[@"BlockIsRunning"] boolValue]);
+    XCTAssertNil(replayed[@"ActiveBlocklist"]);
+    XCTAssert(journal.recordCount == 2);
+
+    // no snapshot at all (e.g. it was deleted): everything in the journal still applies
+    NSDictionary* replayedWithoutSnapshot = [journal dictionaryByReplayingOntoSnapshot: nil];
+    XCTAssert([replayedWithoutSnapshot[@"SettingsVersionNumber"] intValue] == 5);
+
+    XCTAssert([journal truncate: &err]);
+    XCTAssert(journal.journalSize == 0);
+    XCTAssert([[journal dictionaryByReplayingOntoSnapshot: snapshot] isEqualToDictionary: snapshot]);
+}
+
+- (void) testJournalTornTailRecovery {
+    SCSettingsJournal* journal = [self newJournal];
+    NSDictionary* snapshot = @{ @"SettingsVersionNumber": @1 };
+
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @2, @"TestKey": @"first" } unsetKeys: @[] error: nil]);
+    unsigned long long intactSize = journal.journalSize;
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @3, @"TestKey": @"second" } unsetKeys: @[] error: nil]);
+
+    // simulate a crash halfway through writing the second record
+    XCTAssert(truncate(journal.journalPath.fileSystemRepresentation, (off_t)(intactSize + 5)) == 0);
+
+    NSDictionary* replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed[@"TestKey"] isEqualToString: @"first"]);
+    XCTAssert([replayed[@"SettingsVersionNumber"] intValue] == 2);
+
+    // the writer cuts the torn record off so new appends are readable again
+    XCTAssert([journal discardTornTail: nil]);
+    XCTAssert(journal.journalSize == intactSize);
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @3, @"TestKey": @"third" } unsetKeys: @[] error: nil]);
+    replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed[@"TestKey"] isEqualToString: @"third"]);
+
+    // garbage with a bad checksum is treated the same way
+    NSFileHandle* handle = [NSFileHandle fileHandleForWritingAtPath: journal.journalPath];
+    [handle seekToEndOfFile];
+    uint32_t bogusHeader[2] = { CFSwapInt32HostToLittle(4), 0xDEADBEEF };
+    [handle writeData: [NSData dataWithBytes: bogusHeader length: sizeof(bogusHeader)]];
+    [handle writeData: [@"junk" dataUsingEncoding: NSUTF8StringEncoding]];
+    [handle closeFile];
+
+    replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed[@"TestKey"] isEqualToString: @"third"]);
+    XCTAssert(journal.recordCount == 2);
+}
+
+- (void) testJournalSkipsRecordsAlreadyInSnapshot {
+    SCSettingsJournal* journal = [self newJournal];
+
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @2, @"TestKey": @"old" } unsetKeys: @[] error: nil]);
+
+    // a compaction wrote version 5 but crashed before truncating the journal;
+    // the stale record must not roll TestKey back
+    NSDictionary* snapshot = @{ @"SettingsVersionNumber": @5, @"TestKey": @"new" };
+    NSDictionary* replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed isEqualToDictionary: snapshot]);
+
+    XCTAssert([journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @6, @"TestKey": @"newest" } unsetKeys: @[] error: nil]);
+    replayed = [journal dictionaryByReplayingOntoSnapshot: snapshot];
+    XCTAssert([replayed[@"TestKey"] isEqualToString: @"newest"]);
+}
+
+// Benchmarks: rewriting the whole settings plist (the old write path) vs. appending one change
+
+- (NSDictionary*)largeSettingsDict {
+    NSMutableDictionary* approvedSchedules = [NSMutableDictionary dictionary];
+    for (int i = 0; i < 200; i++) {
+        NSMutableArray* blocklist = [NSMutableArray array];
+        for (int j = 0; j < 100; j++) {
+            [blocklist addObject: [NSString stringWithFormat: @"site%d-%d.example.com", i, j]];
+        }
+        approvedSchedules[[NSUUID UUID].UUIDString] = @{ @"blocklist": blocklist, @"startDate": [NSDate date], @"endDate": [NSDate distantFuture] };
+    }
+
+    return @{
+        @"SettingsVersionNumber": @100,
+        @"LastSettingsUpdate": [NSDate date],
+        @"BlockIsRunning": @YES,
+        @"ApprovedSchedules": approvedSchedules
+    };
+}
+
+- (void) testPerformanceFullSnapshotWrite {
+    NSDictionary* settings = [self largeSettingsDict];
+    NSString* path = [self.tempDir stringByAppendingPathComponent: @"settings.plist"];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            NSData* plistData = [NSPropertyListSerialization dataWithPropertyList: settings
+                                                                           format: NSPropertyListBinaryFormat_v1_0
+                                                                          options: kNilOptions
+                                                                            error: nil];
+            [plistData writeToFile: path options: NSDataWritingAtomic error: nil];
+        }
+    }];
+}
+
+- (void) testPerformanceJournalAppend {
+    SCSettingsJournal* journal = [self newJournal];
+    __block int version = 100;
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            version++;
+            [journal appendChangeSetWithValues: @{ @"SettingsVersionNumber": @(version), @"LastSettingsUpdate": [NSDate date], @"BlockIsRunning": @YES }
+                                     unsetKeys: @[]
+                                         error: nil];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,112 @@
+//
+//  SCSettingsSharedSegmentTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCSettingsSharedSegment.h"
+
+@interface SCSettingsSharedSegmentTests : XCTestCase
+
+@property NSString* segmentPath;
+
+@end
+
+@implementation SCSettingsSharedSegmentTests
+
+- (void)setUp {
+    self.segmentPath = [NSTemporaryDirectory() stringByAppendingPathComponent: [NSString stringWithFormat: @"%@.shm", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: self.segmentPath error: nil];
+}
+
+- (void) testSharedSegmentPublishAndRead {
+    // nothing published yet
+    XCTAssertNil([SCSettingsSharedSegment readerWithPath: self.segmentPath]);
+
+    SCSettingsSharedSegment* publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssertNotNil(publisher);
+    SCSettingsSharedSegment* reader = [SCSettingsSharedSegment readerWithPath: self.segmentPath];
+    XCTAssertNotNil(reader);
+    XCTAssertNil([reader readSettingsWithSequence: NULL]);
+
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @1, @"BlockIsRunning": @NO }]);
+    uint64_t firstSequence = 0;
+    NSDictionary* settings = [reader readSettingsWithSequence: &firstSequence];
+    XCTAssert([settings[@"SettingsVersionNumber"] intValue] == 1);
+    XCTAssert(firstSequence == reader.sequence);
+    XCTAssert(firstSequence % 2 == 0);
+
+    // the reader sees a new publish through its existing mapping
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @2, @"BlockIsRunning": @YES }]);
+    XCTAssert(reader.sequence > firstSequence);
+    settings = [reader readSettingsWithSequence: NULL];
+    XCTAssert([settings[@"BlockIsRunning"] boolValue]);
+
+    // a restarted publisher carries on the same sequence rather than starting over
+    uint64_t sequenceBeforeRestart = reader.sequence;
+    publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @3 }]);
+    XCTAssert(reader.sequence > sequenceBeforeRestart);
+    XCTAssert([[reader readSettingsWithSequence: NULL][@"SettingsVersionNumber"] intValue] == 3);
+}
+
+- (void) testSharedSegmentGrowsForLargeSettings {
+    SCSettingsSharedSegment* publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @1 }]);
+    SCSettingsSharedSegment* reader = [SCSettingsSharedSegment readerWithPath: self.segmentPath];
+
+    // bigger than the initial mapping on both sides
+    NSMutableArray* blocklist = [NSMutableArray array];
+    for (int i = 0; i < 100000; i++) {
+        [blocklist addObject: [NSString stringWithFormat: @"site%d.example.com", i]];
+    }
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @2, @"ActiveBlocklist": blocklist }]);
+
+    NSDictionary* settings = [reader readSettingsWithSequence: NULL];
+    XCTAssert([settings[@"ActiveBlocklist"] count] == 100000);
+    XCTAssert([settings[@"ActiveBlocklist"][99999] isEqualToString: @"site99999.example.com"]);
+}
+
+- (void) testSharedSegmentEpochs {
+    SCSettingsSharedSegment* publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @5 }]);
+    SCSettingsSharedSegment* reader = [SCSettingsSharedSegment readerWithPath: self.segmentPath];
+
+    uint64_t firstEpoch = 0;
+    XCTAssertNotNil([reader readSettingsWithSequence: NULL epoch: &firstEpoch]);
+    XCTAssert(firstEpoch != 0);
+    XCTAssert(firstEpoch == publisher.publisherEpoch);
+
+    // a restarted publisher can go back to a lower version, but readers can tell from the epoch
+    publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @0 }]);
+    uint64_t restartedEpoch = 0;
+    XCTAssert([[reader readSettingsWithSequence: NULL epoch: &restartedEpoch][@"SettingsVersionNumber"] intValue] == 0);
+    XCTAssert(restartedEpoch != firstEpoch);
+
+    [publisher startNewEpoch];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @0 }]);
+    uint64_t resetEpoch = 0;
+    [reader readSettingsWithSequence: NULL epoch: &resetEpoch];
+    XCTAssert(resetEpoch != restartedEpoch);
+}
+
+- (void) testSharedSegmentNoticesRemovedFile {
+    SCSettingsSharedSegment* publisher = [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert([publisher publishSettings: @{ @"SettingsVersionNumber": @1 }]);
+    SCSettingsSharedSegment* reader = [SCSettingsSharedSegment readerWithPath: self.segmentPath];
+    XCTAssertFalse(reader.isDetachedFromPath);
+
+    [[NSFileManager defaultManager] removeItemAtPath: self.segmentPath error: nil];
+    XCTAssert(reader.isDetachedFromPath);
+
+    // a new file at the same path is a different segment
+    [SCSettingsSharedSegment publisherWithPath: self.segmentPath];
+    XCTAssert(reader.isDetachedFromPath);
+    XCTAssertFalse([SCSettingsSharedSegment readerWithPath: self.segmentPath].isDetachedFromPath);
+}
+
+@end
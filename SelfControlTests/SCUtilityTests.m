@@ -10,6 +10,7 @@
 #import "SCSentry.h"
 #import "SCErr.h"
 #import "SCSettings.h"
+#import "SCBlocklistDelta.h"
 
 @interface SCUtilityTests : XCTestCase
 
@@ -164,6 +165,71 @@ NSDictionary* veryLongBlockLegacyDict; // year-long block, one day in
     XCTAssert([SCBlockUtilities currentBlockIsExpired]);
 }
 
+- (void) testBlocklistDelta {
+    SCBlocklistDelta* delta = [SCBlocklistDelta deltaFromBlocklist: @[ @"facebook.com", @"reddit.com", @"app:com.apple.Terminal" ]
+                                                      toBlocklist: @[ @"reddit.com", @"twitter.com", @"twitter.com", @"app:com.apple.Terminal" ]];
+    XCTAssert([delta.addedEntries isEqualToArray: @[ @"twitter.com" ]]);
+    XCTAssert([delta.removedEntries isEqualToArray: @[ @"facebook.com" ]]);
+    XCTAssert(delta.unchangedCount == 2);
+    XCTAssert(delta.hasRemovals && !delta.isEmpty);
+
+    // dropping removals keeps the additions, and the enforced list keeps the removed entry
+    SCBlocklistDelta* addOnly = [delta deltaByDroppingRemovals];
+    XCTAssert(!addOnly.hasRemovals && [addOnly.addedEntries isEqualToArray: @[ @"twitter.com" ]]);
+    NSArray* enforced = [delta blocklistByApplyingAdditionsToBlocklist: @[ @"facebook.com", @"reddit.com" ]];
+    XCTAssert([enforced isEqualToArray: @[ @"facebook.com", @"reddit.com", @"twitter.com" ]]);
+
+    // same entries in a different order is not a change
+    XCTAssert([SCBlocklistDelta deltaFromBlocklist: @[ @"a.com", @"b.com" ] toBlocklist: @[ @"b.com", @"a.com" ]].isEmpty);
+    XCTAssert([SCBlocklistDelta deltaFromBlocklist: nil toBlocklist: nil].isEmpty);
+    XCTAssert([SCBlocklistDelta deltaFromBlocklist: nil toBlocklist: @[ @"a.com" ]].addedEntries.count == 1);
+}
+
+- (void) testBatchedSettingsChanges {
+    SCSettings* settings = [SCSettings sharedSettings];
+    [settings setValue: @"old" forKey: @"ActiveScheduleID"];
+    int versionBefore = [[settings valueForKey: @"SettingsVersionNumber"] intValue];
+
+    [settings setValuesForKeys: @{
+        @"ActiveBlocklist": @[ @"facebook.com" ],
+        @"BlockSound": @3,
+        @"ActiveScheduleID": [NSNull null]
+    }];
+
+    // the whole batch counts as one change
+    XCTAssert([[settings valueForKey: @"SettingsVersionNumber"] intValue] == versionBefore + 1);
+    XCTAssert([[settings valueForKey: @"ActiveBlocklist"] isEqualToArray: @[ @"facebook.com" ]]);
+    XCTAssert([[settings valueForKey: @"BlockSound"] intValue] == 3);
+    XCTAssert([settings valueForKey: @"ActiveScheduleID"] == nil);
+
+    [settings resetAllSettingsToDefaults];
+    XCTAssert([[settings valueForKey: @"ActiveBlocklist"] count] == 0);
+    XCTAssert([[settings valueForKey: @"BlockSound"] intValue] == 5);
+}
+
+- (void) testSettingsSnapshotReads {
+    SCSettings* settings = [SCSettings sharedSettings];
+    [settings setValue: @[ @"facebook.com" ] forKey: @"ActiveBlocklist"];
+
+    // a snapshot handed out earlier never changes underneath its holder
+    NSDictionary* snapshot = settings.dictionaryRepresentation;
+    [settings setValue: @[ @"twitter.com" ] forKey: @"ActiveBlocklist"];
+    XCTAssert([snapshot[@"ActiveBlocklist"] isEqualToArray: @[ @"facebook.com" ]]);
+    XCTAssert([[settings valueForKey: @"ActiveBlocklist"] isEqualToArray: @[ @"twitter.com" ]]);
+    XCTAssert([settings.dictionaryRepresentation[@"ActiveBlocklist"] isEqualToArray: @[ @"twitter.com" ]]);
+
+    // with no writes in between, readers share the same snapshot
+    XCTAssert(settings.dictionaryRepresentation == settings.dictionaryRepresentation);
+
+    // unset keys fall back to their defaults, and unknown keys stay nil
+    [settings setValue: nil forKey: @"BlockSound"];
+    XCTAssert([[settings valueForKey: @"BlockSound"] intValue] == 5);
+    XCTAssert([settings.dictionaryRepresentation[@"BlockSound"] intValue] == 5);
+    XCTAssert([settings valueForKey: @"NotARealSettingKey"] == nil);
+
+    [settings resetAllSettingsToDefaults];
+}
+
 - (void) testLegacyBlockDetection {
     // test blockIsRunningInLegacyDictionary
     // the block is "running" even if it's expired, since it hasn't been removed
@@ -0,0 +1,168 @@
+//
+//  SCWeeklyScheduleTests.m
+//  SelfControlTests
+//
+
+#import <XCTest/XCTest.h>
+#import "SCWeeklySchedule.h"
+#import "SCTimeRange.h"
+
+@interface SCWeeklyScheduleTests : XCTestCase
+
+@end
+
+@implementation SCWeeklyScheduleTests
+
+- (NSString *)timeStringForMinutes:(NSInteger)minutes {
+    return [NSString stringWithFormat:@"%02ld:%02ld", (long)(minutes / 60), (long)(minutes % 60)];
+}
+
+- (SCWeeklySchedule *)randomScheduleWithSeed:(long)seed {
+    srand48(seed);
+    SCWeeklySchedule *schedule = [SCWeeklySchedule emptyScheduleForBundleID:[NSString stringWithFormat:@"bundle-%ld", seed]];
+    for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
+        double roll = drand48();
+        if (roll < 0.15) continue; // blocked all day
+
+        NSMutableArray<SCTimeRange *> *ranges = [NSMutableArray array];
+        if (roll < 0.25) {
+            // allowed all day, right up to midnight
+            [ranges addObject:[SCTimeRange rangeWithStart:@"00:00" end:@"23:59"]];
+        } else {
+            NSInteger minute = lrand48() % 120;
+            while (minute < 23 * 60) {
+                NSInteger end = MIN(minute + 1 + lrand48() % 240, 23 * 60 + 59);
+                [ranges addObject:[SCTimeRange rangeWithStart:[self timeStringForMinutes:minute] end:[self timeStringForMinutes:end]]];
+                minute = end + 1 + lrand48() % 300;
+            }
+        }
+        [schedule setAllowedWindows:ranges forDay:day];
+    }
+    return schedule;
+}
+
+// The original scan: every minute of the next seven days, checked against every window
+- (NSDate *)bruteForceNextStateChangeForSchedule:(SCWeeklySchedule *)schedule afterDate:(NSDate *)date {
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    NSDateComponents *nowComponents = [calendar components:(NSCalendarUnitWeekday | NSCalendarUnitHour | NSCalendarUnitMinute)
+                                                  fromDate:date];
+    SCDayOfWeek today = (SCDayOfWeek)(nowComponents.weekday - 1);
+    NSInteger currentMinutes = nowComponents.hour * 60 + nowComponents.minute;
+    BOOL currentlyAllowed = [schedule isAllowedOnDay:today atMinutes:currentMinutes];
+
+    for (NSInteger dayOffset = 0; dayOffset < 7; dayOffset++) {
+        SCDayOfWeek checkDay = (today + dayOffset) % 7;
+        NSArray<SCTimeRange *> *windows = [schedule allowedWindowsForDay:checkDay];
+
+        for (NSInteger minute = (dayOffset == 0) ? currentMinutes + 1 : 0; minute < 24 * 60; minute++) {
+            BOOL allowedAtMinute = NO;
+            for (SCTimeRange *window in windows) {
+                if ([window containsTimeInMinutes:minute]) {
+                    allowedAtMinute = YES;
+                    break;
+                }
+            }
+
+            if (allowedAtMinute != currentlyAllowed) {
+                NSDate *targetDate = [calendar dateByAddingUnit:NSCalendarUnitDay value:dayOffset toDate:date options:0];
+                NSDateComponents *targetComponents = [calendar components:(NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay)
+                                                                 fromDate:targetDate];
+                targetComponents.hour = minute / 60;
+                targetComponents.minute = minute % 60;
+                return [calendar dateFromComponents:targetComponents];
+            }
+        }
+    }
+    return nil;
+}
+
+- (void) testNextStateChangeMatchesBruteForce {
+    NSDate *weekStart = [SCWeeklySchedule startOfCurrentWeek];
+    NSMutableArray<NSDate *> *probeDates = [NSMutableArray array];
+    // every 37 minutes across the week, plus the week boundaries
+    for (NSInteger minute = 0; minute < 7 * 24 * 60; minute += 37) {
+        [probeDates addObject:[weekStart dateByAddingTimeInterval:minute * 60]];
+    }
+    [probeDates addObject:[weekStart dateByAddingTimeInterval:-60]];
+    [probeDates addObject:[weekStart dateByAddingTimeInterval:7 * 24 * 60 * 60 - 60]];
+
+    for (long seed = 1; seed <= 20; seed++) {
+        SCWeeklySchedule *schedule = [self randomScheduleWithSeed:seed];
+        for (NSDate *date in probeDates) {
+            XCTAssertEqualObjects([schedule nextStateChangeDateAfterDate:date],
+                                  [self bruteForceNextStateChangeForSchedule:schedule afterDate:date],
+                                  @"seed %ld at %@", seed, date);
+        }
+    }
+
+    // never changes state
+    SCWeeklySchedule *alwaysBlocked = [SCWeeklySchedule emptyScheduleForBundleID:@"blocked"];
+    XCTAssertNil([alwaysBlocked nextStateChangeDateAfterDate:[NSDate date]]);
+}
+
+- (void) testNextStateChangeFollowsEdits {
+    SCWeeklySchedule *schedule = [SCWeeklySchedule emptyScheduleForBundleID:@"edits"];
+    NSDate *date = [[SCWeeklySchedule startOfCurrentWeek] dateByAddingTimeInterval:8 * 60 * 60]; // Monday 8am
+    XCTAssertNil([schedule nextStateChangeDateAfterDate:date]);
+
+    SCTimeRange *range = [SCTimeRange rangeWithStart:@"09:00" end:@"17:00"];
+    [schedule addAllowedWindow:range toDay:SCDayOfWeekMonday];
+    XCTAssertEqualObjects([schedule nextStateChangeDateAfterDate:date], [self bruteForceNextStateChangeForSchedule:schedule afterDate:date]);
+
+    // ranges edited in place (like the day editor does while dragging) are picked up too
+    range.startTime = @"10:30";
+    XCTAssertEqualObjects([schedule nextStateChangeDateAfterDate:date], [self bruteForceNextStateChangeForSchedule:schedule afterDate:date]);
+
+    [schedule clearDay:SCDayOfWeekMonday];
+    XCTAssertNil([schedule nextStateChangeDateAfterDate:date]);
+}
+
+- (void) testScheduleMaskQueries {
+    for (long seed = 1; seed <= 10; seed++) {
+        SCWeeklySchedule *schedule = [self randomScheduleWithSeed:seed];
+        for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
+            NSArray<SCTimeRange *> *windows = [schedule allowedWindowsForDay:day];
+
+            // same answers as checking each window's containsTimeInMinutes: (end time inclusive)
+            for (NSInteger minute = 0; minute < 24 * 60; minute++) {
+                BOOL expectedAllowed = NO;
+                for (SCTimeRange *window in windows) {
+                    if ([window containsTimeInMinutes:minute]) expectedAllowed = YES;
+                }
+                XCTAssertEqual([schedule isAllowedOnDay:day atMinutes:minute], expectedAllowed);
+            }
+
+            // these windows never overlap, so the popcount matches the summed durations
+            NSInteger expectedTotal = 0;
+            for (SCTimeRange *window in windows) expectedTotal += [window durationMinutes];
+            XCTAssertEqual([schedule totalAllowedMinutesForDay:day], expectedTotal);
+        }
+
+        // persistence format is untouched
+        SCWeeklySchedule *roundTripped = [SCWeeklySchedule scheduleFromDictionary:[schedule toDictionary]];
+        for (SCDayOfWeek day = SCDayOfWeekSunday; day <= SCDayOfWeekSaturday; day++) {
+            XCTAssertEqual([roundTripped totalAllowedMinutesForDay:day], [schedule totalAllowedMinutesForDay:day]);
+        }
+        NSDate *date = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+        XCTAssertEqualObjects([roundTripped nextStateChangeDateAfterDate:date], [schedule nextStateChangeDateAfterDate:date]);
+    }
+
+    // overlapping windows only count once
+    SCWeeklySchedule *overlapping = [SCWeeklySchedule emptyScheduleForBundleID:@"overlap"];
+    [overlapping setAllowedWindows:@[[SCTimeRange rangeWithStart:@"09:00" end:@"12:00"], [SCTimeRange rangeWithStart:@"11:00" end:@"13:00"]] forDay:SCDayOfWeekTuesday];
+    XCTAssertEqual([overlapping totalAllowedMinutesForDay:SCDayOfWeekTuesday], 240);
+}
+
+
+- (void) testWeekKeyRoundTrip {
+    NSDate *date = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSString *weekKey = [SCWeeklySchedule weekKeyForDate:date];
+
+    // always a Gregorian ISO date, so stored keys still parse after a locale or calendar change
+    NSRegularExpression *isoDate = [NSRegularExpression regularExpressionWithPattern:@"^[0-9]{4}-[0-9]{2}-[0-9]{2}$" options:0 error:nil];
+    XCTAssertEqual([isoDate numberOfMatchesInString:weekKey options:0 range:NSMakeRange(0, weekKey.length)], 1);
+    XCTAssertEqualObjects([SCWeeklySchedule weekStartDateForWeekKey:weekKey], [SCWeeklySchedule startOfWeekContaining:date]);
+    XCTAssertNil([SCWeeklySchedule weekStartDateForWeekKey:@"not a week"]);
+}
+
+@end
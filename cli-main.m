@@ -25,12 +25,127 @@
 #import "SCSettings.h"
 #import "SCXPCClient.h"
 #import "SCBlockFileReaderWriter.h"
+#import "SCDaemonProtocol.h"
 #import <sysexits.h>
+#import <sys/sysctl.h>
 #import "XPMArguments.h"
 
+// Scheduled activations: at every segment boundary launchd runs
+//   selfcontrol-cli start --schedule-id=<id> --startdate=<date> --enddate=<date>
+// Everything that needs is in the arguments and the daemon, so it's handled before main sets up
+// Sentry, the argument parser, SCSettings, user defaults or an authorization session, none of
+// which it uses. The goal is to have the message on its way to the daemon well under 50ms
+// after exec; how long it actually took is logged with every activation.
+
+// Milliseconds since the kernel started this process, or -1 if it can't be found out
+static double SCMillisecondsSinceLaunch(void) {
+    struct kinfo_proc info;
+    size_t length = sizeof(info);
+    int mib[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+    if (sysctl(mib, 4, &info, &length, NULL, 0) != 0 || length == 0) return -1;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct timeval started = info.kp_proc.p_starttime;
+    return (now.tv_sec - started.tv_sec) * 1000.0 + (now.tv_usec - started.tv_usec) / 1000.0;
+}
+
+// Fills in the values if the arguments are exactly a scheduled activation (flags given as
+// either --flag=value or --flag value). Anything else, e.g. a --uid, goes through the full CLI.
+static BOOL SCParseScheduledActivation(int argc, char* argv[], NSString** scheduleId, NSString** startDateString, NSString** endDateString) {
+    if (argc < 3 || strcmp(argv[1], "start") != 0) return NO;
+
+    NSDictionary<NSString*, NSString*>* flags = @{ @"--schedule-id": @"scheduleId", @"--startdate": @"startDate", @"--enddate": @"endDate" };
+    NSMutableDictionary<NSString*, NSString*>* values = [NSMutableDictionary dictionary];
+    for (int i = 2; i < argc; i++) {
+        NSString* arg = @(argv[i]);
+        NSString* value = nil;
+        NSRange equals = [arg rangeOfString: @"="];
+        if (equals.location != NSNotFound) {
+            value = [arg substringFromIndex: NSMaxRange(equals)];
+            arg = [arg substringToIndex: equals.location];
+        } else if (i + 1 < argc) {
+            value = @(argv[++i]);
+        }
+
+        NSString* key = flags[arg];
+        if (key == nil || value == nil || values[key] != nil) return NO;
+        values[key] = value;
+    }
+    if (values[@"scheduleId"].length == 0) return NO;
+
+    *scheduleId = values[@"scheduleId"];
+    *startDateString = values[@"startDate"];
+    *endDateString = values[@"endDate"];
+    return YES;
+}
+
+static int SCRunScheduledActivation(NSString* scheduleId, NSString* startDateString, NSString* endDateString) {
+    NSLog(@"=== SCHEDULED BLOCK START (fast) ===");
+    NSLog(@"CLI: scheduleId = %@, startDate = %@, endDate = %@", scheduleId, startDateString, endDateString);
+
+    NSISO8601DateFormatter* isoFormatter = [NSISO8601DateFormatter new];
+    NSDate* startDate = startDateString != nil ? [isoFormatter dateFromString: startDateString] : nil;
+    NSDate* endDate = endDateString != nil ? [isoFormatter dateFromString: endDateString] : nil;
+    NSDate* now = [NSDate date];
+
+    // "Next Week's Sunday" job firing on "This Week's Sunday": valid, just not yet
+    if (startDate != nil && [now compare: startDate] == NSOrderedAscending) {
+        NSLog(@"CLI: Job is for future week (startDate=%@), skipping without cleanup", startDate);
+        return EXIT_SUCCESS;
+    }
+    BOOL expired = (endDate == nil || [now compare: endDate] == NSOrderedDescending);
+
+    // starting an approved schedule and cleaning up a stale one both need no authorization
+    NSXPCConnection* connection = [[NSXPCConnection alloc] initWithMachServiceName: @"org.eyebeam.selfcontrold" options: NSXPCConnectionPrivileged];
+    connection.remoteObjectInterface = [NSXPCInterface interfaceWithProtocol: @protocol(SCDaemonProtocol)];
+    [connection resume];
+
+    dispatch_semaphore_t replySema = dispatch_semaphore_create(0);
+    __block NSError* replyError = nil;
+    void (^reply)(NSError*) = ^(NSError* error) {
+        replyError = error;
+        dispatch_semaphore_signal(replySema);
+    };
+    id<SCDaemonProtocol> daemon = [connection remoteObjectProxyWithErrorHandler: reply];
+
+    if (expired) {
+        NSLog(@"CLI: Job has expired (endDate=%@), cleaning up stale schedule", endDate);
+        [daemon cleanupStaleScheduleWithID: scheduleId reply: reply];
+    } else {
+        [daemon startScheduledBlockWithID: scheduleId endDate: endDate reply: reply];
+    }
+    NSLog(@"CLI: Sent schedule %@ to daemon %.1f ms after launch", scheduleId, SCMillisecondsSinceLaunch());
+
+    // replies arrive on the connection's queue, so there's no run loop to spin
+    long timedOut = dispatch_semaphore_wait(replySema, dispatch_time(DISPATCH_TIME_NOW, 30 * NSEC_PER_SEC));
+    [connection invalidate];
+
+    if (timedOut) {
+        replyError = [NSError errorWithDomain: @"SelfControl" code: 408 userInfo: @{NSLocalizedDescriptionKey: @"XPC call timed out"}];
+    }
+    if (replyError != nil) {
+        NSLog(@"CLI ERROR: Daemon returned error: %@", replyError);
+        // Sentry only gets started once there's something to report
+        [SCSentry startSentry: @"org.eyebeam.selfcontrol-cli"];
+        [SCSentry captureError: replyError];
+        return expired ? EXIT_SUCCESS : EX_SOFTWARE;
+    }
+
+    NSLog(@"CLI: Scheduled block %@ %@", scheduleId, expired ? @"cleaned up" : @"successfully started!");
+    return EXIT_SUCCESS;
+}
+
 // The main method which deals which most of the logic flow and execution of
 // the CLI tool.
 int main(int argc, char* argv[]) {
+    @autoreleasepool {
+        NSString *scheduleId, *startDateString, *endDateString;
+        if (SCParseScheduledActivation(argc, argv, &scheduleId, &startDateString, &endDateString)) {
+            exit(SCRunScheduledActivation(scheduleId, startDateString, endDateString));
+        }
+    }
+
     [SCSentry startSentry: @"org.eyebeam.selfcontrol-cli"];
 
     @autoreleasepool {
@@ -108,7 +223,7 @@ int main(int argc, char* argv[]) {
                     NSLog(@"CLI: Block is running but EXPIRED - clearing stale block rules...");
                     NSLog(@"CLI: Expired block end date was: %@", existingEndDate);
 
-                    SCXPCClient* clearXpc = [SCXPCClient new];
+                    SCXPCClient* clearXpc = [SCXPCClient sharedClient];
                     dispatch_semaphore_t clearSema = dispatch_semaphore_create(0);
                     __block NSError* clearError = nil;
 
@@ -164,7 +279,7 @@ int main(int argc, char* argv[]) {
                     NSLog(@"CLI: Job has expired (endDate=%@), cleaning up stale schedule", blockEndDateArg);
 
                     // Cleanup the stale schedule via XPC
-                    SCXPCClient* xpc = [SCXPCClient new];
+                    SCXPCClient* xpc = [SCXPCClient sharedClient];
                     dispatch_semaphore_t cleanupSema = dispatch_semaphore_create(0);
 
                     [xpc cleanupStaleSchedule:scheduleId reply:^(NSError* error) {
@@ -190,7 +305,7 @@ int main(int argc, char* argv[]) {
                 NSLog(@"CLI: Job is valid (startDate <= now <= endDate), proceeding with block start");
 
                 NSLog(@"CLI: Creating XPC client...");
-                SCXPCClient* xpc = [SCXPCClient new];
+                SCXPCClient* xpc = [SCXPCClient sharedClient];
                 dispatch_semaphore_t scheduledBlockSema = dispatch_semaphore_create(0);
 
                 [xpc connectAndExecuteCommandBlock:^(NSError *connectError) {
@@ -314,7 +429,7 @@ int main(int argc, char* argv[]) {
 				}
 			}
             
-            SCXPCClient* xpc = [SCXPCClient new];
+            SCXPCClient* xpc = [SCXPCClient sharedClient];
 
             // use a semaphore to make sure the command-line tool doesn't exit
             // while our blocks are still running
@@ -37,12 +37,17 @@ killall -HUP mDNSResponder 2>/dev/null || true
 # (only non app specific step - this should be fine since explicitly chosen to be /usr/local/etc seperate from other app plists)
 echo "Clearing settings plist..."
 rm /usr/local/etc/.*.plist 2>/dev/null || echo "No settings plist found"
+# the journal holds every change since the plist was last written - without this the block comes back
+rm -f /usr/local/etc/.*.plist.journal
+# and the shared copy the app and CLI read settings from
+rm -f /usr/local/etc/.*.plist.shm
 
 # 6. Clear schedule/commitment data from user defaults (run as actual user, not root)
 echo "Clearing user defaults..."
 CONSOLE_USER=$(stat -f "%Su" /dev/console)
 sudo -u "$CONSOLE_USER" defaults delete org.eyebeam.Fence SCIsCommitted 2>/dev/null || true
 sudo -u "$CONSOLE_USER" defaults delete org.eyebeam.Fence SCWeeklySchedules 2>/dev/null || true
+sudo -u "$CONSOLE_USER" defaults delete org.eyebeam.Fence SCCommitmentWeekKeys 2>/dev/null || true
 
 # Clear week-specific keys (check for any SCWeekSchedules_* or SCWeekCommitment_*)
 for key in $(sudo -u "$CONSOLE_USER" defaults read org.eyebeam.Fence 2>/dev/null | grep -oE "SCWeek(Schedules|Commitment)_[0-9-]+" | sort -u); do